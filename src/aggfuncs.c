@@ -16,15 +16,20 @@
  * GNU General Public License for more details.
  */
 #include "postgres.h"
+#include "access/tupmacs.h"
 #include "catalog/pg_type.h"
 #include "fmgr.h"
+#include "libpq/pqformat.h"
 #include "utils/array.h"
 #include "utils/builtins.h"
 #include "utils/cash.h"
+#include "utils/datum.h"
+#include "utils/lsyscache.h"
 #include "utils/numeric.h"
 #include <math.h>
 #include "pg_strom.h"
 #include "cuda_numeric.h"
+#include "cuda_gpupreagg.h"
 
 /*
  * declarations
@@ -43,6 +48,8 @@ Datum gpupreagg_corr_psum_y(PG_FUNCTION_ARGS);
 Datum gpupreagg_corr_psum_x2(PG_FUNCTION_ARGS);
 Datum gpupreagg_corr_psum_y2(PG_FUNCTION_ARGS);
 Datum gpupreagg_corr_psum_xy(PG_FUNCTION_ARGS);
+Datum gpupreagg_phll(PG_FUNCTION_ARGS);
+Datum gpupreagg_pqhist(PG_FUNCTION_ARGS);
 
 Datum pgstrom_avg_int8_accum(PG_FUNCTION_ARGS);	/* name confusing? */
 Datum pgstrom_sum_int8_accum(PG_FUNCTION_ARGS);	/* name confusing? */
@@ -54,12 +61,25 @@ Datum pgstrom_covariance_float8_accum(PG_FUNCTION_ARGS);
 Datum pgstrom_int8_avg_accum(PG_FUNCTION_ARGS);
 Datum pgstrom_numeric_avg_accum(PG_FUNCTION_ARGS);
 Datum pgstrom_numeric_avg_final(PG_FUNCTION_ARGS);
+Datum pgstrom_numeric_agg_combine(PG_FUNCTION_ARGS);
+Datum pgstrom_numeric_agg_serial(PG_FUNCTION_ARGS);
+Datum pgstrom_numeric_agg_deserial(PG_FUNCTION_ARGS);
 Datum pgstrom_numeric_var_accum(PG_FUNCTION_ARGS);
 Datum pgstrom_numeric_var_samp(PG_FUNCTION_ARGS);
 Datum pgstrom_numeric_var_pop(PG_FUNCTION_ARGS);
 Datum pgstrom_numeric_stddev_samp(PG_FUNCTION_ARGS);
 Datum pgstrom_numeric_stddev_pop(PG_FUNCTION_ARGS);
 
+Datum pgstrom_hll_count_accum(PG_FUNCTION_ARGS);
+Datum pgstrom_hll_sfunc(PG_FUNCTION_ARGS);
+Datum pgstrom_hll_combine(PG_FUNCTION_ARGS);
+Datum pgstrom_hll_count_final(PG_FUNCTION_ARGS);
+
+Datum pgstrom_percentile_hist_accum(PG_FUNCTION_ARGS);
+Datum pgstrom_percentile_sfunc(PG_FUNCTION_ARGS);
+Datum pgstrom_percentile_combine(PG_FUNCTION_ARGS);
+Datum pgstrom_percentile_final(PG_FUNCTION_ARGS);
+
 /* gpupreagg_partial_nrows - placeholder function that generate number
  * of rows being included in this partial group.
  */
@@ -247,6 +267,106 @@ gpupreagg_corr_psum_xy(PG_FUNCTION_ARGS)
 }
 PG_FUNCTION_INFO_V1(gpupreagg_corr_psum_xy);
 
+/*
+ * hll_hash_datum - host side hash of the argument of approx_count_distinct.
+ * It has to be bit-identical to pg_<type>_comp_fasthash of device code,
+ * so it hashes the raw bytes (or payload of varlena) by fasthash.
+ */
+typedef struct
+{
+	Oid		typeid;
+	int16	typlen;
+	bool	typbyval;
+} hll_hash_typinfo;
+
+static cl_uint
+hll_hash_datum(FunctionCallInfo fcinfo, int argno)
+{
+	hll_hash_typinfo *tinfo = fcinfo->flinfo->fn_extra;
+	Datum		datum = PG_GETARG_DATUM(argno);
+	cl_uint		hash;
+
+	if (!tinfo)
+	{
+		tinfo = MemoryContextAlloc(fcinfo->flinfo->fn_mcxt,
+								   sizeof(hll_hash_typinfo));
+		tinfo->typeid = get_fn_expr_argtype(fcinfo->flinfo, argno);
+		if (!OidIsValid(tinfo->typeid))
+			elog(ERROR, "could not determine data type of the argument");
+		get_typlenbyval(tinfo->typeid, &tinfo->typlen, &tinfo->typbyval);
+		fcinfo->flinfo->fn_extra = tinfo;
+	}
+
+	if (tinfo->typbyval)
+	{
+		char	buf[sizeof(Datum)];
+
+		store_att_byval(buf, datum, tinfo->typlen);
+		hash = pg_common_comp_fasthash(GPUPREAGG_HLL_HASH_SEED,
+									   buf, tinfo->typlen);
+	}
+	else if (tinfo->typlen == -1)
+	{
+		struct varlena *vl = PG_DETOAST_DATUM_PACKED(datum);
+
+		hash = pg_common_comp_fasthash(GPUPREAGG_HLL_HASH_SEED,
+									   VARDATA_ANY(vl),
+									   VARSIZE_ANY_EXHDR(vl));
+		if ((Pointer) vl != DatumGetPointer(datum))
+			pfree(vl);
+	}
+	else if (tinfo->typlen > 0)
+	{
+		hash = pg_common_comp_fasthash(GPUPREAGG_HLL_HASH_SEED,
+									   DatumGetPointer(datum),
+									   tinfo->typlen);
+	}
+	else
+		elog(ERROR, "unsupported data type for approx_count_distinct: %s",
+			 format_type_be(tinfo->typeid));
+
+	return pg_common_fin_fasthash(hash);
+}
+
+/* gpupreagg_phll - placeholder function that generates HyperLogLog
+ * registers of the K-th partial column. NULL is not counted.
+ */
+Datum
+gpupreagg_phll(PG_FUNCTION_ARGS)
+{
+	int32		colidx;
+
+	Assert(PG_NARGS() == 2);
+	if (PG_ARGISNULL(0))
+		elog(ERROR, "column index of phll must not be NULL");
+	colidx = PG_GETARG_INT32(0);
+	if (PG_ARGISNULL(1))
+		PG_RETURN_INT64(0);
+	PG_RETURN_INT64((int64) gpupreagg_hll_register(hll_hash_datum(fcinfo, 1),
+												   colidx));
+}
+PG_FUNCTION_INFO_V1(gpupreagg_phll);
+
+/* gpupreagg_pqhist - placeholder function that generates counters of
+ * the log-scale histogram of the K-th partial column. NULL is not counted.
+ */
+Datum
+gpupreagg_pqhist(PG_FUNCTION_ARGS)
+{
+	int32		colidx;
+	int			bucket;
+
+	Assert(PG_NARGS() == 2);
+	if (PG_ARGISNULL(0))
+		elog(ERROR, "column index of pqhist must not be NULL");
+	colidx = PG_GETARG_INT32(0);
+	if (PG_ARGISNULL(1))
+		PG_RETURN_INT64(0);
+	bucket = gpupreagg_qhist_bucket(PG_GETARG_FLOAT8(1));
+	PG_RETURN_INT64((int64) gpupreagg_qhist_counter(bucket, colidx));
+}
+PG_FUNCTION_INFO_V1(gpupreagg_pqhist);
+
 /*
  * ex_avg() - an enhanced average calculation that takes two arguments;
  * number of rows in this group and partial sum of the value.
@@ -326,14 +446,220 @@ PG_FUNCTION_INFO_V1(pgstrom_sum_int8_accum);
 /*
  * numeric_agg_state - self version of aggregation internal state; that
  * can keep N, sum(X) and sum(X*X) in numeric data-type.
+ *
+ * If 128bit integer is available, partial sums are accumulated on the
+ * fixed-point integer (isumX/isumX2) scaled by 10^dscale, and only the
+ * values which cannot be represented (NaN, too large or too many decimal
+ * digits) are added to the numeric sums. The final functions merge both
+ * of them, so the result is identical to pure numeric accumulation.
  */
 typedef struct
 {
 	int64	N;
 	Datum	sumX;
 	Datum	sumX2;
+#ifdef HAVE_INT128
+	int128	isumX;
+	int128	isumX2;
+	int		isumX_dscale;
+	int		isumX2_dscale;
+#endif
 } numeric_agg_state;
 
+#ifdef HAVE_INT128
+#define INT128_MAX_VALUE	((int128)(~((uint128) 0) >> 1))
+#define INT128_MIN_VALUE	(-INT128_MAX_VALUE - 1)
+/* 10^38 is the largest power of 10 that fits to int128 */
+#define INT128_MAX_DSCALE	38
+
+static inline bool
+int128_add_overflow(int128 a, int128 b, int128 *result)
+{
+	if ((b > 0 && a > INT128_MAX_VALUE - b) ||
+		(b < 0 && a < INT128_MIN_VALUE - b))
+		return true;
+	*result = a + b;
+	return false;
+}
+
+static inline bool
+int128_scale_overflow(int128 *p_value, int nshift)
+{
+	int128		value = *p_value;
+
+	while (nshift-- > 0)
+	{
+		if (value > INT128_MAX_VALUE / 10 ||
+			value < INT128_MIN_VALUE / 10)
+			return true;
+		value *= 10;
+	}
+	*p_value = value;
+	return false;
+}
+
+/*
+ * numeric_to_int128 - converts a numeric value to fixed-point integer
+ * scaled by 10^dscale. It returns false if NaN or not representable.
+ */
+static bool
+numeric_to_int128(Numeric num, int128 *p_value, int *p_dscale)
+{
+	union NumericChoice *nc = (union NumericChoice *) VARDATA(num);
+	NumericDigit *digits;
+	int			ndigits;
+	int			weight;
+	int			dscale;
+	int			expo;
+	int128		value = 0;
+	int			i;
+
+	if (NUMERIC_IS_NAN(nc))
+		return false;
+	dscale = NUMERIC_DSCALE(nc);
+	if (dscale > INT128_MAX_DSCALE)
+		return false;
+	digits = NUMERIC_DIGITS(nc);
+	ndigits = (VARSIZE(num) - VARHDRSZ -
+			   ((char *) digits - (char *) nc)) / sizeof(NumericDigit);
+	if (ndigits > 0)
+	{
+		weight = NUMERIC_WEIGHT(nc);
+		for (i=0; i < ndigits; i++)
+		{
+			if (value > (INT128_MAX_VALUE - digits[i]) / PG_NBASE)
+				return false;
+			value = value * PG_NBASE + digits[i];
+		}
+		/* number of decimal digits below the point in 'value' */
+		expo = (ndigits - 1 - weight) * PG_DEC_DIGITS;
+		if (expo < dscale)
+		{
+			if (int128_scale_overflow(&value, dscale - expo))
+				return false;
+		}
+		else
+		{
+			/* digits under the dscale are always zero */
+			while (expo-- > dscale)
+				value /= 10;
+		}
+		if (NUMERIC_SIGN(nc) == NUMERIC_NEG)
+			value = -value;
+	}
+	*p_value = value;
+	*p_dscale = dscale;
+
+	return true;
+}
+
+/*
+ * int128_to_numeric - makes a numeric value from fixed-point integer
+ */
+static Datum
+int128_to_numeric(int128 value, int dscale)
+{
+	char		buf[64];
+	char	   *pos = buf + sizeof(buf);
+	uint128		uval = (value < 0 ? -((uint128) value) : (uint128) value);
+	int			ndigits = 0;
+
+	Assert(dscale <= INT128_MAX_DSCALE);
+	*--pos = '\0';
+	do {
+		*--pos = '0' + (int)(uval % 10);
+		uval /= 10;
+		if (++ndigits == dscale)
+			*--pos = '.';
+	} while (uval != 0 || ndigits <= dscale);
+	if (value < 0)
+		*--pos = '-';
+
+	return DirectFunctionCall3(numeric_in,
+							   CStringGetDatum(pos),
+							   ObjectIdGetDatum(0),
+							   Int32GetDatum(-1));
+}
+#endif	/* HAVE_INT128 */
+
+/*
+ * numeric_agg_accum - adds a numeric value to the sum; 128bit fixed-point
+ * integer is used as long as the value is representable, or it is added
+ * to the numeric sum.
+ */
+#ifdef HAVE_INT128
+/*
+ * numeric_agg_accum_int128 - adds a fixed-point integer to the 128bit
+ * sum. It returns false if overflow.
+ */
+static bool
+numeric_agg_accum_int128(numeric_agg_state *state, bool is_sumX2,
+						 int128 ival, int dscale)
+{
+	int128	   *p_isum = (is_sumX2 ? &state->isumX2 : &state->isumX);
+	int		   *p_dscale = (is_sumX2
+							? &state->isumX2_dscale
+							: &state->isumX_dscale);
+	int128		isum = *p_isum;
+
+	if (dscale > *p_dscale)
+	{
+		if (int128_scale_overflow(&isum, dscale - *p_dscale))
+			return false;
+	}
+	else
+	{
+		if (int128_scale_overflow(&ival, *p_dscale - dscale))
+			return false;
+		dscale = *p_dscale;
+	}
+	if (int128_add_overflow(isum, ival, &isum))
+		return false;
+	*p_isum = isum;
+	*p_dscale = dscale;
+
+	return true;
+}
+#endif
+
+static void
+numeric_agg_accum(numeric_agg_state *state, bool is_sumX2, Datum newval)
+{
+	Datum	   *p_sum = (is_sumX2 ? &state->sumX2 : &state->sumX);
+#ifdef HAVE_INT128
+	int128		ival;
+	int			dscale;
+	Numeric		num = DatumGetNumeric(newval);
+	bool		is_valid = numeric_to_int128(num, &ival, &dscale);
+
+	/* don't leak the detoasted copy in the aggregate context */
+	if ((Pointer) num != DatumGetPointer(newval))
+		pfree(num);
+	if (is_valid && numeric_agg_accum_int128(state, is_sumX2, ival, dscale))
+		return;
+#endif
+	*p_sum = DirectFunctionCall2(numeric_add, *p_sum, newval);
+}
+
+/*
+ * numeric_agg_sum - returns the total of numeric and fixed-point sum
+ */
+static Datum
+numeric_agg_sum(numeric_agg_state *state, bool is_sumX2)
+{
+	Datum		sum = (is_sumX2 ? state->sumX2 : state->sumX);
+#ifdef HAVE_INT128
+	Datum		isum;
+
+	if (is_sumX2)
+		isum = int128_to_numeric(state->isumX2, state->isumX2_dscale);
+	else
+		isum = int128_to_numeric(state->isumX, state->isumX_dscale);
+	sum = DirectFunctionCall2(numeric_add, sum, isum);
+#endif
+	return sum;
+}
+
 Datum
 pgstrom_int8_avg_accum(PG_FUNCTION_ARGS)
 {
@@ -367,8 +693,17 @@ pgstrom_int8_avg_accum(PG_FUNCTION_ARGS)
 	if (nrows > 0 && !PG_ARGISNULL(2))
 	{
 		state->N += nrows;
-		addNum = DirectFunctionCall1(int8_numeric, PG_GETARG_DATUM(2));
-		state->sumX = DirectFunctionCall2(numeric_add, state->sumX, addNum);
+#ifdef HAVE_INT128
+		/* int8 partial sum never needs scaling */
+		if (int128_add_overflow(state->isumX,
+								(int128) PG_GETARG_INT64(2),
+								&state->isumX))
+#endif
+		{
+			addNum = DirectFunctionCall1(int8_numeric, PG_GETARG_DATUM(2));
+			state->sumX = DirectFunctionCall2(numeric_add,
+											  state->sumX, addNum);
+		}
 	}
 	MemoryContextSwitchTo(oldcxt);
 
@@ -408,9 +743,7 @@ pgstrom_numeric_avg_accum(PG_FUNCTION_ARGS)
 	if (nrows > 0 && !PG_ARGISNULL(2))
 	{
 		state->N += nrows;
-		state->sumX = DirectFunctionCall2(numeric_add,
-										  state->sumX,
-										  PG_GETARG_DATUM(2));
+		numeric_agg_accum(state, false, PG_GETARG_DATUM(2));
 	}
 	MemoryContextSwitchTo(oldcxt);
 
@@ -423,6 +756,7 @@ pgstrom_numeric_avg_final(PG_FUNCTION_ARGS)
 {
 	numeric_agg_state *state;
 	Datum		vN;
+	Datum		vSumX;
 	Datum		result;
 
 	state = PG_ARGISNULL(0) ? NULL : (numeric_agg_state *)PG_GETARG_POINTER(0);
@@ -431,16 +765,185 @@ pgstrom_numeric_avg_final(PG_FUNCTION_ARGS)
 	if (state == NULL || state->N == 0)
 		PG_RETURN_NULL();
 	/* If any NaN value is accumlated, return NaN */
-	if (numeric_is_nan(DatumGetNumeric(state->sumX)))
-		PG_RETURN_NUMERIC(state->sumX);
+	vSumX = numeric_agg_sum(state, false);
+	if (numeric_is_nan(DatumGetNumeric(vSumX)))
+		PG_RETURN_NUMERIC(vSumX);
 
 	vN = DirectFunctionCall1(int8_numeric, Int64GetDatum(state->N));
-	result = DirectFunctionCall2(numeric_div, state->sumX, vN);
+	result = DirectFunctionCall2(numeric_div, vSumX, vN);
 
 	PG_RETURN_NUMERIC(result);
 }
 PG_FUNCTION_INFO_V1(pgstrom_numeric_avg_final);
 
+/*
+ * combine / serialize / deserialize functions of numeric_agg_state, to
+ * support parallel aggregation (PostgreSQL 9.6 or later).
+ * Note that sumX2 is not initialized (zero) by the average functions.
+ */
+static Datum
+numeric_agg_merge_sum(Datum sum1, Datum sum2)
+{
+	if (sum2 == 0)
+		return sum1;
+	if (sum1 == 0)
+		return datumCopy(sum2, false, -1);
+	return DirectFunctionCall2(numeric_add, sum1, sum2);
+}
+
+Datum
+pgstrom_numeric_agg_combine(PG_FUNCTION_ARGS)
+{
+	numeric_agg_state *state1;
+	numeric_agg_state *state2;
+	MemoryContext	aggcxt;
+	MemoryContext	oldcxt;
+
+	if (!AggCheckCallContext(fcinfo, &aggcxt))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	state1 = PG_ARGISNULL(0) ? NULL : (numeric_agg_state *)PG_GETARG_POINTER(0);
+	state2 = PG_ARGISNULL(1) ? NULL : (numeric_agg_state *)PG_GETARG_POINTER(1);
+	if (!state2)
+		PG_RETURN_POINTER(state1);
+
+	oldcxt = MemoryContextSwitchTo(aggcxt);
+	if (!state1)
+		state1 = palloc0(sizeof(numeric_agg_state));
+	state1->N += state2->N;
+	state1->sumX = numeric_agg_merge_sum(state1->sumX, state2->sumX);
+	state1->sumX2 = numeric_agg_merge_sum(state1->sumX2, state2->sumX2);
+#ifdef HAVE_INT128
+	if (!numeric_agg_accum_int128(state1, false,
+								  state2->isumX,
+								  state2->isumX_dscale))
+		state1->sumX = numeric_agg_merge_sum(state1->sumX,
+							int128_to_numeric(state2->isumX,
+											  state2->isumX_dscale));
+	if (!numeric_agg_accum_int128(state1, true,
+								  state2->isumX2,
+								  state2->isumX2_dscale))
+		state1->sumX2 = numeric_agg_merge_sum(state1->sumX2,
+							int128_to_numeric(state2->isumX2,
+											  state2->isumX2_dscale));
+#endif
+	MemoryContextSwitchTo(oldcxt);
+
+	PG_RETURN_POINTER(state1);
+}
+PG_FUNCTION_INFO_V1(pgstrom_numeric_agg_combine);
+
+static void
+numeric_agg_send_sum(StringInfo buf, Datum sum)
+{
+	bytea	   *temp;
+
+	if (sum == 0)
+		pq_sendint(buf, -1, 4);
+	else
+	{
+		temp = DatumGetByteaP(DirectFunctionCall1(numeric_send, sum));
+		pq_sendint(buf, VARSIZE(temp) - VARHDRSZ, 4);
+		pq_sendbytes(buf, VARDATA(temp), VARSIZE(temp) - VARHDRSZ);
+		pfree(temp);
+	}
+}
+
+static Datum
+numeric_agg_recv_sum(StringInfo buf)
+{
+	StringInfoData	temp;
+	int				len = pq_getmsgint(buf, 4);
+	Datum			result;
+
+	if (len < 0)
+		return 0;
+	initStringInfo(&temp);
+	appendBinaryStringInfo(&temp, pq_getmsgbytes(buf, len), len);
+
+	result = DirectFunctionCall3(numeric_recv,
+								 PointerGetDatum(&temp),
+								 ObjectIdGetDatum(InvalidOid),
+								 Int32GetDatum(-1));
+	pfree(temp.data);
+
+	return result;
+}
+
+#ifdef HAVE_INT128
+static void
+numeric_agg_send_int128(StringInfo buf, int128 value, int dscale)
+{
+	pq_sendint64(buf, (int64)(value >> 64));
+	pq_sendint64(buf, (int64)((uint64) value));
+	pq_sendint(buf, dscale, 4);
+}
+
+static int128
+numeric_agg_recv_int128(StringInfo buf, int *p_dscale)
+{
+	uint128		hi = (uint64) pq_getmsgint64(buf);
+	uint128		lo = (uint64) pq_getmsgint64(buf);
+
+	*p_dscale = pq_getmsgint(buf, 4);
+	return (int128)((hi << 64) | lo);
+}
+#endif
+
+Datum
+pgstrom_numeric_agg_serial(PG_FUNCTION_ARGS)
+{
+	numeric_agg_state *state;
+	StringInfoData	buf;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+	state = (numeric_agg_state *)PG_GETARG_POINTER(0);
+
+	pq_begintypsend(&buf);
+	pq_sendint64(&buf, state->N);
+	numeric_agg_send_sum(&buf, state->sumX);
+	numeric_agg_send_sum(&buf, state->sumX2);
+#ifdef HAVE_INT128
+	numeric_agg_send_int128(&buf, state->isumX, state->isumX_dscale);
+	numeric_agg_send_int128(&buf, state->isumX2, state->isumX2_dscale);
+#endif
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+PG_FUNCTION_INFO_V1(pgstrom_numeric_agg_serial);
+
+Datum
+pgstrom_numeric_agg_deserial(PG_FUNCTION_ARGS)
+{
+	bytea		   *sstate = PG_GETARG_BYTEA_P(0);
+	StringInfoData	buf;
+	MemoryContext	aggcxt;
+	MemoryContext	oldcxt;
+	numeric_agg_state *state;
+
+	if (!AggCheckCallContext(fcinfo, &aggcxt))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+
+	initStringInfo(&buf);
+	appendBinaryStringInfo(&buf, VARDATA(sstate), VARSIZE(sstate) - VARHDRSZ);
+
+	oldcxt = MemoryContextSwitchTo(aggcxt);
+	state = palloc0(sizeof(numeric_agg_state));
+	state->N = pq_getmsgint64(&buf);
+	state->sumX = numeric_agg_recv_sum(&buf);
+	state->sumX2 = numeric_agg_recv_sum(&buf);
+#ifdef HAVE_INT128
+	state->isumX = numeric_agg_recv_int128(&buf, &state->isumX_dscale);
+	state->isumX2 = numeric_agg_recv_int128(&buf, &state->isumX2_dscale);
+#endif
+	MemoryContextSwitchTo(oldcxt);
+	pq_getmsgend(&buf);
+	pfree(buf.data);
+
+	PG_RETURN_POINTER(state);
+}
+PG_FUNCTION_INFO_V1(pgstrom_numeric_agg_deserial);
+
 /* logic copied from utils/adt/float.c */
 static inline float8 *
 check_float8_array(ArrayType *transarray, int nitems)
@@ -596,12 +1099,8 @@ pgstrom_numeric_var_accum(PG_FUNCTION_ARGS)
 	if (nrows > 0 && !PG_ARGISNULL(2) && !PG_ARGISNULL(3))
 	{
 		state->N += nrows;
-		state->sumX = DirectFunctionCall2(numeric_add,
-										  state->sumX,
-										  PG_GETARG_DATUM(2));
-		state->sumX2 = DirectFunctionCall2(numeric_add,
-										   state->sumX2,
-										   PG_GETARG_DATUM(3));
+		numeric_agg_accum(state, false, PG_GETARG_DATUM(2));
+		numeric_agg_accum(state, true, PG_GETARG_DATUM(3));
 	}
 	MemoryContextSwitchTo(oldcxt);
 
@@ -616,17 +1115,21 @@ pgstrom_numeric_stddev_internal(numeric_agg_state *state,
 	Datum	vZero;
 	Datum	vN;
 	Datum	vN2;
+	Datum	sumX;
+	Datum	sumX2;
 	Datum	vSumX;
 	Datum	vSumX2;
 	Datum	result;
 
 	if (state == NULL)
 		return NULL;
+	sumX = numeric_agg_sum(state, false);
+	sumX2 = numeric_agg_sum(state, true);
 	/* NaN checks */
-	if (numeric_is_nan(DatumGetNumeric(state->sumX)))
-		return DatumGetNumeric(state->sumX);
-	if (numeric_is_nan(DatumGetNumeric(state->sumX2)))
-		return DatumGetNumeric(state->sumX2);
+	if (numeric_is_nan(DatumGetNumeric(sumX)))
+		return DatumGetNumeric(sumX);
+	if (numeric_is_nan(DatumGetNumeric(sumX2)))
+		return DatumGetNumeric(sumX2);
 
 	/*
 	 * Sample stddev and variance are undefined when N <= 1; population stddev
@@ -643,9 +1146,9 @@ pgstrom_numeric_stddev_internal(numeric_agg_state *state,
 	/* vN = (Numeric)N */
 	vN = DirectFunctionCall1(int8_numeric, Int64GetDatum(state->N));
 	/* vsumX = sumX * sumX */
-	vSumX = DirectFunctionCall2(numeric_mul, state->sumX, state->sumX);
+	vSumX = DirectFunctionCall2(numeric_mul, sumX, sumX);
 	/* vsumX2 = N * sumX2 */
-	vSumX2 = DirectFunctionCall2(numeric_mul, state->sumX2, vN);
+	vSumX2 = DirectFunctionCall2(numeric_mul, sumX2, vN);
 	/* N * sumX2 - sumX * sumX */
 	vSumX2 = DirectFunctionCall2(numeric_sub, vSumX2, vSumX);
 
@@ -805,3 +1308,368 @@ pgstrom_covariance_float8_accum(PG_FUNCTION_ARGS)
 	}
 }
 PG_FUNCTION_INFO_V1(pgstrom_covariance_float8_accum);
+
+/*
+ * HyperLogLog based approx_count_distinct()
+ *
+ * Its transition state is an array of GPUPREAGG_HLL_NUM_COLUMNS int8
+ * values; each of them packs 8 registers of 8bit width, as GpuPreAgg
+ * produces with phll(K,X). So, hll_count(phll(0,X),...,phll(15,X))
+ * and approx_count_distinct(X) share the state and final function.
+ */
+static ArrayType *
+hll_registers_merge(FunctionCallInfo fcinfo, ArrayType *transarray,
+					int64 *newvals)
+{
+	int64	   *transvalues;
+	int			i;
+
+	transvalues = check_int64_array(transarray, GPUPREAGG_HLL_NUM_COLUMNS);
+	if (!AggCheckCallContext(fcinfo, NULL))
+	{
+		transarray = DatumGetArrayTypePCopy(PointerGetDatum(transarray));
+		transvalues = (int64 *) ARR_DATA_PTR(transarray);
+	}
+	for (i=0; i < GPUPREAGG_HLL_NUM_COLUMNS; i++)
+		transvalues[i] = (int64) gpupreagg_hll_merge((cl_ulong) transvalues[i],
+													 (cl_ulong) newvals[i]);
+	return transarray;
+}
+
+Datum
+pgstrom_hll_count_accum(PG_FUNCTION_ARGS)
+{
+	ArrayType  *transarray = PG_GETARG_ARRAYTYPE_P(0);
+	int64		newvals[GPUPREAGG_HLL_NUM_COLUMNS];
+	int			i;
+
+	Assert(PG_NARGS() == GPUPREAGG_HLL_NUM_COLUMNS + 1);
+	for (i=0; i < GPUPREAGG_HLL_NUM_COLUMNS; i++)
+		newvals[i] = (PG_ARGISNULL(i+1) ? 0 : PG_GETARG_INT64(i+1));
+
+	PG_RETURN_ARRAYTYPE_P(hll_registers_merge(fcinfo, transarray, newvals));
+}
+PG_FUNCTION_INFO_V1(pgstrom_hll_count_accum);
+
+Datum
+pgstrom_hll_sfunc(PG_FUNCTION_ARGS)
+{
+	ArrayType  *transarray = PG_GETARG_ARRAYTYPE_P(0);
+	int64		newvals[GPUPREAGG_HLL_NUM_COLUMNS];
+	cl_uint		hash;
+	int			i;
+
+	hash = hll_hash_datum(fcinfo, 1);
+	for (i=0; i < GPUPREAGG_HLL_NUM_COLUMNS; i++)
+		newvals[i] = (int64) gpupreagg_hll_register(hash, i);
+
+	PG_RETURN_ARRAYTYPE_P(hll_registers_merge(fcinfo, transarray, newvals));
+}
+PG_FUNCTION_INFO_V1(pgstrom_hll_sfunc);
+
+Datum
+pgstrom_hll_combine(PG_FUNCTION_ARGS)
+{
+	ArrayType  *transarray1 = PG_GETARG_ARRAYTYPE_P(0);
+	ArrayType  *transarray2 = PG_GETARG_ARRAYTYPE_P(1);
+	int64	   *newvals;
+
+	newvals = check_int64_array(transarray2, GPUPREAGG_HLL_NUM_COLUMNS);
+
+	PG_RETURN_ARRAYTYPE_P(hll_registers_merge(fcinfo, transarray1, newvals));
+}
+PG_FUNCTION_INFO_V1(pgstrom_hll_combine);
+
+Datum
+pgstrom_hll_count_final(PG_FUNCTION_ARGS)
+{
+	ArrayType  *transarray = PG_GETARG_ARRAYTYPE_P(0);
+	int64	   *transvalues;
+	double		m = (double) GPUPREAGG_HLL_NUM_REGISTERS;
+	double		alpha = 0.7213 / (1.0 + 1.079 / m);
+	double		sum = 0.0;
+	double		estimate;
+	int			num_zeros = 0;
+	int			i, j;
+
+	transvalues = check_int64_array(transarray, GPUPREAGG_HLL_NUM_COLUMNS);
+	for (i=0; i < GPUPREAGG_HLL_NUM_COLUMNS; i++)
+	{
+		cl_ulong	regs = (cl_ulong) transvalues[i];
+
+		for (j=0; j < 8; j++)
+		{
+			int		rho = (regs >> (8 * j)) & 0xff;
+
+			sum += ldexp(1.0, -rho);
+			if (rho == 0)
+				num_zeros++;
+		}
+	}
+	estimate = alpha * m * m / sum;
+
+	/* small range correction by linear counting */
+	if (estimate <= 2.5 * m && num_zeros > 0)
+		estimate = m * log(m / (double) num_zeros);
+	/* large range correction for 32bit hash */
+	else if (estimate > 4294967296.0 / 30.0 &&
+			 estimate < 4294967296.0)
+		estimate = -4294967296.0 * log(1.0 - estimate / 4294967296.0);
+
+	PG_RETURN_INT64((int64) rint(estimate));
+}
+PG_FUNCTION_INFO_V1(pgstrom_hll_count_final);
+
+/*
+ * Log-scale histogram based approx_percentile()
+ *
+ * Its transition state is an array of float8; the fraction to be
+ * computed, the exact min and max value, then counters of the buckets.
+ * percentile_hist(PMAX(Q),PMIN(X),PMAX(X),PQHIST(0,X),...,PQHIST(31,X))
+ * and approx_percentile(X,Q) share the state and final function.
+ */
+#define QHIST_STATE_FRACTION	0
+#define QHIST_STATE_MIN			1
+#define QHIST_STATE_MAX			2
+#define QHIST_STATE_COUNTS		3
+#define QHIST_STATE_NITEMS		(QHIST_STATE_COUNTS + \
+								 GPUPREAGG_QHIST_NUM_BUCKETS)
+
+static ArrayType *
+qhist_state_fetch(FunctionCallInfo fcinfo)
+{
+	ArrayType  *transarray;
+
+	if (PG_ARGISNULL(0))
+	{
+		Datum		transdatums[QHIST_STATE_NITEMS];
+		MemoryContext aggcxt;
+		MemoryContext oldcxt;
+		int			i;
+
+		transdatums[QHIST_STATE_FRACTION] = Float8GetDatum(get_float8_nan());
+		for (i=QHIST_STATE_MIN; i < QHIST_STATE_NITEMS; i++)
+			transdatums[i] = Float8GetDatum(0.0);
+
+		if (!AggCheckCallContext(fcinfo, &aggcxt))
+			aggcxt = CurrentMemoryContext;
+		oldcxt = MemoryContextSwitchTo(aggcxt);
+		transarray = construct_array(transdatums, QHIST_STATE_NITEMS,
+									 FLOAT8OID,
+									 sizeof(float8), FLOAT8PASSBYVAL, 'd');
+		MemoryContextSwitchTo(oldcxt);
+	}
+	else
+	{
+		transarray = PG_GETARG_ARRAYTYPE_P(0);
+		if (!AggCheckCallContext(fcinfo, NULL))
+			transarray = DatumGetArrayTypePCopy(PointerGetDatum(transarray));
+	}
+	check_float8_array(transarray, QHIST_STATE_NITEMS);
+
+	return transarray;
+}
+
+static void
+qhist_state_update(float8 *transvalues, float8 fraction,
+				   float8 minval, float8 maxval, float8 *counts)
+{
+	float8		nitems = 0.0;
+	float8		nitems_new = 0.0;
+	int			i;
+
+	for (i=0; i < GPUPREAGG_QHIST_NUM_BUCKETS; i++)
+	{
+		nitems += transvalues[QHIST_STATE_COUNTS + i];
+		nitems_new += counts[i];
+	}
+	if (isnan(transvalues[QHIST_STATE_FRACTION]))
+		transvalues[QHIST_STATE_FRACTION] = fraction;
+	if (nitems_new == 0.0)
+		return;
+	if (nitems == 0.0 ||
+		float8_cmp_internal(minval, transvalues[QHIST_STATE_MIN]) < 0)
+		transvalues[QHIST_STATE_MIN] = minval;
+	if (nitems == 0.0 ||
+		float8_cmp_internal(maxval, transvalues[QHIST_STATE_MAX]) > 0)
+		transvalues[QHIST_STATE_MAX] = maxval;
+	for (i=0; i < GPUPREAGG_QHIST_NUM_BUCKETS; i++)
+		transvalues[QHIST_STATE_COUNTS + i] += counts[i];
+}
+
+Datum
+pgstrom_percentile_hist_accum(PG_FUNCTION_ARGS)
+{
+	ArrayType  *transarray;
+	float8		counts[GPUPREAGG_QHIST_NUM_BUCKETS];
+	cl_ulong	packed;
+	bool		has_counts = false;
+	int			i;
+
+	Assert(PG_NARGS() == GPUPREAGG_QHIST_NUM_COLUMNS + 4);
+	transarray = qhist_state_fetch(fcinfo);
+	for (i=0; i < GPUPREAGG_QHIST_NUM_COLUMNS; i++)
+	{
+		packed = (PG_ARGISNULL(i+4) ? 0 : (cl_ulong) PG_GETARG_INT64(i+4));
+		counts[2*i]   = (float8)(packed & 0xffffffffUL);
+		counts[2*i+1] = (float8)(packed >> 32);
+		if (packed != 0)
+			has_counts = true;
+	}
+	/* PMIN(X) and PMAX(X) are NULL only if no rows are counted */
+	if (has_counts && !PG_ARGISNULL(2) && !PG_ARGISNULL(3))
+		qhist_state_update((float8 *) ARR_DATA_PTR(transarray),
+						   PG_ARGISNULL(1)
+						   ? get_float8_nan()
+						   : PG_GETARG_FLOAT8(1),
+						   PG_GETARG_FLOAT8(2),
+						   PG_GETARG_FLOAT8(3),
+						   counts);
+	PG_RETURN_ARRAYTYPE_P(transarray);
+}
+PG_FUNCTION_INFO_V1(pgstrom_percentile_hist_accum);
+
+Datum
+pgstrom_percentile_sfunc(PG_FUNCTION_ARGS)
+{
+	ArrayType  *transarray = qhist_state_fetch(fcinfo);
+	float8		counts[GPUPREAGG_QHIST_NUM_BUCKETS];
+	float8		newval;
+
+	if (!PG_ARGISNULL(1) && !PG_ARGISNULL(2))
+	{
+		newval = PG_GETARG_FLOAT8(1);
+		memset(counts, 0, sizeof(counts));
+		counts[gpupreagg_qhist_bucket(newval)] = 1.0;
+		qhist_state_update((float8 *) ARR_DATA_PTR(transarray),
+						   PG_GETARG_FLOAT8(2),
+						   newval, newval, counts);
+	}
+	PG_RETURN_ARRAYTYPE_P(transarray);
+}
+PG_FUNCTION_INFO_V1(pgstrom_percentile_sfunc);
+
+Datum
+pgstrom_percentile_combine(PG_FUNCTION_ARGS)
+{
+	ArrayType  *transarray;
+	float8	   *newvals;
+
+	if (PG_ARGISNULL(1))
+	{
+		if (PG_ARGISNULL(0))
+			PG_RETURN_NULL();
+		PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+	}
+	transarray = qhist_state_fetch(fcinfo);
+	newvals = check_float8_array(PG_GETARG_ARRAYTYPE_P(1),
+								 QHIST_STATE_NITEMS);
+	qhist_state_update((float8 *) ARR_DATA_PTR(transarray),
+					   newvals[QHIST_STATE_FRACTION],
+					   newvals[QHIST_STATE_MIN],
+					   newvals[QHIST_STATE_MAX],
+					   newvals + QHIST_STATE_COUNTS);
+	PG_RETURN_ARRAYTYPE_P(transarray);
+}
+PG_FUNCTION_INFO_V1(pgstrom_percentile_combine);
+
+/*
+ * qhist_bucket_range - range of the values that belong to the bucket
+ */
+static void
+qhist_bucket_range(int bucket, float8 *p_lower, float8 *p_upper)
+{
+	float8		lower;
+	float8		upper;
+
+	if (bucket == 0)
+	{
+		lower = -get_float8_infinity();
+		upper = ldexp(1.0, GPUPREAGG_QHIST_MIN_EXPONENT);
+	}
+	else if (bucket == GPUPREAGG_QHIST_NUM_BUCKETS - 1)
+	{
+		lower = ldexp(1.0, GPUPREAGG_QHIST_MAX_EXPONENT);
+		upper = get_float8_infinity();
+	}
+	else
+	{
+		int		expo = GPUPREAGG_QHIST_MIN_EXPONENT + (bucket - 1) / 2;
+
+		lower = ldexp(1.0, expo);
+		upper = ldexp(1.0, expo + 1);
+		if ((bucket - 1) % 2 == 0)
+			upper = lower * M_SQRT2;
+		else
+			lower = lower * M_SQRT2;
+	}
+	*p_lower = lower;
+	*p_upper = upper;
+}
+
+Datum
+pgstrom_percentile_final(PG_FUNCTION_ARGS)
+{
+	ArrayType  *transarray;
+	float8	   *transvalues;
+	float8	   *counts;
+	float8		fraction;
+	float8		nitems = 0.0;
+	float8		rank;
+	float8		cumulative = 0.0;
+	float8		lower;
+	float8		upper;
+	float8		pos;
+	int			i;
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+	transarray = PG_GETARG_ARRAYTYPE_P(0);
+	transvalues = check_float8_array(transarray, QHIST_STATE_NITEMS);
+	counts = transvalues + QHIST_STATE_COUNTS;
+	fraction = transvalues[QHIST_STATE_FRACTION];
+
+	for (i=0; i < GPUPREAGG_QHIST_NUM_BUCKETS; i++)
+		nitems += counts[i];
+	if (nitems == 0.0 || isnan(fraction))
+		PG_RETURN_NULL();
+	if (fraction < 0.0 || fraction > 1.0)
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("percentile value %g is not between 0 and 1",
+						fraction)));
+
+	/* find the bucket that contains the rank-th value (0-origin) */
+	rank = fraction * (nitems - 1.0);
+	for (i=0; i < GPUPREAGG_QHIST_NUM_BUCKETS - 1; i++)
+	{
+		if (rank < cumulative + counts[i])
+			break;
+		cumulative += counts[i];
+	}
+
+	/*
+	 * Values are assumed to be distributed uniformly in log-scale within
+	 * the bucket, but the exact min/max values narrow the range.
+	 */
+	qhist_bucket_range(i, &lower, &upper);
+	lower = Max(lower, transvalues[QHIST_STATE_MIN]);
+	upper = Min(upper, transvalues[QHIST_STATE_MAX]);
+	if (counts[i] > 1.0)
+		pos = Min((rank - cumulative) / (counts[i] - 1.0), 1.0);
+	else
+		pos = 0.5;
+
+	/*
+	 * The supported domain is positive values in [2^-6, 2^25). The first
+	 * bucket takes all the values below the domain, including zero and
+	 * negative ones, and the last bucket takes all the values above it,
+	 * with no resolution inside. So, the rank-th value out of the domain
+	 * is clamped into the range between the exact min/max value and the
+	 * boundary of the domain, and estimated linearly there.
+	 */
+	if (i == 0 || i == GPUPREAGG_QHIST_NUM_BUCKETS - 1 || upper <= lower)
+		PG_RETURN_FLOAT8(lower + (upper - lower) * pos);
+	PG_RETURN_FLOAT8(lower * pow(upper / lower, pos));
+}
+PG_FUNCTION_INFO_V1(pgstrom_percentile_final);
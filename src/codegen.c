@@ -25,8 +25,11 @@
 #include "nodes/nodeFuncs.h"
 #include "nodes/pg_list.h"
 #include "optimizer/clauses.h"
+#include "optimizer/cost.h"
+#include "utils/array.h"
 #include "utils/builtins.h"
 #include "utils/fmgroids.h"
+#include "utils/guc.h"
 #include "utils/inval.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
@@ -34,11 +37,13 @@
 #include "utils/syscache.h"
 #include "utils/typcache.h"
 #include "pg_strom.h"
+#include <math.h>
 
 static MemoryContext	devinfo_memcxt;
 static bool		devtype_info_is_built;
 static List	   *devtype_info_slot[128];
 static List	   *devfunc_info_slot[1024];
+static int		pgstrom_array_bsearch_threshold;
 
 /*
  * Catalog of data types supported by device code
@@ -1373,6 +1378,31 @@ codegen_expression_walker(Node *node, codegen_context *context)
 	if (node == NULL)
 		return;
 
+	/* common sub-expression already computed? */
+	if (context->cse_limit > 0 && !IsA(node, List))
+	{
+		ListCell   *lc;
+		int			index = 0;
+
+		forboth (cell, context->cse_exprs,
+				 lc, context->cse_codes)
+		{
+			if (index >= context->cse_limit)
+				break;
+			if (equal(node, lfirst(cell)))
+			{
+				/* computed on the first reference only */
+				appendStringInfo(&context->str,
+								 "(CSE_DONE_%u ? CSE_%u : "
+								 "(CSE_DONE_%u = true, CSE_%u = %s))",
+								 index, index, index, index,
+								 (char *) lfirst(lc));
+				return;
+			}
+			index++;
+		}
+	}
+
 	if (IsA(node, Const))
 	{
 		Const  *con = (Const *) node;
@@ -1591,6 +1621,31 @@ codegen_expression_walker(Node *node, codegen_context *context)
 			codegen_expression_walker(linitial(b->args), context);
 			appendStringInfoChar(&context->str, ')');
 		}
+		else if ((b->boolop == AND_EXPR || b->boolop == OR_EXPR) &&
+				 context->bool_depth < context->bool_ntemps)
+		{
+			const char *label = (b->boolop == AND_EXPR ? "and" : "or");
+			int			depth = context->bool_depth++;
+
+			/* short-circuit evaluation using BOOL_%u variable */
+			Assert(list_length(b->args) > 1);
+			appendStringInfo(&context->str,
+							 "(BOOL_%u = pg_bool_%s_init(), (void)(",
+							 depth, label);
+			foreach (cell, b->args)
+			{
+				Assert(exprType(lfirst(cell)) == BOOLOID);
+				if (cell != list_head(b->args))
+					appendStringInfo(&context->str, " && ");
+				appendStringInfo(&context->str,
+								 "pg_bool_%s_next(&BOOL_%u, ",
+								 label, depth);
+				codegen_expression_walker(lfirst(cell), context);
+				appendStringInfoChar(&context->str, ')');
+			}
+			appendStringInfo(&context->str, "), BOOL_%u)", depth);
+			context->bool_depth--;
+		}
 		else if (b->boolop == AND_EXPR || b->boolop == OR_EXPR)
 		{
 			Assert(list_length(b->args) > 1);
@@ -2036,6 +2091,237 @@ codegen_minmax_expression(MinMaxExpr *minmax, codegen_context *context)
 	appendStringInfo(&context->str, ")");
 }
 
+/*
+ * codegen_scalar_array_op_bsearch
+ *
+ * A ScalarArrayOpExpr with a large constant array, like "col IN (...)"
+ * with thousands of constants, is expensive if device code walks on the
+ * array elements for each row. If the array is a constant of integer-like
+ * fixed-length type and the operator is equality (or inequality for ALL),
+ * we sort and de-duplicate the elements on the host side once, then put
+ * the sorted array on the kern_parambuf, so device code can look up the
+ * scalar value using binary search; O(logN) instead of O(N).
+ * Variable length types (like text) are not supported right now, so it
+ * returns false if the supplied ScalarArrayOpExpr is not applicable.
+ */
+#define SAOP_EXTRA_BSEARCH		0x0002
+
+static int
+codegen_array_datum_comp(const void *a, const void *b, void *arg)
+{
+	int		typlen = *((int *) arg);
+	Datum	datum_a = *((const Datum *) a);
+	Datum	datum_b = *((const Datum *) b);
+	cl_long	x, y;
+
+	switch (typlen)
+	{
+		case sizeof(int16):
+			x = DatumGetInt16(datum_a);
+			y = DatumGetInt16(datum_b);
+			break;
+		case sizeof(int32):
+			x = DatumGetInt32(datum_a);
+			y = DatumGetInt32(datum_b);
+			break;
+		case sizeof(int64):
+			x = DatumGetInt64(datum_a);
+			y = DatumGetInt64(datum_b);
+			break;
+		default:
+			elog(ERROR, "unexpected length of array element: %d", typlen);
+	}
+	if (x < y)
+		return -1;
+	if (x > y)
+		return 1;
+	return 0;
+}
+
+static bool
+codegen_scalar_array_op_bsearch(ScalarArrayOpExpr *opexpr,
+								codegen_context *context)
+{
+	Node		   *scalar = linitial(opexpr->args);
+	Const		   *con = lsecond(opexpr->args);
+	Const		   *con_sorted;
+	ArrayType	   *array;
+	Oid				type_oid = exprType(scalar);
+	TypeCacheEntry *tcache;
+	devexpr_info	devexpr;
+	devtype_info   *dtype;
+	devfunc_info   *dfunc;
+	Datum		   *values;
+	bool		   *nulls;
+	int16			elmlen;
+	bool			elmbyval;
+	char			elmalign;
+	int				typlen;
+	int				i, j, nitems;
+	ListCell	   *cell;
+	StringInfoData	decl;
+
+	/* only constant array without NULLs is a candidate */
+	if (!IsA(con, Const) || con->constisnull)
+		return false;
+	array = DatumGetArrayTypeP(con->constvalue);
+	if (ARR_HASNULL(array) ||
+		ARR_ELEMTYPE(array) != type_oid ||
+		ArrayGetNItems(ARR_NDIM(array),
+					   ARR_DIMS(array)) < pgstrom_array_bsearch_threshold)
+		return false;
+
+	/*
+	 * Only integer-like fixed-length types whose ordering of the raw
+	 * values is identical to the ordering by btree operator class.
+	 */
+	switch (type_oid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case CASHOID:
+		case DATEOID:
+		case TIMEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			break;
+		default:
+			return false;
+	}
+	dtype = pgstrom_devtype_lookup(type_oid);
+	if (!dtype || !dtype->type_array ||
+		!dtype->type_byval || dtype->type_length <= 0)
+		return false;
+
+	/* operator has to be equality for ANY, or inequality for ALL */
+	tcache = lookup_type_cache(type_oid, TYPECACHE_EQ_OPR);
+	if (!OidIsValid(tcache->eq_opr))
+		return false;
+	if (opexpr->useOr
+		? opexpr->opno != tcache->eq_opr
+		: opexpr->opno != get_negator(tcache->eq_opr))
+		return false;
+
+	/* build a sorted and de-duplicated array */
+	get_typlenbyvalalign(type_oid, &elmlen, &elmbyval, &elmalign);
+	typlen = elmlen;
+	deconstruct_array(array, type_oid, elmlen, elmbyval, elmalign,
+					  &values, &nulls, &nitems);
+	qsort_arg(values, nitems, sizeof(Datum),
+			  codegen_array_datum_comp, &typlen);
+	for (i=1, j=0; i < nitems; i++)
+	{
+		if (codegen_array_datum_comp(&values[j], &values[i], &typlen) != 0)
+			values[++j] = values[i];
+	}
+	nitems = j + 1;
+	array = construct_array(values, nitems, type_oid,
+							elmlen, elmbyval, elmalign);
+	con_sorted = makeConst(con->consttype,
+						   con->consttypmod,
+						   con->constcollid,
+						   con->constlen,
+						   PointerGetDatum(array),
+						   false,
+						   false);
+
+	/* find out identical predefined device ScalarArrayOpExpr */
+	foreach (cell, context->expr_defs)
+	{
+		deform_devexpr_info(&devexpr, (List *)lfirst(cell));
+
+		if (devexpr.expr_tag == T_ScalarArrayOpExpr &&
+			devexpr.expr_collid == opexpr->inputcollid &&
+			devexpr.expr_extra1 == ObjectIdGetDatum(opexpr->opno) &&
+			devexpr.expr_extra2 == (BoolGetDatum(opexpr->useOr) |
+									SAOP_EXTRA_BSEARCH))
+			goto found;		/* OK, found a predefined one */
+	}
+
+	/* no predefined one, create a special expression function */
+	dfunc = pgstrom_devfunc_lookup_and_track(get_opcode(opexpr->opno),
+											 opexpr->inputcollid,
+											 context);
+	if (!dfunc)
+		return false;
+
+	memset(&devexpr, 0, sizeof(devexpr_info));
+	devexpr.expr_tag = T_ScalarArrayOpExpr;
+	devexpr.expr_collid = opexpr->inputcollid;
+	devexpr.expr_args = list_make2(dtype, dtype->type_array);
+	devexpr.expr_rettype = pgstrom_devtype_lookup(BOOLOID);
+	if (!devexpr.expr_rettype)
+		elog(ERROR, "codegen: failed to lookup device type: %s",
+			 format_type_be(BOOLOID));
+	devexpr.expr_extra1 = ObjectIdGetDatum(opexpr->opno);
+	devexpr.expr_extra2 = (BoolGetDatum(opexpr->useOr) | SAOP_EXTRA_BSEARCH);
+	devexpr.expr_name = psprintf("%s_%s_bsearch",
+								 dfunc->func_sqlname,
+								 opexpr->useOr ? "any" : "all");
+	/* device function declaration */
+	initStringInfo(&decl);
+	appendStringInfo(
+		&decl,
+		"STATIC_INLINE(pg_bool_t)\n"
+		"pgfn_%s(kern_context *kcxt, pg_%s_t scalar, pg_array_t array)\n"
+		"{\n"
+		"  pg_bool_t  result;\n"
+		"  %s        *values;\n"
+		"  cl_int     head, tail, curr;\n"
+		"\n"
+		"  /* NULL result to NULL array or NULL scalar */\n"
+		"  if (array.isnull || scalar.isnull)\n"
+		"  {\n"
+		"    result.isnull = true;\n"
+		"    result.value  = false;\n"
+		"    return result;\n"
+		"  }\n"
+		"  result.isnull = false;\n"
+		"  result.value  = %s;\n"
+		"\n"
+		"  /* binary search on the sorted array */\n"
+		"  values = (%s *)ARR_DATA_PTR(array.value);\n"
+		"  head = 0;\n"
+		"  tail = ArrayGetNItems(kcxt, ARR_NDIM(array.value),\n"
+		"                              ARR_DIMS(array.value));\n"
+		"  while (head < tail)\n"
+		"  {\n"
+		"    curr = head + (tail - head) / 2;\n"
+		"    if (values[curr] == scalar.value)\n"
+		"    {\n"
+		"      result.value = %s;\n"
+		"      break;\n"
+		"    }\n"
+		"    else if (values[curr] < scalar.value)\n"
+		"      head = curr + 1;\n"
+		"    else\n"
+		"      tail = curr;\n"
+		"  }\n"
+		"  return result;\n"
+		"}\n",
+		devexpr.expr_name,
+		dtype->type_name,
+		dtype->type_base,
+		opexpr->useOr ? "false" : "true",
+		dtype->type_base,
+		opexpr->useOr ? "true" : "false");
+	devexpr.expr_decl = decl.data;
+
+	/* remember this special device function */
+	context->expr_defs = lappend(context->expr_defs,
+								 form_devexpr_info(&devexpr));
+found:
+	/* write out this special expression with the sorted array */
+	appendStringInfo(&context->str, "pgfn_%s(kcxt, ", devexpr.expr_name);
+	codegen_expression_walker(scalar, context);
+	appendStringInfo(&context->str, ", ");
+	codegen_expression_walker((Node *) con_sorted, context);
+	appendStringInfo(&context->str, ")");
+
+	return true;
+}
+
 static void
 codegen_scalar_array_op_expression(ScalarArrayOpExpr *opexpr,
 								   codegen_context *context)
@@ -2049,6 +2335,10 @@ codegen_scalar_array_op_expression(ScalarArrayOpExpr *opexpr,
 	ListCell	   *cell;
 	StringInfoData	decl;
 
+	/* large constant array may be looked up with binary search */
+	if (codegen_scalar_array_op_bsearch(opexpr, context))
+		return;
+
 	/* find out identical predefined device ScalarArrayOpExpr */
 	foreach (cell, context->expr_defs)
 	{
@@ -2260,6 +2550,11 @@ pgstrom_codegen_expression(Node *expr, codegen_context *context)
 	walker_context.kds_index_label = context->kds_index_label;
 	walker_context.extra_flags = context->extra_flags;
 	walker_context.pseudo_tlist = context->pseudo_tlist;
+	walker_context.cse_exprs = context->cse_exprs;
+	walker_context.cse_codes = context->cse_codes;
+	walker_context.cse_limit = context->cse_limit;
+	walker_context.bool_ntemps = context->bool_ntemps;
+	walker_context.bool_depth = 0;
 
 	if (IsA(expr, List))
 	{
@@ -2282,6 +2577,211 @@ pgstrom_codegen_expression(Node *expr, codegen_context *context)
 	return walker_context.str.data;
 }
 
+/*
+ * Common sub-expression elimination
+ *
+ * Device expressions in a particular device function (quals, hash-keys
+ * or projection) are generated independently, so an identical expression
+ * like date_trunc() or numeric cast is evaluated multiple times for each
+ * row if it appears in multiple places.
+ * pgstrom_codegen_cse_begin() picks up device sub-expressions that appear
+ * twice or more in the supplied expressions, then returns a code block
+ * that declares CSE_%u temporary variables and CSE_DONE_%u flags.
+ * Caller has to put the code block after the declarations of KPARAM_%u
+ * and KVAR_%u, but prior to the code generated by the following
+ * pgstrom_codegen_expression(). Once the code generation of the device
+ * function gets completed, pgstrom_codegen_cse_end() has to be called.
+ *
+ * A CSE_%u is not computed in the code block, but on the first reference
+ * in the expression, then the later references pick up the value. So,
+ * a sub-expression is never evaluated on the rows where it would not be
+ * evaluated without CSE, like the ones already filtered out by cheaper
+ * qualifiers, or the ones that takes another branch of CASE. It is also
+ * safe on the sub-expressions that may raise an error, like division by
+ * zero. Expression to be evaluated earlier shall appear at the earlier
+ * position of the cse_exprs, because its code may reference the prior
+ * entries.
+ *
+ * The code block also declares BOOL_%u temporary variables for each
+ * nest level of AND/OR clauses, to generate short-circuit evaluation.
+ */
+typedef struct
+{
+	List	   *cse_exprs;		/* candidate sub-expressions */
+	List	   *cse_count;		/* number of appearance */
+} codegen_cse_context;
+
+static bool
+contain_case_test_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, CaseTestExpr))
+		return true;
+	return expression_tree_walker(node, contain_case_test_walker, context);
+}
+
+static bool
+contain_bool_clause_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, BoolExpr) &&
+		(((BoolExpr *) node)->boolop == AND_EXPR ||
+		 ((BoolExpr *) node)->boolop == OR_EXPR))
+		return true;
+	return expression_tree_walker(node, contain_bool_clause_walker, context);
+}
+
+static void
+codegen_cse_track(Node *node, codegen_cse_context *context)
+{
+	ListCell   *lc1;
+	ListCell   *lc2;
+
+	/*
+	 * Expression that references CaseTestExpr has different meaning
+	 * for each CASE clause, even if it looks identical.
+	 * Expression that contains AND/OR clauses is also skipped, because
+	 * its code uses BOOL_%u variables from the depth zero, thus it
+	 * overwrites the variables of the enclosing AND/OR clauses if its
+	 * first reference is nested in them.
+	 */
+	if (!pgstrom_devtype_lookup(exprType(node)) ||
+		contain_volatile_functions(node) ||
+		contain_case_test_walker(node, NULL) ||
+		contain_bool_clause_walker(node, NULL))
+		return;
+
+	forboth (lc1, context->cse_exprs,
+			 lc2, context->cse_count)
+	{
+		if (equal(node, lfirst(lc1)))
+		{
+			lfirst_int(lc2)++;
+			return;
+		}
+	}
+	context->cse_exprs = lappend(context->cse_exprs, node);
+	context->cse_count = lappend_int(context->cse_count, 1);
+}
+
+static bool
+codegen_cse_walker(Node *node, codegen_cse_context *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, FuncExpr) ||
+		IsA(node, OpExpr) ||
+		IsA(node, DistinctExpr) ||
+		IsA(node, MinMaxExpr) ||
+		IsA(node, ScalarArrayOpExpr) ||
+		IsA(node, CaseExpr) ||
+		IsA(node, CoalesceExpr))
+	{
+		/* sub-expressions shall be evaluated first */
+		if (expression_tree_walker(node, codegen_cse_walker, context))
+			return true;
+		codegen_cse_track(node, context);
+		return false;
+	}
+	return expression_tree_walker(node, codegen_cse_walker, context);
+}
+
+static bool
+codegen_bool_depth_walker(Node *node, int *depth)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, BoolExpr) &&
+		(((BoolExpr *) node)->boolop == AND_EXPR ||
+		 ((BoolExpr *) node)->boolop == OR_EXPR))
+	{
+		int		curr = depth[0]++;
+		bool	rc;
+
+		depth[1] = Max(depth[1], depth[0]);
+		rc = expression_tree_walker(node, codegen_bool_depth_walker, depth);
+		depth[0] = curr;
+		return rc;
+	}
+	return expression_tree_walker(node, codegen_bool_depth_walker, depth);
+}
+
+char *
+pgstrom_codegen_cse_begin(List *exprs, codegen_context *context)
+{
+	codegen_cse_context	cse_context;
+	StringInfoData	buf;
+	ListCell	   *lc1;
+	ListCell	   *lc2;
+	int				depth[2];
+	int				i;
+
+	Assert(context->cse_exprs == NIL && context->cse_limit == 0);
+
+	memset(&cse_context, 0, sizeof(codegen_cse_context));
+	codegen_cse_walker((Node *) exprs, &cse_context);
+
+	initStringInfo(&buf);
+
+	/*
+	 * temporary variables for short-circuit evaluation. Note that
+	 * pgstrom_codegen_expression() makes an implicit AND clause on
+	 * the list with multiple items.
+	 */
+	depth[0] = depth[1] = 0;
+	foreach (lc1, exprs)
+		codegen_bool_depth_walker((Node *) lfirst(lc1), depth);
+	context->bool_ntemps = depth[1] + (list_length(exprs) > 1 ? 1 : 0);
+	for (i=0; i < context->bool_ntemps; i++)
+		appendStringInfo(
+			&buf,
+			"  pg_bool_t BOOL_%u __attribute__((unused));\n", i);
+
+	forboth (lc1, cse_context.cse_exprs,
+			 lc2, cse_context.cse_count)
+	{
+		Node		   *expr = lfirst(lc1);
+		devtype_info   *dtype;
+		char		   *expr_code;
+
+		if (lfirst_int(lc2) < 2)
+			continue;
+
+		dtype = pgstrom_devtype_lookup_and_track(exprType(expr), context);
+		if (!dtype)
+			elog(ERROR, "codegen: failed to lookup device type: %s",
+				 format_type_be(exprType(expr)));
+		/* sub-expressions in the earlier entries are available */
+		expr_code = pgstrom_codegen_expression(expr, context);
+
+		appendStringInfo(
+			&buf,
+			"  pg_%s_t CSE_%u __attribute__((unused));\n"
+			"  cl_bool CSE_DONE_%u __attribute__((unused)) = false;\n",
+			dtype->type_name,
+			context->cse_limit,
+			context->cse_limit);
+		context->cse_exprs = lappend(context->cse_exprs, expr);
+		context->cse_codes = lappend(context->cse_codes, expr_code);
+		context->cse_limit++;
+	}
+	if (buf.len > 0)
+		appendStringInfoChar(&buf, '\n');
+	return buf.data;
+}
+
+void
+pgstrom_codegen_cse_end(codegen_context *context)
+{
+	context->cse_exprs = NIL;
+	context->cse_codes = NIL;
+	context->cse_limit = 0;
+	context->bool_ntemps = 0;
+}
+
 /*
  * pgstrom_codegen_func_declarations
  */
@@ -2690,6 +3190,165 @@ unable_node:
 	return false;
 }
 
+/*
+ * pgstrom_reorder_device_quals
+ *
+ * It reorders the device qualifiers (implicitly AND'ed) and arguments of
+ * the nested AND/OR clauses, according to the estimated cost and
+ * selectivity, because device code evaluates AND/OR clauses using
+ * short-circuit manner. Cheap and selective qualifiers shall be evaluated
+ * first, so expensive ones (like text LIKE or numeric operations) are
+ * evaluated only towards the rows that passed the earlier qualifiers.
+ * Arguments of AND are sorted by cost / (1 - selectivity), and arguments
+ * of OR are sorted by cost / selectivity, in ascending order.
+ * If PlannerInfo is not available, like GpuPreAgg that is injected on
+ * the plan tree, selectivity is not estimated and only cost is considered.
+ */
+typedef struct
+{
+	Node	   *clause;
+	int			index;		/* original position to keep stable order */
+	double		rank;
+} devqual_rank_item;
+
+static double
+codegen_devfunc_cost(Oid func_oid, Oid func_collid)
+{
+	devfunc_info   *dfunc = pgstrom_devfunc_lookup(func_oid, func_collid);
+	double			cost = 1.0;
+
+	if (!dfunc)
+		return cost;
+	if (dfunc->func_flags & DEVKERNEL_NEEDS_TIMELIB)
+		cost += 4.0;
+	if (dfunc->func_flags & DEVKERNEL_NEEDS_MATHLIB)
+		cost += 4.0;
+	if (dfunc->func_flags & DEVKERNEL_NEEDS_NUMERIC)
+		cost += 8.0;
+	if (dfunc->func_flags & DEVKERNEL_NEEDS_TEXTLIB)
+		cost += 16.0;
+	return cost;
+}
+
+static bool
+codegen_device_cost_walker(Node *node, double *p_cost)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, FuncExpr))
+	{
+		FuncExpr   *func = (FuncExpr *) node;
+
+		*p_cost += codegen_devfunc_cost(func->funcid, func->inputcollid);
+	}
+	else if (IsA(node, OpExpr) || IsA(node, DistinctExpr))
+	{
+		OpExpr	   *op = (OpExpr *) node;
+
+		*p_cost += codegen_devfunc_cost(get_opcode(op->opno),
+										op->inputcollid);
+	}
+	else if (IsA(node, ScalarArrayOpExpr))
+	{
+		ScalarArrayOpExpr *opexpr = (ScalarArrayOpExpr *) node;
+		Node	   *arrayarg = lsecond(opexpr->args);
+		double		nitems = 10.0;	/* default guess */
+
+		if (IsA(arrayarg, Const) && !((Const *) arrayarg)->constisnull)
+		{
+			ArrayType  *array = DatumGetArrayTypeP(((Const *)
+													arrayarg)->constvalue);
+			nitems = ArrayGetNItems(ARR_NDIM(array), ARR_DIMS(array));
+			/* see codegen_scalar_array_op_bsearch */
+			if (nitems >= pgstrom_array_bsearch_threshold)
+				nitems = log2(nitems) + 1.0;
+		}
+		*p_cost += nitems * codegen_devfunc_cost(get_opcode(opexpr->opno),
+												 opexpr->inputcollid);
+	}
+	return expression_tree_walker(node, codegen_device_cost_walker, p_cost);
+}
+
+static int
+devqual_rank_comp(const void *a, const void *b)
+{
+	const devqual_rank_item *item_a = a;
+	const devqual_rank_item *item_b = b;
+
+	if (item_a->rank < item_b->rank)
+		return -1;
+	if (item_a->rank > item_b->rank)
+		return 1;
+	return item_a->index - item_b->index;
+}
+
+static List *
+reorder_device_qual_args(PlannerInfo *root, List *args, bool is_and_clause)
+{
+	devqual_rank_item *items;
+	List	   *result = NIL;
+	ListCell   *lc;
+	int			i, nitems = list_length(args);
+
+	if (nitems < 2)
+		return args;
+
+	items = palloc(sizeof(devqual_rank_item) * nitems);
+	i = 0;
+	foreach (lc, args)
+	{
+		Node	   *clause = lfirst(lc);
+		Selectivity	sel = 0.5;
+		double		cost = 0.0;
+
+		if (root)
+			sel = clause_selectivity(root, clause, 0, JOIN_INNER, NULL);
+
+		codegen_device_cost_walker(clause, &cost);
+		CLAMP_PROBABILITY(sel);
+		items[i].clause = clause;
+		items[i].index = i;
+		if (is_and_clause)
+			items[i].rank = cost / Max(1.0 - sel, 1.0e-6);
+		else
+			items[i].rank = cost / Max(sel, 1.0e-6);
+		i++;
+	}
+	qsort(items, nitems, sizeof(devqual_rank_item), devqual_rank_comp);
+
+	for (i=0; i < nitems; i++)
+		result = lappend(result, items[i].clause);
+	pfree(items);
+
+	return result;
+}
+
+static Node *
+reorder_device_quals_mutator(Node *node, PlannerInfo *root)
+{
+	if (node == NULL)
+		return NULL;
+	if (IsA(node, BoolExpr))
+	{
+		BoolExpr   *b = (BoolExpr *) expression_tree_mutator(node,
+											reorder_device_quals_mutator,
+											root);
+		if (b->boolop == AND_EXPR || b->boolop == OR_EXPR)
+			b->args = reorder_device_qual_args(root, b->args,
+											   b->boolop == AND_EXPR);
+		return (Node *) b;
+	}
+	return expression_tree_mutator(node, reorder_device_quals_mutator, root);
+}
+
+List *
+pgstrom_reorder_device_quals(PlannerInfo *root, List *quals)
+{
+	quals = (List *) reorder_device_quals_mutator((Node *) quals, root);
+
+	return reorder_device_qual_args(root, quals, true);
+}
+
 static void
 codegen_cache_invalidator(Datum arg, int cacheid, uint32 hashvalue)
 {
@@ -2724,4 +3383,17 @@ pgstrom_init_codegen(void)
 										   ALLOCSET_DEFAULT_MAXSIZE);
 	CacheRegisterSyscacheCallback(PROCOID, codegen_cache_invalidator, 0);
 	CacheRegisterSyscacheCallback(TYPEOID, codegen_cache_invalidator, 0);
+
+	/* threshold to use binary search for large constant array */
+	DefineCustomIntVariable("pg_strom.array_bsearch_threshold",
+							"min number of constant array elements to use "
+							"binary search on ScalarArrayOpExpr",
+							NULL,
+							&pgstrom_array_bsearch_threshold,
+							32,
+							2,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
 }
@@ -0,0 +1,752 @@
+/*
+ * cpuvec.c
+ *
+ * Chunk-at-a-time evaluation of device qualifiers on the CPU
+ * ----
+ * Copyright 2011-2016 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2016 (C) The PG-Strom Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "postgres.h"
+#include "access/nbtree.h"
+#include "catalog/pg_type.h"
+#include "executor/executor.h"
+#include "nodes/nodeFuncs.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
+#include "utils/typcache.h"
+#include "pg_strom.h"
+#include <math.h>
+
+static bool		pgstrom_cpuvec_enabled;
+
+/*
+ * cpuvec_node - an element of the qualifier tree to be evaluated on
+ * the selection vector. Each node picks up the rows, from the input
+ * selection vector, on which the expression is TRUE. Because only TRUE
+ * rows survive, composition of AND/OR follows the SQL three-value logic
+ * as long as NOT is not involved; it is evaluated by the executor.
+ */
+#define CPUVEC_AND			1
+#define CPUVEC_OR			2
+#define CPUVEC_COMPARE		3	/* Var <op> Const on fixed-width types */
+#define CPUVEC_NULLTEST		4	/* Var IS [NOT] NULL */
+#define CPUVEC_GENERIC		5	/* evaluated by ExecQual row-by-row */
+
+#define CPUVEC_STRATEGY_NE	(BTMaxStrategyNumber + 1)
+
+typedef struct
+{
+	int			tag;			/* one of CPUVEC_* */
+	List	   *args;			/* sub-nodes of AND/OR */
+	int			colidx;			/* index of cpuvec_column */
+	int			strategy;		/* BT*StrategyNumber, or CPUVEC_STRATEGY_NE */
+	bool		is_null;		/* IS NULL, if NULLTEST */
+	int64		ival;			/* constant, if integer comparison */
+	double		fval;			/* constant, if float comparison */
+	List	   *qual_state;		/* list of ExprState, if GENERIC */
+} cpuvec_node;
+
+/*
+ * cpuvec_column - a column picked up from the chunk; integer types
+ * (including bool, date and timestamp) are expanded to int64, and
+ * floating-point types are expanded to double, so the comparison loops
+ * are simple enough for the compiler to be vectorized.
+ */
+typedef struct
+{
+	AttrNumber	attnum;			/* attribute number on the scan tuple */
+	Oid			atttypid;		/* data type of the column */
+	bool		is_float;		/* true, if fvals[] is used */
+	int64	   *ivals;
+	double	   *fvals;
+	char	   *isnull;
+} cpuvec_column;
+
+struct pgstrom_cpuvec
+{
+	MemoryContext memcxt;		/* memory context of the buffers below */
+	cpuvec_node *root;			/* root node; always CPUVEC_AND */
+	List	   *columns;		/* list of cpuvec_column */
+	AttrNumber	max_attno;		/* largest attribute number referenced */
+	cl_uint		nrooms;			/* capacity of the buffers */
+	char	   *mask;			/* temporary buffer for dense evaluation */
+	/* run-time references */
+	pgstrom_data_store *pds;
+	TupleTableSlot *slot;
+	ExprContext *econtext;
+};
+
+/*
+ * cpuvec_column_lookup - returns index of the column, or -1 if not
+ * supported.
+ */
+static int
+cpuvec_column_lookup(pgstrom_cpuvec *cvec, Var *var, bool null_only)
+{
+	cpuvec_column *column;
+	ListCell   *lc;
+	int			index = 0;
+
+	if (var->varno == INNER_VAR ||
+		var->varno == OUTER_VAR ||
+		var->varattno <= 0 ||
+		var->varlevelsup > 0)
+		return -1;
+
+	if (!null_only)
+	{
+		switch (var->vartype)
+		{
+			case BOOLOID:
+			case INT2OID:
+			case INT4OID:
+			case INT8OID:
+			case FLOAT4OID:
+			case FLOAT8OID:
+			case DATEOID:
+			case TIMESTAMPOID:
+			case TIMESTAMPTZOID:
+				break;
+			default:
+				return -1;
+		}
+	}
+
+	foreach (lc, cvec->columns)
+	{
+		column = lfirst(lc);
+		if (column->attnum == var->varattno)
+			return index;
+		index++;
+	}
+	column = palloc0(sizeof(cpuvec_column));
+	column->attnum = var->varattno;
+	column->atttypid = var->vartype;
+	column->is_float = (var->vartype == FLOAT4OID ||
+						var->vartype == FLOAT8OID);
+	cvec->columns = lappend(cvec->columns, column);
+	cvec->max_attno = Max(cvec->max_attno, var->varattno);
+
+	return index;
+}
+
+/*
+ * cpuvec_datum_to_int64 / cpuvec_datum_to_double
+ */
+static inline int64
+cpuvec_datum_to_int64(Datum datum, Oid type_oid)
+{
+	switch (type_oid)
+	{
+		case BOOLOID:
+			return (int64) DatumGetBool(datum);
+		case INT2OID:
+			return (int64) DatumGetInt16(datum);
+		case INT4OID:
+		case DATEOID:
+			return (int64) DatumGetInt32(datum);
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return DatumGetInt64(datum);
+		default:
+			break;
+	}
+	return 0;
+}
+
+static inline double
+cpuvec_datum_to_double(Datum datum, Oid type_oid)
+{
+	if (type_oid == FLOAT4OID)
+		return (double) DatumGetFloat4(datum);
+	return DatumGetFloat8(datum);
+}
+
+/*
+ * cpuvec_build_compare - construct CPUVEC_COMPARE node, if supported
+ */
+static cpuvec_node *
+cpuvec_build_compare(pgstrom_cpuvec *cvec, OpExpr *op)
+{
+	cpuvec_node	   *cnode;
+	Node		   *larg;
+	Node		   *rarg;
+	Oid				opno = op->opno;
+	Var			   *var;
+	Const		   *con;
+	TypeCacheEntry *tcache;
+	int				strategy;
+	int				colidx;
+
+	if (list_length(op->args) != 2)
+		return NULL;
+	larg = linitial(op->args);
+	rarg = lsecond(op->args);
+	while (IsA(larg, RelabelType))
+		larg = (Node *)((RelabelType *) larg)->arg;
+	while (IsA(rarg, RelabelType))
+		rarg = (Node *)((RelabelType *) rarg)->arg;
+
+	if (IsA(larg, Var) && IsA(rarg, Const))
+	{
+		var = (Var *) larg;
+		con = (Const *) rarg;
+	}
+	else if (IsA(larg, Const) && IsA(rarg, Var))
+	{
+		/* Const <op> Var is commuted to Var <op'> Const */
+		var = (Var *) rarg;
+		con = (Const *) larg;
+		opno = get_commutator(opno);
+		if (!OidIsValid(opno))
+			return NULL;
+	}
+	else
+		return NULL;
+
+	/* strict operator never returns TRUE on NULL */
+	if (con->constisnull || var->vartype != con->consttype)
+		return NULL;
+
+	tcache = lookup_type_cache(var->vartype,
+							   TYPECACHE_EQ_OPR | TYPECACHE_BTREE_OPFAMILY);
+	if (!OidIsValid(tcache->btree_opf))
+		return NULL;
+	strategy = get_op_opfamily_strategy(opno, tcache->btree_opf);
+	if (strategy == 0)
+	{
+		if (!OidIsValid(tcache->eq_opr) ||
+			get_negator(tcache->eq_opr) != opno)
+			return NULL;
+		strategy = CPUVEC_STRATEGY_NE;
+	}
+
+	colidx = cpuvec_column_lookup(cvec, var, false);
+	if (colidx < 0)
+		return NULL;
+
+	cnode = palloc0(sizeof(cpuvec_node));
+	cnode->tag = CPUVEC_COMPARE;
+	cnode->colidx = colidx;
+	cnode->strategy = strategy;
+	if (var->vartype == FLOAT4OID || var->vartype == FLOAT8OID)
+	{
+		cnode->fval = cpuvec_datum_to_double(con->constvalue,
+											 con->consttype);
+		/* NaN constant is not worth to handle here */
+		if (isnan(cnode->fval))
+			return NULL;
+	}
+	else
+		cnode->ival = cpuvec_datum_to_int64(con->constvalue,
+											con->consttype);
+	return cnode;
+}
+
+/*
+ * cpuvec_build_node
+ */
+static cpuvec_node *
+cpuvec_build_node(pgstrom_cpuvec *cvec, Expr *expr, PlanState *ps)
+{
+	cpuvec_node *cnode = NULL;
+
+	if (IsA(expr, BoolExpr) &&
+		(((BoolExpr *) expr)->boolop == AND_EXPR ||
+		 ((BoolExpr *) expr)->boolop == OR_EXPR))
+	{
+		BoolExpr   *b = (BoolExpr *) expr;
+		ListCell   *lc;
+
+		cnode = palloc0(sizeof(cpuvec_node));
+		cnode->tag = (b->boolop == AND_EXPR ? CPUVEC_AND : CPUVEC_OR);
+		foreach (lc, b->args)
+			cnode->args = lappend(cnode->args,
+								  cpuvec_build_node(cvec, lfirst(lc), ps));
+		return cnode;
+	}
+	else if (IsA(expr, OpExpr))
+	{
+		cnode = cpuvec_build_compare(cvec, (OpExpr *) expr);
+	}
+	else if (IsA(expr, NullTest) &&
+			 !((NullTest *) expr)->argisrow &&
+			 IsA(((NullTest *) expr)->arg, Var))
+	{
+		NullTest   *nulltest = (NullTest *) expr;
+		int			colidx = cpuvec_column_lookup(cvec,
+												  (Var *) nulltest->arg,
+												  true);
+		if (colidx >= 0)
+		{
+			cnode = palloc0(sizeof(cpuvec_node));
+			cnode->tag = CPUVEC_NULLTEST;
+			cnode->colidx = colidx;
+			cnode->is_null = (nulltest->nulltesttype == IS_NULL);
+		}
+	}
+	else if (IsA(expr, Var) && ((Var *) expr)->vartype == BOOLOID)
+	{
+		/* boolean column is equivalent to (column = true) */
+		int		colidx = cpuvec_column_lookup(cvec, (Var *) expr, false);
+
+		if (colidx >= 0)
+		{
+			cnode = palloc0(sizeof(cpuvec_node));
+			cnode->tag = CPUVEC_COMPARE;
+			cnode->colidx = colidx;
+			cnode->strategy = BTEqualStrategyNumber;
+			cnode->ival = 1;
+		}
+	}
+
+	if (!cnode)
+	{
+		cnode = palloc0(sizeof(cpuvec_node));
+		cnode->tag = CPUVEC_GENERIC;
+		cnode->qual_state = list_make1(ExecInitExpr(expr, ps));
+	}
+	return cnode;
+}
+
+/*
+ * pgstrom_cpuvec_create_quals
+ *
+ * It constructs a qualifier tree for chunk-at-a-time evaluation. NULL is
+ * returned if no portion of the qualifiers can be evaluated column-wise;
+ * row-by-row evaluation is not slower than this in that case.
+ */
+pgstrom_cpuvec *
+pgstrom_cpuvec_create_quals(List *quals, PlanState *ps)
+{
+	pgstrom_cpuvec *cvec;
+	cpuvec_node	   *root;
+	ListCell	   *lc;
+
+	if (!pgstrom_cpuvec_enabled || quals == NIL)
+		return NULL;
+
+	cvec = palloc0(sizeof(pgstrom_cpuvec));
+	cvec->memcxt = CurrentMemoryContext;
+
+	root = palloc0(sizeof(cpuvec_node));
+	root->tag = CPUVEC_AND;
+	foreach (lc, quals)
+		root->args = lappend(root->args,
+							 cpuvec_build_node(cvec, lfirst(lc), ps));
+	cvec->root = root;
+
+	if (cvec->columns == NIL)
+	{
+		pfree(cvec);
+		return NULL;
+	}
+	return cvec;
+}
+
+/*
+ * cpuvec_load_columns - picks up the referenced columns from the chunk
+ */
+static void
+cpuvec_load_columns(pgstrom_cpuvec *cvec)
+{
+	kern_data_store *kds = cvec->pds->kds;
+	cl_uint		nitems = kds->nitems;
+	ListCell   *lc;
+	cl_uint		i;
+
+	/* expand the buffers on demand */
+	if (cvec->nrooms < nitems)
+	{
+		cl_uint		nrooms = Max(nitems, 2 * cvec->nrooms);
+
+		foreach (lc, cvec->columns)
+		{
+			cpuvec_column  *column = lfirst(lc);
+
+			if (column->isnull)
+				pfree(column->isnull);
+			if (column->ivals)
+				pfree(column->ivals);
+			if (column->fvals)
+				pfree(column->fvals);
+			column->isnull = MemoryContextAlloc(cvec->memcxt,
+												sizeof(char) * nrooms);
+			if (column->is_float)
+				column->fvals = MemoryContextAlloc(cvec->memcxt,
+												   sizeof(double) * nrooms);
+			else
+				column->ivals = MemoryContextAlloc(cvec->memcxt,
+												   sizeof(int64) * nrooms);
+		}
+		if (cvec->mask)
+			pfree(cvec->mask);
+		cvec->mask = MemoryContextAlloc(cvec->memcxt, sizeof(char) * nrooms);
+		cvec->nrooms = nrooms;
+	}
+
+	if (kds->format == KDS_FORMAT_SLOT)
+	{
+		/* values/isnull array are already deformed; column-by-column */
+		foreach (lc, cvec->columns)
+		{
+			cpuvec_column  *column = lfirst(lc);
+			int				j = column->attnum - 1;
+
+			for (i=0; i < nitems; i++)
+			{
+				Datum  *values = KERN_DATA_STORE_VALUES(kds, i);
+				char   *isnull = KERN_DATA_STORE_ISNULL(kds, i);
+
+				column->isnull[i] = isnull[j];
+				if (column->is_float)
+					column->fvals[i] = (isnull[j] ? 0.0 :
+						cpuvec_datum_to_double(values[j], column->atttypid));
+				else if (column->ivals)
+					column->ivals[i] = (isnull[j] ? 0 :
+						cpuvec_datum_to_int64(values[j], column->atttypid));
+			}
+		}
+	}
+	else if (kds->format == KDS_FORMAT_ROW)
+	{
+		TupleTableSlot *slot = cvec->slot;
+		HeapTupleData	tuple;
+
+		/* tuples have to be deformed once, then transposed */
+		for (i=0; i < nitems; i++)
+		{
+			if (!pgstrom_fetch_data_store(slot, cvec->pds, i, &tuple))
+				elog(ERROR, "failed to fetch a record from pds");
+			slot_getsomeattrs(slot, cvec->max_attno);
+
+			foreach (lc, cvec->columns)
+			{
+				cpuvec_column  *column = lfirst(lc);
+				int				j = column->attnum - 1;
+				bool			isnull = slot->tts_isnull[j];
+
+				column->isnull[i] = isnull;
+				if (column->is_float)
+					column->fvals[i] = (isnull ? 0.0 :
+						cpuvec_datum_to_double(slot->tts_values[j],
+											   column->atttypid));
+				else
+					column->ivals[i] = (isnull ? 0 :
+						cpuvec_datum_to_int64(slot->tts_values[j],
+											  column->atttypid));
+			}
+		}
+		ExecClearTuple(slot);
+	}
+	else
+		elog(ERROR, "Bug? unexpected data-store format: %d", kds->format);
+}
+
+/*
+ * CPUVEC_FILTER_LOOP
+ *
+ * If the input selection vector contains all the rows, condition is
+ * evaluated densely on the mask buffer first, then compacted to the
+ * output selection vector. Both loops are branch-free, so compiler can
+ * vectorize them. Elsewhere, only the selected rows are evaluated.
+ * The output selection vector may be identical to the input one.
+ */
+#define CPUVEC_FILTER_LOOP(COND)								\
+	do {														\
+		if (nin == nitems)										\
+		{														\
+			for (i=0; i < nitems; i++)							\
+				mask[i] = (COND);								\
+			for (i=0, nout=0; i < nitems; i++)					\
+			{													\
+				sel_out[nout] = i;								\
+				nout += mask[i];								\
+			}													\
+		}														\
+		else													\
+		{														\
+			for (k=0, nout=0; k < nin; k++)						\
+			{													\
+				i = sel_in[k];									\
+				sel_out[nout] = i;								\
+				nout += (COND);									\
+			}													\
+		}														\
+	} while(0)
+
+static cl_uint
+cpuvec_filter_compare(pgstrom_cpuvec *cvec, cpuvec_node *cnode,
+					  cl_uint *sel_in, cl_uint nin, cl_uint *sel_out)
+{
+	cpuvec_column *column = list_nth(cvec->columns, cnode->colidx);
+	cl_uint		nitems = cvec->pds->kds->nitems;
+	char	   *mask = cvec->mask;
+	char	   *isnull = column->isnull;
+	cl_uint		i, k, nout;
+
+	if (!column->is_float)
+	{
+		int64  *X = column->ivals;
+		int64	C = cnode->ival;
+
+		switch (cnode->strategy)
+		{
+			case BTLessStrategyNumber:
+				CPUVEC_FILTER_LOOP(!isnull[i] & (X[i] < C));
+				break;
+			case BTLessEqualStrategyNumber:
+				CPUVEC_FILTER_LOOP(!isnull[i] & (X[i] <= C));
+				break;
+			case BTEqualStrategyNumber:
+				CPUVEC_FILTER_LOOP(!isnull[i] & (X[i] == C));
+				break;
+			case BTGreaterEqualStrategyNumber:
+				CPUVEC_FILTER_LOOP(!isnull[i] & (X[i] >= C));
+				break;
+			case BTGreaterStrategyNumber:
+				CPUVEC_FILTER_LOOP(!isnull[i] & (X[i] > C));
+				break;
+			case CPUVEC_STRATEGY_NE:
+				CPUVEC_FILTER_LOOP(!isnull[i] & (X[i] != C));
+				break;
+			default:
+				elog(ERROR, "unexpected strategy number: %d",
+					 cnode->strategy);
+		}
+	}
+	else
+	{
+		double *X = column->fvals;
+		double	C = cnode->fval;
+
+		/*
+		 * NaN is larger than any other values in PostgreSQL, unlike
+		 * IEEE754 comparison. Note that C is never NaN here.
+		 */
+		switch (cnode->strategy)
+		{
+			case BTLessStrategyNumber:
+				CPUVEC_FILTER_LOOP(!isnull[i] & (X[i] < C));
+				break;
+			case BTLessEqualStrategyNumber:
+				CPUVEC_FILTER_LOOP(!isnull[i] & (X[i] <= C));
+				break;
+			case BTEqualStrategyNumber:
+				CPUVEC_FILTER_LOOP(!isnull[i] & (X[i] == C));
+				break;
+			case BTGreaterEqualStrategyNumber:
+				CPUVEC_FILTER_LOOP(!isnull[i] & ((X[i] >= C) |
+												 (X[i] != X[i])));
+				break;
+			case BTGreaterStrategyNumber:
+				CPUVEC_FILTER_LOOP(!isnull[i] & ((X[i] > C) |
+												 (X[i] != X[i])));
+				break;
+			case CPUVEC_STRATEGY_NE:
+				CPUVEC_FILTER_LOOP(!isnull[i] & (X[i] != C));
+				break;
+			default:
+				elog(ERROR, "unexpected strategy number: %d",
+					 cnode->strategy);
+		}
+	}
+	return nout;
+}
+
+static cl_uint cpuvec_filter_node(pgstrom_cpuvec *cvec, cpuvec_node *cnode,
+								  cl_uint *sel_in, cl_uint nin,
+								  cl_uint *sel_out);
+
+static cl_uint
+cpuvec_filter_or(pgstrom_cpuvec *cvec, cpuvec_node *cnode,
+				 cl_uint *sel_in, cl_uint nin, cl_uint *sel_out)
+{
+	cl_uint		nitems = cvec->pds->kds->nitems;
+	cl_uint	   *remain = palloc(sizeof(cl_uint) * nin);
+	cl_uint	   *temp = palloc(sizeof(cl_uint) * nin);
+	char	   *passed = palloc0(sizeof(char) * nitems);
+	cl_uint		nremain = nin;
+	cl_uint		ntemp;
+	cl_uint		i, j, k, nout;
+	ListCell   *lc;
+
+	memcpy(remain, sel_in, sizeof(cl_uint) * nin);
+	foreach (lc, cnode->args)
+	{
+		ntemp = cpuvec_filter_node(cvec, lfirst(lc), remain, nremain, temp);
+		for (k=0; k < ntemp; k++)
+			passed[temp[k]] = 1;
+		/* rows already TRUE are not evaluated any more */
+		for (k=0, j=0, i=0; k < nremain; k++)
+		{
+			if (j < ntemp && temp[j] == remain[k])
+				j++;
+			else
+				remain[i++] = remain[k];
+		}
+		nremain = i;
+		if (nremain == 0)
+			break;
+	}
+	for (k=0, nout=0; k < nin; k++)
+	{
+		i = sel_in[k];
+		sel_out[nout] = i;
+		nout += passed[i];
+	}
+	pfree(remain);
+	pfree(temp);
+	pfree(passed);
+
+	return nout;
+}
+
+static cl_uint
+cpuvec_filter_generic(pgstrom_cpuvec *cvec, cpuvec_node *cnode,
+					  cl_uint *sel_in, cl_uint nin, cl_uint *sel_out)
+{
+	ExprContext	   *econtext = cvec->econtext;
+	TupleTableSlot *slot = cvec->slot;
+	HeapTupleData	tuple;
+	cl_uint			i, k, nout;
+
+	for (k=0, nout=0; k < nin; k++)
+	{
+		i = sel_in[k];
+		if (!pgstrom_fetch_data_store(slot, cvec->pds, i, &tuple))
+			elog(ERROR, "failed to fetch a record from pds");
+		ResetExprContext(econtext);
+		econtext->ecxt_scantuple = slot;
+		if (ExecQual(cnode->qual_state, econtext, false))
+			sel_out[nout++] = i;
+	}
+	ExecClearTuple(slot);
+
+	return nout;
+}
+
+static cl_uint
+cpuvec_filter_node(pgstrom_cpuvec *cvec, cpuvec_node *cnode,
+				   cl_uint *sel_in, cl_uint nin, cl_uint *sel_out)
+{
+	cl_uint		nitems = cvec->pds->kds->nitems;
+	cl_uint		nout;
+	cl_uint		i, k;
+	ListCell   *lc;
+
+	if (nin == 0)
+		return 0;
+
+	switch (cnode->tag)
+	{
+		case CPUVEC_AND:
+			/* each argument narrows the selection vector */
+			if (sel_out != sel_in)
+				memcpy(sel_out, sel_in, sizeof(cl_uint) * nin);
+			nout = nin;
+			foreach (lc, cnode->args)
+			{
+				nout = cpuvec_filter_node(cvec, lfirst(lc),
+										  sel_out, nout, sel_out);
+				if (nout == 0)
+					break;
+			}
+			break;
+
+		case CPUVEC_OR:
+			nout = cpuvec_filter_or(cvec, cnode, sel_in, nin, sel_out);
+			break;
+
+		case CPUVEC_COMPARE:
+			nout = cpuvec_filter_compare(cvec, cnode, sel_in, nin, sel_out);
+			break;
+
+		case CPUVEC_NULLTEST:
+			{
+				cpuvec_column *column = list_nth(cvec->columns,
+												 cnode->colidx);
+				char	   *mask = cvec->mask;
+				char	   *isnull = column->isnull;
+
+				if (cnode->is_null)
+					CPUVEC_FILTER_LOOP(isnull[i] != 0);
+				else
+					CPUVEC_FILTER_LOOP(isnull[i] == 0);
+			}
+			break;
+
+		case CPUVEC_GENERIC:
+			nout = cpuvec_filter_generic(cvec, cnode, sel_in, nin, sel_out);
+			break;
+
+		default:
+			elog(ERROR, "unexpected cpuvec node tag: %d", cnode->tag);
+	}
+	return nout;
+}
+
+/*
+ * pgstrom_cpuvec_exec_quals
+ *
+ * It evaluates the qualifiers on the whole chunk, then returns number of
+ * the rows that satisfied the qualifiers. Index of the rows are set on
+ * the row_sel[], which must have kds->nitems entries at least.
+ * The slot is used to fetch rows of the chunk, for the portion to be
+ * evaluated by the executor.
+ */
+cl_uint
+pgstrom_cpuvec_exec_quals(pgstrom_cpuvec *cvec,
+						  pgstrom_data_store *pds,
+						  TupleTableSlot *slot,
+						  ExprContext *econtext,
+						  cl_uint *row_sel)
+{
+	cl_uint		nitems = pds->kds->nitems;
+	cl_uint		i, nout;
+
+	if (nitems == 0)
+		return 0;
+
+	cvec->pds = pds;
+	cvec->slot = slot;
+	cvec->econtext = econtext;
+
+	cpuvec_load_columns(cvec);
+	for (i=0; i < nitems; i++)
+		row_sel[i] = i;
+	nout = cpuvec_filter_node(cvec, cvec->root, row_sel, nitems, row_sel);
+
+	cvec->pds = NULL;
+	cvec->slot = NULL;
+	cvec->econtext = NULL;
+
+	return nout;
+}
+
+/*
+ * pgstrom_init_cpuvec
+ */
+void
+pgstrom_init_cpuvec(void)
+{
+	/* pg_strom.enable_cpuvec */
+	DefineCustomBoolVariable("pg_strom.enable_cpuvec",
+							 "Enables chunk-at-a-time evaluation on CPU fallback",
+							 NULL,
+							 &pgstrom_cpuvec_enabled,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+}
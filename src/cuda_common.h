@@ -254,6 +254,7 @@ typedef uintptr_t		hostptr_t;
 #define StromKernel_gpupreagg_final_preparation		0x0305
 #define StromKernel_gpupreagg_final_reduction		0x0306
 #define StromKernel_gpupreagg_fixup_varlena			0x0307
+#define StromKernel_gpupreagg_final_expand			0x0308
 #define StromKernel_gpupreagg_main					0x0399
 #define StromKernel_gpusort_projection				0x0401
 #define StromKernel_gpusort_bitonic_local			0x0402
@@ -659,10 +660,24 @@ typedef struct
 	cl_uint				hash;	/* 32-bit hash value */
 	cl_uint				next;	/* offset of the next */
 	cl_uint				rowid;	/* unique identifier of this hash entry */
-	cl_uint				__padding__; /* for alignment */
+	cl_uint				skewed;	/* non-zero, if heavy-hitter of GpuJoin */
 	kern_tupitem		t;		/* HeapTuple of this entry */
 } kern_hashitem;
 
+/*
+ * kern_hashentry - dense index of the hash items for KDS_FORMAT_HASH
+ *
+ * Entries are grouped by the hash slot, and hash_bucket[] of the slot
+ * points the first entry. Both arrays follow the hash_slot[] array. Probe can check the hash value and the visibility
+ * with contiguous memory access, then touch the kern_hashitem only if
+ * these are matched.
+ */
+typedef struct
+{
+	cl_uint				hash;	/* 32-bit hash value */
+	cl_uint				rowid;	/* rowid of the kern_hashitem */
+} kern_hashentry;
+
 #define KDS_FORMAT_ROW			1
 #define KDS_FORMAT_SLOT			2
 #define KDS_FORMAT_HASH			3	/* inner hash table for GpuHashJoin */
@@ -703,7 +718,9 @@ typedef struct {
 #define KDS_CALCULATE_ROW_FRONTLEN(ncols,nitems)	\
 	KDS_CALCULATE_FRONTEND_LENGTH((ncols),0,(nitems))
 #define KDS_CALCULATE_HASH_FRONTLEN(ncols,nitems)	\
-	KDS_CALCULATE_FRONTEND_LENGTH((ncols),__KDS_NSLOTS(nitems),(nitems))
+	(KDS_CALCULATE_FRONTEND_LENGTH((ncols),__KDS_NSLOTS(nitems),(nitems)) + \
+	 STROMALIGN(sizeof(cl_uint) * (__KDS_NSLOTS(nitems) + 1)) +	\
+	 STROMALIGN(sizeof(kern_hashentry) * (nitems)))
 #define KDS_CALCULATE_ROW_LENGTH(ncols,nitems,data_len)		\
 	(KDS_CALCULATE_ROW_FRONTLEN((ncols),(nitems)) + STROMALIGN(data_len))
 #define KDS_CALCULATE_HASH_LENGTH(ncols,nitems,data_len)	\
@@ -723,6 +740,10 @@ typedef struct {
 	 STROMALIGN(sizeof(cl_uint) * (nitems)) +				\
 	 STROMALIGN(sizeof(cl_uint) * __KDS_NSLOTS((nitems) + 1)) -	\
 	 STROMALIGN(sizeof(cl_uint) * __KDS_NSLOTS(nitems)) +	\
+	 STROMALIGN(sizeof(cl_uint) * (__KDS_NSLOTS((nitems) + 1) + 1)) -	\
+	 STROMALIGN(sizeof(cl_uint) * (__KDS_NSLOTS(nitems) + 1)) +	\
+	 STROMALIGN(sizeof(kern_hashentry) * ((nitems) + 1)) -	\
+	 STROMALIGN(sizeof(kern_hashentry) * (nitems)) +		\
 	 MAXALIGN(consumption))
 
 /* length of kern_data_store */
@@ -745,6 +766,15 @@ typedef struct {
 	((cl_uint *)(KERN_DATA_STORE_BODY(kds) +		\
 				 STROMALIGN(sizeof(cl_uint) * (kds)->nitems)))
 
+/* access macro for hash-format; valid after the hash table build */
+#define KERN_DATA_STORE_HASHBUCKET(kds)				\
+	((cl_uint *)((char *)KERN_DATA_STORE_HASHSLOT(kds) +	\
+				 STROMALIGN(sizeof(cl_uint) * (kds)->nslots)))
+
+#define KERN_DATA_STORE_HASHENTRY(kds)				\
+	((kern_hashentry *)((char *)KERN_DATA_STORE_HASHBUCKET(kds) +	\
+						STROMALIGN(sizeof(cl_uint) * ((kds)->nslots + 1))))
+
 /* access macro for row- and hash-format */
 #define KERN_DATA_STORE_TUPITEM(kds,kds_index)		\
 	((kern_tupitem *)((char *)(kds) +				\
@@ -865,6 +895,77 @@ typedef struct {
 #define KERN_GET_RESULT(kresults, index)		\
 	((kresults)->results + (kresults)->nrels * (index))
 
+/*
+ * Multiply-xorshift hash - a faster alternative of the legacy CRC32 to
+ * calculate hash value of join/group keys. It has no table lookup, and
+ * consumes 4 bytes at once. Both of host and device code use the routines
+ * below, so hash values are bit-identical regardless of the processor.
+ * Bytes are assembled in little-endian order explicitly, not to depend on
+ * the alignment and endian of the key.
+ */
+#define HASHFUNC_LEGACY_CRC32		0
+#define HASHFUNC_FASTHASH			1
+
+#define INIT_FAST_HASH(hash)		((hash) = 0x9e3779b9U)
+#define FIN_FAST_HASH(hash)			((hash) = pg_common_fin_fasthash(hash))
+
+STATIC_INLINE(cl_uint)
+pg_common_mix_fasthash(cl_uint hash, cl_uint k)
+{
+	k *= 0xcc9e2d51U;
+	k = (k << 15) | (k >> 17);
+	k *= 0x1b873593U;
+	hash ^= k;
+	hash = (hash << 13) | (hash >> 19);
+	return hash * 5 + 0xe6546b64U;
+}
+
+STATIC_INLINE(cl_uint)
+pg_common_comp_fasthash(cl_uint hash, const char *__data, cl_uint __len)
+{
+	const cl_uchar *d = (const cl_uchar *)__data;
+	cl_uint		k;
+
+	hash ^= __len;
+	while (__len >= sizeof(cl_uint))
+	{
+		k = ((cl_uint)d[0]         | ((cl_uint)d[1] <<  8) |
+			 ((cl_uint)d[2] << 16) | ((cl_uint)d[3] << 24));
+		hash = pg_common_mix_fasthash(hash, k);
+		d += sizeof(cl_uint);
+		__len -= sizeof(cl_uint);
+	}
+	if (__len > 0)
+	{
+		k = 0;
+		switch (__len)
+		{
+			case 3:
+				k |= (cl_uint)d[2] << 16;
+				/* fall through */
+			case 2:
+				k |= (cl_uint)d[1] << 8;
+				/* fall through */
+			default:
+				k |= (cl_uint)d[0];
+				break;
+		}
+		hash = pg_common_mix_fasthash(hash, k);
+	}
+	return hash;
+}
+
+STATIC_INLINE(cl_uint)
+pg_common_fin_fasthash(cl_uint hash)
+{
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bU;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35U;
+	hash ^= hash >> 16;
+	return hash;
+}
+
 #ifdef __CUDACC__
 /*
  * PostgreSQL Data Type support in OpenCL kernel
@@ -1130,13 +1231,33 @@ pg_common_comp_crc32(const cl_uint *crc32_table,
 		return hash;											\
 	}
 
+#define STROMCL_SIMPLE_COMP_FASTHASH_TEMPLATE(NAME,BASE)		\
+	STATIC_FUNCTION(cl_uint)									\
+	pg_##NAME##_comp_fasthash(cl_uint hash, pg_##NAME##_t datum)	\
+	{															\
+		if (!datum.isnull)										\
+		{														\
+			union {												\
+				BASE	as_base;								\
+				char	as_char[sizeof(BASE)];					\
+			} __data;											\
+																\
+			__data.as_base = datum.value;						\
+			hash = pg_common_comp_fasthash(hash,				\
+										   __data.as_char,		\
+										   sizeof(BASE));		\
+		}														\
+		return hash;											\
+	}
+
 #define STROMCL_SIMPLE_TYPE_TEMPLATE(NAME,BASE)		\
 	STROMCL_SIMPLE_DATATYPE_TEMPLATE(NAME,BASE)		\
 	STROMCL_SIMPLE_VARREF_TEMPLATE(NAME,BASE)		\
 	STROMCL_SIMPLE_VARSTORE_TEMPLATE(NAME,BASE)		\
 	STROMCL_SIMPLE_PARAMREF_TEMPLATE(NAME,BASE)		\
 	STROMCL_SIMPLE_NULLTEST_TEMPLATE(NAME)			\
-	STROMCL_SIMPLE_COMP_CRC32_TEMPLATE(NAME,BASE)
+	STROMCL_SIMPLE_COMP_CRC32_TEMPLATE(NAME,BASE)	\
+	STROMCL_SIMPLE_COMP_FASTHASH_TEMPLATE(NAME,BASE)
 
 #define STROMCL_INDIRECT_TYPE_TEMPLATE(NAME,BASE)	\
 	STROMCL_SIMPLE_DATATYPE_TEMPLATE(NAME,BASE)		\
@@ -1145,6 +1266,7 @@ pg_common_comp_crc32(const cl_uint *crc32_table,
 	STROMCL_INDIRECT_PARAMREF_TEMPLATE(NAME,BASE)	\
 	STROMCL_SIMPLE_NULLTEST_TEMPLATE(NAME)          \
 	STROMCL_SIMPLE_COMP_CRC32_TEMPLATE(NAME,BASE)	\
+	STROMCL_SIMPLE_COMP_FASTHASH_TEMPLATE(NAME,BASE)	\
 	STATIC_INLINE(Datum)							\
 	pg_##NAME##_to_datum(BASE *p_value)				\
 	{												\
@@ -1666,6 +1788,18 @@ pg_varlena_comp_crc32(const cl_uint *crc32_table,
 	return hash;
 }
 
+STATIC_FUNCTION(cl_uint)
+pg_varlena_comp_fasthash(cl_uint hash, pg_varlena_t datum)
+{
+	if (!datum.isnull)
+	{
+		hash = pg_common_comp_fasthash(hash,
+									   VARDATA_ANY(datum.value),
+									   VARSIZE_ANY_EXHDR(datum.value));
+	}
+	return hash;
+}
+
 #define STROMCL_VARLENA_DATATYPE_TEMPLATE(NAME)				\
 	typedef pg_varlena_t	pg_##NAME##_t;
 
@@ -1718,13 +1852,21 @@ pg_varlena_comp_crc32(const cl_uint *crc32_table,
 		return pg_varlena_comp_crc32(crc32_table, hash, datum);		\
 	}
 
+#define STROMCL_VARLENA_COMP_FASTHASH_TEMPLATE(NAME)				\
+	STATIC_INLINE(cl_uint)											\
+	pg_##NAME##_comp_fasthash(cl_uint hash, pg_##NAME##_t datum)	\
+	{																\
+		return pg_varlena_comp_fasthash(hash, datum);				\
+	}
+
 #define STROMCL_VARLENA_TYPE_TEMPLATE(NAME)			\
 	STROMCL_VARLENA_DATATYPE_TEMPLATE(NAME)			\
 	STROMCL_VARLENA_VARREF_TEMPLATE(NAME)			\
 	STROMCL_VARLENA_VARSTORE_TEMPLATE(NAME)			\
 	STROMCL_VARLENA_PARAMREF_TEMPLATE(NAME)			\
 	STROMCL_VARLENA_NULLTEST_TEMPLATE(NAME)			\
-	STROMCL_VARLENA_COMP_CRC32_TEMPLATE(NAME)
+	STROMCL_VARLENA_COMP_CRC32_TEMPLATE(NAME)		\
+	STROMCL_VARLENA_COMP_FASTHASH_TEMPLATE(NAME)
 
 /* pg_bytea_t */
 #ifndef PG_BYTEA_TYPE_DEFINED
@@ -2257,6 +2399,71 @@ operator || (pg_bool_t arg1, pg_bool_t arg2)
 	return result;
 }
 
+/*
+ * Support routines for short-circuit evaluation of BoolExpr
+ *
+ * The operators above evaluate all the arguments prior to the invocation,
+ * so code generator constructs AND/OR clauses as follows, if temporary
+ * variable (BOOL_%u) is available.
+ *
+ *   (BOOL_0 = pg_bool_and_init(),
+ *    (void)(pg_bool_and_next(&BOOL_0, X) &&
+ *           pg_bool_and_next(&BOOL_0, Y) && ...), BOOL_0)
+ *
+ * pg_bool_(and|or)_next accumulates the argument on the result, then
+ * returns false if the result is already determined, thus, the rest of
+ * arguments are never evaluated.
+ */
+STATIC_INLINE(pg_bool_t)
+pg_bool_and_init(void)
+{
+	pg_bool_t	result;
+
+	result.isnull = false;
+	result.value  = true;
+	return result;
+}
+
+STATIC_INLINE(cl_bool)
+pg_bool_and_next(pg_bool_t *p_result, pg_bool_t arg)
+{
+	if (arg.isnull)
+		p_result->isnull = true;
+	else if (!arg.value)
+	{
+		/* FALSE AND any => FALSE */
+		p_result->isnull = false;
+		p_result->value  = false;
+		return false;
+	}
+	return true;
+}
+
+STATIC_INLINE(pg_bool_t)
+pg_bool_or_init(void)
+{
+	pg_bool_t	result;
+
+	result.isnull = false;
+	result.value  = false;
+	return result;
+}
+
+STATIC_INLINE(cl_bool)
+pg_bool_or_next(pg_bool_t *p_result, pg_bool_t arg)
+{
+	if (arg.isnull)
+		p_result->isnull = true;
+	else if (arg.value)
+	{
+		/* TRUE OR any => TRUE */
+		p_result->isnull = false;
+		p_result->value  = true;
+		return false;
+	}
+	return true;
+}
+
 /*
  * macros for general binary compare functions
  */
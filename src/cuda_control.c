@@ -2492,6 +2492,7 @@ errorTextKernel(kern_errorbuf *kerror)
 		KERN_ENTRY(gpupreagg_final_preparation);
 		KERN_ENTRY(gpupreagg_final_reduction);
 		KERN_ENTRY(gpupreagg_fixup_varlena);
+		KERN_ENTRY(gpupreagg_final_expand);
 		KERN_ENTRY(gpupreagg_main);
 		KERN_ENTRY(gpusort_projection);
 		KERN_ENTRY(gpusort_bitonic_local);
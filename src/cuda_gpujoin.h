@@ -32,10 +32,15 @@ typedef struct
 	{
 		cl_uint		chunk_offset;	/* offset to KDS or Hash */
 		cl_uint		ojmap_offset;	/* offset to outer-join map, if any */
+		cl_uint		bloom_offset;	/* offset to bloom filter, if any */
+		cl_uint		bloom_mask;		/* number of bloom filter bits - 1 */
+		cl_uint		skew_offset;	/* offset to heavy-hitter keys, if any */
 		cl_bool		is_nestloop;	/* true, if NestLoop. */
-		cl_bool		left_outer;		/* true, if JOIN_LEFT or JOIN_FULL */
+		cl_bool		left_outer;		/* true, if JOIN_LEFT, JOIN_FULL or
+									 * JOIN_ANTI */
 		cl_bool		right_outer;	/* true, if JOIN_RIGHT or JOIN_FULL */
-		cl_char		__padding__[1];
+		cl_bool		single_match;	/* true, if JOIN_SEMI or JOIN_ANTI */
+		cl_char		__padding__[3];
 	} chunks[FLEXIBLE_ARRAY_MEMBER];
 } kern_multirels;
 
@@ -55,6 +60,118 @@ typedef struct
 #define KERN_MULTIRELS_RIGHT_OUTER_JOIN(kmrels, depth)	\
 	((kmrels)->chunks[(depth)-1].right_outer)
 
+#define KERN_MULTIRELS_SINGLE_MATCH(kmrels, depth)		\
+	((kmrels)->chunks[(depth)-1].single_match)
+
+#define KERN_MULTIRELS_BLOOM_FILTER(kmrels, depth)				\
+	((cl_uint *)((kmrels)->chunks[(depth)-1].bloom_offset == 0	\
+				 ? NULL											\
+				 : ((char *)(kmrels) +							\
+					(kmrels)->chunks[(depth)-1].bloom_offset)))
+
+/*
+ * Per-thread dynamic shared memory for the skewed item processing. It is
+ * located next to the work area of pgstromStairlikeSum, and only allocated
+ * when the depth has kern_hashskew.
+ */
+#define GPUJOIN_HASHSKEW_SHMEM_PER_THREAD				\
+	(sizeof(cl_uint) + sizeof(cl_int) + sizeof(cl_bool))
+
+#define KERN_MULTIRELS_HASH_SKEW(kmrels, depth)					\
+	((kern_hashskew *)((kmrels)->chunks[(depth)-1].skew_offset == 0	\
+					   ? NULL										\
+					   : ((char *)(kmrels) +						\
+						  (kmrels)->chunks[(depth)-1].skew_offset)))
+
+/*
+ * Heavy-hitter keys of the inner hash table
+ *
+ * Inner rows of the heavy-hitter hash values are marked as 'skewed', and
+ * moved to the tail of the hash chain. Outer rows with these hash values
+ * don't walk on the long hash chain by itself; all the threads in a block
+ * cooperatively join them with the dense array of the skewed items, to
+ * avoid a few threads (and the warps) dominating the runtime.
+ */
+typedef struct
+{
+	cl_uint		hash;		/* hash value of the heavy-hitter */
+	cl_uint		nitems;		/* number of inner rows with this hash */
+	cl_uint		start;		/* first index on the item array */
+} kern_skewkey;
+
+typedef struct
+{
+	cl_uint		nkeys;		/* number of heavy-hitter keys */
+	cl_uint		nitems;		/* number of skewed inner rows */
+	kern_skewkey keys[FLEXIBLE_ARRAY_MEMBER];	/* sorted by hash */
+	/* followed by offset of the kern_hashitems from the KDS */
+} kern_hashskew;
+
+#define KERN_HASHSKEW_ITEMS(skew)				\
+	((cl_uint *)&(skew)->keys[(skew)->nkeys])
+#define KERN_HASHSKEW_LENGTH(nkeys,nitems)		\
+	STROMALIGN(offsetof(kern_hashskew, keys[(nkeys)]) +	\
+			   sizeof(cl_uint) * (nitems))
+
+STATIC_INLINE(cl_int)
+gpujoin_hashskew_lookup(kern_hashskew *skew, cl_uint hash)
+{
+	cl_int		lo = 0;
+	cl_int		hi = (cl_int)skew->nkeys - 1;
+
+	while (lo <= hi)
+	{
+		cl_int	mid = (lo + hi) / 2;
+
+		if (skew->keys[mid].hash == hash)
+			return mid;
+		else if (skew->keys[mid].hash < hash)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+	return -1;
+}
+
+/*
+ * Bloom filter on the hash value of inner join keys
+ *
+ * It is built on the host side once inner hash table gets loaded, then
+ * outer rows which obviously have no matched inner rows are filtered out
+ * prior to the hash-table probe. Bit positions are derived from the hash
+ * value of the join keys using double hashing.
+ */
+#define GPUJOIN_BLOOM_NHASHES		3
+
+STATIC_INLINE(void)
+gpujoin_bloom_filter_set(cl_uint *bloom, cl_uint bloom_mask, cl_uint hash)
+{
+	cl_uint		delta = ((hash >> 17) | (hash << 15)) | 1U;
+	cl_uint		i, bit;
+
+	for (i=0; i < GPUJOIN_BLOOM_NHASHES; i++)
+	{
+		bit = (hash + i * delta) & bloom_mask;
+		bloom[bit / 32] |= (1U << (bit % 32));
+	}
+}
+
+STATIC_INLINE(cl_bool)
+gpujoin_bloom_filter_test(const cl_uint *bloom, cl_uint bloom_mask,
+						  cl_uint hash)
+{
+	cl_uint		delta = ((hash >> 17) | (hash << 15)) | 1U;
+	cl_uint		i, bit;
+
+	for (i=0; i < GPUJOIN_BLOOM_NHASHES; i++)
+	{
+		bit = (hash + i * delta) & bloom_mask;
+		if ((bloom[bit / 32] & (1U << (bit % 32))) == 0)
+			return false;
+	}
+	return true;
+}
+
 /*
  * kern_gpujoin - control object of GpuJoin
  */
@@ -73,6 +190,8 @@ typedef struct
 	cl_uint		window_size_saved;	/* internal: last value of 'window_size' */
 	cl_uint		inner_nitems_stage;	/* internal: # of inner join results */
 	cl_uint		right_nitems_stage;	/* internal: # of right join results */
+	cl_uint		nitems_required;	/* in/out: # of join results actually
+									 * required, reported by count phase */
 } kern_join_scale;
 
 typedef struct
@@ -83,6 +202,8 @@ typedef struct
 	cl_uint			kresults_max_items;	/* max items kresult_buf can hold */
 	/* number of inner relations */
 	cl_uint			num_rels;
+	/* remaining count phase; returns immediately on overflow if non-zero */
+	cl_uint			count_retry;
 	/* error status to be backed (OUT) */
 	kern_errorbuf	kerror;
 	/* performance profiler */
@@ -209,7 +330,8 @@ typedef struct
  * gpujoin_exec_outerscan
  *
  * Evaluation of outer-relation's qualifier, if any. Elsewhere, it always
- * returns true.
+ * returns true. Outer rows are also filtered by the bloom filter of the
+ * inner join keys, if any.
  */
 STATIC_FUNCTION(cl_bool)
 gpujoin_outer_quals(kern_context *kcxt,
@@ -219,6 +341,7 @@ gpujoin_outer_quals(kern_context *kcxt,
 KERNEL_FUNCTION(void)
 gpujoin_exec_outerscan(kern_gpujoin *kgjoin,
 					   kern_data_store *kds,
+					   kern_multirels *kmrels,
 					   kern_resultbuf *kresults)
 {
 	kern_parambuf  *kparams = KERN_GPUJOIN_PARAMBUF(kgjoin);
@@ -228,6 +351,7 @@ gpujoin_exec_outerscan(kern_gpujoin *kgjoin,
 	cl_uint			kds_index = window_base + get_global_id();
 	cl_uint			count;
 	cl_uint			offset;
+	cl_int			depth;
 	cl_bool			matched;
 	__shared__ cl_int base;
 
@@ -239,6 +363,32 @@ gpujoin_exec_outerscan(kern_gpujoin *kgjoin,
 	else
 		matched = false;
 
+	for (depth=1; matched && depth <= kgjoin->num_rels; depth++)
+	{
+		cl_uint	   *bloom = KERN_MULTIRELS_BLOOM_FILTER(kmrels, depth);
+		cl_uint		o_buffer[1];
+		cl_uint		hash_value;
+		cl_bool		is_null_keys;
+
+		if (!bloom)
+			continue;
+		/* NOTE: bloom filter is set only if join keys are outer columns */
+		o_buffer[0] = ((size_t)kern_get_tuple_row(kds, kds_index) -
+					   (size_t)kds);
+		hash_value = gpujoin_hash_value(&kcxt,
+										kmrels->pg_crc32_table,
+										kds,
+										kmrels,
+										depth,
+										o_buffer,
+										&is_null_keys);
+		if (is_null_keys ||
+			!gpujoin_bloom_filter_test(bloom,
+									   kmrels->chunks[depth-1].bloom_mask,
+									   hash_value))
+			matched = false;
+	}
+
 	/* expand kresults->nitems */
 	offset = pgstromStairlikeSum(matched ? 1 : 0, &count);
 	if (count > 0)
@@ -383,8 +533,13 @@ gpujoin_exec_hashjoin(kern_gpujoin *kgjoin,
 {
 	kern_parambuf	   *kparams = KERN_GPUJOIN_PARAMBUF(kgjoin);
 	kern_data_store	   *kds_hash = KERN_MULTIRELS_INNER_KDS(kmrels, depth);
+	kern_hashskew	   *skew = KERN_MULTIRELS_HASH_SKEW(kmrels, depth);
+	cl_uint			   *hash_bucket = KERN_DATA_STORE_HASHBUCKET(kds_hash);
+	kern_hashentry	   *hash_entry = KERN_DATA_STORE_HASHENTRY(kds_hash);
 	kern_context		kcxt;
 	kern_hashitem	   *khitem = NULL;
+	cl_uint				h_index = 0;
+	cl_uint				h_limit = 0;
 	cl_uint			   *x_buffer = NULL;
 	cl_uint			   *r_buffer;
 	cl_bool			   *oj_map;
@@ -392,11 +547,17 @@ gpujoin_exec_hashjoin(kern_gpujoin *kgjoin,
 	cl_uint				hash_value;
 	cl_uint				offset;
 	cl_uint				count;
+	cl_int				skew_index = -1;
 	cl_bool				is_matched;
 	cl_bool				needs_outer_row = false;
+	cl_bool				single_match;
+	cl_bool				found_match = false;
 	cl_bool				is_null_keys;
 	__shared__ cl_uint	base;
 	__shared__ cl_uint	pg_crc32_table[256];
+	cl_uint			   *skew_pos = NULL;
+	cl_int			   *skew_key = NULL;
+	cl_bool			   *skew_matched = NULL;
 
 	INIT_KERNEL_CONTEXT(&kcxt,gpujoin_exec_hashjoin,kparams);
 
@@ -406,6 +567,15 @@ gpujoin_exec_hashjoin(kern_gpujoin *kgjoin,
 	assert(kresults_src->nrels == depth);
 	assert(kresults_src->nitems <= kresults_src->nrooms);
 
+	/* skewed item processing uses dynamic shared memory next to workmem */
+	if (skew)
+	{
+		skew_pos = (cl_uint *)(SHARED_WORKMEM(kern_errorbuf) +
+							   get_local_size());
+		skew_key = (cl_int *)(skew_pos + get_local_size());
+		skew_matched = (cl_bool *)(skew_key + get_local_size());
+	}
+
 	/* move crc32 table to __local memory from __global memory.
 	 *
 	 * NOTE: calculation of hash value (based on crc32 in GpuHashJoin) is
@@ -424,6 +594,8 @@ gpujoin_exec_hashjoin(kern_gpujoin *kgjoin,
 
 	/* will be valid, if RIGHT OUTER JOIN */
 	oj_map = KERN_MULTIRELS_OUTER_JOIN_MAP(kmrels, depth, outer_join_map);
+	/* SEMI/ANTI JOIN emits outer row only, at most once */
+	single_match = KERN_MULTIRELS_SINGLE_MATCH(kmrels, depth);
 
 	/* Calculation of hash-value by the outer join keys */
 	if (get_global_id() < kresults_src->nitems)
@@ -442,18 +614,62 @@ gpujoin_exec_hashjoin(kern_gpujoin *kgjoin,
 		{
 			/* NOTE: NULL-keys never match on inner join */
 			if (!is_null_keys)
-				khitem = KERN_HASH_FIRST_ITEM(kds_hash, hash_value);
+			{
+				/* heavy-hitters are processed later */
+				if (skew)
+					skew_index = gpujoin_hashskew_lookup(skew, hash_value);
+				if (skew_index < 0)
+				{
+					cl_uint	h_slot = hash_value % kds_hash->nslots;
+
+					h_index = hash_bucket[h_slot];
+					h_limit = hash_bucket[h_slot + 1];
+				}
+			}
 			needs_outer_row = true;
 		}
 	}
 
 	/*
-	 * Walks on the hash entries chain from the khitem
+	 * Walks on the dense hash entries of the slot. Hash value and rowid
+	 * are checked on the contiguous entries, then kern_hashitem is touched
+	 * only if these are matched.
 	 */
-	do {
-		if (khitem && (khitem->hash  == hash_value &&
-					   khitem->rowid >= window_base &&
-					   khitem->rowid <  window_base + window_size))
+	for (;;)
+	{
+		/* SEMI/ANTI JOIN stops probing at the first match */
+		if (single_match && found_match)
+			h_index = h_limit;
+
+		khitem = NULL;
+		while (h_index < h_limit)
+		{
+			kern_hashentry *hentry = &hash_entry[h_index++];
+
+			if (hentry->hash == hash_value &&
+				hentry->rowid >= window_base &&
+				hentry->rowid <  window_base + window_size)
+			{
+				khitem = KERN_DATA_STORE_HASHITEM(kds_hash, hentry->rowid);
+				break;
+			}
+		}
+		/* skewed items are processed later */
+		if (khitem && khitem->skewed)
+		{
+			khitem = NULL;
+			h_index = h_limit;
+		}
+
+		/*
+		 * checks whether any of local threads still have valid hash-entry
+		 * or not. (NOTE: this routine contains reduction operation)
+		 */
+		pgstromStairlikeSum(khitem != NULL ? 1 : 0, &count);
+		if (count == 0)
+			break;
+
+		if (khitem)
 		{
 			HeapTupleHeaderData *h_htup = &khitem->t.htup;
 			cl_bool			joinquals_matched;
@@ -469,11 +685,15 @@ gpujoin_exec_hashjoin(kern_gpujoin *kgjoin,
 			{
 				/* no need LEFT/FULL OUTER JOIN */
 				needs_outer_row = false;
+				found_match = true;
 				/* no need RIGHT/FULL OUTER JOIN */
 				assert(khitem->rowid < kds_hash->nitems);
 				if (oj_map && !oj_map[khitem->rowid])
 					oj_map[khitem->rowid] = true;
 			}
+			/* SEMI/ANTI JOIN never emits inner rows */
+			if (single_match)
+				is_matched = false;
 		}
 		else
 			is_matched = false;
@@ -497,23 +717,127 @@ gpujoin_exec_hashjoin(kern_gpujoin *kgjoin,
 			}
 		}
 		__syncthreads();
+	}
 
-		/*
-		 * Fetch next hash entry, then checks whether all the local
-		 * threads still have valid hash-entry or not.
-		 * (NOTE: this routine contains reduction operation)
-		 */
-		khitem = KERN_HASH_NEXT_ITEM(kds_hash, khitem);
-		pgstromStairlikeSum(khitem != NULL ? 1 : 0, &count);
-	} while (count > 0);
+	/*
+	 * Join the outer rows with heavy-hitter keys. Each combination of
+	 * the outer row and the skewed inner item is assigned to the threads
+	 * in the block evenly, instead of the chain walk by a single thread.
+	 */
+	if (skew)
+	{
+		cl_uint		skew_total;
+		cl_uint		loop_base;
+
+		skew_pos[get_local_id()] =
+			pgstromStairlikeSum(skew_index < 0 ? 0 :
+								skew->keys[skew_index].nitems,
+								&skew_total);
+		skew_key[get_local_id()] = skew_index;
+		skew_matched[get_local_id()] = false;
+		__syncthreads();
+
+		for (loop_base = 0;
+			 loop_base < skew_total;
+			 loop_base += get_local_size())
+		{
+			cl_uint	   *y_buffer = NULL;
+			cl_uint		index = loop_base + get_local_id();
+
+			is_matched = false;
+			if (index < skew_total)
+			{
+				kern_skewkey   *skey;
+				cl_uint			owner;
+				cl_int			lo = 0;
+				cl_int			hi = get_local_size() - 1;
+				cl_bool			joinquals_matched;
+
+				/* lookup the thread which owns this outer row */
+				while (lo < hi)
+				{
+					cl_int	mid = (lo + hi + 1) / 2;
+
+					if (skew_pos[mid] <= index)
+						lo = mid;
+					else
+						hi = mid - 1;
+				}
+				owner = lo;
+				assert(skew_key[owner] >= 0);
+				skey = &skew->keys[skew_key[owner]];
+				khitem = (kern_hashitem *)
+					((char *)kds_hash +
+					 KERN_HASHSKEW_ITEMS(skew)[skey->start +
+											   index - skew_pos[owner]]);
+				y_buffer = KERN_GET_RESULT(kresults_src,
+										   get_global_id() -
+										   get_local_id() + owner);
+				if (!(single_match && skew_matched[owner]) &&
+					khitem->rowid >= window_base &&
+					khitem->rowid <  window_base + window_size)
+				{
+					is_matched = gpujoin_join_quals(&kcxt,
+													kds,
+													kmrels,
+													depth,
+													y_buffer,
+													&khitem->t.htup,
+													&joinquals_matched);
+					if (joinquals_matched)
+					{
+						/* no need LEFT/FULL OUTER JOIN */
+						skew_matched[owner] = true;
+						/* no need RIGHT/FULL OUTER JOIN */
+						assert(khitem->rowid < kds_hash->nitems);
+						if (oj_map && !oj_map[khitem->rowid])
+							oj_map[khitem->rowid] = true;
+					}
+					/* SEMI/ANTI JOIN never emits inner rows */
+					if (single_match)
+						is_matched = false;
+				}
+			}
+
+			/* Expand kresults_dst->nitems */
+			offset = pgstromStairlikeSum(is_matched ? 1 : 0, &count);
+			if (count > 0)
+			{
+				if (get_local_id() == 0)
+					base = atomicAdd(&kresults_dst->nitems, count);
+				__syncthreads();
+
+				/* kresults_dst still have enough space? */
+				if (base + count >= kresults_dst->nrooms)
+					STROM_SET_ERROR(&kcxt.e, StromError_DataStoreNoSpace);
+				else if (is_matched)
+				{
+					r_buffer = KERN_GET_RESULT(kresults_dst, base + offset);
+					memcpy(r_buffer, y_buffer, sizeof(cl_int) * depth);
+					r_buffer[depth] = (size_t)&khitem->t.htup -
+						(size_t)kds_hash;
+				}
+			}
+			__syncthreads();
+		}
+		if (skew_matched[get_local_id()])
+		{
+			needs_outer_row = false;
+			found_match = true;
+		}
+	}
 
 	/*
 	 * If no inner rows were matched on LEFT OUTER JOIN case, we fill up
-	 * the inner-side of result tuple with NULL.
+	 * the inner-side of result tuple with NULL. ANTI JOIN also emits the
+	 * unmatched outer rows in the same manner, and SEMI JOIN emits the
+	 * matched outer rows once with NULL inner-side.
 	 */
-	if (KERN_MULTIRELS_LEFT_OUTER_JOIN(kmrels, depth))
+	if (KERN_MULTIRELS_LEFT_OUTER_JOIN(kmrels, depth) || single_match)
 	{
-		if (needs_outer_row)
+		if (KERN_MULTIRELS_LEFT_OUTER_JOIN(kmrels, depth)
+			? needs_outer_row
+			: found_match)
 		{
 			assert(x_buffer != NULL);
 			is_matched = gpujoin_join_quals(&kcxt,
@@ -1236,6 +1560,12 @@ gpujoin_resize_window(kern_context *kcxt,
 
 		if (window_size == 0)
 			continue;	/* should not happen */
+		/*
+		 * SEMI/ANTI JOIN has to see all the inner rows at once, to emit
+		 * an outer row at most once.
+		 */
+		if (depth > 0 && KERN_MULTIRELS_SINGLE_MATCH(kmrels, depth))
+			continue;
 		/*
 		 * NOTE: Adjustment of the row-distribution score
 		 *
@@ -1459,6 +1789,7 @@ gpujoin_main(kern_gpujoin *kgjoin,		/* in/out: misc stuffs */
 	cl_int				nsplits;
 	cl_int				victim;
 	cl_ulong			tv_start;
+	size_t				shmem_per_thread;
 	cudaError_t			status = cudaSuccess;
 
 	/* Init kernel context */
@@ -1511,13 +1842,14 @@ retry_major:
 				/* Launch:
 				 * gpujoin_exec_outerscan(kern_gpujoin *kgjoin,
 				 *                        kern_data_store *kds,
+				 *                        kern_multirels *kmrels,
 				 *                        kern_resultbuf *kresults)
 				 */
 				tv_start = GlobalTimer();
 
 				kern_args = (void **)
 					cudaGetParameterBuffer(sizeof(void *),
-										   sizeof(void *) * 3);
+										   sizeof(void *) * 4);
 				if (!kern_args)
 				{
 					STROM_SET_ERROR(&kcxt.e, StromError_OutOfKernelArgs);
@@ -1525,7 +1857,8 @@ retry_major:
 				}
 				kern_args[0] = kgjoin;
 				kern_args[1] = kds_src;
-				kern_args[2] = kresults_src;
+				kern_args[2] = kmrels;
+				kern_args[3] = kresults_src;
 
 				window_size = kgjoin->jscale[0].window_size;
 				status = optimal_workgroup_size(&grid_sz,
@@ -1653,6 +1986,14 @@ retry_major:
 				if (kresults_dst->kerror.errcode==StromError_DataStoreNoSpace)
 				{
 					assert(kresults_dst->nitems > kresults_dst->nrooms);
+					/* count phase reports the exact number of results */
+					if (kgjoin->count_retry > 0 && dest_consumed == 0)
+					{
+						kgjoin->jscale[depth].nitems_required
+							= kresults_dst->nitems;
+						kcxt.e = kresults_dst->kerror;
+						goto out;
+					}
 					nsplits = kresults_dst->nitems / kresults_dst->nrooms + 1;
 					victim = gpujoin_resize_window(&kcxt,
 												   kgjoin,
@@ -1752,6 +2093,14 @@ retry_major:
 				if (kresults_dst->kerror.errcode==StromError_DataStoreNoSpace)
 				{
 					assert(kresults_dst->nitems > kresults_dst->nrooms);
+					/* count phase reports the exact number of results */
+					if (kgjoin->count_retry > 0 && dest_consumed == 0)
+					{
+						kgjoin->jscale[depth].nitems_required
+							= kresults_dst->nitems;
+						kcxt.e = kresults_dst->kerror;
+						goto out;
+					}
 					nsplits = kresults_dst->nitems / kresults_dst->nrooms + 1;
 					victim = gpujoin_resize_window(&kcxt,
 												   kgjoin,
@@ -1809,12 +2158,17 @@ retry_major:
 				}
 				SETUP_KERN_JOIN_ARGS(kern_join_args);
 
+				/* skewed item processing needs extra shared memory */
+				shmem_per_thread = sizeof(kern_errorbuf);
+				if (KERN_MULTIRELS_HASH_SKEW(kmrels, depth) != NULL)
+					shmem_per_thread += GPUJOIN_HASHSKEW_SHMEM_PER_THREAD;
+
 				status = optimal_workgroup_size(&grid_sz,
 												&block_sz,
 												(const void *)
 												gpujoin_exec_hashjoin,
 												kresults_src->nitems,
-												0, sizeof(kern_errorbuf));
+												0, shmem_per_thread);
 				if (status != cudaSuccess)
 				{
 					STROM_SET_RUNTIME_ERROR(&kcxt.e, status);
@@ -1824,7 +2178,7 @@ retry_major:
 				status = cudaLaunchDevice((void *)gpujoin_exec_hashjoin,
 										  kern_join_args,
 										  grid_sz, block_sz,
-										  sizeof(kern_errorbuf) * block_sz.x,
+										  shmem_per_thread * block_sz.x,
 										  NULL);
 				if (status != cudaSuccess)
 				{
@@ -1843,6 +2197,14 @@ retry_major:
 				if (kresults_dst->kerror.errcode==StromError_DataStoreNoSpace)
 				{
 					assert(kresults_dst->nitems > kresults_dst->nrooms);
+					/* count phase reports the exact number of results */
+					if (kgjoin->count_retry > 0 && dest_consumed == 0)
+					{
+						kgjoin->jscale[depth].nitems_required
+							= kresults_dst->nitems;
+						kcxt.e = kresults_dst->kerror;
+						goto out;
+					}
 					nsplits = kresults_dst->nitems / kresults_dst->nrooms + 1;
 					victim = gpujoin_resize_window(&kcxt,
 												   kgjoin,
@@ -1935,6 +2297,14 @@ retry_major:
 				if (kresults_dst->kerror.errcode==StromError_DataStoreNoSpace)
 				{
 					assert(kresults_dst->nitems > kresults_dst->nrooms);
+					/* count phase reports the exact number of results */
+					if (kgjoin->count_retry > 0 && dest_consumed == 0)
+					{
+						kgjoin->jscale[depth].nitems_required
+							= kresults_dst->nitems;
+						kcxt.e = kresults_dst->kerror;
+						goto out;
+					}
 					nsplits = kresults_dst->nitems / kresults_dst->nrooms + 1;
 					victim = gpujoin_resize_window(&kcxt,
 												   kgjoin,
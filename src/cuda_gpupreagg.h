@@ -176,6 +176,111 @@ typedef struct
 #define GPUPREAGG_FIELD_IS_GROUPKEY		1
 #define GPUPREAGG_FIELD_IS_AGGFUNC		2
 
+/*
+ * HyperLogLog registers for approx_count_distinct(X)
+ *
+ * 128 registers of 8bit width are packed into 16 partial columns of
+ * int8; phll(K,X) is 'rho' of X placed at the byte of responsible
+ * register if it belongs to the K-th column, or zero elsewhere. So,
+ * byte-wise max of the partial columns merges the registers.
+ * Both of device and host code share the hash function and the logic
+ * below, because CPU fallback also generates phll(K,X).
+ */
+#define GPUPREAGG_HLL_REGISTER_BITS		7
+#define GPUPREAGG_HLL_NUM_REGISTERS		(1U << GPUPREAGG_HLL_REGISTER_BITS)
+#define GPUPREAGG_HLL_NUM_COLUMNS		(GPUPREAGG_HLL_NUM_REGISTERS / 8)
+#define GPUPREAGG_HLL_HASH_SEED			0x9e3779b9U
+
+STATIC_INLINE(cl_ulong)
+gpupreagg_hll_register(cl_uint hash, cl_int colidx)
+{
+	cl_uint		index = (hash >> (32 - GPUPREAGG_HLL_REGISTER_BITS));
+	cl_uint		bits = (hash << GPUPREAGG_HLL_REGISTER_BITS);
+	cl_ulong	rho = 1;
+
+	if (index / 8 != colidx)
+		return 0;
+	while (rho <= 32 - GPUPREAGG_HLL_REGISTER_BITS &&
+		   (bits & 0x80000000U) == 0)
+	{
+		bits <<= 1;
+		rho++;
+	}
+	return rho << (8 * (index % 8));
+}
+
+/*
+ * byte-wise max of the packed registers
+ */
+STATIC_INLINE(cl_ulong)
+gpupreagg_hll_merge(cl_ulong x, cl_ulong y)
+{
+#ifdef __CUDACC__
+	return (((cl_ulong)__vmaxu4((cl_uint)(x >> 32),
+								(cl_uint)(y >> 32)) << 32) |
+			((cl_ulong)__vmaxu4((cl_uint)(x & 0xffffffffUL),
+								(cl_uint)(y & 0xffffffffUL))));
+#else
+	cl_ulong	result = 0;
+	cl_ulong	mask;
+	int			i;
+
+	for (i=0; i < 8; i++)
+	{
+		mask = (0xffUL << (8 * i));
+		result |= Max(x & mask, y & mask);
+	}
+	return result;
+#endif
+}
+
+/*
+ * Log-scale histogram for approx_percentile(X,Q)
+ *
+ * Bucket-1 ... bucket-62 split [2^-6, 2^25) into half octaves, bucket-0
+ * takes all the smaller values (including zero and negative ones), and
+ * bucket-63 takes all the larger values (including +Inf and NaN).
+ * So, the supported domain is positive values in [2^-6, 2^25); the error
+ * of estimation is bounded by the bucket width (sqrt(2)) only there, and
+ * values out of the domain are interpolated between the exact min/max
+ * and the domain boundary.
+ * Counters of two buckets are packed into a partial column of int8 with
+ * 32bit width each; pqhist(K,X) is 1 at the counter of responsible bucket
+ * if it belongs to the K-th column, or zero elsewhere. So, simple addition
+ * of the partial columns merges the histogram, as long as none of the
+ * counters overflows; device code raises CpuReCheck prior to it.
+ */
+#define GPUPREAGG_QHIST_NUM_BUCKETS		64
+#define GPUPREAGG_QHIST_NUM_COLUMNS		(GPUPREAGG_QHIST_NUM_BUCKETS / 2)
+#define GPUPREAGG_QHIST_MIN_EXPONENT	(-6)
+#define GPUPREAGG_QHIST_MAX_EXPONENT	25
+
+STATIC_INLINE(cl_int)
+gpupreagg_qhist_bucket(cl_double value)
+{
+	cl_double	frac;
+	cl_int		expo;
+
+	if (value != value)
+		return GPUPREAGG_QHIST_NUM_BUCKETS - 1;		/* NaN */
+	if (value < ldexp(1.0, GPUPREAGG_QHIST_MIN_EXPONENT))
+		return 0;
+	if (value >= ldexp(1.0, GPUPREAGG_QHIST_MAX_EXPONENT))
+		return GPUPREAGG_QHIST_NUM_BUCKETS - 1;
+	/* value = frac * 2^expo, and 0.5 <= frac < 1.0 */
+	frac = frexp(value, &expo);
+	return (1 + 2 * (expo - 1 - GPUPREAGG_QHIST_MIN_EXPONENT) +
+			(frac >= 0.70710678118654752440 ? 1 : 0));
+}
+
+STATIC_INLINE(cl_ulong)
+gpupreagg_qhist_counter(cl_int bucket, cl_int colidx)
+{
+	if (bucket / 2 != colidx)
+		return 0;
+	return (1UL << (32 * (bucket % 2)));
+}
+
 #ifdef __CUDACC__
 
 /*
@@ -280,9 +385,10 @@ gpupreagg_data_load(pagg_datum *pdatum,		/* __shared__ */
 
 	/*
 	 * Right now, expected data length for running total of partial
-	 * aggregates are 2, 4, or 8. Elasewhere, it may be a bug.
+	 * aggregates are 1, 2, 4, or 8. Elasewhere, it may be a bug.
 	 */
-	if (cmeta.attlen == sizeof(cl_short) ||		/* also, cl_short */
+	if (cmeta.attlen == sizeof(cl_bool) ||		/* bool_and/bool_or */
+		cmeta.attlen == sizeof(cl_short) ||		/* also, cl_short */
 		cmeta.attlen == sizeof(cl_int))			/* also, cl_float */
 	{
 		pdatum->isnull = isnull[colidx];
@@ -322,9 +428,10 @@ gpupreagg_data_store(pagg_datum *pdatum,	/* __shared__ */
 
 	/*
 	 * Right now, expected data length for running total of partial
-	 * aggregates are 2, 4, or 8. Elasewhere, it may be a bug.
+	 * aggregates are 1, 2, 4, or 8. Elasewhere, it may be a bug.
 	 */
-	if (cmeta.attlen == sizeof(cl_short))
+	if (cmeta.attlen == sizeof(cl_bool) ||		/* bool_and/bool_or */
+		cmeta.attlen == sizeof(cl_short))
 	{
 		isnull[colidx] = pdatum->isnull;
 		values[colidx] = pdatum->int_val;
@@ -1488,6 +1595,67 @@ out:
 	kern_writeback_error_status(&kgpreagg->kerror, kcxt.e);
 }
 
+/*
+ * gpupreagg_final_expand
+ *
+ * It moves all the groups in the final reduction buffer (and its hash-
+ * slot) into the larger ones, when host code expects the current ones
+ * will be filled up soon. Entries of the old hash-slot are already unique
+ * per grouping key (or per key and distribution salt), so no key
+ * comparison is needed; each entry just takes an empty slot on the new
+ * hash-slot with its original hash value.
+ */
+KERNEL_FUNCTION(void)
+gpupreagg_final_expand(kern_gpupreagg *kgpreagg,
+					   kern_data_store *kds_old,
+					   kern_global_hashslot *f_hash_old,
+					   kern_data_store *kds_new,
+					   kern_global_hashslot *f_hash_new)
+{
+	kern_parambuf  *kparams = KERN_GPUPREAGG_PARAMBUF(kgpreagg);
+	kern_context	kcxt;
+	size_t			f_hashsize = f_hash_new->hash_size;
+	size_t			hash_index;
+	cl_uint			nitems_old = min(kds_old->nitems, kds_old->nrooms);
+	cl_uint			index;
+	pagg_hashslot	old_slot;
+	pagg_hashslot	new_slot;
+	pagg_hashslot	cur_slot;
+
+	INIT_KERNEL_CONTEXT(&kcxt,gpupreagg_final_expand,kparams);
+
+	old_slot.s.hash  = 0;
+	old_slot.s.index = (cl_uint)(0xffffffff);	/* INVALID */
+	for (hash_index = get_global_id();
+		 hash_index < f_hash_old->hash_size;
+		 hash_index += get_global_size())
+	{
+		cur_slot.value = f_hash_old->hash_slot[hash_index].value;
+		if (cur_slot.s.index >= nitems_old)
+			continue;	/* empty slot */
+
+		new_slot.s.hash  = cur_slot.s.hash;
+		new_slot.s.index = atomicAdd(&kds_new->nitems, 1);
+		if (new_slot.s.index >= kds_new->nrooms)
+		{
+			STROM_SET_ERROR(&kcxt.e, StromError_DataStoreNoSpace);
+			continue;
+		}
+		gpupreagg_final_data_move(&kcxt,
+								  kds_old, cur_slot.s.index,
+								  kds_new, new_slot.s.index);
+		/* new hash-slot is larger than the old one, so never be full */
+		index = new_slot.s.hash % f_hashsize;
+		while (atomicCAS(&f_hash_new->hash_slot[index].value,
+						 old_slot.value,
+						 new_slot.value) != old_slot.value)
+			index = (index + 1) % f_hashsize;
+		atomicAdd(&f_hash_new->hash_usage, 1);
+	}
+	/* write-back execution status into host-side */
+	kern_writeback_error_status(&kgpreagg->kerror, kcxt.e);
+}
+
 /*
  * gpupreagg_fixup_varlena
  *
@@ -2046,7 +2214,7 @@ out:
  * Due to hardware capability difference we have to implement
  * alternative one using atomicCAS operation. For simplification.
  * we wrap all the atomic functions using:
- *   pg_atomic_(min|max|add)_<type>(<type> *addr, <type> value) 
+ *   pg_atomic_(min|max|add|and|or)_<type>(<type> *addr, <type> value) 
  *
  * ----------------------------------------------------------------
  */
@@ -2065,6 +2233,16 @@ pg_atomic_add_int(cl_int *addr, cl_int value)
 {
 	return __iAtomicAdd(addr, value);
 }
+STATIC_INLINE(cl_int)
+pg_atomic_and_int(cl_int *addr, cl_int value)
+{
+	return atomicAnd(addr, value);
+}
+STATIC_INLINE(cl_int)
+pg_atomic_or_int(cl_int *addr, cl_int value)
+{
+	return atomicOr(addr, value);
+}
 
 
 #define PG_ATOMIC_LONG_TEMPLATE(operation,addr,value)				\
@@ -2107,6 +2285,29 @@ pg_atomic_add_long(cl_long *addr, cl_long value)
 	return (cl_long) atomicAdd((cl_ulong *) addr, (cl_ulong) value);
 }
 
+#define BitAnd(x,y)		((x) & (y))
+#define BitOr(x,y)		((x) | (y))
+
+STATIC_INLINE(cl_long)
+pg_atomic_and_long(cl_long *addr, cl_long value)
+{
+#if __CUDA_ARCH__ < 350
+	PG_ATOMIC_LONG_TEMPLATE(BitAnd, addr, (cl_ulong) value);
+#else
+	return (cl_long) atomicAnd((cl_ulong *) addr, (cl_ulong) value);
+#endif
+}
+
+STATIC_INLINE(cl_long)
+pg_atomic_or_long(cl_long *addr, cl_long value)
+{
+#if __CUDA_ARCH__ < 350
+	PG_ATOMIC_LONG_TEMPLATE(BitOr, addr, (cl_ulong) value);
+#else
+	return (cl_long) atomicOr((cl_ulong *) addr, (cl_ulong) value);
+#endif
+}
+
 #define PG_ATOMIC_FLOAT_TEMPLATE(operation,addr,value)					\
 	do {																\
 		cl_uint		curval = __float_as_int(*(addr));					\
@@ -2179,6 +2380,12 @@ pg_atomic_add_double(cl_double *addr, cl_double value)
 	PG_ATOMIC_DOUBLE_TEMPLATE(Add, addr, value);
 }
 
+STATIC_INLINE(cl_ulong)
+pg_atomic_hll_merge(cl_ulong *addr, cl_ulong value)
+{
+	PG_ATOMIC_LONG_TEMPLATE(gpupreagg_hll_merge, addr, value);
+}
+
 /* macro to check overflow on accumlate operation */
 #define CHECK_OVERFLOW_NONE(x,y)		(0)
 
@@ -2193,6 +2400,11 @@ pg_atomic_add_double(cl_double *addr, cl_double value)
 
 #define CHECK_OVERFLOW_NUMERIC(x,y)		CHECK_OVERFLOW_NONE(x,y)
 
+#define CHECK_OVERFLOW_QHIST(x,y)							\
+	((((cl_ulong)(x) & 0xffffffffUL) +						\
+	  ((cl_ulong)(y) & 0xffffffffUL) > 0xffffffffUL) ||		\
+	 (((cl_ulong)(x) >> 32) + ((cl_ulong)(y) >> 32) > 0xffffffffUL))
+
 /*
  * Helper macros for gpupreagg_local_calc
  */
@@ -2310,6 +2522,36 @@ pg_atomic_add_double(cl_double *addr, cl_double value)
 								   CHECK_OVERFLOW_NUMERIC,				\
 		pg_atomic_add_numeric((kcxt),&(accum)->ulong_val,(newval)->ulong_val))
 
+/* calculation for local partial bitwise and/or */
+#define AGGCALC_LOCAL_PAND_SHORT(kcxt,accum,newval)					\
+	AGGCALC_LOCAL_TEMPLATE_SHORT((kcxt),accum,newval,CHECK_OVERFLOW_NONE, \
+		pg_atomic_and_int(&(accum)->int_val,(newval)->int_val))
+#define AGGCALC_LOCAL_PAND_INT(kcxt,accum,newval)					\
+	AGGCALC_LOCAL_TEMPLATE_INT((kcxt),accum,newval,CHECK_OVERFLOW_NONE, \
+		pg_atomic_and_int(&(accum)->int_val,(newval)->int_val))
+#define AGGCALC_LOCAL_PAND_LONG(kcxt,accum,newval)					\
+	AGGCALC_LOCAL_TEMPLATE_LONG((kcxt),accum,newval,CHECK_OVERFLOW_NONE, \
+		pg_atomic_and_long(&(accum)->long_val,(newval)->long_val))
+#define AGGCALC_LOCAL_POR_SHORT(kcxt,accum,newval)					\
+	AGGCALC_LOCAL_TEMPLATE_SHORT((kcxt),accum,newval,CHECK_OVERFLOW_NONE, \
+		pg_atomic_or_int(&(accum)->int_val,(newval)->int_val))
+#define AGGCALC_LOCAL_POR_INT(kcxt,accum,newval)					\
+	AGGCALC_LOCAL_TEMPLATE_INT((kcxt),accum,newval,CHECK_OVERFLOW_NONE, \
+		pg_atomic_or_int(&(accum)->int_val,(newval)->int_val))
+#define AGGCALC_LOCAL_POR_LONG(kcxt,accum,newval)					\
+	AGGCALC_LOCAL_TEMPLATE_LONG((kcxt),accum,newval,CHECK_OVERFLOW_NONE, \
+		pg_atomic_or_long(&(accum)->long_val,(newval)->long_val))
+
+/* calculation for local partial HyperLogLog registers */
+#define AGGCALC_LOCAL_PHLL(kcxt,accum,newval)						\
+	AGGCALC_LOCAL_TEMPLATE_LONG((kcxt),accum,newval,CHECK_OVERFLOW_NONE, \
+		pg_atomic_hll_merge(&(accum)->ulong_val,(newval)->ulong_val))
+
+/* calculation for local partial histogram of approx_percentile */
+#define AGGCALC_LOCAL_PQHIST(kcxt,accum,newval)						\
+	AGGCALC_LOCAL_TEMPLATE_LONG((kcxt),accum,newval,CHECK_OVERFLOW_QHIST, \
+		pg_atomic_add_long(&(accum)->long_val,(newval)->long_val))
+
 /*
  * Helper macros for gpupreagg_global_calc
  *
@@ -2518,6 +2760,60 @@ pg_atomic_add_double(cl_double *addr, cl_double value)
 		pg_atomic_add_numeric((kcxt),(cl_ulong *)(accum_value),		\
 							  (cl_ulong)(new_value)))
 
+/* calculation for global partial bitwise and/or */
+#define AGGCALC_GLOBAL_PAND_SHORT(kcxt,accum_isnull,accum_value,	\
+								  new_isnull,new_value)				\
+	AGGCALC_GLOBAL_TEMPLATE_SHORT(									\
+		kcxt,accum_isnull,accum_value,								\
+		new_isnull,(cl_int)(new_value),CHECK_OVERFLOW_NONE,			\
+		pg_atomic_and_int((cl_int *)(accum_value),(cl_int)(new_value)))
+#define AGGCALC_GLOBAL_PAND_INT(kcxt,accum_isnull,accum_value,		\
+								new_isnull,new_value)				\
+	AGGCALC_GLOBAL_TEMPLATE_INT(									\
+		kcxt,accum_isnull,accum_value,								\
+		new_isnull,(cl_int)(new_value),CHECK_OVERFLOW_NONE,			\
+		pg_atomic_and_int((cl_int *)(accum_value),(cl_int)(new_value)))
+#define AGGCALC_GLOBAL_PAND_LONG(kcxt,accum_isnull,accum_value,		\
+								 new_isnull,new_value)				\
+	AGGCALC_GLOBAL_TEMPLATE_LONG(									\
+		kcxt,accum_isnull,accum_value,								\
+		new_isnull,(cl_long)(new_value),CHECK_OVERFLOW_NONE,		\
+		pg_atomic_and_long((cl_long *)(accum_value),(cl_long)(new_value)))
+#define AGGCALC_GLOBAL_POR_SHORT(kcxt,accum_isnull,accum_value,		\
+								 new_isnull,new_value)				\
+	AGGCALC_GLOBAL_TEMPLATE_SHORT(									\
+		kcxt,accum_isnull,accum_value,								\
+		new_isnull,(cl_int)(new_value),CHECK_OVERFLOW_NONE,			\
+		pg_atomic_or_int((cl_int *)(accum_value),(cl_int)(new_value)))
+#define AGGCALC_GLOBAL_POR_INT(kcxt,accum_isnull,accum_value,		\
+							   new_isnull,new_value)				\
+	AGGCALC_GLOBAL_TEMPLATE_INT(									\
+		kcxt,accum_isnull,accum_value,								\
+		new_isnull,(cl_int)(new_value),CHECK_OVERFLOW_NONE,			\
+		pg_atomic_or_int((cl_int *)(accum_value),(cl_int)(new_value)))
+#define AGGCALC_GLOBAL_POR_LONG(kcxt,accum_isnull,accum_value,		\
+								new_isnull,new_value)				\
+	AGGCALC_GLOBAL_TEMPLATE_LONG(									\
+		kcxt,accum_isnull,accum_value,								\
+		new_isnull,(cl_long)(new_value),CHECK_OVERFLOW_NONE,		\
+		pg_atomic_or_long((cl_long *)(accum_value),(cl_long)(new_value)))
+
+/* calculation for global partial HyperLogLog registers */
+#define AGGCALC_GLOBAL_PHLL(kcxt,accum_isnull,accum_value,			\
+							new_isnull,new_value)					\
+	AGGCALC_GLOBAL_TEMPLATE_LONG(									\
+		kcxt,accum_isnull,accum_value,								\
+		new_isnull,(cl_long)(new_value),CHECK_OVERFLOW_NONE,		\
+		pg_atomic_hll_merge((cl_ulong *)(accum_value),(cl_ulong)(new_value)))
+
+/* calculation for global partial histogram of approx_percentile */
+#define AGGCALC_GLOBAL_PQHIST(kcxt,accum_isnull,accum_value,		\
+							  new_isnull,new_value)					\
+	AGGCALC_GLOBAL_TEMPLATE_LONG(									\
+		kcxt,accum_isnull,accum_value,								\
+		new_isnull,(cl_long)(new_value),CHECK_OVERFLOW_QHIST,		\
+		pg_atomic_add_long((cl_long *)(accum_value), (cl_long)(new_value)))
+
 /*
  * Helper macros for gpupreagg_nogroup_calc
  */
@@ -2679,5 +2975,51 @@ pg_atomic_add_double(cl_double *addr, cl_double value)
 #define AGGCALC_NOGROUP_PADD_NUMERIC(kcxt,accum,newval)		\
 	AGGCALC_NOGROUP_TEMPLATE_NUMERIC((kcxt),accum,newval,	\
 									 pgfn_numeric_add)
+
+/* calculation for no group partial bitwise and/or */
+#define AGGCALC_NOGROUP_PAND_SHORT(kcxt,accum,newval)		\
+	AGGCALC_NOGROUP_TEMPLATE_SHORT((kcxt),accum,newval,		\
+								   CHECK_OVERFLOW_NONE,		\
+								   BitAnd((accum)->int_val,	\
+										  (newval)->int_val))
+#define AGGCALC_NOGROUP_PAND_INT(kcxt,accum,newval)			\
+	AGGCALC_NOGROUP_TEMPLATE_INT((kcxt),accum,newval,		\
+								 CHECK_OVERFLOW_NONE,		\
+								 BitAnd((accum)->int_val,	\
+										(newval)->int_val))
+#define AGGCALC_NOGROUP_PAND_LONG(kcxt,accum,newval)		\
+	AGGCALC_NOGROUP_TEMPLATE_LONG((kcxt),accum,newval,		\
+								  CHECK_OVERFLOW_NONE,		\
+								  BitAnd((accum)->long_val,	\
+										 (newval)->long_val))
+#define AGGCALC_NOGROUP_POR_SHORT(kcxt,accum,newval)		\
+	AGGCALC_NOGROUP_TEMPLATE_SHORT((kcxt),accum,newval,		\
+								   CHECK_OVERFLOW_NONE,		\
+								   BitOr((accum)->int_val,	\
+										 (newval)->int_val))
+#define AGGCALC_NOGROUP_POR_INT(kcxt,accum,newval)			\
+	AGGCALC_NOGROUP_TEMPLATE_INT((kcxt),accum,newval,		\
+								 CHECK_OVERFLOW_NONE,		\
+								 BitOr((accum)->int_val,	\
+									   (newval)->int_val))
+#define AGGCALC_NOGROUP_POR_LONG(kcxt,accum,newval)			\
+	AGGCALC_NOGROUP_TEMPLATE_LONG((kcxt),accum,newval,		\
+								  CHECK_OVERFLOW_NONE,		\
+								  BitOr((accum)->long_val,	\
+										(newval)->long_val))
+
+/* calculation for no group partial HyperLogLog registers */
+#define AGGCALC_NOGROUP_PHLL(kcxt,accum,newval)						\
+	AGGCALC_NOGROUP_TEMPLATE_LONG((kcxt),accum,newval,				\
+								  CHECK_OVERFLOW_NONE,				\
+								  gpupreagg_hll_merge((accum)->ulong_val, \
+													  (newval)->ulong_val))
+
+/* calculation for no group partial histogram of approx_percentile */
+#define AGGCALC_NOGROUP_PQHIST(kcxt,accum,newval)					\
+	AGGCALC_NOGROUP_TEMPLATE_LONG((kcxt),accum,newval,				\
+								  CHECK_OVERFLOW_QHIST,				\
+								  Add((accum)->long_val,			\
+									  (newval)->long_val))
 #endif	/* __CUDACC__ */
 #endif	/* CUDA_GPUPREAGG_H */
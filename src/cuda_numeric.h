@@ -526,8 +526,9 @@ pg_numeric_param(kern_context *kcxt,
 
 /* NULL check functions */
 STROMCL_SIMPLE_NULLTEST_TEMPLATE(numeric)
-/* CRC32 calculation function */
+/* hash calculation functions */
 STROMCL_SIMPLE_COMP_CRC32_TEMPLATE(numeric,cl_long)
+STROMCL_SIMPLE_COMP_FASTHASH_TEMPLATE(numeric,cl_long)
 /* NUMERIC internal to Datum */
 STATIC_INLINE(Datum)
 pg_numeric_to_datum(cl_ulong value)
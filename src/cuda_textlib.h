@@ -47,7 +47,7 @@ STROMCL_VARLENA_VARREF_TEMPLATE(bpchar)
 STROMCL_VARLENA_VARSTORE_TEMPLATE(bpchar)
 STROMCL_VARLENA_PARAMREF_TEMPLATE(bpchar)
 STROMCL_VARLENA_NULLTEST_TEMPLATE(bpchar)
-/* pg_bpchar_comp_crc32 has to be defined with own way */
+/* pg_bpchar_comp_crc32/fasthash have to be defined with own way */
 STATIC_FUNCTION(cl_uint)
 pg_bpchar_comp_crc32(const cl_uint *crc32_table,
 					 cl_uint hash, pg_bpchar_t datum)
@@ -60,6 +60,18 @@ pg_bpchar_comp_crc32(const cl_uint *crc32_table,
 	}
 	return hash;
 }
+
+STATIC_FUNCTION(cl_uint)
+pg_bpchar_comp_fasthash(cl_uint hash, pg_bpchar_t datum)
+{
+	if (!datum.isnull)
+	{
+		hash = pg_common_comp_fasthash(hash,
+									   VARDATA_ANY(datum.value),
+									   bpchar_truelen(datum.value));
+	}
+	return hash;
+}
 #endif
 
 STATIC_FUNCTION(cl_int)
@@ -34,6 +34,8 @@
 #include "pg_strom.h"
 #include "cuda_numeric.h"
 #include <float.h>
+#include <pthread.h>
+#include <signal.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -43,6 +45,7 @@
  */
 static int		pgstrom_chunk_size_kb;
 static int		pgstrom_chunk_limit_kb = INT_MAX;
+static int		pgstrom_hashbuild_workers;
 
 /*
  * pgstrom_chunk_size - configured chunk size
@@ -785,6 +788,7 @@ PDS_insert_hashitem(pgstrom_data_store *pds,
 	khitem->hash = hash_value;
 	khitem->next = 0x7f7f7f7f;	/* to be set later */
 	khitem->rowid = kds->nitems++;
+	khitem->skewed = 0;
 	khitem->t.t_len = tuple->t_len;
 	khitem->t.t_self = tuple->t_self;
 	memcpy(&khitem->t.htup, tuple->t_data, tuple->t_len);
@@ -794,36 +798,238 @@ PDS_insert_hashitem(pgstrom_data_store *pds,
 	return true;
 }
 
+/*
+ * Parallel build of the hash table
+ *
+ * Hash table is built with three phases; (1) counts number of items for
+ * each hash slot, (2) scatters the items to the dense index according to
+ * the slot, then (3) links the hash chain for each slot range. Each phase
+ * is processed by multiple worker threads concurrently, using atomic
+ * operations on the slot counters. Worker threads touch only the KDS and
+ * the working buffers allocated prior to the launch, thus, never call any
+ * PostgreSQL routines.
+ */
+#define HASHBUILD_MIN_NITEMS_PER_WORKER		32768
+
+typedef struct
+{
+	pthread_mutex_t	start_lock;		/* held until the barrier gets ready */
+	pthread_barrier_t barrier;		/* synchronization between phases */
+} hashbuild_shared_state;
+
+typedef struct
+{
+	kern_data_store *kds;
+	cl_uint		   *slot_pos;		/* cursor of the dense index per slot */
+	cl_uint			item_start;		/* range of rowid to be processed */
+	cl_uint			item_end;
+	cl_uint			slot_start;		/* range of slot to be processed */
+	cl_uint			slot_end;
+	bool			launched;		/* true, if a thread works on this range */
+	hashbuild_shared_state *shared;
+} hashbuild_worker_arg;
+
+static void
+hashbuild_count_slots(hashbuild_worker_arg *arg)
+{
+	kern_data_store *kds = arg->kds;
+	cl_uint		   *hash_bucket = KERN_DATA_STORE_HASHBUCKET(kds);
+	cl_uint			i, j;
+
+	for (i = arg->item_start; i < arg->item_end; i++)
+	{
+		kern_hashitem  *khitem = KERN_DATA_STORE_HASHITEM(kds, i);
+
+		j = khitem->hash % kds->nslots;
+		__sync_fetch_and_add(&hash_bucket[j + 1], 1);
+	}
+}
+
+static void
+hashbuild_scatter_items(hashbuild_worker_arg *arg)
+{
+	kern_data_store *kds = arg->kds;
+	kern_hashentry *hash_entry = KERN_DATA_STORE_HASHENTRY(kds);
+	cl_uint			i, j;
+
+	for (i = arg->item_start; i < arg->item_end; i++)
+	{
+		kern_hashitem  *khitem = KERN_DATA_STORE_HASHITEM(kds, i);
+
+		j = khitem->hash % kds->nslots;
+		j = __sync_fetch_and_add(&arg->slot_pos[j], 1);
+		hash_entry[j].hash = khitem->hash;
+		hash_entry[j].rowid = i;
+	}
+}
+
+static void
+hashbuild_link_chains(hashbuild_worker_arg *arg)
+{
+	kern_data_store *kds = arg->kds;
+	cl_uint		   *hash_slot = KERN_DATA_STORE_HASHSLOT(kds);
+	cl_uint		   *hash_bucket = KERN_DATA_STORE_HASHBUCKET(kds);
+	kern_hashentry *hash_entry = KERN_DATA_STORE_HASHENTRY(kds);
+	cl_uint			i, j;
+
+	for (i = arg->slot_start; i < arg->slot_end; i++)
+	{
+		cl_uint		next = 0;
+
+		/* link the items in order of the dense index */
+		for (j = hash_bucket[i + 1]; j > hash_bucket[i]; j--)
+		{
+			kern_hashitem  *khitem =
+				KERN_DATA_STORE_HASHITEM(kds, hash_entry[j-1].rowid);
+
+			khitem->next = next;
+			next = (uintptr_t)khitem - (uintptr_t)kds;
+		}
+		hash_slot[i] = next;
+	}
+}
+
+/*
+ * hashbuild_worker_main - entrypoint of the worker thread. It runs all the
+ * phases on its own range, and waits for the other workers and the backend
+ * at the barrier between the phases.
+ */
+static void *
+hashbuild_worker_main(void *__arg)
+{
+	hashbuild_worker_arg   *arg = __arg;
+	hashbuild_shared_state *shared = arg->shared;
+
+	/* wait for the backend to set up the barrier */
+	pthread_mutex_lock(&shared->start_lock);
+	pthread_mutex_unlock(&shared->start_lock);
+
+	hashbuild_count_slots(arg);
+	pthread_barrier_wait(&shared->barrier);		/* end of (1) */
+	pthread_barrier_wait(&shared->barrier);		/* prefix sum by backend */
+	hashbuild_scatter_items(arg);
+	pthread_barrier_wait(&shared->barrier);		/* end of (2) */
+	hashbuild_link_chains(arg);
+
+	return NULL;
+}
+
+/*
+ * hashbuild_run_local - runs a phase on the range of the backend itself,
+ * and on the ranges whose worker thread could not be launched.
+ */
+static void
+hashbuild_run_local(hashbuild_worker_arg *args, cl_uint nworkers,
+					void (*phase_func)(hashbuild_worker_arg *arg))
+{
+	cl_uint		i;
+
+	for (i=0; i < nworkers; i++)
+	{
+		if (!args[i].launched)
+			phase_func(&args[i]);
+	}
+}
+
 /*
  * PDS_build_hashtable
  *
- * construct hash table according to the current contents
+ * construct hash table according to the current contents, and the dense
+ * index of the hash items grouped by the hash slot.
  */
 void
 PDS_build_hashtable(pgstrom_data_store *pds)
 {
 	kern_data_store *kds = pds->kds;
-	cl_uint		   *row_index = KERN_DATA_STORE_ROWINDEX(kds);
 	cl_uint		   *hash_slot = KERN_DATA_STORE_HASHSLOT(kds);
-	cl_uint			i, j, nslots = __KDS_NSLOTS(kds->nitems);
+	cl_uint		   *hash_bucket;
+	cl_uint		   *slot_pos;
+	hashbuild_shared_state shared;
+	hashbuild_worker_arg *args;
+	pthread_t	   *threads;
+	sigset_t		sigmask_new;
+	sigset_t		sigmask_old;
+	cl_uint			i, nworkers;
+	cl_uint			nlaunched = 0;
+	cl_uint			nslots = __KDS_NSLOTS(kds->nitems);
 
 	if (kds->format != KDS_FORMAT_HASH)
 		elog(ERROR, "Bug? Only KDS_FORMAT_HASH can build a hash table");
 	if (kds->nslots > 0)
 		elog(ERROR, "Bug? hash table is already built");
 
+	kds->nslots = nslots;
+	hash_bucket = KERN_DATA_STORE_HASHBUCKET(kds);
 	memset(hash_slot, 0, sizeof(cl_uint) * nslots);
-	for (i = 0; i < kds->nitems; i++)
+	memset(hash_bucket, 0, sizeof(cl_uint) * (nslots + 1));
+	slot_pos = palloc(sizeof(cl_uint) * nslots);
+
+	/* number of workers according to the number of items */
+	nworkers = Min(pgstrom_hashbuild_workers,
+				   kds->nitems / HASHBUILD_MIN_NITEMS_PER_WORKER);
+	nworkers = Max(nworkers, 1);
+	args = palloc0(sizeof(hashbuild_worker_arg) * nworkers);
+	threads = palloc(sizeof(pthread_t) * nworkers);
+	for (i=0; i < nworkers; i++)
 	{
-		kern_hashitem  *khitem = (kern_hashitem *)
-			((char *)kds + row_index[i] - offsetof(kern_hashitem, t));
+		args[i].kds = kds;
+		args[i].slot_pos = slot_pos;
+		args[i].item_start = (Size)kds->nitems * i / nworkers;
+		args[i].item_end = (Size)kds->nitems * (i + 1) / nworkers;
+		args[i].slot_start = (Size)nslots * i / nworkers;
+		args[i].slot_end = (Size)nslots * (i + 1) / nworkers;
+		args[i].shared = &shared;
+	}
 
-		Assert(khitem->rowid == i);
-		j = khitem->hash % nslots;
-		khitem->next = hash_slot[j];
-		hash_slot[j] = (uintptr_t)khitem - (uintptr_t)kds;
+	/*
+	 * Launch the worker threads once for all the phases. They are blocked
+	 * by the start_lock until the barrier is initialized, because its
+	 * number of participants is not known prior to the launch.
+	 * Note that worker threads must not receive any signals of the backend.
+	 */
+	pthread_mutex_init(&shared.start_lock, NULL);
+	pthread_mutex_lock(&shared.start_lock);
+	sigfillset(&sigmask_new);
+	pthread_sigmask(SIG_SETMASK, &sigmask_new, &sigmask_old);
+	for (i=1; i < nworkers; i++)
+	{
+		args[i].launched = (pthread_create(&threads[i], NULL,
+										   hashbuild_worker_main,
+										   &args[i]) == 0);
+		if (args[i].launched)
+			nlaunched++;
 	}
-	kds->nslots = nslots;
+	pthread_sigmask(SIG_SETMASK, &sigmask_old, NULL);
+	pthread_barrier_init(&shared.barrier, NULL, nlaunched + 1);
+	pthread_mutex_unlock(&shared.start_lock);
+
+	/* (1) number of items for each slot */
+	hashbuild_run_local(args, nworkers, hashbuild_count_slots);
+	pthread_barrier_wait(&shared.barrier);
+	for (i=0; i < nslots; i++)
+	{
+		hash_bucket[i + 1] += hash_bucket[i];
+		slot_pos[i] = hash_bucket[i];
+	}
+	Assert(hash_bucket[nslots] == kds->nitems);
+	pthread_barrier_wait(&shared.barrier);
+	/* (2) scatter the items to the dense index */
+	hashbuild_run_local(args, nworkers, hashbuild_scatter_items);
+	pthread_barrier_wait(&shared.barrier);
+	/* (3) link the hash chain for each slot */
+	hashbuild_run_local(args, nworkers, hashbuild_link_chains);
+
+	for (i=1; i < nworkers; i++)
+	{
+		if (args[i].launched)
+			pthread_join(threads[i], NULL);
+	}
+	pthread_barrier_destroy(&shared.barrier);
+	pthread_mutex_destroy(&shared.start_lock);
+
+	pfree(threads);
+	pfree(args);
+	pfree(slot_pos);
 }
 
 void
@@ -849,4 +1055,14 @@ pgstrom_init_datastore(void)
 							PGC_USERSET,
 							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
 							check_guc_chunk_limit, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.hashbuild_workers",
+							"Number of threads to build inner hash table",
+							NULL,
+							&pgstrom_hashbuild_workers,
+							4,
+							1,
+							64,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
 }
@@ -33,6 +33,10 @@
 #include "optimizer/restrictinfo.h"
 #include "optimizer/var.h"
 #include "parser/parsetree.h"
+#include "storage/buffile.h"
+#include "storage/ipc.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
 #include "utils/builtins.h"
 #include "utils/guc.h"
 #include "utils/lsyscache.h"
@@ -77,6 +81,7 @@ typedef struct
 	int			num_rels;
 	char	   *kern_source;
 	int			extra_flags;
+	int			hash_function;	/* one of HASHFUNC_* */
 	List	   *func_defs;
 	List	   *expr_defs;
 	List	   *used_params;
@@ -108,6 +113,7 @@ form_gpujoin_info(CustomScan *cscan, GpuJoinInfo *gj_info)
 	privs = lappend(privs, makeInteger(gj_info->num_rels));
 	privs = lappend(privs, makeString(pstrdup(gj_info->kern_source)));
 	privs = lappend(privs, makeInteger(gj_info->extra_flags));
+	privs = lappend(privs, makeInteger(gj_info->hash_function));
 	privs = lappend(privs, gj_info->func_defs);
 	privs = lappend(privs, gj_info->expr_defs);
 	exprs = lappend(exprs, gj_info->used_params);
@@ -145,6 +151,7 @@ deform_gpujoin_info(CustomScan *cscan)
 	gj_info->num_rels = intVal(list_nth(privs, pindex++));
 	gj_info->kern_source = strVal(list_nth(privs, pindex++));
 	gj_info->extra_flags = intVal(list_nth(privs, pindex++));
+	gj_info->hash_function = intVal(list_nth(privs, pindex++));
 	gj_info->func_defs = list_nth(privs, pindex++);
 	gj_info->expr_defs = list_nth(privs, pindex++);
 	gj_info->used_params = list_nth(exprs, eindex++);
@@ -217,6 +224,20 @@ typedef struct
 	List			   *hash_keylen;
 	List			   *hash_keybyval;
 	List			   *hash_keytype;
+	int					hash_function;	/* one of HASHFUNC_* */
+	char			   *icache_key;		/* key of the shared inner cache */
+	pgstrom_inner_cache_sign icache_sign;
+	bool				icache_hit;		/* true, if loaded from the cache */
+	bool				bloom_enabled;	/* true, if bloom filter applicable */
+	cl_uint			   *bloom;			/* bloom filter of inner keys */
+	cl_uint				bloom_mask;		/* number of bloom filter bits - 1 */
+	List			   *skew_list;		/* kern_hashskew per inner chunk */
+	cl_uint				skew_nkeys;		/* number of heavy-hitter keys */
+	Size				skew_nitems;	/* number of skewed inner rows */
+	bool				grace_capable;	/* true, if outer rows can be
+										 * partitioned by the hash value */
+	bool				grace_partitioned;	/* true, if partitioned join
+											 * was applied */
 
 	/* CPU Fallback related */
 	AttrNumber		   *inner_dst_resno;
@@ -228,18 +249,32 @@ typedef struct
 	cl_bool				fallback_right_outer;
 } innerState;
 
+/*
+ * SEMI/ANTI JOIN emits an outer row at most once, thus, it has to see all
+ * the inner rows at once.
+ */
+static inline bool
+gpujoin_single_match(innerState *istate)
+{
+	return (istate->join_type == JOIN_SEMI ||
+			istate->join_type == JOIN_ANTI);
+}
+
 typedef struct
 {
 	GpuTaskState	gts;
 	/* expressions to be used in fallback path */
 	List		   *join_types;
 	List		   *outer_quals;	/* single element list of ExprState */
+	pgstrom_hostjit *hostjit_quals;	/* host JIT code of outer_quals, if any */
 	double			outer_ratio;
 	double			outer_nrows;
 	List		   *hash_outer_keys;
 	List		   *join_quals;
 	/* current window of inner relations */
 	struct pgstrom_multirels *curr_pmrels;
+	/* inner buffer retained across rescans, if any */
+	struct pgstrom_multirels *keep_pmrels;
 	/* result width per tuple for buffer length calculation */
 	int				result_width;
 	/* expected extra length per result tuple  */
@@ -255,6 +290,13 @@ typedef struct
 	 */
 	cl_int			first_right_outer_depth;
 
+	/*
+	 * Join growth ratio of each depth observed by the previous executions
+	 * of the same plan shape, if any (negative means unknown).
+	 */
+	pg_crc32		fb_signature;
+	cl_double	   *fb_ratio;
+
 	/*
 	 * flag to set if outer plan reached to end of the relation
 	 *
@@ -264,6 +306,19 @@ typedef struct
 	 */
 	bool			outer_scan_done;
 
+	/*
+	 * Partitioned (grace) hash-join
+	 *
+	 * If only one depth has multiple inner chunks, we partition the outer
+	 * rows according to the hash range of the inner chunks during the
+	 * first outer scan. The rows of the second or later chunks are spilled
+	 * to the temporary files, then read back on the later passes instead
+	 * of the rescan of the outer relation.
+	 */
+	int				grace_depth;	/* depth of the partitioned join, or 0 */
+	BufFile		  **grace_files;	/* spilled outer rows per inner chunk */
+	size_t			grace_nspilled;	/* number of the spilled outer rows */
+
 	/*
 	 * CPU Fallback
 	 */
@@ -305,6 +360,7 @@ typedef struct pgstrom_multirels
 	Size			head_length;	/* length of the header portion */
 	Size			usage_length;	/* length actually in use */
 	pgstrom_data_store **inner_chunks;	/* array of inner PDS */
+	kern_hashskew **inner_skews;	/* array of heavy-hitter keys, if any */
 	cl_bool			needs_outer_join;	/* true, if OJ is needed */
 	cl_int			n_attached;	/* Number of attached tasks */
 	cl_int		   *refcnt;		/* Reference counter of each GpuContext */
@@ -345,6 +401,50 @@ static CustomScanMethods	gpujoin_plan_methods;
 static CustomExecMethods	gpujoin_exec_methods;
 static bool					enable_gpunestloop;
 static bool					enable_gpuhashjoin;
+static bool					enable_gpujoin_bloom_filter;
+static bool					gpujoin_bloom_prefilter;
+static bool					enable_gpujoin_grace_hash;
+static bool					enable_gpujoin_skew_handling;
+static bool					enable_gpujoin_feedback;
+static bool					gpujoin_count_then_materialize;
+static int					debug_gpujoin_inner_limit;	/* in KB */
+
+/* bloom filter uses 8 bits per inner key, up to 64MB */
+#define GPUJOIN_BLOOM_BITS_PER_KEY	8
+#define GPUJOIN_BLOOM_MAX_NBITS		(1U << 29)
+
+/*
+ * a hash value is a heavy-hitter if it has more rows than 1/64 of the inner
+ * chunk, and at least 256 rows. So, a chunk has 64 heavy-hitters at most.
+ */
+#define GPUJOIN_SKEW_MIN_NITEMS		256
+#define GPUJOIN_SKEW_MAX_KEYS		64
+
+/*
+ * gpujoin_feedback_head - shared store of the join growth ratio for each
+ * plan shape, to be consulted by gpujoin_exec_estimate_nitems() on the
+ * next execution. Slots are assigned by the plan signature, and the last
+ * plan overwrites the slot on conflicts.
+ */
+#define GPUJOIN_FEEDBACK_NSLOTS		1024
+#define GPUJOIN_FEEDBACK_MAX_RELS	15
+
+typedef struct
+{
+	pg_crc32	signature;		/* plan signature, or 0 if empty */
+	cl_int		num_rels;		/* number of inner relations */
+	cl_uint		nsamples;		/* number of executions observed */
+	cl_float	growth_ratio[GPUJOIN_FEEDBACK_MAX_RELS + 1];
+} gpujoin_feedback_entry;
+
+typedef struct
+{
+	slock_t		lock;
+	gpujoin_feedback_entry entries[GPUJOIN_FEEDBACK_NSLOTS];
+} gpujoin_feedback_head;
+
+static shmem_startup_hook_type shmem_startup_next;
+static gpujoin_feedback_head *gjfb_head = NULL;
 
 /* static functions */
 static bool	gpujoin_task_process(GpuTask *gtask);
@@ -359,6 +459,12 @@ static pg_crc32 get_tuple_hashvalue(innerState *istate,
 									bool is_inner_hashkeys,
 									TupleTableSlot *slot,
 									bool *p_is_null_keys);
+static void gpujoin_fallback_tuple_extract(TupleTableSlot *slot_fallback,
+										   TupleDesc tupdesc, Oid table_oid,
+										   kern_tupitem *tupitem,
+										   AttrNumber *tuple_dst_resno,
+										   AttrNumber src_anum_min,
+										   AttrNumber src_anum_max);
 
 static char *gpujoin_codegen(PlannerInfo *root,
 							 CustomScan *cscan,
@@ -367,6 +473,8 @@ static char *gpujoin_codegen(PlannerInfo *root,
 
 static void gpujoin_inner_unload(GpuJoinState *gjs, bool needs_rescan);
 static pgstrom_multirels *gpujoin_inner_getnext(GpuJoinState *gjs);
+static void gpujoin_grace_setup(GpuJoinState *gjs);
+static void gpujoin_grace_cleanup(GpuJoinState *gjs);
 static pgstrom_multirels *multirels_attach_buffer(pgstrom_multirels *pmrels);
 static bool multirels_get_buffer(pgstrom_multirels *pmrels,
 								 pgstrom_gpujoin *pgjoin);
@@ -904,7 +1012,9 @@ cost_gpujoin(PlannerInfo *root,
 				appendStringInfo(&buf, " %s%s ",
 								 join_type == JOIN_FULL ? "F" :
 								 join_type == JOIN_LEFT ? "L" :
-								 join_type == JOIN_RIGHT ? "R" : "I",
+								 join_type == JOIN_RIGHT ? "R" :
+								 join_type == JOIN_SEMI ? "S" :
+								 join_type == JOIN_ANTI ? "A" : "I",
 								 is_nestloop ? "NL" : "HJ");
 
 				__dump_gpujoin_path(&buf, root, inner_path);
@@ -1274,7 +1384,9 @@ gpujoin_add_join_path(PlannerInfo *root,
 		if (ip_item->join_type != JOIN_INNER &&
 			ip_item->join_type != JOIN_FULL &&
 			ip_item->join_type != JOIN_RIGHT &&
-			ip_item->join_type != JOIN_LEFT)
+			ip_item->join_type != JOIN_LEFT &&
+			ip_item->join_type != JOIN_SEMI &&
+			ip_item->join_type != JOIN_ANTI)
 			break;
 
 		Assert(outerrel == outer_path->parent);
@@ -1309,7 +1421,7 @@ gpujoin_add_join_path(PlannerInfo *root,
 			 * If processing an outer join, only use its own join clauses
 			 * for hashing.  For inner joins we need not be so picky.
 			 */
-			if (IS_OUTER_JOIN(jointype) && rinfo->is_pushed_down)
+			if (IS_OUTER_JOIN(ip_item->join_type) && rinfo->is_pushed_down)
 				continue;
 
 			/* Is it hash-joinable clause? */
@@ -1334,6 +1446,10 @@ gpujoin_add_join_path(PlannerInfo *root,
 
 		/*
 		 * OK, try GpuNestLoop logic
+		 *
+		 * NOTE: SEMI/ANTI JOIN is supported by GpuHashJoin only, because
+		 * it has to see all the inner rows at once to emit an outer row
+		 * at most once, but GpuNestLoop may split inner relation.
 		 */
 		if (enable_gpunestloop &&
 			(ip_item->join_type == JOIN_INNER ||
@@ -1806,6 +1922,9 @@ create_gpujoin_plan(PlannerInfo *root,
 												false);
 			other_quals = NIL;
 		}
+		/* cheap and selective qualifiers shall be evaluated first */
+		join_quals = pgstrom_reorder_device_quals(root, join_quals);
+		other_quals = pgstrom_reorder_device_quals(root, other_quals);
 		gj_info.join_quals = lappend(gj_info.join_quals,
 									 build_flatten_qualifier(join_quals));
 		gj_info.other_quals = lappend(gj_info.other_quals,
@@ -1832,6 +1951,7 @@ create_gpujoin_plan(PlannerInfo *root,
 		Index	scanrelid = ((Scan *) outer_plan)->scanrelid;
 
 		cscan->scan.scanrelid = scanrelid;
+		outer_quals = pgstrom_reorder_device_quals(root, outer_quals);
 		gj_info.outer_quals = build_flatten_qualifier(outer_quals);
 		outer_plan = NULL;
 	}
@@ -1852,6 +1972,7 @@ create_gpujoin_plan(PlannerInfo *root,
 	pgstrom_init_codegen_context(&context);
 	context.pseudo_tlist = cscan->custom_scan_tlist;
 
+	gj_info.hash_function = pgstrom_hash_function;
 	gj_info.kern_source = gpujoin_codegen(root, cscan, &gj_info, &context);
 	gj_info.extra_flags = (DEVKERNEL_NEEDS_GPUJOIN |
 						   DEVKERNEL_NEEDS_DYNPARA |
@@ -1878,6 +1999,7 @@ codegen_device_projection(CustomScan *cscan, GpuJoinInfo *gj_info,
 	List		   *tlist_dev = cscan->custom_scan_tlist;
 	List		   *ps_src_depth = gj_info->ps_src_depth;
 	List		   *ps_src_resno = gj_info->ps_src_resno;
+	List		   *exprs = NIL;
 	ListCell	   *lc1;
 	ListCell	   *lc2;
 	ListCell	   *lc3;
@@ -2114,6 +2236,17 @@ codegen_device_projection(CustomScan *cscan, GpuJoinInfo *gj_info,
 	/*
 	 * Execution of the expression
 	 */
+	forboth (lc1, tlist_dev,
+			 lc2, ps_src_depth)
+	{
+		TargetEntry	   *tle = lfirst(lc1);
+		cl_int			src_depth = lfirst_int(lc2);
+
+		if (!tle->resjunk && src_depth < 0)
+			exprs = lappend(exprs, tle->expr);
+	}
+	appendStringInfoString(&body, pgstrom_codegen_cse_begin(exprs, context));
+
 	is_first = true;
 	extra_maxlen = 0;
 	forboth (lc1, tlist_dev,
@@ -2284,6 +2417,8 @@ codegen_device_projection(CustomScan *cscan, GpuJoinInfo *gj_info,
 			}
 		}
 	}
+	pgstrom_codegen_cse_end(context);
+
 	/* how much extra field required? */
 	appendStringInfoString(
 		&body,
@@ -2732,6 +2867,144 @@ assign_gpujoin_session_info(StringInfo buf, GpuTaskState *gts)
 		((GpuJoinState *) gts)->extra_maxlen);
 }
 
+/*
+ * gpujoin_feedback_lookup
+ *
+ * It looks up the join growth ratio of the same plan shape observed by
+ * the previous executions. The plan shape is identified by the generated
+ * kernel source, join types and the outer relation.
+ */
+static void
+gpujoin_feedback_lookup(GpuJoinState *gjs, GpuJoinInfo *gj_info)
+{
+	Relation	outer_rel = gjs->gts.css.ss.ss_currentRelation;
+	Oid			outer_relid = (outer_rel ? RelationGetRelid(outer_rel)
+							   : InvalidOid);
+	pg_crc32	signature;
+	gpujoin_feedback_entry *entry;
+	ListCell   *lc;
+	int			i;
+
+	if (!gjfb_head || gjs->num_rels > GPUJOIN_FEEDBACK_MAX_RELS)
+		return;
+
+	INIT_LEGACY_CRC32(signature);
+	COMP_LEGACY_CRC32(signature, &gjs->num_rels, sizeof(int));
+	COMP_LEGACY_CRC32(signature, &outer_relid, sizeof(Oid));
+	COMP_LEGACY_CRC32(signature, &gj_info->extra_flags, sizeof(int));
+	foreach (lc, gj_info->join_types)
+	{
+		int		join_type = lfirst_int(lc);
+
+		COMP_LEGACY_CRC32(signature, &join_type, sizeof(int));
+	}
+	COMP_LEGACY_CRC32(signature, gj_info->kern_source,
+					  strlen(gj_info->kern_source));
+	FIN_LEGACY_CRC32(signature);
+	if (signature == 0)
+		signature = 1;		/* 0 means empty slot */
+	gjs->fb_signature = signature;
+
+	if (!enable_gpujoin_feedback)
+		return;
+
+	entry = &gjfb_head->entries[signature % GPUJOIN_FEEDBACK_NSLOTS];
+	SpinLockAcquire(&gjfb_head->lock);
+	if (entry->signature == signature &&
+		entry->num_rels == gjs->num_rels)
+	{
+		gjs->fb_ratio = palloc(sizeof(cl_double) * (gjs->num_rels + 1));
+		for (i=0; i <= gjs->num_rels; i++)
+			gjs->fb_ratio[i] = entry->growth_ratio[i];
+	}
+	SpinLockRelease(&gjfb_head->lock);
+}
+
+/*
+ * gpujoin_feedback_update
+ *
+ * It saves the join growth ratio actually observed on this execution.
+ * It is blended with the previous value, to avoid a sudden swing by
+ * a particular execution.
+ */
+static void
+gpujoin_feedback_update(GpuJoinState *gjs)
+{
+	gpujoin_feedback_entry *entry;
+	cl_double	ratio[GPUJOIN_FEEDBACK_MAX_RELS + 1];
+	size_t		nitems_in;
+	int			i;
+
+	if (!gjfb_head || gjs->fb_signature == 0 ||
+		!enable_gpujoin_feedback || gjs->source_nitems == 0)
+		return;
+
+	for (i=0; i <= gjs->num_rels; i++)
+	{
+		if (i == 0)
+			nitems_in = gjs->source_nitems;
+		else
+			nitems_in = gjs->inner_nitems[i-1] + gjs->right_nitems[i-1];
+
+		if (nitems_in == 0)
+			ratio[i] = -1.0;	/* unknown */
+		else if (i == 0)
+			ratio[i] = ((double)(gjs->inner_nitems[0] +
+								 gjs->right_nitems[0]) /
+						(double) nitems_in);
+		else
+			ratio[i] = (double) gjs->inner_nitems[i] / (double) nitems_in;
+	}
+
+	entry = &gjfb_head->entries[gjs->fb_signature % GPUJOIN_FEEDBACK_NSLOTS];
+	SpinLockAcquire(&gjfb_head->lock);
+	if (entry->signature != gjs->fb_signature ||
+		entry->num_rels != gjs->num_rels)
+	{
+		entry->signature = gjs->fb_signature;
+		entry->num_rels = gjs->num_rels;
+		entry->nsamples = 0;
+		for (i=0; i <= gjs->num_rels; i++)
+			entry->growth_ratio[i] = -1.0;
+	}
+	for (i=0; i <= gjs->num_rels; i++)
+	{
+		if (ratio[i] < 0.0)
+			continue;
+		if (entry->growth_ratio[i] < 0.0)
+			entry->growth_ratio[i] = ratio[i];
+		else
+			entry->growth_ratio[i] = (entry->growth_ratio[i] + ratio[i]) / 2.0;
+	}
+	entry->nsamples++;
+	SpinLockRelease(&gjfb_head->lock);
+}
+
+/*
+ * gpujoin_outer_only_keys
+ *
+ * It checks whether the hash keys reference only outer columns, thus,
+ * the hash value is computable at the outer scan.
+ */
+static bool
+gpujoin_outer_only_keys(List *hash_outer_keys, List *ps_src_depth)
+{
+	List	   *vars_list = pull_vars_of_level((Node *) hash_outer_keys, 0);
+	ListCell   *lc;
+
+	foreach (lc, vars_list)
+	{
+		Var	   *var = lfirst(lc);
+
+		if (var->varno != INDEX_VAR ||
+			var->varattno < 1 ||
+			var->varattno > list_length(ps_src_depth) ||
+			list_nth_int(ps_src_depth, var->varattno - 1) != 0)
+			return false;
+	}
+	return true;
+}
+
 static Node *
 gpujoin_create_scan_state(CustomScan *node)
 {
@@ -2829,6 +3102,8 @@ gpujoin_begin(CustomScanState *node, EState *estate, int eflags)
 	{
 		ExprState  *expr_state = ExecInitExpr(gj_info->outer_quals, &ss->ps);
 		gjs->outer_quals = list_make1(expr_state);
+		gjs->hostjit_quals =
+			pgstrom_hostjit_create_quals((Node *) gj_info->outer_quals);
 	}
 	gjs->outer_ratio = gj_info->outer_ratio;
 	gjs->outer_nrows = gj_info->outer_nrows;
@@ -3007,6 +3282,8 @@ gpujoin_begin(CustomScanState *node, EState *estate, int eflags)
 		{
 			cl_uint		shift;
 
+			istate->hash_function = gj_info->hash_function;
+
 			hash_inner_keys = fixup_varnode_to_origin(i+1,
 													  gj_info->ps_src_depth,
 													  gj_info->ps_src_resno,
@@ -3048,6 +3325,33 @@ gpujoin_begin(CustomScanState *node, EState *estate, int eflags)
 			istate->hgram_nitems = palloc0(sizeof(Size) * istate->hgram_width);
 			istate->hgram_shift = sizeof(cl_uint) * BITS_PER_BYTE - shift;
 			istate->hgram_curr = 0;
+
+			/*
+			 * Bloom filter of the inner keys is applicable if outer rows
+			 * without matched inner rows are simply dropped, and the hash
+			 * value is computable from the outer columns only.
+			 * Filtering out outer rows breaks outer-join map of the
+			 * shallower RIGHT/FULL OUTER JOIN, so it is not applicable
+			 * also. Once most outer rows are expected to match, we don't
+			 * take the cost for the filter.
+			 */
+			istate->bloom_enabled =
+				(enable_gpujoin_bloom_filter &&
+				 (istate->join_type == JOIN_INNER ||
+				  istate->join_type == JOIN_RIGHT ||
+				  istate->join_type == JOIN_SEMI) &&
+				 (first_right_outer_depth < 0 ||
+				  first_right_outer_depth == istate->depth) &&
+				 istate->nrows_ratio < 0.9 &&
+				 gpujoin_outer_only_keys(hash_outer_keys,
+										 gj_info->ps_src_depth));
+
+			/* shared inner cache, if cacheable */
+			istate->icache_key =
+				pgstrom_inner_cache_key(istate->state,
+										hash_inner_keys,
+										istate->join_type,
+										istate->hash_function);
 		}
 
 		/*
@@ -3090,6 +3394,37 @@ gpujoin_begin(CustomScanState *node, EState *estate, int eflags)
 	gjs->first_right_outer_depth = Min(first_right_outer_depth,
 									   gjs->num_rels + 1);
 
+	/* join growth ratio observed by the previous executions, if any */
+	if ((eflags & EXEC_FLAG_EXPLAIN_ONLY) == 0)
+		gpujoin_feedback_lookup(gjs, gj_info);
+
+	/*
+	 * Outer rows can be partitioned by the hash range of the inner chunks
+	 * if its hash value is computable from the outer columns only. Any
+	 * other depth must not be RIGHT/FULL OUTER JOIN, because it tracks
+	 * unmatched inner rows on the assumption that every pass sees all the
+	 * outer rows.
+	 */
+	for (i=0; i < gjs->num_rels; i++)
+	{
+		innerState *istate = &gjs->inners[i];
+		List	   *hash_outer_keys = list_nth(gj_info->hash_outer_keys, i);
+
+		if (!enable_gpujoin_grace_hash || hash_outer_keys == NIL)
+			continue;
+		for (j=0; j < gjs->num_rels; j++)
+		{
+			if (j != i &&
+				(gjs->inners[j].join_type == JOIN_RIGHT ||
+				 gjs->inners[j].join_type == JOIN_FULL))
+				break;
+		}
+		if (j < gjs->num_rels)
+			continue;
+		istate->grace_capable =
+			gpujoin_outer_only_keys(hash_outer_keys, gj_info->ps_src_depth);
+	}
+
 	/*
 	 * Construct CUDA program, and kick asynchronous compile process.
 	 * Note that assign_gpujoin_session_info() is called back from
@@ -3129,6 +3464,9 @@ gpujoin_end(CustomScanState *node)
 	GpuJoinState   *gjs = (GpuJoinState *) node;
 	int				i;
 
+	/* save the join growth ratio for the next execution */
+	gpujoin_feedback_update(gjs);
+
 	/*
 	 * clean up GpuJoin specific resources
 	 */
@@ -3137,6 +3475,7 @@ gpujoin_end(CustomScanState *node)
 		multirels_detach_buffer(gjs->curr_pmrels, false, __FUNCTION__);
 		gjs->curr_pmrels = NULL;
 	}
+	gpujoin_grace_cleanup(gjs);
 	gpujoin_inner_unload(gjs, false);
 
 	/*
@@ -3153,7 +3492,6 @@ static void
 gpujoin_rescan(CustomScanState *node)
 {
 	GpuJoinState   *gjs = (GpuJoinState *) node;
-	bool			keep_inners = true;
 	cl_int			i;
 
 	/* inform this GpuTaskState will produce more rows, prior to cleanup */
@@ -3168,12 +3506,8 @@ gpujoin_rescan(CustomScanState *node)
 	if (gjs->gts.css.ss.ps.chgParam != NULL)
 	{
 		for (i=0; i < gjs->num_rels; i++)
-		{
 			UpdateChangedParamSet(gjs->inners[i].state,
 								  gjs->gts.css.ss.ps.chgParam);
-			if (gjs->inners[i].state->chgParam != NULL)
-				keep_inners = false;
-		}
 	}
 
 	/*
@@ -3194,21 +3528,14 @@ gpujoin_rescan(CustomScanState *node)
 		multirels_detach_buffer(gjs->curr_pmrels, false, __FUNCTION__);
 		gjs->curr_pmrels = NULL;
 	}
+	gpujoin_grace_cleanup(gjs);
 
-	if (!keep_inners)
-		gpujoin_inner_unload(gjs, true);
-	else
-	{
-		/*
-		 * Just rewind the inner pointer.
-		 *
-		 * NOTE: It is a tricky hack. gpujoin_inner_getnext() increments
-		 * the pds_index prior to construction of pmrels, so all pds_index
-		 * shall be reverted to 1, as expected beginning point.
-		 */
-        for (i=0; i < gjs->num_rels; i++)
-            gjs->inners[i].pds_index = 0;
-	}
+	/*
+	 * Release the inner relations whose parameters were changed, then
+	 * rewind the others. Unchanged inner chunks (and the multirels buffer
+	 * if all the inners are unchanged) are reused on the next scan.
+	 */
+	gpujoin_inner_unload(gjs, true);
 }
 
 static void
@@ -3301,7 +3628,9 @@ gpujoin_explain(CustomScanState *node, List *ancestors, ExplainState *es)
 			appendStringInfo(&str, "GpuHash%sJoin",
 							 join_type == JOIN_FULL ? "Full" :
 							 join_type == JOIN_LEFT ? "Left" :
-							 join_type == JOIN_RIGHT ? "Right" : "");
+							 join_type == JOIN_RIGHT ? "Right" :
+							 join_type == JOIN_SEMI ? "Semi" :
+							 join_type == JOIN_ANTI ? "Anti" : "");
 		}
 		else
 		{
@@ -3366,7 +3695,7 @@ gpujoin_explain(CustomScanState *node, List *ancestors, ExplainState *es)
 			{
 				appendStringInfo(
 					&str,
-					"Nrows (in:%zu out:%zu+%zu, %.2f%% planned %.2f%%)",
+					"Nrows (in:%zu out:%zu+%zu, %.2f%% planned %.2f%%",
 					nrows_in,
 					nrows_out1,
 					nrows_out2,
@@ -3378,13 +3707,18 @@ gpujoin_explain(CustomScanState *node, List *ancestors, ExplainState *es)
 			{
 				appendStringInfo(
 					&str,
-					"Nrows (in:%zu out:%zu, %.2f%% planned %.2f%%)",
+					"Nrows (in:%zu out:%zu, %.2f%% planned %.2f%%",
 					nrows_in,
 					nrows_out1,
 					100.0 * ((double)(nrows_out1) /
 							 (double)(nrows_in)),
 					100.0 * nrows_ratio);
 			}
+			/* growth ratio by the previous executions, if used */
+			if (gjs->fb_ratio && gjs->fb_ratio[depth] >= 0.0)
+				appendStringInfo(&str, " feedback %.2f%%",
+								 100.0 * gjs->fb_ratio[depth]);
+			appendStringInfoChar(&str, ')');
 
 			if (es->format == EXPLAIN_FORMAT_TEXT)
 			{
@@ -3396,12 +3730,29 @@ gpujoin_explain(CustomScanState *node, List *ancestors, ExplainState *es)
 
 			appendStringInfo(
 				&str,
-				"KDS-%s (size: %s planned %s, nbatches: %u planned %u)",
+				"KDS-%s (size: %s planned %s, nbatches: %u planned %u%s%s)",
 				hash_outer_key ? "Hash" : "Heap",
 				format_bytesz(istate->pds_limit),
 				format_bytesz(istate->ichunk_size),
 				istate->nbatches_exec,
-				istate->nbatches_plan);
+				istate->nbatches_plan,
+				istate->grace_partitioned ? ", partitioned" : "",
+				istate->icache_hit ? ", cached" : "");
+			if (istate->grace_partitioned && es->analyze)
+				appendStringInfo(&str, ", Spilled: %zu rows",
+								 gjs->grace_nspilled);
+			if (istate->skew_nkeys > 0)
+				appendStringInfo(
+					&str,
+					", Skew (keys: %u, rows: %zu)",
+					istate->skew_nkeys,
+					istate->skew_nitems);
+			if (istate->bloom)
+				appendStringInfo(
+					&str,
+					", Bloom (size: %s)",
+					format_bytesz(((Size) istate->bloom_mask + 1) /
+								  BITS_PER_BYTE));
 		}
 		else
 		{
@@ -3500,12 +3851,16 @@ gpujoin_codegen_outer_quals(StringInfo source,
 	{
 		List   *pseudo_tlist_saved = context->pseudo_tlist;
 		Node   *outer_quals = (Node *) gj_info->outer_quals;
+		char   *cse_text;
 		char   *expr_text;
 
 		context->pseudo_tlist = NIL;
+		cse_text = pgstrom_codegen_cse_begin(gj_info->outer_quals, context);
 		expr_text = pgstrom_codegen_expression(outer_quals, context);
+		pgstrom_codegen_cse_end(context);
 		pgstrom_codegen_param_declarations(source, context);
 		pgstrom_codegen_var_declarations(source, context);
+		appendStringInfoString(source, cse_text);
 
 		appendStringInfo(
 			source,
@@ -3721,6 +4076,7 @@ gpujoin_codegen_join_quals(StringInfo source,
 {
 	List	   *join_quals;
 	List	   *other_quals;
+	char	   *cse_code;
 	char	   *join_quals_code = NULL;
 	char	   *other_quals_code = NULL;
 
@@ -3733,12 +4089,15 @@ gpujoin_codegen_join_quals(StringInfo source,
 	 */
 	context->used_vars = NIL;
 	context->param_refs = NULL;
+	cse_code = pgstrom_codegen_cse_begin(list_concat(list_copy(join_quals),
+													 other_quals), context);
 	if (join_quals != NIL)
 		join_quals_code = pgstrom_codegen_expression((Node *)join_quals,
 													 context);
 	if (other_quals != NIL)
 		other_quals_code = pgstrom_codegen_expression((Node *)other_quals,
 													  context);
+	pgstrom_codegen_cse_end(context);
 	/*
 	 * function declaration
 	 */
@@ -3758,6 +4117,7 @@ gpujoin_codegen_join_quals(StringInfo source,
 	 * variable/params declaration & initialization
 	 */
 	gpujoin_codegen_var_param_decl(source, gj_info, cur_depth, context);
+	appendStringInfoString(source, cse_code);
 
 	/*
 	 * evaluation of other-quals and join-quals
@@ -3838,10 +4198,15 @@ gpujoin_codegen_hash_value(StringInfo source,
 	context->param_refs = NULL;
 
 	initStringInfo(&body);
+	appendStringInfoString(&body, pgstrom_codegen_cse_begin(hash_outer_keys,
+															context));
 	appendStringInfo(
 		&body,
 		"  /* Hash-value calculation */\n"
-		"  INIT_LEGACY_CRC32(hash);\n");
+		"  %s(hash);\n",
+		gj_info->hash_function == HASHFUNC_FASTHASH
+		? "INIT_FAST_HASH"
+		: "INIT_LEGACY_CRC32");
 	foreach (lc, hash_outer_keys)
 	{
 		Node	   *key_expr = lfirst(lc);
@@ -3856,15 +4221,28 @@ gpujoin_codegen_hash_value(StringInfo source,
 			&body,
 			"  temp.%s_v = %s;\n"
 			"  if (!temp.%s_v.isnull)\n"
-			"    is_null_keys = false;\n"
-			"  hash = pg_%s_comp_crc32(pg_crc32_table, hash, temp.%s_v);\n",
+			"    is_null_keys = false;\n",
 			dtype->type_name,
 			pgstrom_codegen_expression(key_expr, context),
-			dtype->type_name,
-			dtype->type_name,
 			dtype->type_name);
+		if (gj_info->hash_function == HASHFUNC_FASTHASH)
+			appendStringInfo(
+				&body,
+				"  hash = pg_%s_comp_fasthash(hash, temp.%s_v);\n",
+				dtype->type_name,
+				dtype->type_name);
+		else
+			appendStringInfo(
+				&body,
+				"  hash = pg_%s_comp_crc32(pg_crc32_table, hash, temp.%s_v);\n",
+				dtype->type_name,
+				dtype->type_name);
 	}
-	appendStringInfo(&body, "  FIN_LEGACY_CRC32(hash);\n");
+	appendStringInfo(&body, "  %s(hash);\n",
+					 gj_info->hash_function == HASHFUNC_FASTHASH
+					 ? "FIN_FAST_HASH"
+					 : "FIN_LEGACY_CRC32");
+	pgstrom_codegen_cse_end(context);
 
 	/*
 	 * variable/params declaration & initialization
@@ -4015,6 +4393,17 @@ gpujoin_exec_estimate_nitems(GpuJoinState *gjs,
 					  : 0.0);
 	merge_ratio = Min(1.0, merge_ratio);	/* up to 100% */
 
+	/*
+	 * Growth ratio observed by the previous executions of the same plan
+	 * shape is more reliable than the plan estimation.
+	 */
+	if (depth == 0)
+		plan_ratio = gjs->outer_ratio;
+	else
+		plan_ratio = istate->nrows_ratio;
+	if (gjs->fb_ratio && gjs->fb_ratio[depth] >= 0.0)
+		plan_ratio = gjs->fb_ratio[depth];
+
 	/* special case handling for outer_quals evaluation */
 	if (depth == 0)
 	{
@@ -4048,14 +4437,13 @@ gpujoin_exec_estimate_nitems(GpuJoinState *gjs,
 		 * plan estimation
 		 */
 		if (gjs->source_nitems == 0)
-			return (double) jscale[0].window_size * gjs->outer_ratio;
+			return (double) jscale[0].window_size * plan_ratio;
 
 		/*
 		 * Elsewhere, we mix the plan estimation and run-time statistics
 		 * according to the outer scan progress. Once merge_ratio gets
 		 * to 100%, plan estimation shall be entirely ignored.
 		 */
-		plan_ratio = gjs->outer_ratio;
 		exec_ratio = ((double)(gjs->inner_nitems[0] +
 							   gjs->right_nitems[0]) /
 					  (double)(gjs->source_nitems));
@@ -4094,7 +4482,6 @@ gpujoin_exec_estimate_nitems(GpuJoinState *gjs,
 			pgstrom_data_store *pds_in = pmrels->inner_chunks[depth - 1];
 			cl_uint				nitems_in = pds_in->kds->nitems;
 
-			plan_ratio = istate->nrows_ratio;
 			if (gjs->inner_nitems[depth - 1] +
 				gjs->right_nitems[depth - 1] > 0)
 				exec_ratio = ((double)(gjs->inner_nitems[depth]) /
@@ -4232,7 +4619,7 @@ gpujoin_attach_result_buffer(GpuJoinState *gjs,
 			 */
 			cl_int	nsplit = length / pgstrom_chunk_size_limit() + 1;
 
-			Assert(target_depth > 0 && target_depth <= gjs->num_rels);
+			Assert(target_depth >= 0 && target_depth <= gjs->num_rels);
 			pgjoin->kern.jscale[target_depth].window_size
 				= (pgjoin->kern.jscale[target_depth].window_size / nsplit) + 1;
 			if (pgjoin->kern.jscale[target_depth].window_size <= 1)
@@ -4314,14 +4701,15 @@ gpujoin_attach_result_buffer(GpuJoinState *gjs,
 /*
  * gpujoin_create_task
  *
- *
- *
+ * If pgjoin_count is supplied, it is the count phase of two-phase execution
+ * that reported the number of join results actually required.
  */
 static GpuTask *
 gpujoin_create_task(GpuJoinState *gjs,
 					pgstrom_multirels *pmrels,
 					pgstrom_data_store *pds_src,
-					kern_join_scale *jscale_old)
+					kern_join_scale *jscale_old,
+					pgstrom_gpujoin *pgjoin_count)
 {
 	GpuContext		   *gcontext = gjs->gts.gcontext;
 	pgstrom_gpujoin	   *pgjoin;
@@ -4418,6 +4806,26 @@ gpujoin_create_task(GpuJoinState *gjs,
 	}
 	Assert(!jscale_old || jscale_rewind);
 
+	/*
+	 * Two-phase execution; the first run works as count phase unless the
+	 * result buffer is sufficient. Once it overflowed, the kernel reports
+	 * the number of join results actually required, then the next run
+	 * materializes the results with the exact size instead of the window
+	 * split. Each run fixes one more depth at least.
+	 */
+	if (gpujoin_count_then_materialize && pds_src && !jscale_old)
+	{
+		if (!pgjoin_count)
+			pgjoin->kern.count_retry = gjs->num_rels;
+		else
+		{
+			pgjoin->kern.count_retry = pgjoin_count->kern.count_retry - 1;
+			for (i=0; i <= gjs->num_rels; i++)
+				pgjoin->kern.jscale[i].nitems_required =
+					pgjoin_count->kern.jscale[i].nitems_required;
+		}
+	}
+
 	/*
 	 * Estimation of the number of join result items for each depth
 	 */
@@ -4441,6 +4849,21 @@ major_retry:
 													jscale_old,
 													ntuples,
 													depth);
+		/* number of results reported by the count phase, if any */
+		if (pgjoin->kern.jscale[depth].nitems_required > 0)
+		{
+			kern_join_scale	   *jscale = pgjoin->kern.jscale;
+			double				nrows = jscale[depth].nitems_required;
+
+			/* adjustment if window was split after the count phase */
+			for (i=0; i <= depth; i++)
+			{
+				if (pgjoin_count->kern.jscale[i].window_size > 0)
+					nrows *= ((double) jscale[i].window_size /
+							  (double) pgjoin_count->kern.jscale[i].window_size);
+			}
+			ntuples_next = Max(ntuples_next, nrows);
+		}
 
 		/* check expected length of the kern_gpujoin head */
 		max_items_temp = (Size)((double)(depth+1) *
@@ -4453,9 +4876,10 @@ major_retry:
 		/*
 		 * Remember the largest distributed depth (if run-time statistics
 		 * exists), or depth with largest delta elsewhere, for later
-		 * window reduction.
+		 * window reduction. Inner window of SEMI/ANTI JOIN is never split,
+		 * because it has to see all the inner rows at once.
 		 */
-		if (depth > 0)
+		if (depth > 0 && !gpujoin_single_match(&gjs->inners[depth-1]))
 		{
 			if (gjs->row_dist_score_valid)
 			{
@@ -4495,7 +4919,7 @@ major_retry:
 		 * TODO: We may be able to utilize in-kernel joined row distribution
 		 *       histgram for better separation point.
 		 */
-		if (depth > 0 &&
+		if (depth > 0 && !gpujoin_single_match(&gjs->inners[depth-1]) &&
 			(depth == 1 || ntuples_next - ntuples > ntuples_delta))
 		{
 			ntuples_delta = Max(ntuples_next - ntuples, 0.0);
@@ -4572,6 +4996,325 @@ major_retry:
 }
 
 
+/*
+ * gpujoin_outer_tupdesc
+ *
+ * It returns the tuple-descriptor of the outer chunks.
+ */
+static TupleDesc
+gpujoin_outer_tupdesc(GpuJoinState *gjs)
+{
+	if (gjs->gts.css.ss.ss_currentRelation)
+		return RelationGetDescr(gjs->gts.css.ss.ss_currentRelation);
+	return ExecGetResultType(outerPlanState(gjs));
+}
+
+/*
+ * gpujoin_grace_partition
+ *
+ * It returns the index of the inner chunk which covers the supplied hash
+ * value at the partitioned depth.
+ */
+static int
+gpujoin_grace_partition(GpuJoinState *gjs, pg_crc32 hash)
+{
+	innerState *istate = &gjs->inners[gjs->grace_depth - 1];
+	ListCell   *lc;
+	int			index = 1;
+
+	foreach (lc, istate->pds_list)
+	{
+		pgstrom_data_store *pds = lfirst(lc);
+
+		if (hash <= pds->kds->hash_max)
+			return index;
+		index++;
+	}
+	elog(ERROR, "Bug? no inner chunk covers hash value %08x", hash);
+	return -1;	/* be compiler quiet */
+}
+
+/*
+ * gpujoin_exec_outer_prefilter
+ *
+ * It removes outer rows which have no matched inner keys according to the
+ * bloom filter, and moves outer rows which shall be joined with the later
+ * inner chunks to the partition files, if partitioned join. Then, shrinks
+ * the outer chunk to reduce DMA. It returns false if no rows are left.
+ */
+static bool
+gpujoin_exec_outer_prefilter(GpuJoinState *gjs, pgstrom_data_store *pds)
+{
+	kern_data_store	   *kds = pds->kds;
+	cl_uint			   *row_index = KERN_DATA_STORE_ROWINDEX(kds);
+	TupleTableSlot	   *slot_fallback = gjs->slot_fallback;
+	TupleDesc			tupdesc;
+	char			   *buffer;
+	Size				usage = 0;
+	Size				length;
+	cl_uint				i, nitems;
+	int					depth;
+	bool				has_bloom = false;
+	bool				do_partition = false;
+
+	if (kds->format != KDS_FORMAT_ROW || kds->nitems == 0)
+		return true;
+	if (gpujoin_bloom_prefilter)
+	{
+		for (depth=1; depth <= gjs->num_rels; depth++)
+		{
+			if (gjs->inners[depth-1].bloom)
+				has_bloom = true;
+		}
+	}
+	/* outer rows are partitioned only on the first pass */
+	if (gjs->grace_depth > 0 &&
+		gjs->inners[gjs->grace_depth - 1].pds_index == 1)
+		do_partition = true;
+	if (!has_bloom && !do_partition)
+		return true;	/* nothing to do */
+
+	tupdesc = gpujoin_outer_tupdesc(gjs);
+
+	/* see the comment in gpujoin_next_tuple_fallback */
+	ExecClearTuple(slot_fallback);
+	ExecStoreVirtualTuple(slot_fallback);
+
+	buffer = palloc(kds->usage);
+	for (i=0; i < kds->nitems; i++)
+	{
+		kern_tupitem   *tupitem = KERN_DATA_STORE_TUPITEM(kds, i);
+		pg_crc32		hash;
+		bool			is_null_keys;
+
+		gpujoin_fallback_tuple_extract(slot_fallback,
+									   tupdesc,
+									   kds->table_oid,
+									   tupitem,
+									   gjs->outer_dst_resno,
+									   gjs->outer_src_anum_min,
+									   gjs->outer_src_anum_max);
+		for (depth=1; has_bloom && depth <= gjs->num_rels; depth++)
+		{
+			innerState *istate = &gjs->inners[depth-1];
+
+			if (!istate->bloom)
+				continue;
+			ResetExprContext(istate->econtext);
+			hash = get_tuple_hashvalue(istate, false, slot_fallback,
+									   &is_null_keys);
+			if (is_null_keys ||
+				!gpujoin_bloom_filter_test(istate->bloom,
+										   istate->bloom_mask, hash))
+				break;
+		}
+		if (has_bloom && depth <= gjs->num_rels)
+			continue;	/* filtered out */
+
+		length = LONGALIGN(offsetof(kern_tupitem, htup) + tupitem->t_len);
+		if (do_partition)
+		{
+			innerState *istate = &gjs->inners[gjs->grace_depth - 1];
+			int			index;
+
+			ResetExprContext(istate->econtext);
+			hash = get_tuple_hashvalue(istate, false, slot_fallback,
+									   &is_null_keys);
+			index = gpujoin_grace_partition(gjs, hash);
+			if (index > 1)
+			{
+				BufFile	   *file = gjs->grace_files[index - 1];
+
+				if (!file)
+				{
+					file = BufFileCreateTemp(false);
+					gjs->grace_files[index - 1] = file;
+				}
+				if (BufFileWrite(file, tupitem, length) != length)
+					ereport(ERROR,
+							(errcode_for_file_access(),
+							 errmsg("could not write to GpuJoin temporary file: %m")));
+				gjs->grace_nspilled++;
+				continue;
+			}
+		}
+		Assert(usage + length <= kds->usage);
+		memcpy(buffer + usage, tupitem, length);
+		usage += length;
+	}
+	ExecClearTuple(slot_fallback);
+
+	/* rebuild the outer chunk with the survived rows */
+	nitems = 0;
+	kds->usage = 0;
+	for (length = 0; length < usage; )
+	{
+		kern_tupitem   *tupitem = (kern_tupitem *)(buffer + length);
+		Size			sz = LONGALIGN(offsetof(kern_tupitem, htup) +
+									   tupitem->t_len);
+
+		kds->usage += sz;
+		memcpy((char *)kds + kds->length - kds->usage, tupitem, sz);
+		row_index[nitems++] = kds->length - kds->usage;
+		length += sz;
+	}
+	kds->nitems = nitems;
+	pfree(buffer);
+	PDS_shrink_size(pds);
+
+	return (nitems > 0);
+}
+
+/*
+ * gpujoin_grace_setup
+ *
+ * It enables partitioned join if only one depth has multiple inner chunks
+ * partitioned by the hash value.
+ */
+static void
+gpujoin_grace_setup(GpuJoinState *gjs)
+{
+	innerState *istate;
+	int			i, grace_depth = 0;
+
+	Assert(gjs->grace_depth == 0 && !gjs->grace_files);
+	for (i=0; i < gjs->num_rels; i++)
+	{
+		istate = &gjs->inners[i];
+		if (list_length(istate->pds_list) < 2)
+			continue;
+		if (grace_depth > 0 || !istate->grace_capable)
+			return;		/* not applicable */
+		grace_depth = istate->depth;
+	}
+	if (grace_depth == 0)
+		return;			/* no need to partition */
+
+	istate = &gjs->inners[grace_depth - 1];
+	istate->grace_partitioned = true;
+	gjs->grace_depth = grace_depth;
+	gjs->grace_files = palloc0(sizeof(BufFile *) *
+							   list_length(istate->pds_list));
+}
+
+/*
+ * gpujoin_grace_cleanup
+ *
+ * It closes the partition files, if any.
+ */
+static void
+gpujoin_grace_cleanup(GpuJoinState *gjs)
+{
+	int		i, nparts;
+
+	if (gjs->grace_depth == 0)
+		return;
+	nparts = list_length(gjs->inners[gjs->grace_depth - 1].pds_list);
+	for (i=0; i < nparts; i++)
+	{
+		if (gjs->grace_files[i])
+			BufFileClose(gjs->grace_files[i]);
+	}
+	pfree(gjs->grace_files);
+	gjs->grace_files = NULL;
+	gjs->grace_depth = 0;
+}
+
+/*
+ * gpujoin_grace_rewind
+ *
+ * It rewinds the partition file of the current inner chunk, instead of
+ * the rescan of outer relation.
+ */
+static void
+gpujoin_grace_rewind(GpuJoinState *gjs)
+{
+	int			index = gjs->inners[gjs->grace_depth - 1].pds_index;
+	BufFile	   *file = gjs->grace_files[index - 1];
+
+	Assert(index > 1);
+	if (file && BufFileSeek(file, 0, 0L, SEEK_SET) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not rewind GpuJoin temporary file: %m")));
+}
+
+/*
+ * gpujoin_grace_load_chunk
+ *
+ * It reads the outer rows spilled to the partition file of the current
+ * inner chunk, then returns an outer chunk, or NULL if no more rows.
+ */
+static pgstrom_data_store *
+gpujoin_grace_load_chunk(GpuJoinState *gjs)
+{
+	int			index = gjs->inners[gjs->grace_depth - 1].pds_index;
+	BufFile	   *file = gjs->grace_files[index - 1];
+	pgstrom_data_store *pds;
+	kern_data_store *kds;
+	cl_uint	   *row_index;
+	kern_tupitem titem;
+	kern_tupitem *tupitem;
+	Size		head_sz = offsetof(kern_tupitem, htup);
+	Size		length;
+	int			fileno;
+	off_t		offset;
+
+	if (!file)
+		return NULL;
+
+	pds = PDS_create_row(gjs->gts.gcontext,
+						 gpujoin_outer_tupdesc(gjs),
+						 pgstrom_chunk_size());
+	kds = pds->kds;
+	if (gjs->gts.css.ss.ss_currentRelation)
+		kds->table_oid = RelationGetRelid(gjs->gts.css.ss.ss_currentRelation);
+	row_index = KERN_DATA_STORE_ROWINDEX(kds);
+
+	while (true)
+	{
+		BufFileTell(file, &fileno, &offset);
+		length = BufFileRead(file, &titem, head_sz);
+		if (length == 0)
+			break;		/* end of the partition */
+		if (length != head_sz)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from GpuJoin temporary file: %m")));
+		length = LONGALIGN(head_sz + titem.t_len);
+		if (KDS_CALCULATE_ROW_LENGTH(kds->ncols,
+									 kds->nitems + 1,
+									 kds->usage + length) > kds->length)
+		{
+			if (kds->nitems == 0)
+				elog(ERROR, "Bug? spilled outer row is larger than chunk");
+			/* this row shall be read on the next call */
+			if (BufFileSeek(file, fileno, offset, SEEK_SET) != 0)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not seek GpuJoin temporary file: %m")));
+			break;
+		}
+		kds->usage += length;
+		tupitem = (kern_tupitem *)((char *)kds + kds->length - kds->usage);
+		memcpy(tupitem, &titem, head_sz);
+		if (BufFileRead(file, (char *)tupitem + head_sz,
+						length - head_sz) != length - head_sz)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from GpuJoin temporary file: %m")));
+		row_index[kds->nitems++] = kds->length - kds->usage;
+	}
+
+	if (kds->nitems == 0)
+	{
+		PDS_release(pds);
+		return NULL;
+	}
+	PDS_shrink_size(pds);
+	return pds;
+}
+
 static GpuTask *
 gpujoin_next_chunk(GpuTaskState *gts)
 {
@@ -4620,7 +5363,9 @@ gpujoin_next_chunk(GpuTaskState *gts)
 			 */
 			if (gjs->outer_scan_done)
 			{
-				if (gjs->gts.css.ss.ss_currentRelation)
+				if (gjs->grace_depth > 0)
+					gpujoin_grace_rewind(gjs);
+				else if (gjs->gts.css.ss.ss_currentRelation)
 					pgstrom_rewind_scan_chunk(&gjs->gts);
 				else
 					ExecReScan(outerPlanState(gjs));
@@ -4629,7 +5374,15 @@ gpujoin_next_chunk(GpuTaskState *gts)
 		}
 
 		PERFMON_BEGIN(&gts->pfm, &tv1);
-		if (gjs->gts.css.ss.ss_currentRelation)
+		if (gjs->grace_depth > 0 &&
+			gjs->inners[gjs->grace_depth - 1].pds_index > 1)
+		{
+			/* Load the outer rows spilled on the first pass */
+			pds = gpujoin_grace_load_chunk(gjs);
+			if (!pds)
+				gjs->outer_scan_done = true;
+		}
+		else if (gjs->gts.css.ss.ss_currentRelation)
 		{
 			/* Scan and load the outer relation by itself */
 			pds = pgstrom_exec_scan_chunk(gts, pgstrom_chunk_size());
@@ -4678,6 +5431,17 @@ gpujoin_next_chunk(GpuTaskState *gts)
 		}
 		PERFMON_END(&gjs->gts.pfm, time_outer_load, &tv1, &tv2);
 
+		/*
+		 * Host side pre-filter by the bloom filter of the inner keys, and
+		 * partitioning of the outer rows, prior to DMA send of the outer
+		 * chunk.
+		 */
+		if (pds && !gpujoin_exec_outer_prefilter(gjs, pds))
+		{
+			PDS_release(pds);
+			pds = NULL;
+		}
+
 		/*
 		 * We also need to check existence of next inner hash-chunks,
 		 * even if here is no more outer records, In case of multi-relations
@@ -4686,7 +5450,7 @@ gpujoin_next_chunk(GpuTaskState *gts)
 		 */
 	} while (!pds);
 
-	return gpujoin_create_task(gjs, gjs->curr_pmrels, pds, NULL);
+	return gpujoin_create_task(gjs, gjs->curr_pmrels, pds, NULL, NULL);
 }
 
 /*
@@ -5076,7 +5840,8 @@ gpujoin_fallback_inner_recurse(GpuJoinState *gjs,
 				if (is_null_keys)
 				{
 					if (istate->join_type == JOIN_LEFT ||
-						istate->join_type == JOIN_FULL)
+						istate->join_type == JOIN_FULL ||
+						istate->join_type == JOIN_ANTI)
 					{
 						istate->fallback_inner_index = UINT_MAX;
 						tupitem = NULL;
@@ -5093,7 +5858,8 @@ gpujoin_fallback_inner_recurse(GpuJoinState *gjs,
 				if (!khitem)
 				{
 					if (istate->join_type == JOIN_LEFT ||
-						istate->join_type == JOIN_FULL)
+						istate->join_type == JOIN_FULL ||
+						istate->join_type == JOIN_ANTI)
 					{
 						istate->fallback_inner_index = UINT_MAX;
 						tupitem = NULL;
@@ -5130,7 +5896,8 @@ gpujoin_fallback_inner_recurse(GpuJoinState *gjs,
 				{
 					if (!istate->fallback_inner_matched &&
 						(istate->join_type == JOIN_LEFT ||
-						 istate->join_type == JOIN_FULL))
+						 istate->join_type == JOIN_FULL ||
+						 istate->join_type == JOIN_ANTI))
 					{
 						istate->fallback_inner_index = UINT_MAX;
 						tupitem = NULL;
@@ -5156,11 +5923,14 @@ gpujoin_fallback_inner_recurse(GpuJoinState *gjs,
 			{
 				/*
 				 * A dummy fallback_inner_index shall be set when a half-NULLs
-				 * tuple is constructed on LEFT/FULL OUTER JOIN. It means this
+				 * tuple is constructed on LEFT/FULL OUTER JOIN (or ANTI JOIN),
+				 * or an outer row is matched on SEMI JOIN. It means this
 				 * depth has no more capable to fetch next joined rows.
 				 */
 				Assert(istate->join_type == JOIN_LEFT ||
-					   istate->join_type == JOIN_FULL);
+					   istate->join_type == JOIN_FULL ||
+					   istate->join_type == JOIN_SEMI ||
+					   istate->join_type == JOIN_ANTI);
 				return false;
 			}
 
@@ -5197,6 +5967,13 @@ gpujoin_fallback_inner_recurse(GpuJoinState *gjs,
 				}
 				/* No LJ/FJ tuple is needed for this outer item */
 				istate->fallback_inner_matched = true;
+
+				/* AJ never emits the matched outer item */
+				if (istate->join_type == JOIN_ANTI)
+					return false;
+				/* SJ emits the outer item only once */
+				if (istate->join_type == JOIN_SEMI)
+					istate->fallback_inner_index = UINT_MAX;
 			}
 
 			/*
@@ -5306,7 +6083,8 @@ gpujoin_next_tuple_fallback(GpuJoinState *gjs, pgstrom_gpujoin *pgjoin)
 											   gjs->outer_src_anum_min,
 											   gjs->outer_src_anum_max);
 				/* evaluation of the outer qual if any */
-				if (!ExecQual(gjs->outer_quals, econtext, false))
+				if (!pgstrom_hostjit_exec_quals(gjs->hostjit_quals,
+												gjs->outer_quals, econtext))
 					continue;
 				/* ok, rewind the deeper levels prior to walk down */
 				for (i=0; i < gjs->num_rels; i++)
@@ -5487,6 +6265,35 @@ gpujoin_task_complete(GpuTask *gtask)
 		pfm->gjoin.num_minor_retry += pgjoin->kern.pfm.num_minor_retry;
 	}
 skip:
+	/*
+	 * Count phase of the two-phase execution ran out of the result buffer.
+	 * We enqueue a new task with the number of results actually required,
+	 * then release this task.
+	 */
+	if (pgjoin->task.kerror.errcode == StromError_DataStoreNoSpace &&
+		pgjoin->kern.count_retry > 0)
+	{
+		pgstrom_gpujoin	   *pgjoin_new = (pgstrom_gpujoin *)
+			gpujoin_create_task(gjs,
+								pgjoin->pmrels,
+								pgjoin->pds_src,
+								NULL,
+								pgjoin);
+		pgjoin->pds_src = NULL;
+
+		SpinLockAcquire(&gjs->gts.lock);
+		dlist_push_tail(&gjs->gts.pending_tasks,
+						&pgjoin_new->task.chain);
+		gjs->gts.num_pending_tasks++;
+		SpinLockRelease(&gjs->gts.lock);
+
+		gjs->gts.pfm.gjoin.num_global_retry++;
+
+		pgstrom_cleanup_gputask_cuda_resources(&pgjoin->task);
+		pgstrom_release_gputask(&pgjoin->task);
+		return false;
+	}
+
 	if (pgjoin->task.kerror.errcode == StromError_Success)
 	{
 		pgstrom_data_store *pds_src = pgjoin->pds_src;
@@ -5587,7 +6394,8 @@ skip:
 					gpujoin_create_task(gjs,
 										pgjoin->pmrels,
 										pds_src,
-										jscale);
+										jscale,
+										NULL);
 
 				/* add this new task to the pending list */
 				SpinLockAcquire(&gjs->gts.lock);
@@ -5962,33 +6770,54 @@ add_extra_randomness(pgstrom_data_store *pds)
 /*
  * gpujoin_inner_unload - it release inner relations and its data stores.
  *
- * TODO: We like to retain a part of inner relations if it is not
- * parametalized.
+ * If needs_rescan, inner relations which are not parameterized, or whose
+ * parameters were not changed, are retained as is, so the next scan can
+ * reuse the inner chunks already built. Only the inner relations with
+ * chgParam shall be released and re-scanned by the next ExecProcNode.
  */
 static void
 gpujoin_inner_unload(GpuJoinState *gjs, bool needs_rescan)
 {
 	ListCell   *lc;
 	cl_int		i;
+	bool		any_unloaded = false;
 
 	for (i=0; i < gjs->num_rels; i++)
 	{
 		innerState *istate = &gjs->inners[i];
 
-		/*
-		 * If chgParam of subnode is not null then plan will be
-		 * re-scanned by next ExecProcNode.
-		 */
+		/* rewind the inner position; see gpujoin_inner_getnext */
+		istate->pds_index = 0;
 		if (needs_rescan && istate->state->chgParam == NULL)
-			ExecReScan(istate->state);
+			continue;
 		foreach (lc, istate->pds_list)
 			PDS_release((pgstrom_data_store *) lfirst(lc));
 		istate->pds_list = NIL;
-		istate->pds_index = 0;
 		istate->pds_limit = 0;
 		istate->consumed = 0;
 		istate->ntuples = 0;
 		istate->tupstore = NULL;
+		if (istate->bloom)
+			pfree(istate->bloom);
+		istate->bloom = NULL;
+		istate->bloom_mask = 0;
+		foreach (lc, istate->skew_list)
+		{
+			if (lfirst(lc))
+				pfree(lfirst(lc));
+		}
+		list_free(istate->skew_list);
+		istate->skew_list = NIL;
+		istate->skew_nkeys = 0;
+		istate->skew_nitems = 0;
+		any_unloaded = true;
+	}
+
+	/* retained multirels buffer is no longer valid, if any */
+	if (any_unloaded && gjs->keep_pmrels)
+	{
+		multirels_detach_buffer(gjs->keep_pmrels, false, __FUNCTION__);
+		gjs->keep_pmrels = NULL;
 	}
 	gjs->inner_preloaded = false;
 }
@@ -6023,7 +6852,10 @@ get_tuple_hashvalue(innerState *istate,
 	}
 
 	/* calculation of a hash value of this entry */
-	INIT_LEGACY_CRC32(hash);
+	if (istate->hash_function == HASHFUNC_FASTHASH)
+		INIT_FAST_HASH(hash);
+	else
+		INIT_LEGACY_CRC32(hash);
 	forfour (lc1, hash_keys_list,
 			 lc2, istate->hash_keylen,
 			 lc3, istate->hash_keybyval,
@@ -6035,6 +6867,9 @@ get_tuple_hashvalue(innerState *istate,
 		Oid			keytype = lfirst_oid(lc4);
 		Datum		value;
 		bool		isnull;
+		pg_numeric_t temp;
+		const char *key_data;
+		cl_uint		key_len;
 
 		value = ExecEvalExpr(clause, istate->econtext, &isnull, NULL);
 		if (isnull)
@@ -6045,7 +6880,6 @@ get_tuple_hashvalue(innerState *istate,
 		if (keytype == NUMERICOID)
 		{
 			kern_context	dummy;
-			pg_numeric_t	temp;
 
 			/*
 			 * FIXME: If NUMERIC value is out of range, we cannot execute
@@ -6053,7 +6887,8 @@ get_tuple_hashvalue(innerState *istate,
 			 */
 			temp = pg_numeric_from_varlena(&dummy, (struct varlena *)
 										   DatumGetPointer(value));
-			COMP_LEGACY_CRC32(hash, &temp.value, sizeof(temp.value));
+			key_data = (const char *) &temp.value;
+			key_len = sizeof(temp.value);
 		}
 		else if (keytype == BPCHAROID)
 		{
@@ -6066,24 +6901,256 @@ get_tuple_hashvalue(innerState *istate,
 
 			for (i = len - 1; i >= 0 && s[i] == ' '; i--)
 				;
-			COMP_LEGACY_CRC32(hash, VARDATA_ANY(value), i+1);
+			key_data = VARDATA_ANY(value);
+			key_len = i+1;
 		}
 		else if (keybyval)
-			COMP_LEGACY_CRC32(hash, &value, keylen);
+		{
+			key_data = (const char *) &value;
+			key_len = keylen;
+		}
 		else if (keylen > 0)
-			COMP_LEGACY_CRC32(hash, DatumGetPointer(value), keylen);
+		{
+			key_data = DatumGetPointer(value);
+			key_len = keylen;
+		}
 		else
-			COMP_LEGACY_CRC32(hash,
-							  VARDATA_ANY(value),
-							  VARSIZE_ANY_EXHDR(value));
+		{
+			key_data = VARDATA_ANY(value);
+			key_len = VARSIZE_ANY_EXHDR(value);
+		}
+
+		/* must be bit-identical to the device side */
+		if (istate->hash_function == HASHFUNC_FASTHASH)
+			hash = pg_common_comp_fasthash(hash, key_data, key_len);
+		else
+			COMP_LEGACY_CRC32(hash, key_data, key_len);
 	}
-	FIN_LEGACY_CRC32(hash);
+	if (istate->hash_function == HASHFUNC_FASTHASH)
+		FIN_FAST_HASH(hash);
+	else
+		FIN_LEGACY_CRC32(hash);
 
 	*p_is_null_keys = is_null_keys;
 
 	return hash;
 }
 
+/*
+ * gpujoin_inner_build_bloom
+ *
+ * It builds a bloom filter on the hash value of inner keys, if applicable.
+ */
+static void
+gpujoin_inner_build_bloom(GpuJoinState *gjs, innerState *istate)
+{
+	MemoryContext	memcxt = gjs->gts.gcontext->memcxt;
+	Size			nitems = 0;
+	cl_uint			nbits = 1024;
+	cl_uint			i;
+	ListCell	   *lc;
+
+	if (!istate->bloom_enabled || istate->bloom)
+		return;
+
+	foreach (lc, istate->pds_list)
+		nitems += ((pgstrom_data_store *) lfirst(lc))->kds->nitems;
+	if (nitems == 0)
+		return;
+	while (nbits < nitems * GPUJOIN_BLOOM_BITS_PER_KEY)
+	{
+		/* too large bloom filter has less advantage than its cost */
+		if (nbits >= GPUJOIN_BLOOM_MAX_NBITS)
+			return;
+		nbits <<= 1;
+	}
+	istate->bloom = MemoryContextAllocZero(memcxt, nbits / BITS_PER_BYTE);
+	istate->bloom_mask = nbits - 1;
+
+	foreach (lc, istate->pds_list)
+	{
+		kern_data_store *kds = ((pgstrom_data_store *) lfirst(lc))->kds;
+
+		Assert(kds->format == KDS_FORMAT_HASH);
+		for (i=0; i < kds->nitems; i++)
+		{
+			kern_hashitem  *khitem = KERN_DATA_STORE_HASHITEM(kds, i);
+
+			gpujoin_bloom_filter_set(istate->bloom,
+									 istate->bloom_mask,
+									 khitem->hash);
+		}
+	}
+}
+
+static int
+gpujoin_hashskew_comp(const void *a, const void *b)
+{
+	cl_uint		hash_a = *((const cl_uint *) a);
+	cl_uint		hash_b = *((const cl_uint *) b);
+
+	if (hash_a < hash_b)
+		return -1;
+	if (hash_a > hash_b)
+		return 1;
+	return 0;
+}
+
+/*
+ * gpujoin_build_hashskew
+ *
+ * It detects the heavy-hitter hash values in the inner hash table, then
+ * moves the skewed items to the tail of hash chain, and returns the dense
+ * array of them. NULL is returned if no heavy-hitters.
+ */
+static kern_hashskew *
+gpujoin_build_hashskew(GpuJoinState *gjs,
+					   innerState *istate,
+					   pgstrom_data_store *pds)
+{
+	kern_data_store *kds = pds->kds;
+	cl_uint	   *hash_slot = KERN_DATA_STORE_HASHSLOT(kds);
+	kern_hashskew *skew;
+	kern_skewkey *keys;
+	cl_uint	   *hashes;
+	cl_uint	   *items;
+	cl_uint	   *nfilled;
+	cl_uint		threshold;
+	cl_uint		nhashes = 0;
+	cl_uint		nkeys = 0;
+	cl_uint		nitems = 0;
+	cl_uint		i, j;
+
+	Assert(kds->format == KDS_FORMAT_HASH && kds->nslots > 0);
+	threshold = Max(GPUJOIN_SKEW_MIN_NITEMS,
+					kds->nitems / GPUJOIN_SKEW_MAX_KEYS);
+	if (kds->nitems < threshold)
+		return NULL;
+
+	/*
+	 * Pick up the candidates; hash values in the histogram bucket with
+	 * enough number of rows. Histogram is not built if the hash table
+	 * was loaded from the inner cache.
+	 */
+	hashes = palloc(sizeof(cl_uint) * kds->nitems);
+	for (i=0; i < kds->nitems; i++)
+	{
+		kern_hashitem  *khitem = KERN_DATA_STORE_HASHITEM(kds, i);
+
+		if (!istate->icache_hit &&
+			istate->hgram_nitems[khitem->hash >>
+								 istate->hgram_shift] < threshold)
+			continue;
+		hashes[nhashes++] = khitem->hash;
+	}
+	qsort(hashes, nhashes, sizeof(cl_uint), gpujoin_hashskew_comp);
+
+	keys = palloc(sizeof(kern_skewkey) * GPUJOIN_SKEW_MAX_KEYS);
+	for (i=0; i < nhashes; i = j)
+	{
+		for (j=i+1; j < nhashes && hashes[j] == hashes[i]; j++);
+		if (j - i < threshold)
+			continue;
+		Assert(nkeys < GPUJOIN_SKEW_MAX_KEYS);
+		keys[nkeys].hash = hashes[i];
+		keys[nkeys].nitems = j - i;
+		keys[nkeys].start = nitems;
+		nitems += j - i;
+		nkeys++;
+	}
+	pfree(hashes);
+
+	if (nkeys == 0)
+	{
+		pfree(keys);
+		return NULL;
+	}
+
+	/* setup kern_hashskew */
+	skew = MemoryContextAllocZero(gjs->gts.gcontext->memcxt,
+								  KERN_HASHSKEW_LENGTH(nkeys, nitems));
+	skew->nkeys = nkeys;
+	skew->nitems = nitems;
+	memcpy(skew->keys, keys, sizeof(kern_skewkey) * nkeys);
+	pfree(keys);
+
+	items = KERN_HASHSKEW_ITEMS(skew);
+	nfilled = palloc0(sizeof(cl_uint) * nkeys);
+	for (i=0; i < kds->nitems; i++)
+	{
+		kern_hashitem  *khitem = KERN_DATA_STORE_HASHITEM(kds, i);
+		cl_int			k = gpujoin_hashskew_lookup(skew, khitem->hash);
+
+		if (k < 0)
+			khitem->skewed = 0;
+		else
+		{
+			khitem->skewed = 1;
+			items[skew->keys[k].start + nfilled[k]++] =
+				(uintptr_t)khitem - (uintptr_t)kds;
+		}
+	}
+	pfree(nfilled);
+
+	/* move the skewed items to the tail of hash chain */
+	for (i=0; i < kds->nslots; i++)
+	{
+		kern_hashitem  *khitem;
+		kern_hashitem  *knext;
+		cl_uint			head = 0;
+		cl_uint			skew_head = 0;
+		cl_uint		   *tailp = &head;
+		cl_uint		   *skew_tailp = &skew_head;
+
+		for (khitem = KERN_HASH_FIRST_ITEM(kds, i);
+			 khitem != NULL;
+			 khitem = knext)
+		{
+			knext = KERN_HASH_NEXT_ITEM(kds, khitem);
+			if (khitem->skewed)
+			{
+				*skew_tailp = (uintptr_t)khitem - (uintptr_t)kds;
+				skew_tailp = &khitem->next;
+			}
+			else
+			{
+				*tailp = (uintptr_t)khitem - (uintptr_t)kds;
+				tailp = &khitem->next;
+			}
+		}
+		*skew_tailp = 0;
+		*tailp = skew_head;
+		hash_slot[i] = head;
+	}
+	istate->skew_nkeys += nkeys;
+	istate->skew_nitems += nitems;
+
+	return skew;
+}
+
+/*
+ * gpujoin_inner_detect_skew
+ *
+ * It detects the heavy-hitter keys for each inner hash chunk.
+ */
+static void
+gpujoin_inner_detect_skew(GpuJoinState *gjs, innerState *istate)
+{
+	ListCell   *lc;
+
+	if (!enable_gpujoin_skew_handling ||
+		istate->hash_inner_keys == NIL ||
+		istate->skew_list != NIL)
+		return;
+
+	foreach (lc, istate->pds_list)
+	{
+		istate->skew_list = lappend(istate->skew_list,
+									gpujoin_build_hashskew(gjs, istate,
+														   lfirst(lc)));
+	}
+}
+
 /*
  * gpujoin_inner_hash_preload_TC
  *
@@ -6180,7 +7247,9 @@ gpujoin_inner_hash_preload_TS(GpuJoinState *gjs,
 		 * so we drop these tuples from the inner buffer.
 		 */
 		if (is_null_keys && (istate->join_type == JOIN_INNER ||
-							 istate->join_type == JOIN_LEFT))
+							 istate->join_type == JOIN_LEFT ||
+							 istate->join_type == JOIN_SEMI ||
+							 istate->join_type == JOIN_ANTI))
 			continue;
 
 		forboth (lc1, pds_list,
@@ -6259,6 +7328,8 @@ next:
 			add_extra_randomness(pds);
 			PDS_build_hashtable(pds);
 		}
+		/* bloom filter of the inner keys, if applicable */
+		gpujoin_inner_build_bloom(gjs, istate);
 		return false;
 	}
 
@@ -6271,7 +7342,9 @@ next:
 	 * we don't need to keep this tuple in the 
 	 */
 	if (is_null_keys && (istate->join_type == JOIN_INNER ||
-						 istate->join_type == JOIN_LEFT))
+						 istate->join_type == JOIN_LEFT ||
+						 istate->join_type == JOIN_SEMI ||
+						 istate->join_type == JOIN_ANTI))
 		goto next;
 
 	scan_desc = scan_slot->tts_tupleDescriptor;
@@ -6298,9 +7371,10 @@ next:
 	istate->hgram_nitems[index]++;
 
 	/*
-	 * XXX - If join type is LEFT or FULL OUTER, each PDS has to be
-	 * strictly partitioned by the hash-value, thus, we saves entire
-	 * relation on the tuple-store, then reconstruct PDS later.
+	 * XXX - If join type is RIGHT or FULL OUTER, or outer rows shall be
+	 * partitioned by the hash-value, each PDS has to be strictly
+	 * partitioned by the hash-value, thus, we saves entire relation on
+	 * the tuple-store, then reconstruct PDS later.
 	 */
 retry:
 	if (istate->tupstore)
@@ -6320,8 +7394,8 @@ retry:
 													   istate->consumed +
 													   consumption))
 	{
-		if (istate->join_type == JOIN_INNER ||
-			istate->join_type == JOIN_LEFT)
+		if ((istate->join_type == JOIN_INNER ||
+			 istate->join_type == JOIN_LEFT) && !istate->grace_capable)
 		{
 			PDS_shrink_size(pds_hash);
 
@@ -6512,6 +7586,7 @@ gpujoin_create_multirels(GpuJoinState *gjs)
 									  kern.chunks[gjs->num_rels]));
 	alloc_length = head_length +
 		STROMALIGN(sizeof(pgstrom_data_store *) * gjs->num_rels) +
+		STROMALIGN(sizeof(kern_hashskew *) * gjs->num_rels) +
 		STROMALIGN(sizeof(cl_int) * gcontext->num_context) +
 		STROMALIGN(sizeof(CUdeviceptr) * gcontext->num_context) +
 		STROMALIGN(sizeof(CUevent) * gcontext->num_context) +
@@ -6527,6 +7602,8 @@ gpujoin_create_multirels(GpuJoinState *gjs)
 	pos = (char *)pmrels + head_length;
 	pmrels->inner_chunks = (pgstrom_data_store **) pos;
 	pos += STROMALIGN(sizeof(pgstrom_data_store *) * gjs->num_rels);
+	pmrels->inner_skews = (kern_hashskew **) pos;
+	pos += STROMALIGN(sizeof(kern_hashskew *) * gjs->num_rels);
 	pmrels->refcnt = (cl_int *) pos;
 	pos += STROMALIGN(sizeof(cl_int) * gcontext->num_context);
 	pmrels->m_kmrels = (CUdeviceptr *) pos;
@@ -6557,6 +7634,27 @@ gpujoin_create_multirels(GpuJoinState *gjs)
 		pmrels->kern.chunks[i].chunk_offset = pmrels->usage_length;
 		pmrels->usage_length += STROMALIGN(pds->kds->length);
 
+		if (istate->bloom)
+		{
+			pmrels->kern.chunks[i].bloom_offset = pmrels->usage_length;
+			pmrels->kern.chunks[i].bloom_mask = istate->bloom_mask;
+			pmrels->usage_length +=
+				STROMALIGN(((Size) istate->bloom_mask + 1) / BITS_PER_BYTE);
+		}
+
+		if (istate->skew_list != NIL)
+		{
+			kern_hashskew  *skew = list_nth(istate->skew_list,
+											istate->pds_index - 1);
+			if (skew)
+			{
+				pmrels->inner_skews[i] = skew;
+				pmrels->kern.chunks[i].skew_offset = pmrels->usage_length;
+				pmrels->usage_length +=
+					KERN_HASHSKEW_LENGTH(skew->nkeys, skew->nitems);
+			}
+		}
+
 		if (!istate->hash_outer_keys)
 			pmrels->kern.chunks[i].is_nestloop = true;
 
@@ -6569,8 +7667,11 @@ gpujoin_create_multirels(GpuJoinState *gjs)
 			pmrels->needs_outer_join = true;
 		}
 		if (istate->join_type == JOIN_LEFT ||
-			istate->join_type == JOIN_FULL)
+			istate->join_type == JOIN_FULL ||
+			istate->join_type == JOIN_ANTI)
 			pmrels->kern.chunks[i].left_outer = true;
+		if (gpujoin_single_match(istate))
+			pmrels->kern.chunks[i].single_match = true;
 	}
 	Assert(pmrels->kern.ojmap_length == ojmap_length);
 	return pmrels;
@@ -6587,7 +7688,7 @@ static bool
 gpujoin_inner_preload(GpuJoinState *gjs)
 {
 	innerState	  **istate_buf;
-	cl_int			istate_nums = gjs->num_rels;
+	cl_int			istate_nums;
 	Size			total_limit;
 	Size			total_usage;
 	bool			kmrels_size_fixed = false;
@@ -6601,11 +7702,60 @@ gpujoin_inner_preload(GpuJoinState *gjs)
 	 * the current hard limit of the inner relations buffer.
 	 */
 	total_limit = gpuMemMaxAllocSize() / 2 - BLCKSZ * gjs->num_rels;
+	/* tighter limit for testing of the multi-chunks inner relations */
+	if (debug_gpujoin_inner_limit > 0)
+		total_limit = Min(total_limit,
+						  (Size) debug_gpujoin_inner_limit * 1024L);
 	total_usage = STROMALIGN(offsetof(kern_multirels,
 									  chunks[gjs->num_rels]));
 	istate_buf = palloc0(sizeof(innerState *) * gjs->num_rels);
-	for (i=0; i < istate_nums; i++)
-		istate_buf[i] = &gjs->inners[i];
+	istate_nums = 0;
+	for (i=0; i < gjs->num_rels; i++)
+	{
+		innerState *istate = &gjs->inners[i];
+
+		/*
+		 * Try to pick up the hash table built by other queries from the
+		 * shared inner cache.
+		 */
+		if (istate->pds_list == NIL && istate->icache_key)
+		{
+			pgstrom_data_store *pds
+				= pgstrom_inner_cache_lookup(gjs->gts.gcontext,
+											 istate->state,
+											 istate->icache_key,
+											 &istate->icache_sign);
+			if (pds)
+			{
+				kern_data_store *kds = pds->kds;
+
+				istate->pds_list = list_make1(pds);
+				istate->ntuples = kds->nitems;
+				istate->consumed = (KDS_CALCULATE_HEAD_LENGTH(kds->ncols) +
+									kds->usage);
+				istate->icache_hit = true;
+				gpujoin_inner_build_bloom(gjs, istate);
+			}
+		}
+
+		/*
+		 * Inner relations retained by the previous scan don't need to
+		 * be loaded again; its chunks are already built.
+		 */
+		if (istate->pds_list != NIL)
+		{
+			ListCell   *lc;
+
+			foreach (lc, istate->pds_list)
+			{
+				pgstrom_data_store *pds = lfirst(lc);
+
+				total_usage += STROMALIGN(pds->kds->length);
+			}
+			continue;
+		}
+		istate_buf[istate_nums++] = istate;
+	}
 
 	/* load tuples from the inner relations with round-robin policy */
 	while (istate_nums > 0)
@@ -6632,13 +7782,13 @@ gpujoin_inner_preload(GpuJoinState *gjs)
 			 * NOTE: current usage becomes limitation, so next call of
 			 * gpujoin_inner_XXXX_preload will make its second chunk.
 			 */
-			for (i=0; i < gjs->num_rels; i++)
+			for (i=0; i < istate_nums; i++)
 			{
 				innerState	   *istate = istate_buf[i];
 				TupleTableSlot *scan_slot = istate->state->ps_ResultTupleSlot;
 				TupleDesc	 	scan_desc = scan_slot->tts_tupleDescriptor;
 
-				gjs->inners[i].pds_limit =
+				istate->pds_limit =
 					(istate->hash_inner_keys != NIL
 					 ? KDS_CALCULATE_HASH_LENGTH(scan_desc->natts,
 												 istate->ntuples,
@@ -6663,6 +7813,27 @@ gpujoin_inner_preload(GpuJoinState *gjs)
 	}
 	pfree(istate_buf);
 
+	/* save the hash table built right now on the shared inner cache */
+	for (i=0; i < gjs->num_rels; i++)
+	{
+		innerState	   *istate = &gjs->inners[i];
+
+		if (istate->icache_sign.valid &&
+			list_length(istate->pds_list) == 1)
+			pgstrom_inner_cache_store(istate->state,
+									  istate->icache_key,
+									  &istate->icache_sign,
+									  linitial(istate->pds_list));
+		istate->icache_sign.valid = false;
+	}
+
+	/*
+	 * Detection of the heavy-hitter keys. Note that it reorganizes the
+	 * hash chain, so has to be done after the save on the inner cache.
+	 */
+	for (i=0; i < gjs->num_rels; i++)
+		gpujoin_inner_detect_skew(gjs, &gjs->inners[i]);
+
 	/*
 	 * NOTE: Special optimization case. In case when any chunk has no items,
 	 * and all deeper level is inner join, it is obvious no tuples shall be
@@ -6706,6 +7877,7 @@ gpujoin_inner_preload(GpuJoinState *gjs)
 static pgstrom_multirels *
 gpujoin_inner_getnext(GpuJoinState *gjs)
 {
+	pgstrom_multirels *pmrels;
 	int		i, j;
 
 	if (!gjs->inner_preloaded)
@@ -6716,6 +7888,12 @@ gpujoin_inner_getnext(GpuJoinState *gjs)
 		/* setup initial inner index position */
 		for (i=0; i < gjs->num_rels; i++)
 			gjs->inners[i].pds_index = 1;
+		/* partitioned join, if applicable */
+		gpujoin_grace_setup(gjs);
+
+		/* reuse the multirels buffer of the previous scan, if any */
+		if (gjs->keep_pmrels)
+			return multirels_attach_buffer(gjs->keep_pmrels);
 	}
 	else
 	{
@@ -6735,13 +7913,36 @@ gpujoin_inner_getnext(GpuJoinState *gjs)
 			}
 		}
 		if (i == 0)
+		{
+			gpujoin_grace_cleanup(gjs);
 			return NULL;	/* end of inner chunks */
+		}
 	}
 
 	/*
 	 * OK, makes next pgstrom_multirels buffer
 	 */
-	return gpujoin_create_multirels(gjs);
+	pmrels = gpujoin_create_multirels(gjs);
+
+	/*
+	 * If all the inner relations are loaded onto a single multirels buffer
+	 * and no outer join map is needed, we retain this buffer (and device
+	 * memory once loaded) for the rescan with unchanged parameters.
+	 */
+	if (!pmrels->needs_outer_join)
+	{
+		for (i=0; i < gjs->num_rels; i++)
+		{
+			if (list_length(gjs->inners[i].pds_list) != 1)
+				break;
+		}
+		if (i == gjs->num_rels)
+		{
+			Assert(!gjs->keep_pmrels);
+			gjs->keep_pmrels = multirels_attach_buffer(pmrels);
+		}
+	}
+	return pmrels;
 }
 
 /*
@@ -6773,7 +7974,7 @@ multirels_get_buffer(pgstrom_multirels *pmrels, pgstrom_gpujoin *pgjoin)
 
 	Assert(&pmrels->gjs->gts == pgjoin->task.gts);
 
-	if (pmrels->refcnt[cuda_index] == 0)
+	if (pmrels->refcnt[cuda_index] == 0 && !pmrels->m_kmrels[cuda_index])
 	{
 		CUdeviceptr	m_kmrels = 0UL;
 		CUdeviceptr	m_ojmaps = 0UL;
@@ -6822,7 +8023,8 @@ multirels_put_buffer(pgstrom_multirels *pmrels, GpuTask *gtask)
 
 	Assert(&pmrels->gjs->gts == gtask->gts);
 	Assert(pmrels->refcnt[cuda_index] > 0);
-	if (--pmrels->refcnt[cuda_index] == 0)
+	if (--pmrels->refcnt[cuda_index] == 0 &&
+		pmrels != pmrels->gjs->keep_pmrels)
 	{
 		/*
 		 * OK, no concurrent tasks did not reference the inner-relations
@@ -6886,6 +8088,39 @@ multirels_send_buffer(pgstrom_multirels *pmrels, GpuTask *gtask)
 			if (rc != CUDA_SUCCESS)
 				elog(ERROR, "failed on cuMemcpyHtoDAsync: %s", errorText(rc));
 			total_length += kds->length;
+
+			/* bloom filter of the inner keys, if any */
+			offset = pmrels->kern.chunks[i].bloom_offset;
+			if (offset > 0)
+			{
+				length = ((Size) pmrels->kern.chunks[i].bloom_mask + 1)
+					/ BITS_PER_BYTE;
+				rc = cuMemcpyHtoDAsync(m_kmrels + offset,
+									   gjs->inners[i].bloom,
+									   length,
+									   cuda_stream);
+				if (rc != CUDA_SUCCESS)
+					elog(ERROR, "failed on cuMemcpyHtoDAsync: %s",
+						 errorText(rc));
+				total_length += length;
+			}
+
+			/* heavy-hitter keys of the inner hash table, if any */
+			offset = pmrels->kern.chunks[i].skew_offset;
+			if (offset > 0)
+			{
+				kern_hashskew  *skew = pmrels->inner_skews[i];
+
+				length = KERN_HASHSKEW_LENGTH(skew->nkeys, skew->nitems);
+				rc = cuMemcpyHtoDAsync(m_kmrels + offset,
+									   skew,
+									   length,
+									   cuda_stream);
+				if (rc != CUDA_SUCCESS)
+					elog(ERROR, "failed on cuMemcpyHtoDAsync: %s",
+						 errorText(rc));
+				total_length += length;
+			}
 		}
 		/* DMA Send synchronization */
 		rc = cuEventRecord(ev_loaded, cuda_stream);
@@ -7088,7 +8323,7 @@ multirels_detach_buffer(pgstrom_multirels *pmrels, bool may_kick_outer_join,
 	{
 		GpuJoinState	   *gjs = pmrels->gjs;
 		pgstrom_gpujoin	   *pgjoin_new = (pgstrom_gpujoin *)
-			gpujoin_create_task(gjs, pmrels, NULL, NULL);
+			gpujoin_create_task(gjs, pmrels, NULL, NULL, NULL);
 
 		/* Enqueue OUTER JOIN task here */
 		SpinLockAcquire(&gjs->gts.lock);
@@ -7115,11 +8350,44 @@ multirels_detach_buffer(pgstrom_multirels *pmrels, bool may_kick_outer_join,
 			Assert(pmrels->refcnt[index] == 0);
 			if (pmrels->m_ojmaps[index] != 0UL)
 				__gpuMemFree(gcontext, index, pmrels->m_ojmaps[index]);
+			/* device buffer retained across rescans, if any */
+			if (pmrels->m_kmrels[index] != 0UL)
+				__gpuMemFree(gcontext, index, pmrels->m_kmrels[index]);
+			if (pmrels->ev_loaded[index])
+			{
+				CUresult	rc = cuEventDestroy(pmrels->ev_loaded[index]);
+
+				if (rc != CUDA_SUCCESS)
+					elog(WARNING, "failed on cuEventDestroy: %s",
+						 errorText(rc));
+			}
 		}
 		pfree(pmrels);
 	}
 }
 
+/*
+ * pgstrom_startup_gpujoin
+ *
+ * allocation of the shared join growth ratio store
+ */
+static void
+pgstrom_startup_gpujoin(void)
+{
+	bool		found;
+
+	if (shmem_startup_next)
+		(*shmem_startup_next)();
+
+	gjfb_head = ShmemInitStruct("PG-Strom GpuJoin feedback",
+								sizeof(gpujoin_feedback_head), &found);
+	if (found)
+		elog(ERROR, "Bug? shared memory for GpuJoin feedback already exists");
+
+	memset(gjfb_head, 0, sizeof(gpujoin_feedback_head));
+	SpinLockInit(&gjfb_head->lock);
+}
+
 /*
  * pgstrom_init_gpujoin
  *
@@ -7146,6 +8414,71 @@ pgstrom_init_gpujoin(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* turn on/off bloom filter of the inner keys */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_bloom_filter",
+							 "Enables bloom filter of inner keys in GpuHashJoin",
+							 NULL,
+							 &enable_gpujoin_bloom_filter,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off partitioned hash-join for larger inner relations */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_grace_hash",
+							 "Enables partitioned GpuHashJoin by single outer scan",
+							 NULL,
+							 &enable_gpujoin_grace_hash,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off separate processing of heavy-hitter join keys */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_skew_handling",
+							 "Enables separate processing of heavy-hitter keys in GpuHashJoin",
+							 NULL,
+							 &enable_gpujoin_skew_handling,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off feedback of the join growth ratio */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_feedback",
+							 "Enables feedback of join growth ratio to the next execution",
+							 NULL,
+							 &enable_gpujoin_feedback,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off two-phase (count then materialize) execution */
+	DefineCustomBoolVariable("pg_strom.gpujoin_count_then_materialize",
+							 "Retries GpuJoin with exact result buffer on overflow",
+							 NULL,
+							 &gpujoin_count_then_materialize,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off host side pre-filter by the bloom filter */
+	DefineCustomBoolVariable("pg_strom.gpujoin_bloom_prefilter",
+							 "Enables host side pre-filter of outer rows by bloom filter",
+							 NULL,
+							 &gpujoin_bloom_prefilter,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* limit of the inner relations buffer, for debugging */
+	DefineCustomIntVariable("pg_strom.debug_gpujoin_inner_limit",
+							"Limit of GpuJoin inner buffer (0 = no limit)",
+							NULL,
+							&debug_gpujoin_inner_limit,
+							0,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
 	/* setup path methods */
 	gpujoin_path_methods.CustomName				= "GpuJoin";
 	gpujoin_path_methods.PlanCustomPath			= create_gpujoin_plan;
@@ -7167,4 +8500,9 @@ pgstrom_init_gpujoin(void)
 	/* hook registration */
 	set_join_pathlist_next = set_join_pathlist_hook;
 	set_join_pathlist_hook = gpujoin_add_join_path;
+
+	/* allocation of static shared memory */
+	RequestAddinShmemSpace(MAXALIGN(sizeof(gpujoin_feedback_head)));
+	shmem_startup_next = shmem_startup_hook;
+	shmem_startup_hook = pgstrom_startup_gpujoin;
 }
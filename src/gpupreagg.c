@@ -18,6 +18,8 @@
 #include "postgres.h"
 #include "access/sysattr.h"
 #include "access/xact.h"
+#include "catalog/namespace.h"
+#include "catalog/pg_aggregate.h"
 #include "catalog/pg_cast.h"
 #include "catalog/pg_namespace.h"
 #include "catalog/pg_proc.h"
@@ -33,6 +35,7 @@
 #include "optimizer/var.h"
 #include "parser/parsetree.h"
 #include "utils/builtins.h"
+#include "utils/datum.h"
 #include "utils/fmgroids.h"
 #include "utils/guc.h"
 #include "utils/lsyscache.h"
@@ -40,6 +43,7 @@
 #include "utils/rel.h"
 #include "utils/ruleutils.h"
 #include "utils/syscache.h"
+#include "utils/typcache.h"
 #include <math.h>
 #include "pg_strom.h"
 #include "cuda_common.h"
@@ -50,6 +54,10 @@ static CustomScanMethods		gpupreagg_scan_methods;
 static CustomExecMethods		gpupreagg_exec_methods;
 static bool						enable_gpupreagg;
 static bool						debug_force_gpupreagg;
+static bool						enable_gpupreagg_fallback_hashagg;
+static bool						enable_gpupreagg_final_expand;
+static bool						enable_gpupreagg_final;
+static int						gpupreagg_sketch_nrows;
 
 #if 0
 /* list of reduction mode */
@@ -70,11 +78,13 @@ typedef struct
 	Size			varlena_unitsz;	/* estimated unit size of varlena */
 	cl_int			safety_limit;	/* reasonable limit for reduction */
 	cl_int			key_dist_salt;	/* salt, if more distribution needed */
+	cl_int			hash_function;	/* one of HASHFUNC_* */
 	double			outer_nitems;	/* number of expected outer input */
 	List		   *outer_quals;	/* device executable quals of outer-scan */
 	const char	   *kern_source;
 	int				extra_flags;
 	List		   *used_params;	/* referenced Const/Param */
+	bool			final_merge;	/* true, if no upper Agg node */
 } GpuPreAggInfo;
 
 static inline void
@@ -96,12 +106,14 @@ form_gpupreagg_info(CustomScan *cscan, GpuPreAggInfo *gpa_info)
 	privs = lappend(privs, makeInteger(gpa_info->varlena_unitsz));
 	privs = lappend(privs, makeInteger(gpa_info->safety_limit));
 	privs = lappend(privs, makeInteger(gpa_info->key_dist_salt));
+	privs = lappend(privs, makeInteger(gpa_info->hash_function));
 	privs = lappend(privs,
 					makeInteger(double_as_long(gpa_info->outer_nitems)));
 	exprs = lappend(exprs, gpa_info->outer_quals);
 	privs = lappend(privs, makeString(pstrdup(gpa_info->kern_source)));
 	privs = lappend(privs, makeInteger(gpa_info->extra_flags));
 	exprs = lappend(exprs, gpa_info->used_params);
+	privs = lappend(privs, makeInteger(gpa_info->final_merge));
 
 	cscan->custom_private = privs;
 	cscan->custom_exprs = exprs;
@@ -133,12 +145,14 @@ deform_gpupreagg_info(CustomScan *cscan)
 	gpa_info->varlena_unitsz = intVal(list_nth(privs, pindex++));
 	gpa_info->safety_limit = intVal(list_nth(privs, pindex++));
 	gpa_info->key_dist_salt = intVal(list_nth(privs, pindex++));
+	gpa_info->hash_function = intVal(list_nth(privs, pindex++));
 	gpa_info->outer_nitems =
 		long_as_double(intVal(list_nth(privs, pindex++)));
 	gpa_info->outer_quals = list_nth(exprs, eindex++);
 	gpa_info->kern_source = strVal(list_nth(privs, pindex++));
 	gpa_info->extra_flags = intVal(list_nth(privs, pindex++));
 	gpa_info->used_params = list_nth(exprs, eindex++);
+	gpa_info->final_merge = intVal(list_nth(privs, pindex++));
 
 	return gpa_info;
 }
@@ -151,10 +165,45 @@ typedef struct
 	cl_int			safety_limit;
 	cl_int			key_dist_salt;
 	cl_int			reduction_mode;
+	List		   *sketch_keys;	/* ExprState of the grouping keys */
 	List		   *outer_quals;
+	pgstrom_hostjit *hostjit_quals;	/* host JIT code of outer_quals, if any */
 	TupleTableSlot *outer_overflow;
 	pgstrom_data_store *outer_pds;
 
+	/*
+	 * CPU hash pre-aggregation on the fallback path; rows of a segment
+	 * with needs_fallback are grouped by the host, then emitted as
+	 * partial aggregates, instead of one partial row per source row.
+	 */
+	bool			fb_hashagg;		/* true, if CPU hash-agg is available */
+	int				fb_numCols;		/* number of grouping key columns */
+	AttrNumber	   *fb_keyColIdx;	/* key columns in the result tuple */
+	FmgrInfo	   *fb_eqfuncs;		/* equality functions of the keys */
+	FmgrInfo	   *fb_hashfuncs;	/* hash functions of the keys */
+	cl_char		   *fb_aggkind;		/* one of FB_HASHAGG_* per column */
+	FmgrInfo	   *fb_aggfuncs;	/* combine functions per column */
+	Oid			   *fb_aggcoll;		/* collation of the combine functions */
+	Size			fb_entry_size;	/* estimated size of a group entry */
+	MemoryContext	fb_memcxt;		/* memory context of the hash table */
+	TupleHashTable	fb_htable;		/* hash table of the current segment */
+	TupleHashIterator fb_hiter;		/* iterator to emit the groups */
+	bool			fb_hiter_active;/* true, if fb_hiter is in progress */
+	bool			fb_input_done;	/* true, if no more rows in segment */
+
+	/*
+	 * Final mode; GpuPreAgg replaced the upper Agg node, so it has to
+	 * ensure one row per group. If all the groups are not in a single
+	 * segment, partial results are merged by the host hash table.
+	 */
+	bool			final_merge;	/* true, if GpuPreAgg runs final mode */
+	cl_int			fm_state;		/* one of GPUPREAGG_FMSTATE_* */
+	cl_uint			num_segments;	/* # of segments created */
+	MemoryContext	fm_memcxt;		/* memory context of the hash table */
+	TupleHashTable	fm_htable;		/* hash table to merge segments */
+	TupleHashIterator fm_hiter;		/* iterator to emit the groups */
+	bool			fm_hiter_active;/* true, if fm_hiter is in progress */
+
 	/*
 	 * segment is a set of chunks to be aggregated
 	 */
@@ -168,8 +217,32 @@ typedef struct
 	double			stat_num_chunks;	/* # of chunks in plan/exec avg */
 	double			stat_src_nitems;	/* # of source rows in plan/exec avg */
 	double			stat_varlena_unitsz;/* unitsz of varlena buffer in plan */
+	double			stat_plan_ngroups;	/* # of groups estimated by planner */
+	double			stat_sketch_ngroups;/* # of groups by sketch, or -1.0 */
+	size_t			stat_total_ngroups;	/* # of groups made by all segments */
+	cl_uint			stat_num_expanded;	/* # of final buffer expansion */
 } GpuPreAggState;
 
+#define GPUPREAGG_FMSTATE_INIT			0	/* no rows were returned yet */
+#define GPUPREAGG_FMSTATE_PASSTHROUGH	1	/* single segment holds all */
+#define GPUPREAGG_FMSTATE_MERGE			2	/* merge segments by host */
+#define GPUPREAGG_FMSTATE_EMIT			3	/* emit the merged groups */
+
+/* how to combine a column of the partial aggregate rows by the host */
+#define FB_HASHAGG_KEY		0	/* grouping key (or constant) */
+#define FB_HASHAGG_ADD		1	/* nrows, psum, psum_x2, pcov_*, pand and
+									 * por; combined by a binary function */
+#define FB_HASHAGG_MIN		2	/* pmin */
+#define FB_HASHAGG_MAX		3	/* pmax */
+#define FB_HASHAGG_HLL		4	/* phll; byte-wise max of the registers */
+
+typedef struct
+{
+	TupleHashEntryData shared;	/* common header for hash table entries */
+	Datum	   *values;			/* accumulated partial values */
+	bool	   *isnull;
+} gpupreagg_hashagg_entry;
+
 /*
  * gpupreagg_segment
  *
@@ -184,6 +257,8 @@ typedef struct
  * however, a series of buffer release shall be executed by the last task
  * who references this segment.
  */
+#define GPUPREAGG_MAX_FINAL_EXPAND		6	/* up to x64 of the initial size */
+
 typedef struct gpupreagg_segment
 {
 	GpuPreAggState *gpas;				/* reference to GpuPreAggState */
@@ -196,7 +271,13 @@ typedef struct gpupreagg_segment
 	cl_int			refcnt;				/* referenced by pgstrom_gpupreagg */
 	cl_int			cuda_index;			/* device to be used */
 	cl_bool			has_terminator;		/* true, if any terminator task */
+	cl_bool			has_last_chunk;		/* true, if last chunk of the input */
 	cl_bool			needs_fallback;		/* true, if CPU fallback needed */
+	cl_bool			needs_expand;		/* true, if kds_final to be expanded */
+	cl_int			num_expanded;		/* # of kds_final size doubling */
+	cl_int			num_retired;		/* # of retired device buffers */
+	CUdeviceptr		m_hashslot_expand;	/* new final buffer on expansion */
+	CUdeviceptr		m_hashslot_retired[GPUPREAGG_MAX_FINAL_EXPAND];
 	pgstrom_data_store **pds_src;		/* reference to source PDSs */
 	CUevent			ev_final_loaded;	/* event of final-buffer load */
 	CUevent		   *ev_kern_main;		/* event of gpupreagg_main end */
@@ -261,6 +342,11 @@ static TupleTableSlot *gpupreagg_next_tuple(GpuTaskState *gts);
 #define ALTFUNC_EXPR_PCOV_X2		108	/* PCOV_X2(X,Y) */
 #define ALTFUNC_EXPR_PCOV_Y2		109	/* PCOV_Y2(X,Y) */
 #define ALTFUNC_EXPR_PCOV_XY		110	/* PCOV_XY(X,Y) */
+#define ALTFUNC_EXPR_PHLL			111	/* PHLL(K,X), K is index of args */
+#define ALTFUNC_EXPR_PQHIST			112	/* PQHIST(K,X), K is index of PQHIST */
+#define ALTFUNC_EXPR_PMAX_Y			113	/* PMAX(Y) */
+#define ALTFUNC_EXPR_PAND			114	/* PAND(X) */
+#define ALTFUNC_EXPR_POR			115	/* POR(X) */
 
 /*
  * XXX - GpuPreAgg with Numeric arguments are problematic because
@@ -275,7 +361,10 @@ static TupleTableSlot *gpupreagg_next_tuple(GpuTaskState *gts);
  * List of supported aggregate functions
  */
 typedef struct {
-	/* aggregate function can be preprocessed */
+	/* aggregate function can be preprocessed.
+	 * prefix indicates the schema that stores the aggregate function,
+	 * in the same manner as the alternative functions below.
+	 */
 	const char *aggfn_name;
 	int			aggfn_nargs;
 	Oid			aggfn_argtypes[4];
@@ -286,231 +375,271 @@ typedef struct {
 	 */
 	const char *altfn_name;
 	int			altfn_nargs;
-	Oid			altfn_argtypes[8];
-	int			altfn_argexprs[8];
+	Oid			altfn_argtypes[40];
+	int			altfn_argexprs[40];
 	int			extra_flags;
 	int			safety_limit;
 } aggfunc_catalog_t;
 static aggfunc_catalog_t  aggfunc_catalog[] = {
 	/* AVG(X) = EX_AVG(NROWS(), PSUM(X)) */
-	{ "avg",    1, {INT2OID},
+	{ "c:avg",    1, {INT2OID},
 	  "s:avg",  2, {INT4OID, INT8OID},
 	  {ALTFUNC_EXPR_NROWS, ALTFUNC_EXPR_PSUM}, 0, INT_MAX
 	},
-	{ "avg",    1, {INT4OID},
+	{ "c:avg",    1, {INT4OID},
 	  "s:avg",  2, {INT4OID, INT8OID},
 	  {ALTFUNC_EXPR_NROWS, ALTFUNC_EXPR_PSUM}, 0, INT_MAX
 	},
-	{ "avg",    1, {INT8OID},
+	{ "c:avg",    1, {INT8OID},
 	  "s:avg_int8",  2, {INT4OID, INT8OID},
 	  {ALTFUNC_EXPR_NROWS, ALTFUNC_EXPR_PSUM}, 0, INT_MAX
 	},
-	{ "avg",    1, {FLOAT4OID},
+	{ "c:avg",    1, {FLOAT4OID},
 	  "s:avg",  2, {INT4OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS, ALTFUNC_EXPR_PSUM}, 0, INT_MAX
 	},
-	{ "avg",    1, {FLOAT8OID},
+	{ "c:avg",    1, {FLOAT8OID},
 	  "s:avg",  2, {INT4OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS, ALTFUNC_EXPR_PSUM}, 0, INT_MAX
 	},
 #ifdef GPUPREAGG_SUPPORT_NUMERIC
-	{ "avg",	1, {NUMERICOID},
+	{ "c:avg",	1, {NUMERICOID},
 	  "s:avg_numeric",	2, {INT4OID, NUMERICOID},
 	  {ALTFUNC_EXPR_NROWS, ALTFUNC_EXPR_PSUM},
 	  DEVKERNEL_NEEDS_NUMERIC, 100
 	},
 #endif
 	/* COUNT(*) = SUM(NROWS(*|X)) */
-	{ "count", 0, {},
+	{ "c:count", 0, {},
 	  "s:count", 1, {INT4OID},
 	  {ALTFUNC_EXPR_NROWS}, 0, INT_MAX
 	},
-	{ "count", 1, {ANYOID},
+	{ "c:count", 1, {ANYOID},
 	  "s:count", 1, {INT4OID},
 	  {ALTFUNC_EXPR_NROWS}, 0, INT_MAX
 	},
 	/* MAX(X) = MAX(PMAX(X)) */
-	{ "max", 1, {INT2OID},
+	{ "c:max", 1, {INT2OID},
 	  "c:max", 1, {INT2OID},
 	  {ALTFUNC_EXPR_PMAX}, 0, INT_MAX
 	},
-	{ "max", 1, {INT4OID},
+	{ "c:max", 1, {INT4OID},
 	  "c:max", 1, {INT4OID},
 	  {ALTFUNC_EXPR_PMAX}, 0, INT_MAX
 	},
-	{ "max", 1, {INT8OID},
+	{ "c:max", 1, {INT8OID},
 	  "c:max", 1, {INT8OID},
 	  {ALTFUNC_EXPR_PMAX}, 0, INT_MAX
 	},
-	{ "max", 1, {FLOAT4OID},
+	{ "c:max", 1, {FLOAT4OID},
 	  "c:max", 1, {FLOAT4OID},
 	  {ALTFUNC_EXPR_PMAX}, 0, INT_MAX
 	},
-	{ "max", 1, {FLOAT8OID},
+	{ "c:max", 1, {FLOAT8OID},
 	  "c:max", 1, {FLOAT8OID},
 	  {ALTFUNC_EXPR_PMAX}, 0, INT_MAX
 	},
 #ifdef GPUPREAGG_SUPPORT_NUMERIC
-	{ "max", 1, {NUMERICOID},
+	{ "c:max", 1, {NUMERICOID},
 	  "c:max", 1, {NUMERICOID},
 	  {ALTFUNC_EXPR_PMAX}, DEVKERNEL_NEEDS_NUMERIC, INT_MAX
 	},
 #endif
-	{ "max", 1, {CASHOID},
+	{ "c:max", 1, {CASHOID},
 	  "c:max", 1, {CASHOID},
 	  {ALTFUNC_EXPR_PMAX}, DEVKERNEL_NEEDS_MONEY, INT_MAX
 	},
-	{ "max", 1, {DATEOID},
+	{ "c:max", 1, {DATEOID},
 	  "c:max", 1, {DATEOID},
 	  {ALTFUNC_EXPR_PMAX}, 0, INT_MAX
 	},
-	{ "max", 1, {TIMEOID},
+	{ "c:max", 1, {TIMEOID},
 	  "c:max", 1, {TIMEOID},
 	  {ALTFUNC_EXPR_PMAX}, 0, INT_MAX
 	},
-	{ "max", 1, {TIMESTAMPOID},
+	{ "c:max", 1, {TIMESTAMPOID},
 	  "c:max", 1, {TIMESTAMPOID},
 	  {ALTFUNC_EXPR_PMAX}, 0, INT_MAX
 	},
-	{ "max", 1, {TIMESTAMPTZOID},
+	{ "c:max", 1, {TIMESTAMPTZOID},
 	  "c:max", 1, {TIMESTAMPTZOID},
 	  {ALTFUNC_EXPR_PMAX}, 0, INT_MAX
 	},
 
 	/* MIX(X) = MIN(PMIN(X)) */
-	{ "min", 1, {INT2OID},
+	{ "c:min", 1, {INT2OID},
 	  "c:min", 1, {INT2OID},
 	  {ALTFUNC_EXPR_PMIN}, 0, INT_MAX
 	},
-	{ "min", 1, {INT4OID},
+	{ "c:min", 1, {INT4OID},
 	  "c:min", 1, {INT4OID},
 	  {ALTFUNC_EXPR_PMIN}, 0, INT_MAX
 	},
-	{ "min", 1, {INT8OID},
+	{ "c:min", 1, {INT8OID},
 	  "c:min", 1, {INT8OID},
 	  {ALTFUNC_EXPR_PMIN}, 0, INT_MAX
 	},
-	{ "min", 1, {FLOAT4OID},
+	{ "c:min", 1, {FLOAT4OID},
 	  "c:min", 1, {FLOAT4OID},
 	  {ALTFUNC_EXPR_PMIN}, 0, INT_MAX
 	},
-	{ "min", 1, {FLOAT8OID},
+	{ "c:min", 1, {FLOAT8OID},
 	  "c:min", 1, {FLOAT8OID},
 	  {ALTFUNC_EXPR_PMIN}, 0, INT_MAX
 	},
 #ifdef GPUPREAGG_SUPPORT_NUMERIC
-	{ "min", 1, {NUMERICOID},
+	{ "c:min", 1, {NUMERICOID},
 	  "c:min", 1, {NUMERICOID},
 	  {ALTFUNC_EXPR_PMIN}, DEVKERNEL_NEEDS_NUMERIC, INT_MAX
 	},
 #endif
-	{ "min", 1, {CASHOID},
+	{ "c:min", 1, {CASHOID},
 	  "c:max", 1, {CASHOID},
 	  {ALTFUNC_EXPR_PMAX}, DEVKERNEL_NEEDS_MONEY, INT_MAX
 	},
-	{ "min", 1, {DATEOID},
+	{ "c:min", 1, {DATEOID},
 	  "c:min", 1, {DATEOID},
 	  {ALTFUNC_EXPR_PMIN}, 0, INT_MAX
 	},
-	{ "min", 1, {TIMEOID},
+	{ "c:min", 1, {TIMEOID},
 	  "c:min", 1, {TIMEOID},
 	  {ALTFUNC_EXPR_PMIN}, 0, INT_MAX
 	},
-	{ "min", 1, {TIMESTAMPOID},
+	{ "c:min", 1, {TIMESTAMPOID},
 	  "c:min", 1, {TIMESTAMPOID},
 	  {ALTFUNC_EXPR_PMIN}, 0, INT_MAX
 	},
-	{ "min", 1, {TIMESTAMPTZOID},
+	{ "c:min", 1, {TIMESTAMPTZOID},
 	  "c:min", 1, {TIMESTAMPTZOID},
 	  {ALTFUNC_EXPR_PMIN}, 0, INT_MAX
 	},
 
 	/* SUM(X) = SUM(PSUM(X)) */
-	{ "sum", 1, {INT2OID},
+	{ "c:sum", 1, {INT2OID},
 	  "s:sum", 1, {INT8OID},
 	  {ALTFUNC_EXPR_PSUM}, 0, INT_MAX
 	},
-	{ "sum", 1, {INT4OID},
+	{ "c:sum", 1, {INT4OID},
 	  "s:sum", 1, {INT8OID},
 	  {ALTFUNC_EXPR_PSUM}, 0, INT_MAX
 	},
-	{ "sum", 1, {INT8OID},
+	{ "c:sum", 1, {INT8OID},
 	  "c:sum", 1, {INT8OID},
 	  {ALTFUNC_EXPR_PSUM}, 0, INT_MAX
 	},
-	{ "sum", 1, {FLOAT4OID},
+	{ "c:sum", 1, {FLOAT4OID},
 	  "c:sum", 1, {FLOAT4OID},
 	  {ALTFUNC_EXPR_PSUM}, 0, INT_MAX
 	},
-	{ "sum", 1, {FLOAT8OID},
+	{ "c:sum", 1, {FLOAT8OID},
 	  "c:sum", 1, {FLOAT8OID},
 	  {ALTFUNC_EXPR_PSUM}, 0, INT_MAX
 	},
 #ifdef GPUPREAGG_SUPPORT_NUMERIC
-	{ "sum", 1, {NUMERICOID},
+	{ "c:sum", 1, {NUMERICOID},
 	  "c:sum", 1, {NUMERICOID},
 	  {ALTFUNC_EXPR_PSUM}, DEVKERNEL_NEEDS_NUMERIC, 100
 	},
 #endif
-	{ "sum", 1, {CASHOID},
+	{ "c:sum", 1, {CASHOID},
 	  "c:sum", 1, {CASHOID},
 	  {ALTFUNC_EXPR_PSUM}, DEVKERNEL_NEEDS_MONEY, INT_MAX
 	},
+	/* BOOL_AND(X) = BOOL_AND(PAND(X)), EVERY(X) = EVERY(PAND(X)) */
+	{ "c:bool_and", 1, {BOOLOID},
+	  "c:bool_and", 1, {BOOLOID},
+	  {ALTFUNC_EXPR_PAND}, 0, INT_MAX
+	},
+	{ "c:every", 1, {BOOLOID},
+	  "c:every", 1, {BOOLOID},
+	  {ALTFUNC_EXPR_PAND}, 0, INT_MAX
+	},
+	/* BOOL_OR(X) = BOOL_OR(POR(X)) */
+	{ "c:bool_or", 1, {BOOLOID},
+	  "c:bool_or", 1, {BOOLOID},
+	  {ALTFUNC_EXPR_POR}, 0, INT_MAX
+	},
+	/* BIT_AND(X) = BIT_AND(PAND(X)) */
+	{ "c:bit_and", 1, {INT2OID},
+	  "c:bit_and", 1, {INT2OID},
+	  {ALTFUNC_EXPR_PAND}, 0, INT_MAX
+	},
+	{ "c:bit_and", 1, {INT4OID},
+	  "c:bit_and", 1, {INT4OID},
+	  {ALTFUNC_EXPR_PAND}, 0, INT_MAX
+	},
+	{ "c:bit_and", 1, {INT8OID},
+	  "c:bit_and", 1, {INT8OID},
+	  {ALTFUNC_EXPR_PAND}, 0, INT_MAX
+	},
+	/* BIT_OR(X) = BIT_OR(POR(X)) */
+	{ "c:bit_or", 1, {INT2OID},
+	  "c:bit_or", 1, {INT2OID},
+	  {ALTFUNC_EXPR_POR}, 0, INT_MAX
+	},
+	{ "c:bit_or", 1, {INT4OID},
+	  "c:bit_or", 1, {INT4OID},
+	  {ALTFUNC_EXPR_POR}, 0, INT_MAX
+	},
+	{ "c:bit_or", 1, {INT8OID},
+	  "c:bit_or", 1, {INT8OID},
+	  {ALTFUNC_EXPR_POR}, 0, INT_MAX
+	},
 	/* STDDEV(X) = EX_STDDEV(NROWS(),PSUM(X),PSUM(X*X)) */
-	{ "stddev", 1, {FLOAT4OID},
+	{ "c:stddev", 1, {FLOAT4OID},
 	  "s:stddev", 3, {INT4OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
 	   ALTFUNC_EXPR_PSUM,
 	   ALTFUNC_EXPR_PSUM_X2}, 0, SHRT_MAX
 	},
-	{ "stddev", 1, {FLOAT8OID},
+	{ "c:stddev", 1, {FLOAT8OID},
 	  "s:stddev", 3, {INT4OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
 	   ALTFUNC_EXPR_PSUM,
 	   ALTFUNC_EXPR_PSUM_X2}, 0, SHRT_MAX
 	},
 #ifdef GPUPREAGG_SUPPORT_NUMERIC
-	{ "stddev", 1, {NUMERICOID},
+	{ "c:stddev", 1, {NUMERICOID},
 	  "s:stddev", 3, {INT4OID, NUMERICOID, NUMERICOID},
 	  {ALTFUNC_EXPR_NROWS,
 	   ALTFUNC_EXPR_PSUM,
 	   ALTFUNC_EXPR_PSUM_X2}, DEVKERNEL_NEEDS_NUMERIC, 32
 	},
 #endif
-	{ "stddev_pop", 1, {FLOAT4OID},
+	{ "c:stddev_pop", 1, {FLOAT4OID},
 	  "s:stddev_pop", 3, {INT4OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
 	   ALTFUNC_EXPR_PSUM,
 	   ALTFUNC_EXPR_PSUM_X2}, 0, SHRT_MAX
 	},
-	{ "stddev_pop", 1, {FLOAT8OID},
+	{ "c:stddev_pop", 1, {FLOAT8OID},
 	  "s:stddev_pop", 3, {INT4OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
 	   ALTFUNC_EXPR_PSUM,
 	   ALTFUNC_EXPR_PSUM_X2}, 0, SHRT_MAX
 	},
 #ifdef GPUPREAGG_SUPPORT_NUMERIC
-	{ "stddev_pop", 1, {NUMERICOID},
+	{ "c:stddev_pop", 1, {NUMERICOID},
 	  "s:stddev_pop", 3, {INT4OID, NUMERICOID, NUMERICOID},
 	  {ALTFUNC_EXPR_NROWS,
        ALTFUNC_EXPR_PSUM,
        ALTFUNC_EXPR_PSUM_X2}, DEVKERNEL_NEEDS_NUMERIC, 32
 	},
 #endif
-	{ "stddev_samp", 1, {FLOAT4OID},
+	{ "c:stddev_samp", 1, {FLOAT4OID},
 	  "s:stddev_samp", 3, {INT4OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
 	   ALTFUNC_EXPR_PSUM,
 	   ALTFUNC_EXPR_PSUM_X2}, 0, SHRT_MAX
 	},
-	{ "stddev_samp", 1, {FLOAT8OID},
+	{ "c:stddev_samp", 1, {FLOAT8OID},
 	  "s:stddev_samp", 3, {INT4OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
 	   ALTFUNC_EXPR_PSUM,
 	   ALTFUNC_EXPR_PSUM_X2}, 0, SHRT_MAX
 	},
 #ifdef GPUPREAGG_SUPPORT_NUMERIC
-	{ "stddev_samp", 1, {NUMERICOID},
+	{ "c:stddev_samp", 1, {NUMERICOID},
 	  "s:stddev_samp", 3, {INT4OID, NUMERICOID, NUMERICOID},
 	  {ALTFUNC_EXPR_NROWS,
 	   ALTFUNC_EXPR_PSUM,
@@ -518,60 +647,60 @@ static aggfunc_catalog_t  aggfunc_catalog[] = {
 	},
 #endif
 	/* VARIANCE(X) = PGSTROM.VARIANCE(NROWS(), PSUM(X),PSUM(X^2)) */
-	{ "variance", 1, {FLOAT4OID},
+	{ "c:variance", 1, {FLOAT4OID},
 	  "s:variance", 3, {INT4OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
 	   ALTFUNC_EXPR_PSUM,
 	   ALTFUNC_EXPR_PSUM_X2}, 0, SHRT_MAX
 	},
-	{ "variance", 1, {FLOAT8OID},
+	{ "c:variance", 1, {FLOAT8OID},
 	  "s:variance", 3, {INT4OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
 	   ALTFUNC_EXPR_PSUM,
 	   ALTFUNC_EXPR_PSUM_X2}, 0, SHRT_MAX
 	},
 #ifdef GPUPREAGG_SUPPORT_NUMERIC
-	{ "variance", 1, {NUMERICOID},
+	{ "c:variance", 1, {NUMERICOID},
 	  "s:variance", 3, {INT4OID, NUMERICOID, NUMERICOID},
 	  {ALTFUNC_EXPR_NROWS,
        ALTFUNC_EXPR_PSUM,
        ALTFUNC_EXPR_PSUM_X2}, DEVKERNEL_NEEDS_NUMERIC, 32
 	},
 #endif
-	{ "var_pop", 1, {FLOAT4OID},
+	{ "c:var_pop", 1, {FLOAT4OID},
 	  "s:var_pop", 3, {INT4OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
 	   ALTFUNC_EXPR_PSUM,
 	   ALTFUNC_EXPR_PSUM_X2}, 0, SHRT_MAX
 	},
-	{ "var_pop", 1, {FLOAT8OID},
+	{ "c:var_pop", 1, {FLOAT8OID},
 	  "s:var_pop", 3, {INT4OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
 	   ALTFUNC_EXPR_PSUM,
 	   ALTFUNC_EXPR_PSUM_X2}, 0, SHRT_MAX
 	},
 #ifdef GPUPREAGG_SUPPORT_NUMERIC
-	{ "var_pop", 1, {NUMERICOID},
+	{ "c:var_pop", 1, {NUMERICOID},
 	  "s:var_pop", 3, {INT4OID, NUMERICOID, NUMERICOID},
 	  {ALTFUNC_EXPR_NROWS,
        ALTFUNC_EXPR_PSUM,
        ALTFUNC_EXPR_PSUM_X2}, DEVKERNEL_NEEDS_NUMERIC, 32
 	},
 #endif
-	{ "var_samp", 1, {FLOAT4OID},
+	{ "c:var_samp", 1, {FLOAT4OID},
 	  "s:var_samp", 3, {INT4OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
 	   ALTFUNC_EXPR_PSUM,
 	   ALTFUNC_EXPR_PSUM_X2}, 0, SHRT_MAX
 	},
-	{ "var_samp", 1, {FLOAT8OID},
+	{ "c:var_samp", 1, {FLOAT8OID},
 	  "s:var_samp", 3, {INT4OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
 	   ALTFUNC_EXPR_PSUM,
 	   ALTFUNC_EXPR_PSUM_X2}, 0, SHRT_MAX
 	},
 #ifdef GPUPREAGG_SUPPORT_NUMERIC
-	{ "var_samp", 1, {NUMERICOID},
+	{ "c:var_samp", 1, {NUMERICOID},
 	  "s:var_samp", 3, {INT4OID, NUMERICOID, NUMERICOID},
 	  {ALTFUNC_EXPR_NROWS,
        ALTFUNC_EXPR_PSUM,
@@ -584,7 +713,7 @@ static aggfunc_catalog_t  aggfunc_catalog[] = {
 	 *                          PCOV_X2(X,Y), PCOV_Y2(X,Y),
 	 *                          PCOV_XY(X,Y))
 	 */
-	{ "corr", 2, {FLOAT8OID, FLOAT8OID},
+	{ "c:corr", 2, {FLOAT8OID, FLOAT8OID},
 	  "s:corr", 6,
 	  {INT4OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
@@ -594,7 +723,7 @@ static aggfunc_catalog_t  aggfunc_catalog[] = {
 	   ALTFUNC_EXPR_PCOV_Y2,
 	   ALTFUNC_EXPR_PCOV_XY}, 0, SHRT_MAX
 	},
-	{ "covar_pop", 2, {FLOAT8OID, FLOAT8OID},
+	{ "c:covar_pop", 2, {FLOAT8OID, FLOAT8OID},
 	  "s:covar_pop", 6,
 	  {INT4OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
@@ -604,7 +733,7 @@ static aggfunc_catalog_t  aggfunc_catalog[] = {
 	   ALTFUNC_EXPR_PCOV_Y2,
 	   ALTFUNC_EXPR_PCOV_XY}, 0, SHRT_MAX
 	},
-	{ "covar_samp", 2, {FLOAT8OID, FLOAT8OID},
+	{ "c:covar_samp", 2, {FLOAT8OID, FLOAT8OID},
 	  "s:covar_samp", 6,
 	  {INT4OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
@@ -620,7 +749,7 @@ static aggfunc_catalog_t  aggfunc_catalog[] = {
 	 * That takes PSUM_X, PSUM_Y, PSUM_X2, PSUM_Y2, PSUM_XY according
 	 * to the function
 	 */
-	{ "regr_avgx", 2, {FLOAT8OID, FLOAT8OID},
+	{ "c:regr_avgx", 2, {FLOAT8OID, FLOAT8OID},
 	  "s:regr_avgx", 6,
 	  {INT4OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
@@ -630,7 +759,7 @@ static aggfunc_catalog_t  aggfunc_catalog[] = {
        ALTFUNC_EXPR_PCOV_Y2,
        ALTFUNC_EXPR_PCOV_XY}, 0, SHRT_MAX
 	},
-	{ "regr_avgy", 2, {FLOAT8OID, FLOAT8OID},
+	{ "c:regr_avgy", 2, {FLOAT8OID, FLOAT8OID},
 	  "s:regr_avgy", 6,
 	  {INT4OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
@@ -640,10 +769,10 @@ static aggfunc_catalog_t  aggfunc_catalog[] = {
 	   ALTFUNC_EXPR_PCOV_Y2,
 	   ALTFUNC_EXPR_PCOV_XY}, 0, SHRT_MAX
 	},
-	{ "regr_count", 2, {FLOAT8OID, FLOAT8OID},
+	{ "c:regr_count", 2, {FLOAT8OID, FLOAT8OID},
 	  "s:regr_count", 1, {INT4OID}, {ALTFUNC_EXPR_NROWS}, 0
 	},
-	{ "regr_intercept", 2, {FLOAT8OID, FLOAT8OID},
+	{ "c:regr_intercept", 2, {FLOAT8OID, FLOAT8OID},
 	  "s:regr_intercept", 6,
 	  {INT4OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
@@ -653,7 +782,7 @@ static aggfunc_catalog_t  aggfunc_catalog[] = {
 	   ALTFUNC_EXPR_PCOV_Y2,
 	   ALTFUNC_EXPR_PCOV_XY}, 0, SHRT_MAX
 	},
-	{ "regr_r2", 2, {FLOAT8OID, FLOAT8OID},
+	{ "c:regr_r2", 2, {FLOAT8OID, FLOAT8OID},
 	  "s:regr_r2", 6,
 	  {INT4OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
@@ -663,7 +792,7 @@ static aggfunc_catalog_t  aggfunc_catalog[] = {
 	   ALTFUNC_EXPR_PCOV_Y2,
 	   ALTFUNC_EXPR_PCOV_XY}, 0, SHRT_MAX
 	},
-	{ "regr_slope", 2, {FLOAT8OID, FLOAT8OID},
+	{ "c:regr_slope", 2, {FLOAT8OID, FLOAT8OID},
 	  "s:regr_slope", 6,
 	  {INT4OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
@@ -673,7 +802,7 @@ static aggfunc_catalog_t  aggfunc_catalog[] = {
 	   ALTFUNC_EXPR_PCOV_Y2,
 	   ALTFUNC_EXPR_PCOV_XY}, 0, SHRT_MAX
 	},
-	{ "regr_sxx", 2, {FLOAT8OID, FLOAT8OID},
+	{ "c:regr_sxx", 2, {FLOAT8OID, FLOAT8OID},
 	  "s:regr_sxx", 6,
 	  {INT4OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
@@ -683,7 +812,7 @@ static aggfunc_catalog_t  aggfunc_catalog[] = {
 	   ALTFUNC_EXPR_PCOV_Y2,
 	   ALTFUNC_EXPR_PCOV_XY}, 0, SHRT_MAX
 	},
-	{ "regr_sxy", 2, {FLOAT8OID, FLOAT8OID},
+	{ "c:regr_sxy", 2, {FLOAT8OID, FLOAT8OID},
 	  "s:regr_sxy", 6,
 	  {INT4OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
@@ -693,7 +822,7 @@ static aggfunc_catalog_t  aggfunc_catalog[] = {
 	   ALTFUNC_EXPR_PCOV_Y2,
 	   ALTFUNC_EXPR_PCOV_XY}, 0, SHRT_MAX
 	},
-	{ "regr_syy", 2, {FLOAT8OID, FLOAT8OID},
+	{ "c:regr_syy", 2, {FLOAT8OID, FLOAT8OID},
 	  "s:regr_syy", 6,
 	  {INT4OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID, FLOAT8OID},
 	  {ALTFUNC_EXPR_NROWS,
@@ -703,6 +832,63 @@ static aggfunc_catalog_t  aggfunc_catalog[] = {
 	   ALTFUNC_EXPR_PCOV_Y2,
 	   ALTFUNC_EXPR_PCOV_XY}, 0, SHRT_MAX
 	},
+	/*
+	 * APPROX_COUNT_DISTINCT(X) = HLL_COUNT(PHLL(0,X),...,PHLL(15,X))
+	 *
+	 * Each PHLL() carries 8 of HyperLogLog registers; see the comment
+	 * at GPUPREAGG_HLL_NUM_COLUMNS
+	 */
+	{ "s:approx_count_distinct", 1, {ANYELEMENTOID},
+	  "s:hll_count", GPUPREAGG_HLL_NUM_COLUMNS,
+	  {INT8OID, INT8OID, INT8OID, INT8OID,
+	   INT8OID, INT8OID, INT8OID, INT8OID,
+	   INT8OID, INT8OID, INT8OID, INT8OID,
+	   INT8OID, INT8OID, INT8OID, INT8OID},
+	  {ALTFUNC_EXPR_PHLL, ALTFUNC_EXPR_PHLL,
+	   ALTFUNC_EXPR_PHLL, ALTFUNC_EXPR_PHLL,
+	   ALTFUNC_EXPR_PHLL, ALTFUNC_EXPR_PHLL,
+	   ALTFUNC_EXPR_PHLL, ALTFUNC_EXPR_PHLL,
+	   ALTFUNC_EXPR_PHLL, ALTFUNC_EXPR_PHLL,
+	   ALTFUNC_EXPR_PHLL, ALTFUNC_EXPR_PHLL,
+	   ALTFUNC_EXPR_PHLL, ALTFUNC_EXPR_PHLL,
+	   ALTFUNC_EXPR_PHLL, ALTFUNC_EXPR_PHLL}, 0, INT_MAX
+	},
+	/*
+	 * APPROX_PERCENTILE(X,Q) = PERCENTILE_HIST(PMAX(Q),PMIN(X),PMAX(X),
+	 *                                          PQHIST(0,X),...,PQHIST(31,X))
+	 *
+	 * Each PQHIST() carries 2 counters of the log-scale histogram; see the
+	 * comment at GPUPREAGG_QHIST_NUM_BUCKETS
+	 */
+	{ "s:approx_percentile", 2, {FLOAT8OID, FLOAT8OID},
+	  "s:percentile_hist", 3 + GPUPREAGG_QHIST_NUM_COLUMNS,
+	  {FLOAT8OID, FLOAT8OID, FLOAT8OID,
+	   INT8OID, INT8OID, INT8OID, INT8OID,
+	   INT8OID, INT8OID, INT8OID, INT8OID,
+	   INT8OID, INT8OID, INT8OID, INT8OID,
+	   INT8OID, INT8OID, INT8OID, INT8OID,
+	   INT8OID, INT8OID, INT8OID, INT8OID,
+	   INT8OID, INT8OID, INT8OID, INT8OID,
+	   INT8OID, INT8OID, INT8OID, INT8OID,
+	   INT8OID, INT8OID, INT8OID, INT8OID},
+	  {ALTFUNC_EXPR_PMAX_Y, ALTFUNC_EXPR_PMIN, ALTFUNC_EXPR_PMAX,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST,
+	   ALTFUNC_EXPR_PQHIST, ALTFUNC_EXPR_PQHIST}, 0, INT_MAX
+	},
 };
 
 static const aggfunc_catalog_t *
@@ -710,18 +896,29 @@ aggfunc_lookup_by_oid(Oid aggfnoid)
 {
 	Form_pg_proc	proform;
 	HeapTuple		htup;
+	Oid				namespace_oid;
+	Oid				pgstrom_namespace_oid;
 	int				i;
 
 	htup = SearchSysCache1(PROCOID, ObjectIdGetDatum(aggfnoid));
 	if (!HeapTupleIsValid(htup))
 		elog(ERROR, "cache lookup failed for function %u", aggfnoid);
 	proform = (Form_pg_proc) GETSTRUCT(htup);
+	pgstrom_namespace_oid = get_namespace_oid("pgstrom", true);
 
 	for (i=0; i < lengthof(aggfunc_catalog); i++)
 	{
 		aggfunc_catalog_t  *catalog = &aggfunc_catalog[i];
 
-		if (strcmp(catalog->aggfn_name, NameStr(proform->proname)) == 0 &&
+		if (strncmp(catalog->aggfn_name, "c:", 2) == 0)
+			namespace_oid = PG_CATALOG_NAMESPACE;
+		else if (strncmp(catalog->aggfn_name, "s:", 2) == 0)
+			namespace_oid = pgstrom_namespace_oid;
+		else
+			elog(ERROR, "Bug? unexpected namespace of aggregate function");
+
+		if (namespace_oid == proform->pronamespace &&
+			strcmp(catalog->aggfn_name + 2, NameStr(proform->proname)) == 0 &&
 			catalog->aggfn_nargs == proform->pronargs &&
 			memcmp(catalog->aggfn_argtypes,
 				   proform->proargtypes.values,
@@ -1209,6 +1406,7 @@ make_gpupreagg_refnode(Aggref *aggref, List **prep_tlist,
 	Oid			namespace_oid;
 	HeapTuple	tuple;
 	Form_pg_proc proc_form;
+	int			qhist_index = 0;
 	int			i;
 
 	/*
@@ -1330,6 +1528,7 @@ make_gpupreagg_refnode(Aggref *aggref, List **prep_tlist,
 		TargetEntry *tle;
 		Expr	   *expr;
 		Var		   *varref;
+		Const	   *kconst;
 		AttrNumber	resno;
 
 		switch (code)
@@ -1355,6 +1554,18 @@ make_gpupreagg_refnode(Aggref *aggref, List **prep_tlist,
 												 NULL);
 				expr = make_altfunc_expr("pmax", list_make1(expr));
 				break;
+			case ALTFUNC_EXPR_PAND:
+			case ALTFUNC_EXPR_POR:
+				tle = linitial(aggref->args);
+				Assert(IsA(tle, TargetEntry));
+				expr = tle->expr;
+				if (aggref->aggfilter)
+					expr = make_expr_conditional(expr, aggref->aggfilter,
+												 NULL);
+				expr = make_altfunc_expr(code == ALTFUNC_EXPR_PAND
+										 ? "pand" : "por",
+										 list_make1(expr));
+				break;
 			case ALTFUNC_EXPR_PSUM:
 				tle = linitial(aggref->args);
 				Assert(IsA(tle, TargetEntry));
@@ -1406,6 +1617,53 @@ make_gpupreagg_refnode(Aggref *aggref, List **prep_tlist,
 			case ALTFUNC_EXPR_PCOV_XY:
 				expr = make_altfunc_pcov_expr(aggref, "pcov_xy");
 				break;
+			case ALTFUNC_EXPR_PHLL:
+				tle = linitial(aggref->args);
+				Assert(IsA(tle, TargetEntry));
+				expr = tle->expr;
+				if (aggref->aggfilter)
+					expr = make_expr_conditional(expr, aggref->aggfilter,
+												 NULL);
+				/*
+				 * NOTE: pgstrom.phll() is declared only for the data types
+				 * whose hash value is identical on host and device, so
+				 * make_altfunc_expr() fails on the other data types.
+				 */
+				expr = make_altfunc_expr("phll",
+										 list_make2(makeConst(INT4OID,
+															  -1,
+															  InvalidOid,
+															  sizeof(int32),
+															  Int32GetDatum(i),
+															  false,
+															  true),
+													expr));
+				break;
+			case ALTFUNC_EXPR_PQHIST:
+				tle = linitial(aggref->args);
+				Assert(IsA(tle, TargetEntry));
+				expr = tle->expr;
+				if (aggref->aggfilter)
+					expr = make_expr_conditional(expr, aggref->aggfilter,
+												 NULL);
+				kconst = makeConst(INT4OID,
+								   -1,
+								   InvalidOid,
+								   sizeof(int32),
+								   Int32GetDatum(qhist_index++),
+								   false,
+								   true);
+				expr = make_altfunc_expr("pqhist", list_make2(kconst, expr));
+				break;
+			case ALTFUNC_EXPR_PMAX_Y:
+				tle = lsecond(aggref->args);
+				Assert(IsA(tle, TargetEntry));
+				expr = tle->expr;
+				if (aggref->aggfilter)
+					expr = make_expr_conditional(expr, aggref->aggfilter,
+												 NULL);
+				expr = make_altfunc_expr("pmax", list_make1(expr));
+				break;
 			default:
 				elog(ERROR, "Bug? unexpected ALTFUNC_EXPR_* label");
 		}
@@ -1513,6 +1771,37 @@ gpupreagg_rewrite_mutator(Node *node, gpupreagg_rewrite_context *context)
 			"because var-node referenced non-grouping key";
 		return NULL;
 	}
+	else if (IsA(node, GroupingFunc))
+	{
+		GroupingFunc   *grpfunc;
+		List		   *cols = NIL;
+		ListCell	   *lc;
+
+		/*
+		 * GROUPING() checks whether its arguments are grouped by the
+		 * current grouping set, using 'cols' (column numbers of the
+		 * input tuple); so, it has to follow the tlist of GpuPreAgg.
+		 */
+		grpfunc = (GroupingFunc *)
+			expression_tree_mutator(node, gpupreagg_rewrite_mutator,
+									(void *)context);
+		foreach (lc, grpfunc->cols)
+		{
+			AttrNumber	varattno = context->attr_maps[lfirst_int(lc) - 1];
+
+			if (varattno <= 0)
+			{
+				context->not_available = true;
+				context->not_available_reason =
+					"because GROUPING() referenced non-grouping key";
+				return NULL;
+			}
+			cols = lappend_int(cols, varattno);
+		}
+		grpfunc->cols = cols;
+
+		return (Node *) grpfunc;
+	}
 	return expression_tree_mutator(node, gpupreagg_rewrite_mutator,
 								   (void *)context);
 }
@@ -1759,12 +2048,16 @@ gpupreagg_codegen_qual_eval(GpuPreAggInfo *gpa_info,
 		 * however, needs to be careful to deal with...
 		 */
 		Node   *outer_quals = (Node *)gpa_info->outer_quals;
+		char   *cse_code = pgstrom_codegen_cse_begin(gpa_info->outer_quals,
+													 context);
 		char   *expr_code = pgstrom_codegen_expression(outer_quals,
 													   context);
 		Assert(expr_code != NULL);
+		pgstrom_codegen_cse_end(context);
 
 		pgstrom_codegen_param_declarations(&str, context);
 		pgstrom_codegen_var_declarations(&str, context);
+		appendStringInfoString(&str, cse_code);
 		appendStringInfo(
 			&str,
 			"\n"
@@ -1840,13 +2133,27 @@ gpupreagg_codegen_hashvalue(GpuPreAggInfo *gpa_info,
 			dtype->type_name, resno,
 			dtype->type_name, resno - 1);
 
-		/* crc32 computing */
+		/* hash value computing */
+		if (gpa_info->hash_function == HASHFUNC_FASTHASH)
+			appendStringInfo(
+				&body,
+				"  hash_value = pg_%s_comp_fasthash(hash_value, keyval_%u);\n",
+				dtype->type_name, resno);
+		else
+			appendStringInfo(
+				&body,
+				"  hash_value = pg_%s_comp_crc32(crc32_table,\n"
+				"                                hash_value, keyval_%u);\n",
+				dtype->type_name, resno);
+	}
+	/*
+	 * The caller initializes/finalizes hash_value as legacy CRC32 does,
+	 * so fasthash needs its own finalization for good distribution.
+	 */
+	if (gpa_info->hash_function == HASHFUNC_FASTHASH)
 		appendStringInfo(
 			&body,
-			"  hash_value = pg_%s_comp_crc32(crc32_table,\n"
-			"                                hash_value, keyval_%u);\n",
-			dtype->type_name, resno);
-	}
+			"  hash_value = pg_common_fin_fasthash(hash_value);\n");
 	/* no constants should be appear */
 	Assert(bms_is_empty(context->param_refs));
 
@@ -1985,6 +2292,7 @@ aggcalc_method_of_typeoid(Oid type_oid)
 	{
 		case INT2OID:
 			return "SHORT";
+		case BOOLOID:
 		case INT4OID:
 		case DATEOID:
 			return "INT";
@@ -2141,6 +2449,21 @@ gpupreagg_codegen_aggcalc(GpuPreAggInfo *gpa_info,
 							 aggcalc_method_of_typeoid(type_oid),
 							 aggcalc_args);
 		}
+		else if (strcmp(func_name, "pand") == 0 ||
+				 strcmp(func_name, "por") == 0)
+		{
+			Assert(list_length(func->args) == 1);
+			type_oid = exprType(linitial(func->args));
+			appendStringInfo(&body,
+							 "  case %d:\n"
+							 "    AGGCALC_%s_%s_%s(%s);\n"
+							 "    break;\n",
+							 tle->resno - 1,
+							 aggcalc_class,
+							 strcmp(func_name, "pand") == 0 ? "PAND" : "POR",
+							 aggcalc_method_of_typeoid(type_oid),
+							 aggcalc_args);
+		}
 		else if (strcmp(func_name, "psum") == 0    ||
 				 strcmp(func_name, "psum_x2") == 0)
 		{
@@ -2172,6 +2495,28 @@ gpupreagg_codegen_aggcalc(GpuPreAggInfo *gpa_info,
 							 aggcalc_method_of_typeoid(FLOAT8OID),
 							 aggcalc_args);
 		}
+		else if (strcmp(func_name, "phll") == 0)
+		{
+			/* byte-wise max of the packed registers */
+			appendStringInfo(&body,
+							 "  case %d:\n"
+							 "    AGGCALC_%s_PHLL(%s);\n"
+							 "    break;\n",
+							 tle->resno - 1,
+							 aggcalc_class,
+							 aggcalc_args);
+		}
+		else if (strcmp(func_name, "pqhist") == 0)
+		{
+			/* addition of the packed counters */
+			appendStringInfo(&body,
+							 "  case %d:\n"
+							 "    AGGCALC_%s_PQHIST(%s);\n"
+							 "    break;\n",
+							 tle->resno - 1,
+							 aggcalc_class,
+							 aggcalc_args);
+		}
 		else
 		{
 			elog(NOTICE, "Bug? unexpected function: %s", func_name);
@@ -2244,6 +2589,7 @@ gpupreagg_codegen_projection_misc(StringInfo body, cl_int dst_index,
 	 * false, NULL shall be set. Even if NULL, value fields MUST have
 	 * reasonable initial value to the later atomic operation.
 	 * In case of PMIN(), NULL takes possible maximum number.
+	 * In case of PAND(), NULL takes a value with all the bits set.
 	 */
 	Node		   *clause = linitial(func->args);
 	Oid				type_oid = exprType(clause);
@@ -2251,9 +2597,17 @@ gpupreagg_codegen_projection_misc(StringInfo body, cl_int dst_index,
 	const char	   *max_const;
 	const char	   *min_const;
 	const char	   *zero_const;
+	const char	   *ones_const = "__invalid__";
 
 	switch (type_oid)
 	{
+		case BOOLOID:
+			max_const = "true";
+			min_const = "false";
+			zero_const = "false";
+			ones_const = "true";
+			break;
+
 		case INT2OID:
 			/* NOTE: Only 32/64bit width are supported by atomic operation,
 			 * thus, we deal with 16bit datum using 32bit field internally.
@@ -2272,12 +2626,14 @@ gpupreagg_codegen_projection_misc(StringInfo body, cl_int dst_index,
 			max_const = "INT_MAX";
 			min_const = "INT_MIN";
 			zero_const = "0";
+			ones_const = "~0";
 			break;
 
 		case INT8OID:
             max_const = "LONG_MAX";
             min_const = "LONG_MIN";
             zero_const = "0";
+			ones_const = "~0L";
 			break;
 
 		case FLOAT4OID:
@@ -2355,7 +2711,93 @@ gpupreagg_codegen_projection_misc(StringInfo body, cl_int dst_index,
 		dst_index - 1,
 		strcmp(func_name, "pmin") == 0 ? max_const :
 		strcmp(func_name, "pmax") == 0 ? min_const :
-		strcmp(func_name, "psum") == 0 ? zero_const : "__invalid__");
+		strcmp(func_name, "psum") == 0 ? zero_const :
+		strcmp(func_name, "pand") == 0 ? ones_const :
+		strcmp(func_name, "por") == 0  ? zero_const : "__invalid__");
+}
+
+/*
+ * gpupreagg_codegen_projection_phll - put initial value of phll(K,X)
+ *
+ * Hash value of X is calculated only once for the series of phll(K,X)
+ * that share the same X, because they are located next to each other.
+ */
+static void
+gpupreagg_codegen_projection_phll(StringInfo body, cl_int dst_index,
+								  FuncExpr *func, Node **p_last_clause,
+								  codegen_context *context)
+{
+	Const		   *kconst = linitial(func->args);
+	Node		   *clause = lsecond(func->args);
+	devtype_info   *dtype;
+
+	Assert(IsA(kconst, Const) && !kconst->constisnull);
+	if (!*p_last_clause || !equal(*p_last_clause, clause))
+	{
+		dtype = pgstrom_devtype_lookup_and_track(exprType(clause), context);
+		if (!dtype)
+			elog(ERROR, "cache lookup failed for device type: %s",
+				 format_type_be(exprType(clause)));
+		appendStringInfo(
+			body,
+			"  temp.%s_v = %s;\n"
+			"  temp_hll_isnull = temp.%s_v.isnull;\n"
+			"  temp_hll_hash = pg_common_fin_fasthash(\n"
+			"    pg_%s_comp_fasthash(GPUPREAGG_HLL_HASH_SEED, temp.%s_v));\n",
+			dtype->type_name,
+			pgstrom_codegen_expression(clause, context),
+			dtype->type_name,
+			dtype->type_name,
+			dtype->type_name);
+		*p_last_clause = clause;
+	}
+	/* NULL is not counted, so it is initialized by empty registers */
+	appendStringInfo(
+		body,
+		"  dst_isnull[%d] = false;\n"
+		"  dst_values[%d] = (temp_hll_isnull\n"
+		"                    ? 0\n"
+		"                    : gpupreagg_hll_register(temp_hll_hash, %d));\n",
+		dst_index - 1,
+		dst_index - 1,
+		DatumGetInt32(kconst->constvalue));
+}
+
+/*
+ * gpupreagg_codegen_projection_pqhist - put initial value of pqhist(K,X)
+ *
+ * Like phll(K,X), bucket of X is calculated only once for the series of
+ * pqhist(K,X) that share the same X.
+ */
+static void
+gpupreagg_codegen_projection_pqhist(StringInfo body, cl_int dst_index,
+									FuncExpr *func, Node **p_last_clause,
+									codegen_context *context)
+{
+	Const		   *kconst = linitial(func->args);
+	Node		   *clause = lsecond(func->args);
+
+	Assert(IsA(kconst, Const) && !kconst->constisnull);
+	Assert(exprType(clause) == FLOAT8OID);
+	if (!*p_last_clause || !equal(*p_last_clause, clause))
+	{
+		appendStringInfo(
+			body,
+			"  temp_float8x = %s;\n"
+			"  temp_qhist_bucket = (temp_float8x.isnull ? -1 :\n"
+			"    gpupreagg_qhist_bucket(temp_float8x.value));\n",
+			pgstrom_codegen_expression(clause, context));
+		*p_last_clause = clause;
+	}
+	/* NULL is not counted, so it is initialized by empty counters */
+	appendStringInfo(
+		body,
+		"  dst_isnull[%d] = false;\n"
+		"  dst_values[%d] = (temp_qhist_bucket < 0 ? 0 :\n"
+		"    gpupreagg_qhist_counter(temp_qhist_bucket, %d));\n",
+		dst_index - 1,
+		dst_index - 1,
+		DatumGetInt32(kconst->constvalue));
 }
 
 /*
@@ -2564,6 +3006,9 @@ gpupreagg_codegen_projection(GpuPreAggInfo *gpa_info,
 	Bitmapset	   *varattnos = NULL;
 	Bitmapset	   *kvars_decl = NULL;
 	Bitmapset	   *ovars_decl = NULL;
+	List		   *cse_exprs = NIL;
+	Node		   *hll_last_clause = NULL;
+	Node		   *qhist_last_clause = NULL;
 	cl_bool			outer_compatible = true;
 	Const		   *kparam_0;
 	cl_char		   *gpagg_atts;
@@ -2593,6 +3038,9 @@ gpupreagg_codegen_projection(GpuPreAggInfo *gpa_info,
 		&decl,
 		"  pg_float8_t        temp_float8x __attribute__ ((unused));\n"
 		"  pg_float8_t        temp_float8y __attribute__ ((unused));\n"
+		"  cl_uint            temp_hll_hash __attribute__ ((unused));\n"
+		"  cl_bool            temp_hll_isnull __attribute__ ((unused));\n"
+		"  cl_int             temp_qhist_bucket __attribute__ ((unused));\n"
 		"  char              *addr         __attribute__ ((unused));\n");
 
 	/*
@@ -2864,6 +3312,12 @@ gpupreagg_codegen_projection(GpuPreAggInfo *gpa_info,
 
 		/*
 		 * Construct KVAR_%u
+		 *
+		 * NOTE: grouping keys and arguments of the aggregate functions
+		 * often share sub-expressions, like date_trunc() on a timestamp
+		 * column. They are computed once in a nested block, because the
+		 * CSE_%u variables of the partial aggregate functions below are
+		 * declared in the function level.
 		 */
 		var_label_saved = context->var_label;
 		context->var_label = "OVAR";
@@ -2871,6 +3325,16 @@ gpupreagg_codegen_projection(GpuPreAggInfo *gpa_info,
 		{
 			TargetEntry *tle = lfirst(lc);
 
+			k = tle->resno - FirstLowInvalidHeapAttributeNumber;
+			if (bms_is_member(k, varattnos) && varremaps[tle->resno - 1] == 0)
+				cse_exprs = lappend(cse_exprs, tle->expr);
+		}
+		appendStringInfo(&body, "  {\n%s",
+						 pgstrom_codegen_cse_begin(cse_exprs, context));
+		foreach (lc, tlist_dev)
+		{
+			TargetEntry *tle = lfirst(lc);
+
 			k = tle->resno - FirstLowInvalidHeapAttributeNumber;
 			if (bms_is_member(k, varattnos) && varremaps[tle->resno - 1] == 0)
 			{
@@ -2888,6 +3352,10 @@ gpupreagg_codegen_projection(GpuPreAggInfo *gpa_info,
 					pgstrom_codegen_expression((Node *)tle->expr, context));
 			}
 		}
+		appendStringInfoString(&body, "  }\n");
+		pgstrom_codegen_cse_end(context);
+		list_free(cse_exprs);
+		cse_exprs = NIL;
 		context->var_label = var_label_saved;
 		heap_close(outer_baserel, NoLock);
 	}
@@ -2904,6 +3372,21 @@ gpupreagg_codegen_projection(GpuPreAggInfo *gpa_info,
 	kparam_0->constisnull = false;
 	gpagg_atts = (cl_char *)VARDATA(vl_datum);
 
+	/*
+	 * arguments of partial aggregate functions often have identical
+	 * expression, like psum(X) and psum_x2(X) for stddev(X).
+	 */
+	foreach (lc, tlist_gpa)
+	{
+		TargetEntry *tle = lfirst(lc);
+
+		if (varremaps[tle->resno - 1] == 0 && IsA(tle->expr, FuncExpr))
+			cse_exprs = list_concat(cse_exprs,
+									list_copy(((FuncExpr *) tle->expr)->args));
+	}
+	appendStringInfoString(&body, pgstrom_codegen_cse_begin(cse_exprs,
+															context));
+
 	foreach (lc, tlist_gpa)
 	{
 		TargetEntry *tle = lfirst(lc);
@@ -2961,7 +3444,9 @@ gpupreagg_codegen_projection(GpuPreAggInfo *gpa_info,
 												   func, context);
 			else if (strcmp(func_name, "pmax") == 0 ||
 					 strcmp(func_name, "pmin") == 0 ||
-					 strcmp(func_name, "psum") == 0)
+					 strcmp(func_name, "psum") == 0 ||
+					 strcmp(func_name, "pand") == 0 ||
+					 strcmp(func_name, "por") == 0)
 				gpupreagg_codegen_projection_misc(&body, tle->resno,
 												  func, func_name, context);
 			else if (strcmp(func_name, "psum_x2") == 0)
@@ -2974,6 +3459,14 @@ gpupreagg_codegen_projection(GpuPreAggInfo *gpa_info,
 					 strcmp(func_name, "pcov_xy") == 0)
 				gpupreagg_codegen_projection_corr(&body, tle->resno,
 												  func, func_name, context);
+			else if (strcmp(func_name, "phll") == 0)
+				gpupreagg_codegen_projection_phll(&body, tle->resno,
+												  func, &hll_last_clause,
+												  context);
+			else if (strcmp(func_name, "pqhist") == 0)
+				gpupreagg_codegen_projection_pqhist(&body, tle->resno,
+													func, &qhist_last_clause,
+													context);
 			else
 				elog(ERROR, "Bug? unexpected partial aggregate function: %s",
 					 func_name);
@@ -2982,6 +3475,7 @@ gpupreagg_codegen_projection(GpuPreAggInfo *gpa_info,
 			elog(ERROR, "bug? unexpected node in tlist_gpa: %s",
 				 nodeToString(tle->expr));
 	}
+	pgstrom_codegen_cse_end(context);
 	appendStringInfoString(&body, "}\n");
 
 	pgstrom_codegen_param_declarations(&decl, context);
@@ -3093,103 +3587,448 @@ indexvar_fixup_by_tlist(Node *node, List *tlist_dev)
 }
 
 /*
- * pgstrom_try_insert_gpupreagg
+ * gpupreagg_hashagg_column
  *
- * Entrypoint of the gpupreagg. It checks whether the supplied Aggregate node
- * is consists of all supported expressions.
+ * It determines how a column of the partial results shall be combined by
+ * the host side hash aggregation. Every target-entry of GpuPreAgg is either
+ * a grouping key, a constant NULL, or a partial aggregate function; the
+ * latter ones are combined according to its kind, and the others are used
+ * as hash keys. It returns false if host cannot handle the column.
  */
-void
-pgstrom_try_insert_gpupreagg(PlannedStmt *pstmt, Agg *agg)
+static bool
+gpupreagg_hashagg_column(TargetEntry *tle, Oid namespace_oid,
+						 cl_char *p_kind, Oid *p_func_oid, Oid *p_eq_opr)
 {
-	CustomScan	   *cscan;
-	GpuPreAggInfo	gpa_info;
-	Sort		   *sort_node;
-	Plan		   *outer_node;
-	Index			outer_scanrelid = 0;
-	List		   *tlist_gpa = NIL;
-	List		   *agg_quals = NIL;
-	List		   *agg_tlist = NIL;
-	AttrNumber	   *attr_maps = NULL;
-	Bitmapset	   *attr_refs = NULL;
-	List		   *outer_tlist = NIL;
-	List		   *outer_quals = NIL;
-	List		   *tlist_dev = NIL;
-	double			outer_nitems;
-	Size			varlena_unitsz;
-	cl_int			safety_limit;
-	cl_int			key_dist_salt;
-	double			num_groups;
-	cl_int			num_chunks;
-	ListCell	   *lc;
-	int				i;
-	AggStrategy		new_agg_strategy;
-	AggClauseCosts	agg_clause_costs;
-	Plan			newcost_agg;
-	Plan			newcost_sort;
-	Plan			newcost_gpreagg;
-	int				extra_flags;
-	codegen_context context;
-
-	/* nothing to do, if feature is turned off */
-	if (!pgstrom_enabled || !enable_gpupreagg)
-		return;
-
-	/* Try to construct target-list of both Agg and GpuPreAgg node.
-	 * If unavailable to construct, it indicates this aggregation
-	 * does not support partial aggregation.
-	 */
-	if (!gpupreagg_rewrite_expr(agg,
-								&agg_tlist,
-								&agg_quals,
-								&tlist_gpa,
-								&attr_maps,
-								&attr_refs,
-								&extra_flags,
-								&varlena_unitsz,
-								&safety_limit))
-		return;
-	/* main portion is always needed! */
-	extra_flags |= DEVKERNEL_NEEDS_DYNPARA | DEVKERNEL_NEEDS_GPUPREAGG;
-
-	/*
-	 * cost estimation of aggregate clauses
-	 */
-	memset(&agg_clause_costs, 0, sizeof(AggClauseCosts));
-	count_agg_clauses(NULL, (Node *) agg_tlist, &agg_clause_costs);
-	count_agg_clauses(NULL, (Node *) agg_quals, &agg_clause_costs);
-
-	/* be compiler quiet */
-	memset(&newcost_agg,     0, sizeof(Plan));
-	memset(&newcost_sort,    0, sizeof(Plan));
-	memset(&newcost_gpreagg, 0, sizeof(Plan));
+	Oid				type_oid = exprType((Node *) tle->expr);
+	const char	   *func_name = NULL;
+	TypeCacheEntry *tcache;
+
+	*p_func_oid = InvalidOid;
+	*p_eq_opr = InvalidOid;
+	if (IsA(tle->expr, FuncExpr) &&
+		get_func_namespace(((FuncExpr *) tle->expr)->funcid) == namespace_oid)
+		func_name = get_func_name(((FuncExpr *) tle->expr)->funcid);
+
+	if (func_name && (strcmp(func_name, "pmin") == 0 ||
+					  strcmp(func_name, "pmax") == 0))
+	{
+		tcache = lookup_type_cache(type_oid, TYPECACHE_CMP_PROC);
+		if (!OidIsValid(tcache->cmp_proc))
+			return false;
+		*p_kind = (strcmp(func_name, "pmin") == 0
+				   ? FB_HASHAGG_MIN
+				   : FB_HASHAGG_MAX);
+		*p_func_oid = tcache->cmp_proc;
+	}
+	else if (func_name && (strcmp(func_name, "pand") == 0 ||
+						   strcmp(func_name, "por") == 0))
+	{
+		bool	is_and = (strcmp(func_name, "pand") == 0);
+		Oid		oprid;
 
-	if (agg->aggstrategy != AGG_SORTED)
+		if (type_oid == BOOLOID)
+			*p_func_oid = (is_and ? F_BOOLAND_STATEFUNC : F_BOOLOR_STATEFUNC);
+		else
+		{
+			oprid = OpernameGetOprid(list_make1(makeString(is_and ? "&" : "|")),
+									 type_oid, type_oid);
+			if (!OidIsValid(oprid))
+				return false;
+			*p_func_oid = get_opcode(oprid);
+		}
+		*p_kind = FB_HASHAGG_ADD;
+	}
+	else if (func_name && strcmp(func_name, "phll") == 0)
 	{
-		/*
-		 * If this aggregate strategy is either plain or hash, we don't
-		 * need to pay attention something complicated.
-		 * Just inject GpuPreAgg under the Agg node, because Agg does not
-		 * expect order of input stream.
-		 */
-		sort_node = NULL;
-		outer_node = outerPlan(agg);
-		new_agg_strategy = agg->aggstrategy;
+		*p_kind = FB_HASHAGG_HLL;
 	}
-	else if (IsA(outerPlan(agg), Sort))
+	else if (func_name && strcmp(func_name, "pqhist") == 0)
 	{
 		/*
-		 * If this aggregation expects the input stream is already sorted
-		 * and Sort node is connected below, it makes sense to reduce
-		 * number of rows to be processed by Sort, not only Agg.
-		 * So, we try to inject GpuPreAgg prior to the Sort node.
+		 * The packed 32bit counters may overflow once partial results of
+		 * multiple chunks are combined by the host, so we leave them to
+		 * the upper Agg node that accumulates the counters by int8.
 		 */
-		sort_node = (Sort *)outerPlan(agg);
-		outer_node = outerPlan(sort_node);
-		new_agg_strategy = agg->aggstrategy;
+		return false;
 	}
-	else
+	else if (func_name && (strcmp(func_name, "nrows") == 0 ||
+						   strcmp(func_name, "psum") == 0 ||
+						   strcmp(func_name, "psum_x2") == 0 ||
+						   strncmp(func_name, "pcov_", 5) == 0))
 	{
-		Size	hashentrysize;
+		Oid		add_oprid = OpernameGetOprid(list_make1(makeString("+")),
+											 type_oid, type_oid);
+		if (!OidIsValid(add_oprid))
+			return false;
+		*p_kind = FB_HASHAGG_ADD;
+		*p_func_oid = get_opcode(add_oprid);
+	}
+	else
+	{
+		RegProcedure	lhs_hash;
+		RegProcedure	rhs_hash;
+
+		tcache = lookup_type_cache(type_oid, TYPECACHE_EQ_OPR);
+		if (!OidIsValid(tcache->eq_opr) ||
+			!get_op_hash_functions(tcache->eq_opr, &lhs_hash, &rhs_hash))
+			return false;
+		*p_kind = FB_HASHAGG_KEY;
+		*p_eq_opr = tcache->eq_opr;
+	}
+	return true;
+}
+
+/*
+ * gpupreagg_final_expr_mutator
+ *
+ * It replaces Aggref nodes of the upper Agg by an equivalent expression
+ * that computes the final result from a partial result row per group;
+ * that is finalfn(transfn(initcond, partial values...)). Aggregates with
+ * internal or polymorphic transition type, or extra final arguments, are
+ * not supported, because their support functions assume the aggregate
+ * context.
+ */
+static Node *
+gpupreagg_final_expr_mutator(Node *node, bool *p_supported)
+{
+	if (!node)
+		return NULL;
+	if (IsA(node, Aggref))
+	{
+		Aggref		   *aggref = (Aggref *) node;
+		HeapTuple		tuple;
+		Form_pg_aggregate aggform;
+		Oid				transfn_oid;
+		Oid				finalfn_oid;
+		Oid				transtype;
+		Datum			textInitVal;
+		bool			initValIsNull;
+		Const		   *init_const;
+		List		   *args = NIL;
+		Expr		   *state;
+		ListCell	   *lc;
+
+		if (aggref->aggorder != NIL || aggref->aggdistinct != NIL ||
+			aggref->aggfilter != NULL || aggref->aggvariadic ||
+			aggref->aggkind != AGGKIND_NORMAL || aggref->agglevelsup > 0)
+		{
+			*p_supported = false;
+			return node;
+		}
+		foreach (lc, aggref->args)
+			args = lappend(args, ((TargetEntry *) lfirst(lc))->expr);
+
+		tuple = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(aggref->aggfnoid));
+		if (!HeapTupleIsValid(tuple))
+			elog(ERROR, "cache lookup failed for aggregate %u",
+				 aggref->aggfnoid);
+		aggform = (Form_pg_aggregate) GETSTRUCT(tuple);
+		transfn_oid = aggform->aggtransfn;
+		finalfn_oid = aggform->aggfinalfn;
+		transtype = aggform->aggtranstype;
+		textInitVal = SysCacheGetAttr(AGGFNOID, tuple,
+									  Anum_pg_aggregate_agginitval,
+									  &initValIsNull);
+		if (transtype == INTERNALOID ||
+			IsPolymorphicType(transtype) ||
+			aggform->aggfinalextra)
+		{
+			ReleaseSysCache(tuple);
+			*p_supported = false;
+			return node;
+		}
+
+		if (initValIsNull)
+			init_const = makeNullConst(transtype, -1, InvalidOid);
+		else
+		{
+			Oid		typinput;
+			Oid		typioparam;
+			int16	typlen;
+			bool	typbyval;
+			char   *initval = TextDatumGetCString(textInitVal);
+
+			getTypeInputInfo(transtype, &typinput, &typioparam);
+			get_typlenbyval(transtype, &typlen, &typbyval);
+			init_const = makeConst(transtype, -1, InvalidOid,
+								   typlen,
+								   OidInputFunctionCall(typinput,
+														initval,
+														typioparam, -1),
+								   false,
+								   typbyval);
+		}
+		ReleaseSysCache(tuple);
+
+		if (func_strict(transfn_oid) && initValIsNull)
+		{
+			/*
+			 * The first non-null input becomes the transition state,
+			 * like max(), min() or sum().
+			 */
+			if (list_length(args) != 1 ||
+				exprType(linitial(args)) != transtype)
+			{
+				*p_supported = false;
+				return node;
+			}
+			state = linitial(args);
+		}
+		else
+		{
+			state = (Expr *) makeFuncExpr(transfn_oid,
+										  transtype,
+										  lcons(init_const, args),
+										  InvalidOid,
+										  aggref->inputcollid,
+										  COERCE_EXPLICIT_CALL);
+			/* strict transfn keeps the initial state on NULL inputs */
+			if (func_strict(transfn_oid))
+			{
+				CoalesceExpr   *coalesce = makeNode(CoalesceExpr);
+
+				coalesce->coalescetype = transtype;
+				coalesce->coalescecollid = InvalidOid;
+				coalesce->args = list_make2(state, copyObject(init_const));
+				coalesce->location = -1;
+				state = (Expr *) coalesce;
+			}
+		}
+
+		if (OidIsValid(finalfn_oid))
+			return (Node *) makeFuncExpr(finalfn_oid,
+										 aggref->aggtype,
+										 list_make1(state),
+										 aggref->aggcollid,
+										 aggref->inputcollid,
+										 COERCE_EXPLICIT_CALL);
+		if (exprType((Node *) state) != aggref->aggtype)
+			*p_supported = false;
+		return (Node *) state;
+	}
+	else if (IsA(node, GroupingFunc))
+	{
+		*p_supported = false;
+		return node;
+	}
+	return expression_tree_mutator(node, gpupreagg_final_expr_mutator,
+								   (void *) p_supported);
+}
+
+/*
+ * gpupreagg_hashagg_entry_size
+ *
+ * Estimated size of a group entry of the host side hash aggregation; the
+ * hash element, the first tuple, and the values/isnull arrays with copies
+ * of by-reference datum.
+ */
+static Size
+gpupreagg_hashagg_entry_size(int nattrs, int width)
+{
+	return (MAXALIGN(sizeof(HASHELEMENT)) +
+			MAXALIGN(sizeof(gpupreagg_hashagg_entry)) +
+			MAXALIGN(SizeofMinimalTupleHeader) +
+			MAXALIGN(sizeof(Datum) * nattrs) +
+			MAXALIGN(sizeof(bool) * nattrs) +
+			2 * MAXALIGN(width));
+}
+
+/*
+ * gpupreagg_make_final_plan
+ *
+ * It tries to construct a Result node that replaces the upper Agg node,
+ * if GpuPreAgg can produce exactly one partial result row per group.
+ * The Result node computes the final values of the aggregate functions
+ * from the row, so the host does not need to run another aggregation.
+ * It is available only if Agg has grouping keys (empty input has to
+ * produce a row without them), no HAVING clause (Result does not
+ * evaluate per-row quals) and no grouping sets, and the partial results
+ * can be merged by the host when multiple segments are required.
+ * The host hash table to merge the segments has to fit in work_mem
+ * according to the estimated number of groups, because there is no
+ * upper Agg node to emit the groups to, once the table gets full.
+ * The Result node takes over the init-plans, the parameter sets and the
+ * plan node id of the Agg node, because it takes the place of the Agg
+ * in the plan tree already finalized.
+ */
+static Result *
+gpupreagg_make_final_plan(Agg *agg, List *agg_tlist, List *agg_quals,
+						  List *tlist_gpa, int width_gpa)
+{
+	Oid			namespace_oid = get_namespace_oid("pgstrom", false);
+	Result	   *result;
+	List	   *final_tlist;
+	Size		entry_size;
+	bool		supported = true;
+	ListCell   *lc;
+
+	if (!enable_gpupreagg_final ||
+		agg->numCols == 0 ||
+		agg_quals != NIL ||
+		agg->groupingSets != NIL ||
+		agg->chain != NIL)
+		return NULL;
+
+	entry_size = gpupreagg_hashagg_entry_size(list_length(tlist_gpa),
+											  width_gpa);
+	if ((double) entry_size * agg->plan.plan_rows > (double) work_mem * 1024.0)
+		return NULL;
+
+	foreach (lc, tlist_gpa)
+	{
+		cl_char		kind;
+		Oid			func_oid;
+		Oid			eq_opr;
+
+		if (!gpupreagg_hashagg_column(lfirst(lc), namespace_oid,
+									  &kind, &func_oid, &eq_opr))
+			return NULL;
+	}
+
+	final_tlist = (List *)
+		gpupreagg_final_expr_mutator((Node *) agg_tlist, &supported);
+	if (!supported)
+		return NULL;
+
+	result = makeNode(Result);
+	result->plan.startup_cost = agg->plan.startup_cost;
+	result->plan.total_cost   = agg->plan.total_cost;
+	result->plan.plan_rows    = agg->plan.plan_rows;
+	result->plan.plan_width   = agg->plan.plan_width;
+	result->plan.targetlist   = final_tlist;
+	result->plan.qual         = NIL;
+	result->plan.lefttree     = NULL;	/* set by the caller */
+	result->plan.righttree    = NULL;
+	/* Result takes over the sub-plans and parameters of the Agg */
+	result->plan.initPlan     = agg->plan.initPlan;
+	result->plan.extParam     = bms_copy(agg->plan.extParam);
+	result->plan.allParam     = bms_copy(agg->plan.allParam);
+#if PG_VERSION_NUM >= 90600
+	result->plan.plan_node_id = agg->plan.plan_node_id;
+#endif
+	result->resconstantqual   = NULL;
+
+	return result;
+}
+
+/*
+ * gpupreagg_add_grouping_key - adds a grouping key of GpuPreAggInfo,
+ * unless it is already added by other phase of grouping sets.
+ */
+static void
+gpupreagg_add_grouping_key(GpuPreAggInfo *gpa_info, AttrNumber resno)
+{
+	int		i;
+
+	for (i=0; i < gpa_info->numCols; i++)
+	{
+		if (gpa_info->grpColIdx[i] == resno)
+			return;
+	}
+	gpa_info->grpColIdx[gpa_info->numCols++] = resno;
+}
+
+/*
+ * pgstrom_try_insert_gpupreagg
+ *
+ * Entrypoint of the gpupreagg. It checks whether the supplied Aggregate node
+ * is consists of all supported expressions. It returns the plan node to be
+ * placed instead of the supplied Agg; usually Agg itself, but a Result node
+ * if GpuPreAgg runs final aggregation.
+ */
+Plan *
+pgstrom_try_insert_gpupreagg(PlannedStmt *pstmt, Agg *agg)
+{
+	CustomScan	   *cscan;
+	Result		   *result;
+	GpuPreAggInfo	gpa_info;
+	Sort		   *sort_node;
+	Plan		   *outer_node;
+	Index			outer_scanrelid = 0;
+	List		   *tlist_gpa = NIL;
+	List		   *agg_quals = NIL;
+	List		   *agg_tlist = NIL;
+	AttrNumber	   *attr_maps = NULL;
+	Bitmapset	   *attr_refs = NULL;
+	List		   *outer_tlist = NIL;
+	List		   *outer_quals = NIL;
+	List		   *tlist_dev = NIL;
+	double			outer_nitems;
+	Size			varlena_unitsz;
+	cl_int			safety_limit;
+	cl_int			key_dist_salt;
+	double			num_groups;
+	cl_int			num_chunks;
+	ListCell	   *lc;
+	int				i;
+	AggStrategy		new_agg_strategy;
+	AggClauseCosts	agg_clause_costs;
+	Plan			newcost_agg;
+	Plan			newcost_sort;
+	Plan			newcost_gpreagg;
+	int				extra_flags;
+	codegen_context context;
+
+	/* nothing to do, if feature is turned off */
+	if (!pgstrom_enabled || !enable_gpupreagg)
+		return &agg->plan;
+
+	/* Try to construct target-list of both Agg and GpuPreAgg node.
+	 * If unavailable to construct, it indicates this aggregation
+	 * does not support partial aggregation.
+	 */
+	if (!gpupreagg_rewrite_expr(agg,
+								&agg_tlist,
+								&agg_quals,
+								&tlist_gpa,
+								&attr_maps,
+								&attr_refs,
+								&extra_flags,
+								&varlena_unitsz,
+								&safety_limit))
+		return &agg->plan;
+	/* main portion is always needed! */
+	extra_flags |= DEVKERNEL_NEEDS_DYNPARA | DEVKERNEL_NEEDS_GPUPREAGG;
+
+	/*
+	 * cost estimation of aggregate clauses
+	 */
+	memset(&agg_clause_costs, 0, sizeof(AggClauseCosts));
+	count_agg_clauses(NULL, (Node *) agg_tlist, &agg_clause_costs);
+	count_agg_clauses(NULL, (Node *) agg_quals, &agg_clause_costs);
+
+	/* be compiler quiet */
+	memset(&newcost_agg,     0, sizeof(Plan));
+	memset(&newcost_sort,    0, sizeof(Plan));
+	memset(&newcost_gpreagg, 0, sizeof(Plan));
+
+	if (agg->aggstrategy != AGG_SORTED)
+	{
+		/*
+		 * If this aggregate strategy is either plain or hash, we don't
+		 * need to pay attention something complicated.
+		 * Just inject GpuPreAgg under the Agg node, because Agg does not
+		 * expect order of input stream.
+		 */
+		sort_node = NULL;
+		outer_node = outerPlan(agg);
+		new_agg_strategy = agg->aggstrategy;
+	}
+	else if (IsA(outerPlan(agg), Sort))
+	{
+		/*
+		 * If this aggregation expects the input stream is already sorted
+		 * and Sort node is connected below, it makes sense to reduce
+		 * number of rows to be processed by Sort, not only Agg.
+		 * So, we try to inject GpuPreAgg prior to the Sort node.
+		 */
+		sort_node = (Sort *)outerPlan(agg);
+		outer_node = outerPlan(sort_node);
+		new_agg_strategy = agg->aggstrategy;
+	}
+	else
+	{
+		Size	hashentrysize;
 
 		/*
 		 * Elsewhere, outer-plan of Agg is not Sort even though its strategy
@@ -3202,6 +4041,14 @@ pgstrom_try_insert_gpupreagg(PlannedStmt *pstmt, Agg *agg)
 		outer_node = outerPlan(agg);
 		new_agg_strategy = AGG_HASHED;
 
+		/*
+		 * Agg node with GROUPING SETS / ROLLUP / CUBE has to work on
+		 * the sorted basis, because the executor walks on the chain of
+		 * sort-and-aggregate phases.
+		 */
+		if (agg->groupingSets != NIL)
+			return &agg->plan;
+
 		/*
 		 * NOTE: all the supported aggregate functions are available to
 		 * aggregate values with both of hashed and sorted basis.
@@ -3217,7 +4064,7 @@ pgstrom_try_insert_gpupreagg(PlannedStmt *pstmt, Agg *agg)
 						 agg_clause_costs.transitionSpace +
 						 hash_agg_entry_size(agg_clause_costs.numAggs));
 		if (hashentrysize * agg->plan.plan_rows > work_mem * 1024L)
-			return;
+			return &agg->plan;
 	}
 
 	/*
@@ -3262,7 +4109,7 @@ pgstrom_try_insert_gpupreagg(PlannedStmt *pstmt, Agg *agg)
 
 	if (!debug_force_gpupreagg &&
 		agg->plan.total_cost <= newcost_agg.total_cost)
-		return;
+		return &agg->plan;
 
 	/* OK, let's construct GpuPreAgg node here */
 
@@ -3278,6 +4125,8 @@ pgstrom_try_insert_gpupreagg(PlannedStmt *pstmt, Agg *agg)
 		outer_tlist		= outer_node->targetlist;
 		outer_nitems	= outer_node->plan_rows;
 		outer_node		= NULL;
+		/* no PlannerInfo here, so cheap qualifiers shall be first */
+		outer_quals = pgstrom_reorder_device_quals(NULL, outer_quals);
 	}
 
 	/*
@@ -3333,15 +4182,31 @@ pgstrom_try_insert_gpupreagg(PlannedStmt *pstmt, Agg *agg)
 	/* also set up private information */
 	memset(&gpa_info, 0, sizeof(GpuPreAggInfo));
 	gpa_info.tlist_dev      = tlist_dev;
-	gpa_info.numCols        = agg->numCols;
-	gpa_info.grpColIdx      = palloc0(sizeof(AttrNumber) * agg->numCols);
+	/*
+	 * Device code groups the rows by the union of the grouping keys of
+	 * all the phases, not only the keys of the top Agg; each grouping set
+	 * is rolled up by the upper Agg from this finer combination.
+	 */
+	gpa_info.numCols        = 0;
+	gpa_info.grpColIdx      = palloc0(sizeof(AttrNumber) *
+									  list_length(tlist_gpa));
 	for (i=0; i < agg->numCols; i++)
-		gpa_info.grpColIdx[i] = attr_maps[agg->grpColIdx[i] - 1];
+		gpupreagg_add_grouping_key(&gpa_info,
+								   attr_maps[agg->grpColIdx[i] - 1]);
+	foreach (lc, agg->chain)
+	{
+		Agg	   *subagg = (Agg *) lfirst(lc);
+
+		for (i=0; i < subagg->numCols; i++)
+			gpupreagg_add_grouping_key(&gpa_info,
+									   attr_maps[subagg->grpColIdx[i] - 1]);
+	}
 	gpa_info.num_groups     = num_groups;
 	gpa_info.num_chunks     = num_chunks;
 	gpa_info.varlena_unitsz = varlena_unitsz;
 	gpa_info.safety_limit   = safety_limit;
 	gpa_info.key_dist_salt  = key_dist_salt;
+	gpa_info.hash_function  = pgstrom_hash_function;
 	gpa_info.outer_quals	= outer_quals;
 	gpa_info.outer_nitems	= outer_nitems;
 
@@ -3359,6 +4224,14 @@ pgstrom_try_insert_gpupreagg(PlannedStmt *pstmt, Agg *agg)
 	gpa_info.extra_flags = extra_flags | context.extra_flags;
 	gpa_info.used_params = context.used_params;
 
+	/*
+	 * If GpuPreAgg can produce one row per group, the upper Agg node can
+	 * be replaced by a Result node that computes the final values.
+	 */
+	result = gpupreagg_make_final_plan(agg, agg_tlist, agg_quals, tlist_gpa,
+									   cscan->scan.plan.plan_width);
+	gpa_info.final_merge = (result != NULL);
+
 	/*
 	 * NOTE: In case when GpuPreAgg pull up outer base relation, CPU fallback
 	 * routine wants to execute projection from the base relation in one step.
@@ -3426,10 +4299,29 @@ pgstrom_try_insert_gpupreagg(PlannedStmt *pstmt, Agg *agg)
 	foreach (lc, agg->chain)
 	{
 		Agg	   *subagg = lfirst(lc);
+		Sort   *subsort = (Sort *) outerPlan(subagg);
 
 		for (i=0; i < subagg->numCols; i++)
 			subagg->grpColIdx[i] = attr_maps[subagg->grpColIdx[i] - 1];
+		/*
+		 * The following phases of grouping sets re-sort the tuples of
+		 * the outer node (i.e, GpuPreAgg) by the Sort node, if any.
+		 */
+		if (subsort)
+		{
+			Assert(IsA(subsort, Sort));
+			for (i=0; i < subsort->numCols; i++)
+				subsort->sortColIdx[i] =
+					attr_maps[subsort->sortColIdx[i] - 1];
+		}
+	}
+
+	if (result)
+	{
+		result->plan.lefttree = outerPlan(agg);
+		return &result->plan;
 	}
+	return &agg->plan;
 }
 
 bool
@@ -3454,6 +4346,92 @@ gpupreagg_create_scan_state(CustomScan *cscan)
 	return (Node *) gpas;
 }
 
+/*
+ * gpupreagg_setup_hashagg
+ *
+ * It prepares the host side hash aggregation on the partial results; used
+ * for CPU fallback and merge of multiple segments on the final mode.
+ */
+static void
+gpupreagg_setup_hashagg(GpuPreAggState *gpas, CustomScan *cscan)
+{
+	Oid				namespace_oid = get_namespace_oid("pgstrom", false);
+	List		   *tlist_gpa = cscan->scan.plan.targetlist;
+	int				nattrs = list_length(tlist_gpa);
+	Oid			   *eqOperators;
+	ListCell	   *lc;
+
+	gpas->fb_hashagg = false;
+	gpas->fb_numCols = 0;
+	gpas->fb_keyColIdx = palloc0(sizeof(AttrNumber) * nattrs);
+	gpas->fb_aggkind = palloc0(sizeof(cl_char) * nattrs);
+	gpas->fb_aggfuncs = palloc0(sizeof(FmgrInfo) * nattrs);
+	gpas->fb_aggcoll = palloc0(sizeof(Oid) * nattrs);
+	gpas->fb_memcxt = NULL;
+	gpas->fb_htable = NULL;
+	gpas->fb_hiter_active = false;
+	gpas->fb_input_done = false;
+	eqOperators = palloc0(sizeof(Oid) * nattrs);
+
+	foreach (lc, tlist_gpa)
+	{
+		TargetEntry	   *tle = lfirst(lc);
+		int				anum = tle->resno - 1;
+		cl_char			kind;
+		Oid				func_oid;
+		Oid				eq_opr;
+
+		if (!gpupreagg_hashagg_column(tle, namespace_oid,
+									  &kind, &func_oid, &eq_opr))
+			return;
+		gpas->fb_aggkind[anum] = kind;
+		if (kind == FB_HASHAGG_KEY)
+		{
+			gpas->fb_keyColIdx[gpas->fb_numCols] = tle->resno;
+			eqOperators[gpas->fb_numCols] = eq_opr;
+			gpas->fb_numCols++;
+		}
+		else if (kind != FB_HASHAGG_HLL)
+		{
+			fmgr_info(func_oid, &gpas->fb_aggfuncs[anum]);
+			if (kind != FB_HASHAGG_ADD)
+				gpas->fb_aggcoll[anum] = exprCollation((Node *) tle->expr);
+		}
+	}
+	execTuplesHashPrepare(gpas->fb_numCols,
+						  eqOperators,
+						  &gpas->fb_eqfuncs,
+						  &gpas->fb_hashfuncs);
+	gpas->fb_entry_size =
+		gpupreagg_hashagg_entry_size(nattrs, cscan->scan.plan.plan_width);
+	gpas->fb_memcxt = AllocSetContextCreate(CurrentMemoryContext,
+											"GpuPreAgg fallback hash table",
+											ALLOCSET_DEFAULT_MINSIZE,
+											ALLOCSET_DEFAULT_INITSIZE,
+											ALLOCSET_DEFAULT_MAXSIZE);
+	gpas->fb_hashagg = true;
+}
+
+/*
+ * gpupreagg_choose_reduction_mode
+ *
+ * It chooses the reduction policy according to the number of groups;
+ * by the planner estimation at the beginning, then by the sketch of the
+ * grouping keys prior to the first segment.
+ */
+static cl_int
+gpupreagg_choose_reduction_mode(int numCols, double num_groups,
+								double outer_nitems, double num_chunks)
+{
+	if (numCols == 0)
+		return GPUPREAGG_NOGROUP_REDUCTION;
+	if (num_groups < (gpuMaxThreadsPerBlock() / 4))
+		return GPUPREAGG_LOCAL_REDUCTION;
+	if (num_groups < (outer_nitems / Max(num_chunks, 1.0)) / 4)
+		return GPUPREAGG_GLOBAL_REDUCTION;
+	return GPUPREAGG_FINAL_REDUCTION;
+}
+
 static void
 gpupreagg_begin(CustomScanState *node, EState *estate, int eflags)
 {
@@ -3522,20 +4500,51 @@ gpupreagg_begin(CustomScanState *node, EState *estate, int eflags)
 	gpas->safety_limit = gpa_info->safety_limit;
 	gpas->key_dist_salt = gpa_info->key_dist_salt;
 
-	if (gpa_info->numCols == 0)
-		gpas->reduction_mode = GPUPREAGG_NOGROUP_REDUCTION;
-	else if (gpa_info->num_groups < (gpuMaxThreadsPerBlock() / 4))
-		gpas->reduction_mode = GPUPREAGG_LOCAL_REDUCTION;
-	else if (gpa_info->num_groups < (outer_nitems / gpa_info->num_chunks) / 4)
-		gpas->reduction_mode = GPUPREAGG_GLOBAL_REDUCTION;
-	else
-		gpas->reduction_mode = GPUPREAGG_FINAL_REDUCTION;
+	gpas->reduction_mode =
+		gpupreagg_choose_reduction_mode(gpa_info->numCols,
+										gpa_info->num_groups,
+										outer_nitems,
+										gpa_info->num_chunks);
 
 	gpas->outer_quals = (List *)
 		ExecInitExpr((Expr *) gpa_info->outer_quals, ps);
+	gpas->hostjit_quals =
+		pgstrom_hostjit_create_quals((Node *) gpa_info->outer_quals);
 	gpas->outer_overflow = NULL;
 	gpas->outer_pds = NULL;
 	gpas->curr_segment = NULL;
+	gpupreagg_setup_hashagg(gpas, cscan);
+	gpas->sketch_keys = NIL;
+	if (gpas->fb_hashagg)
+	{
+		int		i;
+
+		/* only grouping keys are evaluated to sketch number of groups */
+		for (i=0; i < gpas->fb_numCols; i++)
+		{
+			TargetEntry *tle = get_tle_by_resno(cscan->scan.plan.targetlist,
+												gpas->fb_keyColIdx[i]);
+
+			gpas->sketch_keys = lappend(gpas->sketch_keys,
+										ExecInitExpr(tle->expr, ps));
+		}
+	}
+	gpas->final_merge = gpa_info->final_merge;
+	gpas->fm_state = GPUPREAGG_FMSTATE_INIT;
+	gpas->num_segments = 0;
+	gpas->fm_memcxt = NULL;
+	gpas->fm_htable = NULL;
+	gpas->fm_hiter_active = false;
+	if (gpas->final_merge)
+	{
+		if (!gpas->fb_hashagg)
+			elog(ERROR, "Bug? GpuPreAgg final mode without host hash-agg");
+		gpas->fm_memcxt = AllocSetContextCreate(CurrentMemoryContext,
+												"GpuPreAgg final merge",
+												ALLOCSET_DEFAULT_MINSIZE,
+												ALLOCSET_DEFAULT_INITSIZE,
+												ALLOCSET_DEFAULT_MAXSIZE);
+	}
 
 	/*
 	 * init run-time statistics
@@ -3549,6 +4558,10 @@ gpupreagg_begin(CustomScanState *node, EState *estate, int eflags)
 	gpas->stat_num_chunks = gpa_info->num_chunks;
 	gpas->stat_src_nitems = outer_nitems;
 	gpas->stat_varlena_unitsz = gpa_info->varlena_unitsz;
+	gpas->stat_plan_ngroups = gpa_info->num_groups;
+	gpas->stat_sketch_ngroups = -1.0;
+	gpas->stat_total_ngroups = 0;
+	gpas->stat_num_expanded = 0;
 	/* init perfmon */
 	pgstrom_init_perfmon(&gpas->gts);
 }
@@ -3632,6 +4645,153 @@ gpupreagg_check_segment_capacity(GpuPreAggState *gpas,
 	return true;
 }
 
+/*
+ * gpupreagg_sketch_num_groups
+ *
+ * It estimates number of groups by a sketch of the grouping keys on the
+ * first chunk, then replaces the planner's estimation that is often far
+ * from the actual ngroups, prior to the creation of the first segment.
+ * Hash values of the grouping keys on the rows sampled at regular interval
+ * are counted on a small open-addressing table, then number of distinct
+ * values in the whole input is extrapolated by the Haas-Stokes estimator
+ * that is also used by ANALYZE. It can run only if host hash-agg is
+ * available, because it relies on the hash functions of the keys.
+ * Only the grouping key expressions are evaluated on the sampled rows,
+ * not the whole projection that also computes the partial aggregates.
+ * The reduction policy is chosen again according to the sketch.
+ */
+static void
+gpupreagg_sketch_num_groups(GpuPreAggState *gpas,
+							pgstrom_data_store *pds,
+							bool is_last_chunk)
+{
+	TupleTableSlot *scan_slot = gpas->gts.css.ss.ss_ScanTupleSlot;
+	ExprContext	   *econtext = gpas->gts.css.ss.ps.ps_ExprContext;
+	cl_uint			nitems = pds->kds->nitems;
+	cl_uint			nsamples;
+	cl_uint			nslots;
+	cl_uint		   *hash_keys;
+	cl_uint		   *hash_counts;
+	double			row_step;
+	double			total_nrows;
+	double			ndistinct;
+	cl_uint			nvisited = 0;
+	cl_uint			nrows = 0;
+	cl_uint			d = 0;
+	cl_uint			f1 = 0;
+	cl_uint			i, j;
+	int				k;
+	HeapTupleData	tuple;
+
+	if (!gpas->fb_hashagg ||
+		gpas->reduction_mode == GPUPREAGG_NOGROUP_REDUCTION ||
+		gpupreagg_sketch_nrows <= 0 || nitems == 0)
+		return;
+
+	nsamples = Min(nitems, (cl_uint) gpupreagg_sketch_nrows);
+	row_step = (double) nitems / (double) nsamples;
+	for (nslots = 1024; nslots < 2 * nsamples; nslots <<= 1);
+	hash_keys = palloc0(sizeof(cl_uint) * nslots);
+	hash_counts = palloc0(sizeof(cl_uint) * nslots);
+
+	for (i=0; i < nsamples; i++)
+	{
+		ListCell   *lc;
+		cl_uint		hashkey = 0;
+
+		ResetExprContext(econtext);
+		ExecClearTuple(scan_slot);
+		if (!pgstrom_fetch_data_store(scan_slot, pds,
+									  (size_t)(row_step * (double) i),
+									  &tuple))
+			break;
+		nvisited++;
+		econtext->ecxt_scantuple = scan_slot;
+
+		if (gpas->outer_quals != NULL &&
+			!pgstrom_hostjit_exec_quals(gpas->hostjit_quals,
+										gpas->outer_quals, econtext))
+			continue;
+
+		/* same manner as TupleHashTableHash() */
+		k = 0;
+		foreach (lc, gpas->sketch_keys)
+		{
+			ExprState  *keystate = lfirst(lc);
+			FmgrInfo   *hashfunc = &gpas->fb_hashfuncs[k++];
+			Datum		datum;
+			bool		isnull;
+
+			hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+			datum = ExecEvalExpr(keystate, econtext, &isnull, NULL);
+			if (!isnull)
+				hashkey ^= DatumGetUInt32(FunctionCall1(hashfunc, datum));
+		}
+		nrows++;
+
+		/* zero is reserved for empty slot */
+		if (hashkey == 0)
+			hashkey = 1;
+		for (j = hashkey & (nslots - 1);
+			 hash_keys[j] != 0 && hash_keys[j] != hashkey;
+			 j = (j + 1) & (nslots - 1));
+		if (hash_keys[j] == 0)
+		{
+			hash_keys[j] = hashkey;
+			d++;
+		}
+		hash_counts[j]++;
+	}
+	ResetExprContext(econtext);
+	ExecClearTuple(scan_slot);
+
+	for (j=0; j < nslots; j++)
+	{
+		if (hash_counts[j] == 1)
+			f1++;
+	}
+	pfree(hash_keys);
+	pfree(hash_counts);
+
+	if (nrows == 0)
+		return;
+
+	/*
+	 * Number of rows in the whole input that passes outer_quals. If the
+	 * first chunk is also the last one, it is exactly the population.
+	 */
+	total_nrows = (double) nitems;
+	if (!is_last_chunk)
+		total_nrows = Max(total_nrows, gpas->stat_src_nitems);
+	total_nrows *= (double) nrows / (double) nvisited;
+
+	if (nvisited == nitems || nrows >= total_nrows)
+		ndistinct = (double) d;			/* all the rows were sampled */
+	else if (f1 == nrows)
+		ndistinct = total_nrows;		/* likely unique key */
+	else
+	{
+		/* Duj1 estimator; see compute_distinct_stats() also */
+		ndistinct = ((double) nrows * (double) d) /
+			(((double) nrows - (double) f1) +
+			 (double) f1 * (double) nrows / total_nrows);
+		ndistinct = Max(ndistinct, (double) d);
+		ndistinct = Min(ndistinct, total_nrows);
+	}
+	ndistinct = Max(floor(ndistinct + 0.5), 1.0);
+
+	elog(DEBUG1, "GpuPreAgg sketch: %u of %u rows, d=%u, f1=%u, "
+		 "ngroups=%.0f (plan: %.0f)",
+		 nrows, nitems, d, f1, ndistinct, gpas->stat_plan_ngroups);
+	gpas->stat_num_groups = ndistinct;
+	gpas->stat_sketch_ngroups = ndistinct;
+	gpas->reduction_mode =
+		gpupreagg_choose_reduction_mode(gpas->fb_numCols,
+										ndistinct,
+										gpas->stat_src_nitems,
+										gpas->stat_num_chunks);
+}
+
 /*
  * gpupreagg_create_segment
  *
@@ -3656,7 +4816,8 @@ gpupreagg_create_segment(GpuPreAggState *gpas)
 
 	/*
 	 * (50% + plan/exec avg) x configured margin is scale of the final
-	 * reduction buffer.
+	 * reduction buffer. If the sketch was available, the plan
+	 * estimation is already replaced by the sketch of the first chunk.
 	 *
 	 * NOTE: We ensure the final buffer has at least 2039 rooms to store
 	 * the reduction results, because planner often estimate Ngroups
@@ -3722,13 +4883,15 @@ gpupreagg_create_segment(GpuPreAggState *gpas)
 		STROMALIGN(sizeof(CUevent) * num_chunks);
 	segment = MemoryContextAllocZero(gcontext->memcxt, required);
 	segment->gpas = gpas;
+	gpas->num_segments++;
 	segment->pds_final = pds_final;		/* refcnt==1 */
 	segment->m_kds_final = 0UL;
 	segment->m_hashslot_final = 0UL;
 
 	/*
-	 * FIXME: f_hashsize is nroom of the pds_final. It is not a reasonable
-	 * estimation, thus needs to be revised.
+	 * NOTE: f_hashsize is nroom of the pds_final; it has 50% + margin of
+	 * the estimated ngroups, so hash-slots are not too crowded as long as
+	 * the sketch is not far from the actual ngroups.
 	 */
 	segment->f_hashsize = f_nrooms;
 	segment->num_chunks = num_chunks;
@@ -3736,7 +4899,12 @@ gpupreagg_create_segment(GpuPreAggState *gpas)
 	segment->refcnt = 1;
 	segment->cuda_index = cuda_index;
 	segment->has_terminator = false;
+	segment->has_last_chunk = false;
 	segment->needs_fallback = false;
+	segment->needs_expand = false;
+	segment->num_expanded = 0;
+	segment->num_retired = 0;
+	segment->m_hashslot_expand = 0UL;
 	segment->pds_src = (pgstrom_data_store **)((char *)segment + offset);
 	offset += STROMALIGN(sizeof(pgstrom_data_store *) * num_chunks);
 	segment->ev_kern_main = (CUevent *)((char *)segment + offset);
@@ -3752,6 +4920,68 @@ gpupreagg_create_segment(GpuPreAggState *gpas)
 	return segment;
 }
 
+/*
+ * gpupreagg_expand_segment
+ *
+ * It enlarges the final result buffer of the segment, instead of urgent
+ * termination, when gpupreagg_check_segment_capacity() expects it shall
+ * be filled up soon. Host side buffer is replaced immediately, then the
+ * next task of this segment moves the groups on the device buffer into
+ * the new one prior to its own reduction. So, a segment can keep to
+ * absorb the following chunks, and the upper Agg node receives less
+ * duplicated partial results.
+ */
+static bool
+gpupreagg_expand_segment(GpuPreAggState *gpas, gpupreagg_segment *segment)
+{
+	GpuContext	   *gcontext = gpas->gts.gcontext;
+	TupleDesc		tupdesc
+		= gpas->gts.css.ss.ps.ps_ResultTupleSlot->tts_tupleDescriptor;
+	Size			orig_nrooms = segment->allocated_nrooms;
+	Size			orig_varlena = segment->allocated_varlena;
+	cl_int			orig_expanded = segment->num_expanded;
+	pgstrom_data_store *pds_final;
+
+	if (!enable_gpupreagg_final_expand ||
+		segment->has_terminator ||
+		segment->needs_fallback)
+		return false;
+	/* expansion is already planned, but not moved on the device yet */
+	if (segment->needs_expand)
+		return true;
+
+	do {
+		if (segment->num_expanded >= GPUPREAGG_MAX_FINAL_EXPAND ||
+			2 * segment->allocated_nrooms > UINT_MAX)
+		{
+			segment->allocated_nrooms = orig_nrooms;
+			segment->allocated_varlena = orig_varlena;
+			segment->num_expanded = orig_expanded;
+			return false;
+		}
+		segment->allocated_nrooms *= 2;
+		segment->allocated_varlena *= 2;
+		segment->num_expanded++;
+	} while (!gpupreagg_check_segment_capacity(gpas, segment));
+
+	pds_final = PDS_create_slot(gcontext,
+								tupdesc,
+								segment->allocated_nrooms,
+								segment->allocated_varlena,
+								true);
+	PDS_release(segment->pds_final);
+	segment->pds_final = pds_final;
+	segment->needs_expand = true;
+
+	elog(DEBUG1, "GpuPreAgg expand segment %p: nrooms %zu => %zu, "
+		 "varlena %s => %s",
+		 segment,
+		 orig_nrooms, segment->allocated_nrooms,
+		 format_bytesz(orig_varlena),
+		 format_bytesz(segment->allocated_varlena));
+	return true;
+}
+
 /*
  * gpupreagg_cleanup_segment - release relevant CUDA resources
  */
@@ -3770,6 +5000,21 @@ gpupreagg_cleanup_segment(gpupreagg_segment *segment)
 		segment->m_kds_final = 0UL;
 	}
 
+	if (segment->m_hashslot_expand != 0UL)
+	{
+		__gpuMemFree(gcontext, segment->cuda_index,
+					 segment->m_hashslot_expand);
+		segment->m_hashslot_expand = 0UL;
+	}
+
+	for (i=0; i < segment->num_retired; i++)
+	{
+		__gpuMemFree(gcontext, segment->cuda_index,
+					 segment->m_hashslot_retired[i]);
+		segment->m_hashslot_retired[i] = 0UL;
+	}
+	segment->num_retired = 0;
+
 	if (segment->ev_final_loaded)
 	{
 		rc = cuEventDestroy(segment->ev_final_loaded);
@@ -3826,6 +5071,8 @@ gpupreagg_put_segment(gpupreagg_segment *segment)
 			 */
 			Assert(gpas->outer_quals != NIL || segment->total_ngroups > 0);
 			n = ++gpas->stat_num_segments;
+			gpas->stat_total_ngroups += segment->total_ngroups;
+			gpas->stat_num_expanded += segment->num_expanded;
 			gpas->stat_num_groups =
 				((double)gpas->stat_num_groups * (n-1) +
 				 (double)segment->total_ngroups) / n;
@@ -3965,6 +5212,143 @@ gpupreagg_setup_segment(pgstrom_gpupreagg *gpreagg, bool perfmon_enabled)
 	return true;
 }
 
+/*
+ * gpupreagg_expand_final_buffer
+ *
+ * It enqueues the commands to move the contents of the current final
+ * result buffer on the device into the expanded one, then switches the
+ * segment to the new buffer. Any kernels already launched on this
+ * segment are synchronized prior to the movement, and the tasks launched
+ * later synchronize the new ev_final_loaded event.
+ * The old device buffer is retained until segment cleanup, because the
+ * commands we enqueued here may still reference it.
+ */
+static void
+gpupreagg_expand_final_buffer(pgstrom_gpupreagg *gpreagg)
+{
+	gpupreagg_segment  *segment = gpreagg->segment;
+	kern_data_store	   *kds_final = segment->pds_final->kds;
+	size_t				f_hashsize_old = segment->f_hashsize;
+	size_t				f_hashsize_new = kds_final->nrooms;
+	CUdeviceptr			m_hashslot_new = segment->m_hashslot_expand;
+	CUdeviceptr			m_kds_new;
+	CUfunction			kern_final_prep;
+	CUfunction			kern_final_expand;
+	CUevent				ev_final_loaded;
+	CUresult			rc;
+	size_t				grid_size;
+	size_t				block_size;
+	cl_int				i;
+	void			   *kern_args[5];
+
+	Assert(segment->needs_expand && m_hashslot_new != 0UL);
+	Assert(segment->num_retired < GPUPREAGG_MAX_FINAL_EXPAND);
+	m_kds_new = m_hashslot_new +
+		GPUMEMALIGN(offsetof(kern_global_hashslot,
+							 hash_slot[f_hashsize_new]));
+
+	rc = cuModuleGetFunction(&kern_final_prep,
+							 gpreagg->task.cuda_module,
+							 "gpupreagg_final_preparation");
+	if (rc != CUDA_SUCCESS)
+		elog(ERROR, "failed on cuModuleGetFunction: %s", errorText(rc));
+
+	rc = cuModuleGetFunction(&kern_final_expand,
+							 gpreagg->task.cuda_module,
+							 "gpupreagg_final_expand");
+	if (rc != CUDA_SUCCESS)
+		elog(ERROR, "failed on cuModuleGetFunction: %s", errorText(rc));
+
+	/* Synchronization of the kernels that reference the current buffer */
+	for (i=0; i < segment->idx_chunks; i++)
+	{
+		rc = cuStreamWaitEvent(gpreagg->task.cuda_stream,
+							   segment->ev_kern_main[i], 0);
+		if (rc != CUDA_SUCCESS)
+			elog(ERROR, "failed on cuStreamWaitEvent: %s", errorText(rc));
+	}
+
+	/* enqueue DMA send request of the new kds_final header */
+	rc = cuMemcpyHtoDAsync(m_kds_new, kds_final,
+						   KERN_DATA_STORE_HEAD_LENGTH(kds_final),
+						   gpreagg->task.cuda_stream);
+	if (rc != CUDA_SUCCESS)
+		elog(ERROR, "failed on cuMemcpyHtoDAsync: %s", errorText(rc));
+
+	/* Launch:
+	 * KERNEL_FUNCTION(void)
+	 * gpupreagg_final_preparation(size_t hash_size,
+	 *                             kern_global_hashslot *f_hashslot)
+	 */
+	optimal_workgroup_size(&grid_size,
+						   &block_size,
+						   kern_final_prep,
+						   gpreagg->task.cuda_device,
+						   f_hashsize_new,
+						   0, sizeof(kern_errorbuf));
+	kern_args[0] = &f_hashsize_new;
+	kern_args[1] = &m_hashslot_new;
+	rc = cuLaunchKernel(kern_final_prep,
+						grid_size, 1, 1,
+						block_size, 1, 1,
+						sizeof(kern_errorbuf) * block_size,
+						gpreagg->task.cuda_stream,
+						kern_args,
+						NULL);
+	if (rc != CUDA_SUCCESS)
+		elog(ERROR, "failed on cuLaunchKernel: %s", errorText(rc));
+
+	/* Launch:
+	 * KERNEL_FUNCTION(void)
+	 * gpupreagg_final_expand(kern_gpupreagg *kgpreagg,
+	 *                        kern_data_store *kds_old,
+	 *                        kern_global_hashslot *f_hash_old,
+	 *                        kern_data_store *kds_new,
+	 *                        kern_global_hashslot *f_hash_new)
+	 */
+	optimal_workgroup_size(&grid_size,
+						   &block_size,
+						   kern_final_expand,
+						   gpreagg->task.cuda_device,
+						   f_hashsize_old,
+						   0, sizeof(kern_errorbuf));
+	kern_args[0] = &gpreagg->m_gpreagg;
+	kern_args[1] = &segment->m_kds_final;
+	kern_args[2] = &segment->m_hashslot_final;
+	kern_args[3] = &m_kds_new;
+	kern_args[4] = &m_hashslot_new;
+	rc = cuLaunchKernel(kern_final_expand,
+						grid_size, 1, 1,
+						block_size, 1, 1,
+						sizeof(kern_errorbuf) * block_size,
+						gpreagg->task.cuda_stream,
+						kern_args,
+						NULL);
+	if (rc != CUDA_SUCCESS)
+		elog(ERROR, "failed on cuLaunchKernel: %s", errorText(rc));
+
+	/* Tasks launched later shall synchronize the new buffer */
+	rc = cuEventCreate(&ev_final_loaded, CU_EVENT_DISABLE_TIMING);
+	if (rc != CUDA_SUCCESS)
+		elog(ERROR, "failed on cuEventCreate: %s", errorText(rc));
+	rc = cuEventRecord(ev_final_loaded, gpreagg->task.cuda_stream);
+	if (rc != CUDA_SUCCESS)
+		elog(ERROR, "failed on cuEventRecord: %s", errorText(rc));
+	rc = cuEventDestroy(segment->ev_final_loaded);
+	if (rc != CUDA_SUCCESS)
+		elog(WARNING, "failed on cuEventDestroy: %s", errorText(rc));
+
+	/* OK, switch the segment to the new buffer */
+	segment->m_hashslot_retired[segment->num_retired++]
+		= segment->m_hashslot_final;
+	segment->m_hashslot_final = m_hashslot_new;
+	segment->m_kds_final = m_kds_new;
+	segment->m_hashslot_expand = 0UL;
+	segment->f_hashsize = f_hashsize_new;
+	segment->ev_final_loaded = ev_final_loaded;
+	segment->needs_expand = false;
+}
+
 static pgstrom_gpupreagg *
 gpupreagg_task_create(GpuPreAggState *gpas,
 					  pgstrom_data_store *pds_in,
@@ -4139,7 +5523,12 @@ gpupreagg_next_chunk(GpuTaskState *gts)
 	 */
 retry_segment:
 	if (!gpas->curr_segment)
+	{
+		/* replace the planner's ngroups by the sketch on the first chunk */
+		if (gpas->num_segments == 0)
+			gpupreagg_sketch_num_groups(gpas, pds, is_terminator);
 		gpas->curr_segment = gpupreagg_create_segment(gpas);
+	}
 	segment = gpupreagg_get_segment(gpas->curr_segment);
 	/*
 	 * Once a segment gets terminator task, it also means the segment is
@@ -4164,6 +5553,8 @@ retry_segment:
 	Assert(segment->idx_chunks < segment->num_chunks);
 	segment_id = segment->idx_chunks++;
 	segment->pds_src[segment_id] = PDS_retain(pds);
+	if (is_terminator)
+		segment->has_last_chunk = true;
 	if (segment->idx_chunks == segment->num_chunks)
 		is_terminator = true;
 	gpreagg = gpupreagg_task_create(gpas, pds, segment, is_terminator);
@@ -4222,7 +5613,8 @@ retry:
 	 * Filter out the tuple, if any outer_quals
 	 */
 	if (gpas->outer_quals != NULL &&
-		!ExecQual(gpas->outer_quals, econtext, false))
+		!pgstrom_hostjit_exec_quals(gpas->hostjit_quals,
+									gpas->outer_quals, econtext))
 		goto retry;
 
 	/*
@@ -4239,6 +5631,236 @@ retry:
 	return slot;
 }
 
+/*
+ * gpupreagg_hashagg_combine - combines partial aggregate values of the
+ * supplied slot into the hash table entry, according to the kind of each
+ * column. NULL partial values are not combined, as device code does.
+ */
+static void
+gpupreagg_hashagg_combine(GpuPreAggState *gpas,
+						  gpupreagg_hashagg_entry *entry,
+						  TupleTableSlot *slot,
+						  MemoryContext memcxt)
+{
+	TupleDesc		tupdesc = slot->tts_tupleDescriptor;
+	MemoryContext	oldcxt;
+	Datum			newval;
+	int				i;
+
+	for (i=0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = tupdesc->attrs[i];
+		cl_char		kind = gpas->fb_aggkind[i];
+
+		if (kind == FB_HASHAGG_KEY || slot->tts_isnull[i])
+			continue;
+
+		newval = slot->tts_values[i];
+		if (!entry->isnull[i])
+		{
+			if (kind == FB_HASHAGG_ADD)
+				newval = FunctionCall2Coll(&gpas->fb_aggfuncs[i],
+										   gpas->fb_aggcoll[i],
+										   entry->values[i],
+										   newval);
+			else if (kind == FB_HASHAGG_HLL)
+				newval = Int64GetDatum(gpupreagg_hll_merge(
+										DatumGetInt64(entry->values[i]),
+										DatumGetInt64(newval)));
+			else
+			{
+				int32	cmp = DatumGetInt32(
+					FunctionCall2Coll(&gpas->fb_aggfuncs[i],
+									  gpas->fb_aggcoll[i],
+									  newval,
+									  entry->values[i]));
+				if (kind == FB_HASHAGG_MIN ? cmp >= 0 : cmp <= 0)
+					continue;
+			}
+			if (!attr->attbyval)
+				pfree(DatumGetPointer(entry->values[i]));
+		}
+		oldcxt = MemoryContextSwitchTo(memcxt);
+		entry->values[i] = datumCopy(newval, attr->attbyval, attr->attlen);
+		entry->isnull[i] = false;
+		MemoryContextSwitchTo(oldcxt);
+	}
+}
+
+/*
+ * gpupreagg_hashagg_create - makes an empty hash table for the host side
+ * hash aggregation on the partial results
+ */
+static TupleHashTable
+gpupreagg_hashagg_create(GpuPreAggState *gpas, MemoryContext memcxt)
+{
+	ExprContext	   *econtext = gpas->gts.css.ss.ps.ps_ExprContext;
+	long			nbuckets;
+
+	nbuckets = (long) Min(Max(gpas->stat_num_groups, 256.0), 65536.0);
+	return BuildTupleHashTable(gpas->fb_numCols,
+							   gpas->fb_keyColIdx,
+							   gpas->fb_eqfuncs,
+							   gpas->fb_hashfuncs,
+							   nbuckets,
+							   sizeof(gpupreagg_hashagg_entry),
+							   memcxt,
+							   econtext->ecxt_per_tuple_memory);
+}
+
+/*
+ * gpupreagg_hashagg_insert - puts a partial result row on the hash table;
+ * either a new group entry, or combined to the existing one
+ */
+static void
+gpupreagg_hashagg_insert(GpuPreAggState *gpas,
+						 TupleHashTable htable,
+						 MemoryContext memcxt,
+						 TupleTableSlot *slot)
+{
+	gpupreagg_hashagg_entry *entry;
+	bool			isnew;
+
+	slot_getallattrs(slot);
+	entry = (gpupreagg_hashagg_entry *)
+		LookupTupleHashEntry(htable, slot, &isnew);
+	if (isnew)
+	{
+		TupleDesc		tupdesc = slot->tts_tupleDescriptor;
+		MemoryContext	oldcxt;
+		int				i;
+
+		oldcxt = MemoryContextSwitchTo(memcxt);
+		entry->values = palloc(sizeof(Datum) * tupdesc->natts);
+		entry->isnull = palloc(sizeof(bool) * tupdesc->natts);
+		for (i=0; i < tupdesc->natts; i++)
+		{
+			Form_pg_attribute attr = tupdesc->attrs[i];
+
+			entry->isnull[i] = slot->tts_isnull[i];
+			if (slot->tts_isnull[i])
+				entry->values[i] = (Datum) 0;
+			else
+				entry->values[i] = datumCopy(slot->tts_values[i],
+											 attr->attbyval,
+											 attr->attlen);
+		}
+		MemoryContextSwitchTo(oldcxt);
+	}
+	else
+		gpupreagg_hashagg_combine(gpas, entry, slot, memcxt);
+}
+
+/*
+ * gpupreagg_hashagg_store - stores a group entry on the result slot
+ */
+static TupleTableSlot *
+gpupreagg_hashagg_store(GpuPreAggState *gpas,
+						gpupreagg_hashagg_entry *entry)
+{
+	TupleTableSlot *slot = gpas->gts.css.ss.ps.ps_ResultTupleSlot;
+	int				natts = slot->tts_tupleDescriptor->natts;
+
+	ExecClearTuple(slot);
+	memcpy(slot->tts_values, entry->values, sizeof(Datum) * natts);
+	memcpy(slot->tts_isnull, entry->isnull, sizeof(bool) * natts);
+	return ExecStoreVirtualTuple(slot);
+}
+
+/*
+ * gpupreagg_hashagg_exceeds_limit - true, if the hash table is estimated
+ * to consume more memory than work_mem
+ */
+static bool
+gpupreagg_hashagg_exceeds_limit(GpuPreAggState *gpas, TupleHashTable htable)
+{
+	double		usage = ((double) hash_get_num_entries(htable->hashtab) *
+						 (double) gpas->fb_entry_size);
+
+	return (usage > (double) work_mem * 1024.0);
+}
+
+/*
+ * gpupreagg_hashagg_release - discards the hash table; the iterator has
+ * to be terminated first, if it is still in progress
+ */
+static void
+gpupreagg_hashagg_release(TupleHashTable *p_htable,
+						  TupleHashIterator *hiter,
+						  bool *p_hiter_active,
+						  MemoryContext memcxt)
+{
+	if (*p_hiter_active)
+	{
+		TermTupleHashIterator(hiter);
+		*p_hiter_active = false;
+	}
+	*p_htable = NULL;
+	if (memcxt)
+		MemoryContextReset(memcxt);
+}
+
+/*
+ * gpupreagg_next_tuple_fallback_hashagg - a fallback routine that groups
+ * the partial aggregate rows of the segment by the host, then returns one
+ * partial row per group. It keeps the final Agg node away from a flood of
+ * single-row partial aggregations when GPU gave up the segment.
+ * Once the hash table exceeds work_mem, the current groups are returned
+ * and the table is reset; the upper node combines the partial rows of
+ * the same group anyway.
+ */
+static TupleTableSlot *
+gpupreagg_next_tuple_fallback_hashagg(GpuPreAggState *gpas,
+									  gpupreagg_segment *segment)
+{
+	ExprContext	   *econtext = gpas->gts.css.ss.ps.ps_ExprContext;
+	TupleTableSlot *slot;
+	gpupreagg_hashagg_entry *entry;
+
+	for (;;)
+	{
+		if (!gpas->fb_htable)
+		{
+			if (gpas->fb_input_done)
+			{
+				/* all the groups of this segment are already returned */
+				gpas->fb_input_done = false;
+				return NULL;
+			}
+			gpas->fb_htable = gpupreagg_hashagg_create(gpas,
+													   gpas->fb_memcxt);
+			for (;;)
+			{
+				ResetExprContext(econtext);
+				slot = gpupreagg_next_tuple_fallback(gpas, segment);
+				if (TupIsNull(slot))
+				{
+					gpas->fb_input_done = true;
+					break;
+				}
+				gpupreagg_hashagg_insert(gpas, gpas->fb_htable,
+										 gpas->fb_memcxt, slot);
+				if (gpupreagg_hashagg_exceeds_limit(gpas, gpas->fb_htable))
+					break;
+			}
+			ResetExprContext(econtext);
+			InitTupleHashIterator(gpas->fb_htable, &gpas->fb_hiter);
+			gpas->fb_hiter_active = true;
+		}
+
+		entry = (gpupreagg_hashagg_entry *)
+			ScanTupleHashTable(&gpas->fb_hiter);
+		if (entry)
+			return gpupreagg_hashagg_store(gpas, entry);
+		/* ScanTupleHashTable already terminated the iterator */
+		gpas->fb_hiter_active = false;
+		gpupreagg_hashagg_release(&gpas->fb_htable,
+								  &gpas->fb_hiter,
+								  &gpas->fb_hiter_active,
+								  gpas->fb_memcxt);
+	}
+}
+
 static TupleTableSlot *
 gpupreagg_next_tuple(GpuTaskState *gts)
 {
@@ -4255,7 +5877,12 @@ gpupreagg_next_tuple(GpuTaskState *gts)
 
 	PERFMON_BEGIN(&gts->pfm, &tv1);
 	if (segment->needs_fallback)
-		slot = gpupreagg_next_tuple_fallback(gpas, segment);
+	{
+		if (gpas->fb_hashagg && enable_gpupreagg_fallback_hashagg)
+			slot = gpupreagg_next_tuple_fallback_hashagg(gpas, segment);
+		else
+			slot = gpupreagg_next_tuple_fallback(gpas, segment);
+	}
 	else if (gpas->gts.curr_index < kds_final->nitems)
 	{
 		size_t		index = gpas->gts.curr_index++;
@@ -4272,9 +5899,77 @@ gpupreagg_next_tuple(GpuTaskState *gts)
 	return slot;
 }
 
+/*
+ * gpupreagg_exec_final_merge
+ *
+ * It ensures one row per group on the final mode. If a single segment
+ * consumed all the input without CPU fallback, its results are already
+ * unique, so they are returned as is. Elsewhere, results of the segments
+ * are merged on the host hash table, then returned.
+ */
+static TupleTableSlot *
+gpupreagg_exec_final_merge(GpuPreAggState *gpas)
+{
+	TupleTableSlot *slot;
+	gpupreagg_hashagg_entry *entry;
+
+	if (gpas->fm_state != GPUPREAGG_FMSTATE_EMIT)
+	{
+		for (;;)
+		{
+			slot = pgstrom_exec_gputask(&gpas->gts);
+			if (TupIsNull(slot))
+				break;
+
+			if (gpas->fm_state == GPUPREAGG_FMSTATE_INIT)
+			{
+				pgstrom_gpupreagg  *gpreagg
+					= (pgstrom_gpupreagg *) gpas->gts.curr_task;
+				gpupreagg_segment  *segment = gpreagg->segment;
+
+				if (gpas->num_segments == 1 &&
+					segment->has_last_chunk &&
+					!segment->needs_fallback)
+					gpas->fm_state = GPUPREAGG_FMSTATE_PASSTHROUGH;
+				else
+				{
+					gpas->fm_htable = gpupreagg_hashagg_create(gpas,
+															gpas->fm_memcxt);
+					gpas->fm_state = GPUPREAGG_FMSTATE_MERGE;
+				}
+			}
+			if (gpas->fm_state == GPUPREAGG_FMSTATE_PASSTHROUGH)
+				return slot;
+
+			gpupreagg_hashagg_insert(gpas, gpas->fm_htable,
+									 gpas->fm_memcxt, slot);
+		}
+		if (gpas->fm_state != GPUPREAGG_FMSTATE_MERGE)
+			return NULL;
+		InitTupleHashIterator(gpas->fm_htable, &gpas->fm_hiter);
+		gpas->fm_hiter_active = true;
+		gpas->fm_state = GPUPREAGG_FMSTATE_EMIT;
+	}
+
+	if (!gpas->fm_hiter_active)
+		return NULL;
+	entry = (gpupreagg_hashagg_entry *) ScanTupleHashTable(&gpas->fm_hiter);
+	if (!entry)
+	{
+		/* ScanTupleHashTable already terminated the iterator */
+		gpas->fm_hiter_active = false;
+		return NULL;
+	}
+	return gpupreagg_hashagg_store(gpas, entry);
+}
+
 static TupleTableSlot *
 gpupreagg_exec(CustomScanState *node)
 {
+	GpuPreAggState *gpas = (GpuPreAggState *) node;
+
+	if (gpas->final_merge)
+		return gpupreagg_exec_final_merge(gpas);
 	return pgstrom_exec_gputask((GpuTaskState *) node);
 }
 
@@ -4289,6 +5984,15 @@ gpupreagg_end(CustomScanState *node)
 		gpupreagg_put_segment(gpas->curr_segment);
 		gpas->curr_segment = NULL;
 	}
+	/* Terminate the hash table scan in progress, if any */
+	gpupreagg_hashagg_release(&gpas->fb_htable,
+							  &gpas->fb_hiter,
+							  &gpas->fb_hiter_active,
+							  NULL);
+	gpupreagg_hashagg_release(&gpas->fm_htable,
+							  &gpas->fm_hiter,
+							  &gpas->fm_hiter_active,
+							  NULL);
 	/* Clean up subtree, if any */
 	if (outerPlanState(node))
 		ExecEndNode(outerPlanState(node));
@@ -4305,6 +6009,25 @@ gpupreagg_rescan(CustomScanState *node)
 	pgstrom_activate_gputaskstate(&gpas->gts);
 	/* Cleanup and relase any concurrent tasks */
 	pgstrom_cleanup_gputaskstate(&gpas->gts);
+	/* Discard the hash table of CPU fallback, if any */
+	gpupreagg_hashagg_release(&gpas->fb_htable,
+							  &gpas->fb_hiter,
+							  &gpas->fb_hiter_active,
+							  gpas->fb_memcxt);
+	gpas->fb_input_done = false;
+	/* Release current segment, not to be shared with the next scan */
+	if (gpas->curr_segment)
+	{
+		gpupreagg_put_segment(gpas->curr_segment);
+		gpas->curr_segment = NULL;
+	}
+	/* Also reset the final merge state */
+	gpas->fm_state = GPUPREAGG_FMSTATE_INIT;
+	gpas->num_segments = 0;
+	gpupreagg_hashagg_release(&gpas->fm_htable,
+							  &gpas->fm_hiter,
+							  &gpas->fm_hiter_active,
+							  gpas->fm_memcxt);
 	/* Rewind the subtree */
 	if (gpas->gts.css.ss.ss_currentRelation)
 		pgstrom_rewind_scan_chunk(&gpas->gts);
@@ -4335,6 +6058,8 @@ gpupreagg_explain(CustomScanState *node, List *ancestors, ExplainState *es)
 	else
 		policy = "Unknown";
 	ExplainPropertyText("Reduction", policy, es);
+	if (gpa_info->final_merge)
+		ExplainPropertyText("Final Aggregation", "on", es);
 
 	/* Set up deparsing context */
 	context = set_deparse_context_planstate(es->deparse_cxt,
@@ -4362,6 +6087,27 @@ gpupreagg_explain(CustomScanState *node, List *ancestors, ExplainState *es)
 				 gpas->key_dist_salt);
 		ExplainPropertyText("Logic Parameter", temp, es);
 	}
+	if (es->analyze && gpas->stat_num_segments > 0)
+	{
+		if (gpas->stat_sketch_ngroups < 0.0)
+			snprintf(temp, sizeof(temp),
+					 "plan: %.0f, actual: %zu in %u segments",
+					 gpas->stat_plan_ngroups,
+					 gpas->stat_total_ngroups,
+					 gpas->stat_num_segments);
+		else
+			snprintf(temp, sizeof(temp),
+					 "plan: %.0f, sketch: %.0f, actual: %zu in %u segments",
+					 gpas->stat_plan_ngroups,
+					 gpas->stat_sketch_ngroups,
+					 gpas->stat_total_ngroups,
+					 gpas->stat_num_segments);
+		if (gpas->stat_num_expanded > 0)
+			snprintf(temp + strlen(temp), sizeof(temp) - strlen(temp),
+					 ", final buffer expanded %u times",
+					 gpas->stat_num_expanded);
+		ExplainPropertyText("Num Groups", temp, es);
+	}
 	pgstrom_explain_gputaskstate(&gpas->gts, es);
 }
 
@@ -4528,8 +6274,14 @@ skip:
 		 * Once a segment->has_terminator is set, no other tasks shall not
 		 * be added, so what we have to do is use dlist_push_tail to
 		 * re-enqueue the pending list.
+		 *
+		 * Prior to the urgent termination, we try to expand the final
+		 * result buffer of the segment; it allows to keep absorbing the
+		 * following chunks in the same segment. Only if it is not
+		 * available, the segment shall be terminated.
 		 */
-		if (!segment->has_terminator)
+		if (!segment->has_terminator &&
+			!gpupreagg_expand_segment(gpas, segment))
 		{
 			gpupreagg_segment  *segment = gpreagg->segment;
 
@@ -4769,6 +6521,21 @@ __gpupreagg_task_process(pgstrom_gpupreagg *gpreagg)
 	if (!gpupreagg_setup_segment(gpreagg, pfm->enabled))
 		goto out_of_resource;
 
+	/*
+	 * Allocation of the expanded final result buffer, if planned
+	 */
+	if (segment->needs_expand && !segment->m_hashslot_expand)
+	{
+		kern_data_store *kds_final = segment->pds_final->kds;
+
+		length = (GPUMEMALIGN(offsetof(kern_global_hashslot,
+									   hash_slot[kds_final->nrooms])) +
+				  GPUMEMALIGN(KERN_DATA_STORE_LENGTH(kds_final)));
+		segment->m_hashslot_expand = gpuMemAlloc(&gpreagg->task, length);
+		if (!segment->m_hashslot_expand)
+			goto out_of_resource;
+	}
+
 	/*
 	 * Creation of event objects, if any
 	 */
@@ -4820,6 +6587,12 @@ __gpupreagg_task_process(pgstrom_gpupreagg *gpreagg)
 	}
 	CUDA_EVENT_RECORD(gpreagg, ev_dma_send_stop);
 
+	/*
+	 * Move the groups into the expanded final result buffer, if planned
+	 */
+	if (segment->needs_expand)
+		gpupreagg_expand_final_buffer(gpreagg);
+
 	/* Launch:
 	 * KERNEL_FUNCTION(void)
 	 * gpupreagg_main(kern_gpupreagg *kgpreagg,
@@ -5021,6 +6794,44 @@ pgstrom_init_gpupreagg(void)
 							 PGC_USERSET,
                              GUC_NOT_IN_SAMPLE,
                              NULL, NULL, NULL);
+	/* pg_strom.enable_gpupreagg_final */
+	DefineCustomBoolVariable("pg_strom.enable_gpupreagg_final",
+							 "Enables GpuPreAgg to run final aggregation",
+							 NULL,
+							 &enable_gpupreagg_final,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.enable_gpupreagg_final_expand */
+	DefineCustomBoolVariable("pg_strom.enable_gpupreagg_final_expand",
+							 "Enables expansion of the final result buffer",
+							 NULL,
+							 &enable_gpupreagg_final_expand,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.gpupreagg_sketch_nrows */
+	DefineCustomIntVariable("pg_strom.gpupreagg_sketch_nrows",
+							"Rows sampled to estimate ngroups of GpuPreAgg",
+							NULL,
+							&gpupreagg_sketch_nrows,
+							30000,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* pg_strom.enable_gpupreagg_fallback_hashagg */
+	DefineCustomBoolVariable("pg_strom.enable_gpupreagg_fallback_hashagg",
+							 "Enables CPU hash pre-aggregation on fallback",
+							 NULL,
+							 &enable_gpupreagg_fallback_hashagg,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 
 	/* initialization of plan method table */
 	memset(&gpupreagg_scan_methods, 0, sizeof(CustomScanMethods));
@@ -145,6 +145,8 @@ typedef struct
 	pgstrom_data_store *pds_src;
 	pgstrom_data_store *pds_dst;
 	kern_resultbuf *kresults;
+	cl_uint		   *fallback_rows;	/* selection vector on CPU fallback */
+	cl_uint			fallback_nrows;
 	kern_gpuscan	kern;
 } pgstrom_gpuscan;
 
@@ -158,9 +160,14 @@ typedef struct {
 	cl_int			base_fixed_width; /* width of fixed fields on base rel */
 	cl_int			proj_fixed_width; /* width of fixed fields on projection */
 	cl_int			proj_extra_width; /* width of extra buffer on projection */
+	/* run-time statistics of dev_quals */
+	cl_ulong		num_rows_evaluated;	/* # of rows evaluated by GPU */
+	cl_ulong		num_rows_filtered;	/* # of rows removed by GPU */
 	/* resource for CPU fallback */
 	TupleTableSlot *base_slot;
 	ProjectionInfo *base_proj;
+	pgstrom_hostjit *hostjit_quals;	/* host JIT code of dev_quals, if any */
+	pgstrom_cpuvec *cpuvec_quals;	/* chunk-at-a-time dev_quals, if any */
 } GpuScanState;
 
 /* forward declarations */
@@ -562,13 +569,16 @@ static char *
 gpuscan_codegen_exec_quals(codegen_context *context, List *dev_quals)
 {
 	StringInfoData	body;
+	char		   *cse_code;
 	char		   *expr_code;
 
 	if (dev_quals == NULL)
 		return GPUSCAN_KERN_SOURCE_NO_DEVQUAL;
 
 	/* Let's walk on the device expression tree */
+	cse_code = pgstrom_codegen_cse_begin(dev_quals, context);
 	expr_code = pgstrom_codegen_expression((Node *)dev_quals, context);
+	pgstrom_codegen_cse_end(context);
 
 	initStringInfo(&body);
 	appendStringInfo(
@@ -582,6 +592,8 @@ gpuscan_codegen_exec_quals(codegen_context *context, List *dev_quals)
 	pgstrom_codegen_param_declarations(&body, context);
 	/* add variables declarations */
 	pgstrom_codegen_var_declarations(&body, context);
+	/* add common sub-expressions */
+	appendStringInfoString(&body, cse_code);
 
 	appendStringInfo(
 		&body,
@@ -633,6 +645,8 @@ create_gpuscan_plan(PlannerInfo *root,
 	/* Reduce RestrictInfo list to bare expressions; ignore pseudoconstants */
 	host_quals = extract_actual_clauses(host_quals, false);
     dev_quals = extract_actual_clauses(dev_quals, false);
+	/* cheap and selective qualifiers shall be evaluated first */
+	dev_quals = pgstrom_reorder_device_quals(root, dev_quals);
 
 	/*
 	 * Construct OpenCL kernel code
@@ -710,6 +724,7 @@ codegen_device_projection(StringInfo source,
 {
 	AttrNumber	   *varremaps;
 	Bitmapset	   *varattnos;
+	List		   *exprs;
 	ListCell	   *lc;
 	int				prev;
 	int				i, j, k;
@@ -936,6 +951,16 @@ codegen_device_projection(StringInfo source,
 	/*
 	 * step.3 - execute expression node, then store the result onto KVAR_xx
 	 */
+	exprs = NIL;
+	foreach (lc, tlist_dev)
+	{
+		TargetEntry    *tle = lfirst(lc);
+
+		if (!IsA(tle->expr, Var))
+			exprs = lappend(exprs, tle->expr);
+	}
+	appendStringInfoString(&body, pgstrom_codegen_cse_begin(exprs, context));
+
     foreach (lc, tlist_dev)
     {
         TargetEntry    *tle = lfirst(lc);
@@ -960,6 +985,7 @@ codegen_device_projection(StringInfo source,
 			tle->resno,
 			pgstrom_codegen_expression((Node *) tle->expr, context));
 	}
+	pgstrom_codegen_cse_end(context);
 
 	appendStringInfo(
 		&body,
@@ -1778,6 +1804,10 @@ gpuscan_begin(CustomScanState *node, EState *estate, int eflags)
 	/* initialize device qualifiers also, for fallback */
 	gss->dev_quals = (List *)
 		ExecInitExpr((Expr *) gs_info->dev_quals, &gss->gts.css.ss.ps);
+	gss->hostjit_quals =
+		pgstrom_hostjit_create_quals((Node *) gs_info->dev_quals);
+	gss->cpuvec_quals =
+		pgstrom_cpuvec_create_quals(gs_info->dev_quals, &gss->gts.css.ss.ps);
 	/* true, if device projection is needed */
 	gss->dev_projection = (cscan->custom_scan_tlist != NIL);
 	/* device projection related resource consumption */
@@ -1831,6 +1861,8 @@ pgstrom_release_gpuscan(GpuTask *gputask)
 		PDS_release(gpuscan->pds_src);
 	if (gpuscan->pds_dst)
 		PDS_release(gpuscan->pds_dst);
+	if (gpuscan->fallback_rows)
+		pfree(gpuscan->fallback_rows);
 	pgstrom_complete_gpuscan(&gpuscan->task);
 
 	pfree(gpuscan);
@@ -2071,13 +2103,40 @@ gpuscan_next_tuple(GpuTaskState *gts)
 		 * according to custom_scan_tlist.
 		 */
 		pgstrom_data_store *pds_src = gpuscan->pds_src;
+		cl_uint				nitems = pds_src->kds->nitems;
 
-		while (gss->gts.curr_index < pds_src->kds->nitems)
+		/*
+		 * If dev_quals can be evaluated chunk-at-a-time, we run them on
+		 * the whole chunk at once, then walk on the selected rows.
+		 */
+		if (gss->cpuvec_quals)
+		{
+			if (!gpuscan->fallback_rows)
+			{
+				ExprContext	   *econtext = gss->gts.css.ss.ps.ps_ExprContext;
+
+				gpuscan->fallback_rows =
+					MemoryContextAlloc(gss->gts.gcontext->memcxt,
+									   sizeof(cl_uint) * Max(nitems, 1));
+				gpuscan->fallback_nrows =
+					pgstrom_cpuvec_exec_quals(gss->cpuvec_quals,
+											  pds_src,
+											  gss->base_slot,
+											  econtext,
+											  gpuscan->fallback_rows);
+			}
+			nitems = gpuscan->fallback_nrows;
+		}
+
+		while (gss->gts.curr_index < nitems)
 		{
 			cl_uint			index = gss->gts.curr_index++;
 			ExprContext	   *econtext = gss->gts.css.ss.ps.ps_ExprContext;
 			ExprDoneCond	is_done;
 
+			if (gpuscan->fallback_rows)
+				index = gpuscan->fallback_rows[index];
+
 			ExecClearTuple(gss->base_slot);
 			if (!pgstrom_fetch_data_store(gss->base_slot, pds_src, index,
 										  &gss->scan_tuple))
@@ -2089,9 +2148,10 @@ gpuscan_next_tuple(GpuTaskState *gts)
 			/*
 			 * step.1 - evaluate dev_quals if any
 			 */
-			if (gss->dev_quals != NIL)
+			if (gss->dev_quals != NIL && !gpuscan->fallback_rows)
 			{
-				if (!ExecQual(gss->dev_quals, econtext, false))
+				if (!pgstrom_hostjit_exec_quals(gss->hostjit_quals,
+												gss->dev_quals, econtext))
 					continue;
 			}
 
@@ -2222,7 +2282,22 @@ gpuscan_explain(CustomScanState *node, List *ancestors, ExplainState *es)
 	pgstrom_explain_expression(gsinfo->dev_quals, "GPU Filter",
 							   &gss->gts.css.ss.ps, context,
                                ancestors, es, false, true);
-	// TODO: Add number of rows filtered by the device side
+	/* Show number of rows filtered by the device side */
+	if (es->analyze && gsinfo->dev_quals != NIL)
+	{
+		double	nloops = gss->gts.css.ss.ps.instrument
+			? Max(gss->gts.css.ss.ps.instrument->nloops, 1.0) : 1.0;
+
+		ExplainPropertyFloat("Rows Removed by GPU Filter",
+							 (double) gss->num_rows_filtered / nloops,
+							 0, es);
+		if (es->verbose && gss->num_rows_evaluated > 0)
+			ExplainPropertyFloat("GPU Filter Selectivity",
+								 100.0 * (double)(gss->num_rows_evaluated -
+												  gss->num_rows_filtered) /
+								 (double) gss->num_rows_evaluated,
+								 2, es);
+	}
 
 	pgstrom_explain_gputaskstate(&gss->gts, es);
 }
@@ -2327,6 +2402,21 @@ pgstrom_complete_gpuscan(GpuTask *gtask)
 						   skip);
 	}
 skip:
+	/* run-time statistics of the device qualifiers */
+	if (gpuscan->task.kerror.errcode == StromError_Success &&
+		!gpuscan->task.cpu_fallback)
+	{
+		GpuScanState   *gss = (GpuScanState *) gts;
+		cl_uint			nitems_in = gpuscan->pds_src->kds->nitems;
+		cl_uint			nitems_out = (gpuscan->pds_dst
+									  ? gpuscan->pds_dst->kds->nitems
+									  : gpuscan->kresults->nitems);
+		if (gss->dev_quals != NIL && nitems_in >= nitems_out)
+		{
+			gss->num_rows_evaluated += nitems_in;
+			gss->num_rows_filtered += nitems_in - nitems_out;
+		}
+	}
 	gpuscan_cleanup_cuda_resources(gpuscan);
 
 	return true;
@@ -0,0 +1,850 @@
+/*
+ * hostjit.c
+ *
+ * Routines to build native host code for the CPU fallback path
+ * ----
+ * Copyright 2011-2016 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2016 (C) The PG-Strom Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "postgres.h"
+#include "access/htup_details.h"
+#include "catalog/pg_language.h"
+#include "catalog/pg_namespace.h"
+#include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
+#include "executor/executor.h"
+#include "fmgr.h"
+#include "libpq/md5.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "storage/fd.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
+#include "utils/syscache.h"
+#include "pg_strom.h"
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static bool		pgstrom_hostjit_enabled;
+static char	   *pgstrom_hostjit_compiler;
+
+/*
+ * Catalog of data types supported by the host JIT code
+ *
+ * Every type must be passed by value, so we can pick up the value from
+ * tts_values[] of the scan slot without any de-toasting.
+ */
+static struct {
+	Oid			type_oid;
+	const char *type_cname;		/* C type on the host JIT code */
+	const char *type_fetch;		/* macro to pick up the value from Datum */
+	bool		type_is_float;	/* true, if floating point */
+} hostjit_type_catalog[] = {
+	{ BOOLOID,		"char",		"HJ_BOOL",		false },
+	{ INT2OID,		"int16_t",	"HJ_INT2",		false },
+	{ INT4OID,		"int32_t",	"HJ_INT4",		false },
+	{ DATEOID,		"int32_t",	"HJ_INT4",		false },
+#ifdef USE_FLOAT4_BYVAL
+	{ FLOAT4OID,	"float",	"HJ_FLOAT4",	true },
+#endif
+#ifdef USE_FLOAT8_BYVAL
+	{ INT8OID,		"int64_t",	"HJ_INT8",		false },
+	{ FLOAT8OID,	"double",	"HJ_FLOAT8",	true },
+#ifdef HAVE_INT64_TIMESTAMP
+	{ TIMESTAMPOID,	"int64_t",	"HJ_INT8",		false },
+	{ TIMESTAMPTZOID, "int64_t", "HJ_INT8",		false },
+#endif
+#endif
+};
+
+/*
+ * Catalog of functions supported by the host JIT code
+ *
+ * Function is identified by its name and argument types in pg_catalog.
+ */
+#define HJFUNC_COMPARE		1
+#define HJFUNC_ARITH		2
+#define HJFUNC_DIVIDE		3
+#define HJFUNC_UMINUS		4
+
+#define HJFUNC_CMP_DECL(prefix,ltype,rtype)						\
+	{ prefix "eq", 2, { ltype, rtype }, BOOLOID, HJFUNC_COMPARE, "==" },	\
+	{ prefix "ne", 2, { ltype, rtype }, BOOLOID, HJFUNC_COMPARE, "!=" },	\
+	{ prefix "lt", 2, { ltype, rtype }, BOOLOID, HJFUNC_COMPARE, "<" },	\
+	{ prefix "le", 2, { ltype, rtype }, BOOLOID, HJFUNC_COMPARE, "<=" },	\
+	{ prefix "gt", 2, { ltype, rtype }, BOOLOID, HJFUNC_COMPARE, ">" },	\
+	{ prefix "ge", 2, { ltype, rtype }, BOOLOID, HJFUNC_COMPARE, ">=" }
+
+#define HJFUNC_ARITH_DECL(prefix,ltype,rtype,restype)				\
+	{ prefix "pl", 2, { ltype, rtype }, restype, HJFUNC_ARITH, "add" },	\
+	{ prefix "mi", 2, { ltype, rtype }, restype, HJFUNC_ARITH, "sub" },	\
+	{ prefix "mul", 2, { ltype, rtype }, restype, HJFUNC_ARITH, "mul" },	\
+	{ prefix "div", 2, { ltype, rtype }, restype, HJFUNC_DIVIDE, "/" }
+
+static struct {
+	const char *func_name;
+	int			func_nargs;
+	Oid			func_argtypes[2];
+	Oid			func_rettype;
+	int			func_class;
+	const char *func_oper;
+} hostjit_func_catalog[] = {
+	HJFUNC_CMP_DECL("bool", BOOLOID, BOOLOID),
+	HJFUNC_CMP_DECL("int2", INT2OID, INT2OID),
+	HJFUNC_CMP_DECL("int24", INT2OID, INT4OID),
+	HJFUNC_CMP_DECL("int42", INT4OID, INT2OID),
+	HJFUNC_CMP_DECL("int4", INT4OID, INT4OID),
+	HJFUNC_CMP_DECL("date_", DATEOID, DATEOID),
+	HJFUNC_ARITH_DECL("int2", INT2OID, INT2OID, INT2OID),
+	HJFUNC_ARITH_DECL("int24", INT2OID, INT4OID, INT4OID),
+	HJFUNC_ARITH_DECL("int42", INT4OID, INT2OID, INT4OID),
+	HJFUNC_ARITH_DECL("int4", INT4OID, INT4OID, INT4OID),
+	{ "int2um", 1, { INT2OID, InvalidOid }, INT2OID, HJFUNC_UMINUS, "-" },
+	{ "int4um", 1, { INT4OID, InvalidOid }, INT4OID, HJFUNC_UMINUS, "-" },
+#ifdef USE_FLOAT4_BYVAL
+	HJFUNC_CMP_DECL("float4", FLOAT4OID, FLOAT4OID),
+	HJFUNC_ARITH_DECL("float4", FLOAT4OID, FLOAT4OID, FLOAT4OID),
+	{ "float4um", 1, { FLOAT4OID, InvalidOid }, FLOAT4OID, HJFUNC_UMINUS, "-" },
+#endif
+#ifdef USE_FLOAT8_BYVAL
+	HJFUNC_CMP_DECL("int8", INT8OID, INT8OID),
+	HJFUNC_CMP_DECL("int28", INT2OID, INT8OID),
+	HJFUNC_CMP_DECL("int82", INT8OID, INT2OID),
+	HJFUNC_CMP_DECL("int48", INT4OID, INT8OID),
+	HJFUNC_CMP_DECL("int84", INT8OID, INT4OID),
+	HJFUNC_CMP_DECL("float8", FLOAT8OID, FLOAT8OID),
+	HJFUNC_ARITH_DECL("int8", INT8OID, INT8OID, INT8OID),
+	HJFUNC_ARITH_DECL("int48", INT4OID, INT8OID, INT8OID),
+	HJFUNC_ARITH_DECL("int84", INT8OID, INT4OID, INT8OID),
+	HJFUNC_ARITH_DECL("float8", FLOAT8OID, FLOAT8OID, FLOAT8OID),
+	{ "int8um", 1, { INT8OID, InvalidOid }, INT8OID, HJFUNC_UMINUS, "-" },
+	{ "float8um", 1, { FLOAT8OID, InvalidOid }, FLOAT8OID, HJFUNC_UMINUS, "-" },
+#ifdef USE_FLOAT4_BYVAL
+	HJFUNC_CMP_DECL("float48", FLOAT4OID, FLOAT8OID),
+	HJFUNC_CMP_DECL("float84", FLOAT8OID, FLOAT4OID),
+	HJFUNC_ARITH_DECL("float48", FLOAT4OID, FLOAT8OID, FLOAT8OID),
+	HJFUNC_ARITH_DECL("float84", FLOAT8OID, FLOAT4OID, FLOAT8OID),
+#endif
+#ifdef HAVE_INT64_TIMESTAMP
+	HJFUNC_CMP_DECL("timestamp_", TIMESTAMPOID, TIMESTAMPOID),
+	HJFUNC_CMP_DECL("timestamptz_", TIMESTAMPTZOID, TIMESTAMPTZOID),
+#endif
+#endif
+};
+
+/*
+ * Common declarations of the host JIT code. Note that NaN, infinity,
+ * overflow and zero-divide are never handled by the JIT code; it returns
+ * -1 to ask the caller to evaluate the expression using the executor,
+ * to get the identical behavior (including error messages).
+ */
+static const char *hostjit_code_prelude =
+	"#include <stdint.h>\n"
+	"#include <math.h>\n"
+	"\n"
+	"#define HJ_BOOL(d)    ((char)((d) != 0))\n"
+	"#define HJ_INT2(d)    ((int16_t)(d))\n"
+	"#define HJ_INT4(d)    ((int32_t)(d))\n"
+	"#define HJ_INT8(d)    ((int64_t)(d))\n"
+	"\n"
+	"static inline float\n"
+	"HJ_FLOAT4(uintptr_t d)\n"
+	"{\n"
+	"  union { uint32_t ival; float fval; } u;\n"
+	"  u.ival = (uint32_t)d;\n"
+	"  return u.fval;\n"
+	"}\n"
+	"\n"
+	"static inline double\n"
+	"HJ_FLOAT8(uintptr_t d)\n"
+	"{\n"
+	"  union { uint64_t ival; double fval; } u;\n"
+	"  u.ival = (uint64_t)d;\n"
+	"  return u.fval;\n"
+	"}\n"
+	"\n";
+
+typedef struct
+{
+	StringInfoData	decl;		/* declarations of temporary variables */
+	StringInfoData	body;		/* statements to evaluate expression */
+	int				ntemps;		/* number of temporary variables */
+	AttrNumber		max_attno;	/* largest attribute number referenced */
+} hostjit_context;
+
+static int hostjit_codegen_walker(Node *node, hostjit_context *context);
+
+/*
+ * hostjit_type_lookup
+ */
+static int
+hostjit_type_lookup(Oid type_oid)
+{
+	int		i;
+
+	for (i=0; i < lengthof(hostjit_type_catalog); i++)
+	{
+		if (hostjit_type_catalog[i].type_oid == type_oid)
+			return i;
+	}
+	return -1;
+}
+
+/*
+ * hostjit_func_lookup
+ */
+static int
+hostjit_func_lookup(Oid func_oid)
+{
+	HeapTuple		tuple;
+	Form_pg_proc	proc;
+	int				i, index = -1;
+
+	tuple = SearchSysCache1(PROCOID, ObjectIdGetDatum(func_oid));
+	if (!HeapTupleIsValid(tuple))
+		elog(ERROR, "cache lookup failed for function %u", func_oid);
+	proc = (Form_pg_proc) GETSTRUCT(tuple);
+
+	if (proc->pronamespace == PG_CATALOG_NAMESPACE &&
+		proc->prolang == INTERNALlanguageId &&
+		proc->proisstrict &&
+		!proc->proretset)
+	{
+		for (i=0; i < lengthof(hostjit_func_catalog); i++)
+		{
+			if (strcmp(hostjit_func_catalog[i].func_name,
+					   NameStr(proc->proname)) != 0 ||
+				hostjit_func_catalog[i].func_nargs != proc->pronargs ||
+				hostjit_func_catalog[i].func_rettype != proc->prorettype ||
+				memcmp(hostjit_func_catalog[i].func_argtypes,
+					   proc->proargtypes.values,
+					   sizeof(Oid) * proc->pronargs) != 0)
+				continue;
+			index = i;
+			break;
+		}
+	}
+	ReleaseSysCache(tuple);
+
+	return index;
+}
+
+/*
+ * hostjit_temp_alloc - declares a pair of temporary variables
+ */
+static int
+hostjit_temp_alloc(hostjit_context *context, int type_index)
+{
+	int		temp = ++context->ntemps;
+
+	appendStringInfo(&context->decl,
+					 "  %s v%d = 0;\n"
+					 "  char n%d = 1;\n",
+					 hostjit_type_catalog[type_index].type_cname, temp, temp);
+	return temp;
+}
+
+/*
+ * hostjit_codegen_function - code of function invocation
+ */
+static int
+hostjit_codegen_function(Oid func_oid, List *args, hostjit_context *context)
+{
+	int			findex = hostjit_func_lookup(func_oid);
+	int			rindex;
+	const char *rtype;
+	const char *oper;
+	int			temp, a, b = 0;
+
+	if (findex < 0 ||
+		list_length(args) != hostjit_func_catalog[findex].func_nargs)
+		return -1;
+	rindex = hostjit_type_lookup(hostjit_func_catalog[findex].func_rettype);
+	if (rindex < 0)
+		return -1;
+	rtype = hostjit_type_catalog[rindex].type_cname;
+	oper = hostjit_func_catalog[findex].func_oper;
+
+	a = hostjit_codegen_walker(linitial(args), context);
+	if (a < 0)
+		return -1;
+	if (list_length(args) > 1)
+	{
+		b = hostjit_codegen_walker(lsecond(args), context);
+		if (b < 0)
+			return -1;
+	}
+	temp = hostjit_temp_alloc(context, rindex);
+
+	/* strict function returns NULL if any NULL argument */
+	if (list_length(args) > 1)
+		appendStringInfo(&context->body,
+						 "  if (!n%d && !n%d)\n"
+						 "  {\n"
+						 "    n%d = 0;\n", a, b, temp);
+	else
+		appendStringInfo(&context->body,
+						 "  if (!n%d)\n"
+						 "  {\n"
+						 "    n%d = 0;\n", a, temp);
+
+	switch (hostjit_func_catalog[findex].func_class)
+	{
+		case HJFUNC_COMPARE:
+			if (hostjit_type_catalog[rindex].type_oid != BOOLOID)
+				elog(ERROR, "Bug? comparison function must return bool");
+			if (hostjit_func_catalog[findex].func_argtypes[0] == FLOAT4OID ||
+				hostjit_func_catalog[findex].func_argtypes[0] == FLOAT8OID)
+				appendStringInfo(&context->body,
+								 "    if (isnan(v%d) || isnan(v%d))\n"
+								 "      return -1;\n", a, b);
+			appendStringInfo(&context->body,
+							 "    v%d = (v%d %s v%d);\n",
+							 temp, a, oper, b);
+			break;
+
+		case HJFUNC_ARITH:
+			if (hostjit_type_catalog[rindex].type_is_float)
+			{
+				appendStringInfo(&context->body,
+								 "    v%d = (%s)v%d %s (%s)v%d;\n"
+								 "    if (!isfinite(v%d))\n"
+								 "      return -1;\n",
+								 temp, rtype, a,
+								 strcmp(oper, "add") == 0 ? "+" :
+								 strcmp(oper, "sub") == 0 ? "-" : "*",
+								 rtype, b, temp);
+				if (strcmp(oper, "mul") == 0)
+					appendStringInfo(&context->body,
+									 "    if (v%d == 0.0 && v%d != 0.0 && "
+									 "v%d != 0.0)\n"
+									 "      return -1;\n", temp, a, b);
+			}
+			else
+				appendStringInfo(&context->body,
+								 "    if (__builtin_%s_overflow((%s)v%d, "
+								 "(%s)v%d, &v%d))\n"
+								 "      return -1;\n",
+								 oper, rtype, a, rtype, b, temp);
+			break;
+
+		case HJFUNC_DIVIDE:
+			if (hostjit_type_catalog[rindex].type_is_float)
+				appendStringInfo(&context->body,
+								 "    if (v%d == 0.0)\n"
+								 "      return -1;\n"
+								 "    v%d = (%s)v%d / (%s)v%d;\n"
+								 "    if (!isfinite(v%d) || "
+								 "(v%d == 0.0 && v%d != 0.0))\n"
+								 "      return -1;\n",
+								 b, temp, rtype, a, rtype, b,
+								 temp, temp, a);
+			else
+				appendStringInfo(&context->body,
+								 "    if (v%d == 0)\n"
+								 "      return -1;\n"
+								 "    else if (v%d == -1)\n"
+								 "    {\n"
+								 "      if (__builtin_sub_overflow((%s)0, "
+								 "(%s)v%d, &v%d))\n"
+								 "        return -1;\n"
+								 "    }\n"
+								 "    else\n"
+								 "      v%d = (%s)v%d / (%s)v%d;\n",
+								 b, b, rtype, rtype, a, temp,
+								 temp, rtype, a, rtype, b);
+			break;
+
+		case HJFUNC_UMINUS:
+			if (hostjit_type_catalog[rindex].type_is_float)
+				appendStringInfo(&context->body,
+								 "    v%d = -v%d;\n", temp, a);
+			else
+				appendStringInfo(&context->body,
+								 "    if (__builtin_sub_overflow((%s)0, "
+								 "v%d, &v%d))\n"
+								 "      return -1;\n",
+								 rtype, a, temp);
+			break;
+
+		default:
+			elog(ERROR, "unexpected host JIT function class: %d",
+				 hostjit_func_catalog[findex].func_class);
+	}
+	appendStringInfo(&context->body, "  }\n");
+
+	return temp;
+}
+
+/*
+ * hostjit_codegen_bool_args - code of AND/OR with short-circuit
+ *
+ * It follows the three-value logic of SQL; AND returns false if any false
+ * argument, then NULL if any NULL argument. OR is symmetric.
+ */
+static int
+hostjit_codegen_bool_args(List *args, bool is_and, hostjit_context *context)
+{
+	int			temp = hostjit_temp_alloc(context, hostjit_type_lookup(BOOLOID));
+	ListCell   *lc;
+
+	appendStringInfo(&context->body,
+					 "  v%d = %d;\n"
+					 "  n%d = 0;\n"
+					 "  do {\n",
+					 temp, is_and ? 1 : 0, temp);
+	foreach (lc, args)
+	{
+		int		arg = hostjit_codegen_walker(lfirst(lc), context);
+
+		if (arg < 0)
+			return -1;
+		appendStringInfo(&context->body,
+						 "  if (!n%d && %sv%d)\n"
+						 "  {\n"
+						 "    v%d = %d;\n"
+						 "    n%d = 0;\n"
+						 "    break;\n"
+						 "  }\n"
+						 "  if (n%d)\n"
+						 "    n%d = 1;\n",
+						 arg, is_and ? "!" : "", arg,
+						 temp, is_and ? 0 : 1,
+						 temp,
+						 arg, temp);
+	}
+	appendStringInfo(&context->body,
+					 "  } while(0);\n");
+	return temp;
+}
+
+/*
+ * hostjit_codegen_walker - returns the index of temporary variable that
+ * holds the result of the expression, or -1 if not supported.
+ */
+static int
+hostjit_codegen_walker(Node *node, hostjit_context *context)
+{
+	int		index;
+	int		temp;
+
+	if (node == NULL)
+		return -1;
+
+	if (IsA(node, Const))
+	{
+		Const  *con = (Const *) node;
+
+		index = hostjit_type_lookup(con->consttype);
+		if (index < 0)
+			return -1;
+		temp = hostjit_temp_alloc(context, index);
+		if (!con->constisnull)
+			appendStringInfo(&context->body,
+							 "  v%d = %s((uintptr_t)" UINT64_FORMAT "ULL);\n"
+							 "  n%d = 0;\n",
+							 temp, hostjit_type_catalog[index].type_fetch,
+							 (uint64) con->constvalue,
+							 temp);
+		return temp;
+	}
+	else if (IsA(node, Var))
+	{
+		Var	   *var = (Var *) node;
+
+		/* only user columns of the scan tuple */
+		if (var->varno == INNER_VAR ||
+			var->varno == OUTER_VAR ||
+			var->varattno <= 0 ||
+			var->varlevelsup > 0)
+			return -1;
+		index = hostjit_type_lookup(var->vartype);
+		if (index < 0)
+			return -1;
+		temp = hostjit_temp_alloc(context, index);
+		appendStringInfo(&context->body,
+						 "  v%d = %s(values[%d]);\n"
+						 "  n%d = isnull[%d];\n",
+						 temp, hostjit_type_catalog[index].type_fetch,
+						 var->varattno - 1,
+						 temp, var->varattno - 1);
+		context->max_attno = Max(context->max_attno, var->varattno);
+		return temp;
+	}
+	else if (IsA(node, RelabelType))
+	{
+		RelabelType *relabel = (RelabelType *) node;
+		int		rindex = hostjit_type_lookup(relabel->resulttype);
+
+		index = hostjit_type_lookup(exprType((Node *) relabel->arg));
+		if (index < 0 || rindex < 0 ||
+			strcmp(hostjit_type_catalog[index].type_cname,
+				   hostjit_type_catalog[rindex].type_cname) != 0)
+			return -1;
+		return hostjit_codegen_walker((Node *) relabel->arg, context);
+	}
+	else if (IsA(node, FuncExpr))
+	{
+		FuncExpr   *func = (FuncExpr *) node;
+
+		if (func->funcretset)
+			return -1;
+		return hostjit_codegen_function(func->funcid, func->args, context);
+	}
+	else if (IsA(node, OpExpr))
+	{
+		OpExpr	   *op = (OpExpr *) node;
+
+		if (op->opretset)
+			return -1;
+		return hostjit_codegen_function(get_opcode(op->opno),
+										op->args, context);
+	}
+	else if (IsA(node, BoolExpr))
+	{
+		BoolExpr   *b = (BoolExpr *) node;
+		int			arg;
+
+		if (b->boolop == AND_EXPR)
+			return hostjit_codegen_bool_args(b->args, true, context);
+		else if (b->boolop == OR_EXPR)
+			return hostjit_codegen_bool_args(b->args, false, context);
+		Assert(b->boolop == NOT_EXPR && list_length(b->args) == 1);
+		arg = hostjit_codegen_walker(linitial(b->args), context);
+		if (arg < 0)
+			return -1;
+		temp = hostjit_temp_alloc(context, hostjit_type_lookup(BOOLOID));
+		appendStringInfo(&context->body,
+						 "  v%d = !v%d;\n"
+						 "  n%d = n%d;\n",
+						 temp, arg, temp, arg);
+		return temp;
+	}
+	else if (IsA(node, NullTest))
+	{
+		NullTest   *nulltest = (NullTest *) node;
+		int			arg;
+
+		if (nulltest->argisrow)
+			return -1;
+		arg = hostjit_codegen_walker((Node *) nulltest->arg, context);
+		if (arg < 0)
+			return -1;
+		temp = hostjit_temp_alloc(context, hostjit_type_lookup(BOOLOID));
+		appendStringInfo(&context->body,
+						 "  v%d = %sn%d;\n"
+						 "  n%d = 0;\n",
+						 temp,
+						 nulltest->nulltesttype == IS_NULL ? "" : "!",
+						 arg, temp);
+		return temp;
+	}
+	else if (IsA(node, List))
+	{
+		/* implicitly-ANDed qualifiers */
+		return hostjit_codegen_bool_args((List *) node, true, context);
+	}
+	return -1;
+}
+
+/*
+ * pgstrom_hostjit_create_quals
+ *
+ * It constructs a source of the host JIT code for the supplied qualifiers,
+ * if supported. Build of the shared object is deferred to the first call
+ * of pgstrom_hostjit_exec_quals, because it is needed only when GPU kernel
+ * returned StromError_CpuReCheck.
+ */
+pgstrom_hostjit *
+pgstrom_hostjit_create_quals(Node *quals)
+{
+	pgstrom_hostjit *hjit;
+	hostjit_context	context;
+	StringInfoData	source;
+	int				result;
+
+	if (!pgstrom_hostjit_enabled || quals == NULL)
+		return NULL;
+
+	memset(&context, 0, sizeof(hostjit_context));
+	initStringInfo(&context.decl);
+	initStringInfo(&context.body);
+
+	result = hostjit_codegen_walker(quals, &context);
+	if (result < 0)
+	{
+		pfree(context.decl.data);
+		pfree(context.body.data);
+		return NULL;
+	}
+
+	initStringInfo(&source);
+	appendStringInfo(&source,
+					 "%s"
+					 "int\n"
+					 "pgstrom_hostjit_quals(uintptr_t *values, char *isnull)\n"
+					 "{\n"
+					 "%s\n"
+					 "%s\n"
+					 "  return (!n%d && v%d) ? 1 : 0;\n"
+					 "}\n",
+					 hostjit_code_prelude,
+					 context.decl.data,
+					 context.body.data,
+					 result, result);
+	pfree(context.decl.data);
+	pfree(context.body.data);
+
+	hjit = palloc0(sizeof(pgstrom_hostjit));
+	hjit->source = source.data;
+	hjit->max_attno = context.max_attno;
+	hjit->load_tried = false;
+	hjit->qual_func = NULL;
+
+	return hjit;
+}
+
+/*
+ * hostjit_check_source
+ *
+ * It checks whether the source file built to the existing shared object
+ * is identical to the supplied one. File name of the shared object is
+ * derived from the digest of the source, so it protects us from reuse of
+ * a shared object built from another source, even if digest collides.
+ */
+static bool
+hostjit_check_source(const char *srcpath, const char *source)
+{
+	size_t		length = strlen(source);
+	char	   *buffer;
+	FILE	   *filp;
+	size_t		nbytes;
+	bool		result;
+
+	filp = AllocateFile(srcpath, PG_BINARY_R);
+	if (!filp)
+	{
+		elog(LOG, "could not open \"%s\": %m", srcpath);
+		return false;
+	}
+	/* read one more byte to detect longer file */
+	buffer = palloc(length + 1);
+	nbytes = fread(buffer, 1, length + 1, filp);
+	FreeFile(filp);
+
+	result = (nbytes == length && memcmp(buffer, source, length) == 0);
+	pfree(buffer);
+
+	return result;
+}
+
+/*
+ * hostjit_build_shared_object
+ *
+ * It compiles the source of host JIT code, if no shared object with the
+ * same source is built yet. Any failures are not critical, because the
+ * caller can evaluate the expression using the executor.
+ *
+ * The source is kept next to the shared object, to ensure the shared object
+ * is built from the identical source prior to the reuse. The shared object
+ * is loaded using dlopen(3) directly, not load_external_function(), because
+ * it is not a PostgreSQL module; it has no PG_MODULE_MAGIC and does not
+ * depend on any PostgreSQL headers.
+ */
+static void
+hostjit_build_shared_object(pgstrom_hostjit *hjit)
+{
+	char			tempdirpath[MAXPGPATH];
+	char			basepath[MAXPGPATH];
+	char			srcpath[MAXPGPATH];
+	char			sopath[MAXPGPATH];
+	char			temppath[MAXPGPATH];
+	char			command[MAXPGPATH * 4];
+	char			digest[33];
+	struct stat		stbuf;
+	FILE		   *filp;
+	void		   *handle;
+	void		   *qual_func;
+	int				rc;
+
+	hjit->load_tried = true;
+
+	if (!pg_md5_hash(hjit->source, strlen(hjit->source), digest))
+	{
+		elog(LOG, "out of memory on digest of host JIT code");
+		return;
+	}
+
+	snprintf(tempdirpath, sizeof(tempdirpath), "%s/base/%s",
+			 DataDir, PG_TEMP_FILES_DIR);
+	snprintf(basepath, sizeof(basepath), "%s/%s_strom_hostjit_%s",
+			 tempdirpath, PG_TEMP_FILE_PREFIX, digest);
+	snprintf(srcpath, sizeof(srcpath), "%s.c", basepath);
+	snprintf(sopath, sizeof(sopath), "%s.so", basepath);
+
+	/* reuse the shared object, if already built by someone */
+	if (stat(sopath, &stbuf) == 0)
+	{
+		if (!hostjit_check_source(srcpath, hjit->source))
+		{
+			elog(LOG, "host JIT code \"%s\" was built from another source",
+				 sopath);
+			return;
+		}
+	}
+	else
+	{
+		if (errno != ENOENT)
+		{
+			elog(LOG, "could not stat \"%s\": %m", sopath);
+			return;
+		}
+		/* may be the first time in this database cluster */
+		mkdir(tempdirpath, S_IRWXU);
+
+		snprintf(temppath, sizeof(temppath), "%s.%d.c", basepath, MyProcPid);
+		filp = AllocateFile(temppath, PG_BINARY_W);
+		if (!filp)
+		{
+			elog(LOG, "could not open \"%s\": %m", temppath);
+			return;
+		}
+		if (fputs(hjit->source, filp) < 0)
+		{
+			elog(LOG, "could not write \"%s\": %m", temppath);
+			FreeFile(filp);
+			unlink(temppath);
+			return;
+		}
+		FreeFile(filp);
+
+		/*
+		 * Build a shared object on the temporary name, then rename it;
+		 * concurrent backends may build the same source at the same time.
+		 * The source file is renamed prior to the shared object, so the
+		 * source always exists if someone can find the shared object.
+		 */
+		snprintf(command, sizeof(command),
+				 "%s -O2 -fPIC -shared -o \"%s.%d.so\" \"%s\"",
+				 pgstrom_hostjit_compiler,
+				 basepath, MyProcPid, temppath);
+		rc = system(command);
+		if (rc != 0)
+		{
+			elog(LOG, "failed on host JIT build (rc=%d): %s", rc, command);
+			unlink(temppath);
+			snprintf(temppath, sizeof(temppath), "%s.%d.so",
+					 basepath, MyProcPid);
+			unlink(temppath);
+			return;
+		}
+		if (rename(temppath, srcpath) != 0)
+		{
+			elog(LOG, "could not rename \"%s\" to \"%s\": %m",
+				 temppath, srcpath);
+			unlink(temppath);
+			snprintf(temppath, sizeof(temppath), "%s.%d.so",
+					 basepath, MyProcPid);
+			unlink(temppath);
+			return;
+		}
+
+		snprintf(temppath, sizeof(temppath), "%s.%d.so",
+				 basepath, MyProcPid);
+		if (rename(temppath, sopath) != 0)
+		{
+			elog(LOG, "could not rename \"%s\" to \"%s\": %m",
+				 temppath, sopath);
+			unlink(temppath);
+			return;
+		}
+	}
+
+	/*
+	 * dlopen(3) returns the same handle for the same path, so we don't
+	 * need to cache the handle by ourselves. It is never closed until
+	 * exit of the backend, like the dynamic loader of PostgreSQL.
+	 */
+	handle = dlopen(sopath, RTLD_NOW | RTLD_LOCAL);
+	if (!handle)
+	{
+		elog(LOG, "could not load host JIT code \"%s\": %s",
+			 sopath, dlerror());
+		return;
+	}
+	qual_func = dlsym(handle, "pgstrom_hostjit_quals");
+	if (!qual_func)
+	{
+		elog(LOG, "could not find pgstrom_hostjit_quals in \"%s\": %s",
+			 sopath, dlerror());
+		return;
+	}
+	hjit->qual_func = (int (*)(Datum *, bool *)) qual_func;
+}
+
+/*
+ * pgstrom_hostjit_exec_quals
+ *
+ * It evaluates the qualifiers on the ecxt_scantuple of the supplied
+ * econtext, using the host JIT code if available. Elsewhere, it falls
+ * back to the executor with qual_state.
+ */
+bool
+pgstrom_hostjit_exec_quals(pgstrom_hostjit *hjit, List *qual_state,
+						   ExprContext *econtext)
+{
+	if (hjit != NULL)
+	{
+		TupleTableSlot *slot = econtext->ecxt_scantuple;
+		int				rc;
+
+		if (!hjit->load_tried)
+			hostjit_build_shared_object(hjit);
+
+		if (hjit->qual_func != NULL)
+		{
+			if (hjit->max_attno > 0)
+				slot_getsomeattrs(slot, hjit->max_attno);
+			rc = hjit->qual_func(slot->tts_values, slot->tts_isnull);
+			if (rc >= 0)
+				return (rc > 0);
+		}
+	}
+	return ExecQual(qual_state, econtext, false);
+}
+
+/*
+ * pgstrom_init_hostjit
+ */
+void
+pgstrom_init_hostjit(void)
+{
+	/* pg_strom.enable_hostjit */
+	DefineCustomBoolVariable("pg_strom.enable_hostjit",
+							 "Enables host JIT code on CPU fallback",
+							 NULL,
+							 &pgstrom_hostjit_enabled,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.hostjit_compiler */
+	DefineCustomStringVariable("pg_strom.hostjit_compiler",
+							   "C compiler to build host JIT code",
+							   NULL,
+							   &pgstrom_hostjit_compiler,
+							   "cc",
+							   PGC_SUSET,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+}
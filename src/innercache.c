@@ -0,0 +1,685 @@
+/*
+ * innercache.c
+ *
+ * Shared cache of the inner hash-tables built by GpuHashJoin
+ * ----
+ * Copyright 2011-2016 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2016 (C) The PG-Strom Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "postgres.h"
+#include "access/visibilitymap.h"
+#include "catalog/catalog.h"
+#include "catalog/pg_class.h"
+#include "executor/executor.h"
+#include "lib/stringinfo.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "port/atomics.h"
+#include "storage/bufmgr.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "storage/smgr.h"
+#include "utils/guc.h"
+#include "utils/pg_crc.h"
+#include "utils/rel.h"
+#include "utils/resowner.h"
+#include "pg_strom.h"
+
+/*
+ * Inner hash-table cache
+ *
+ * A KDS_FORMAT_HASH buffer built on a plain scan of a table is kept on
+ * the shared memory segment, then other queries which join the same
+ * table with the same hash-keys and projection can reuse the image
+ * without scan and hash-table build.
+ *
+ * Validity of the cached image is checked by the relation signature;
+ * number of blocks and the latest LSN of the visibility-map pages. We
+ * only cache relations whose pages are all-visible, so any tuples are
+ * visible to all the snapshots. Once a modification clears a bit of
+ * the visibility-map, the relation is not cacheable until VACUUM sets
+ * it again with a new WAL record, so the LSN tells us the image is
+ * stale. TRUNCATE or rewrite of the table changes relfilenode, which
+ * is a part of the cache key.
+ *
+ * The cache is protected by an LWLock; lookup acquires it in shared mode,
+ * and store or eviction acquires it in exclusive mode. Lookup can update
+ * only the atomic fields (refcnt, nhits and last_used), so the LRU order
+ * is not a list, but a logical clock of the last usage. A backend pins
+ * the entry by refcnt while it copies the image without the lock. The
+ * pinned entry is tracked by the backend, so it is unpinned on the
+ * transaction abort or process exit, even if the copy is interrupted.
+ */
+typedef struct
+{
+	dlist_node		addr_chain;	/* link to address ordered list */
+	dlist_node		hash_chain;	/* link to hash slot, or free list */
+	Size			length;		/* length of the block including header */
+	bool			is_free;	/* true, if free block */
+	bool			is_valid;	/* true, if entry is available to lookup */
+	pg_atomic_uint32 refcnt;	/* number of backends copying the entry */
+	pg_atomic_uint32 last_used;	/* logical clock of the last usage */
+	pg_crc32		hash;		/* hash value of the cache key */
+	Oid				database_oid;
+	Oid				relid;
+	BlockNumber		nblocks;	/* signature: number of blocks */
+	XLogRecPtr		vm_lsn;		/* signature: latest LSN of VM pages */
+	pg_atomic_uint32 nhits;		/* number of cache hits */
+	Size			key_len;	/* length of the cache key */
+	Size			kds_offset;	/* offset to the KDS image from the head */
+	Size			kds_length;	/* length of the KDS image */
+	char			data[FLEXIBLE_ARRAY_MEMBER];
+} innercache_entry;
+
+#define ICACHE_MIN_BLOCKSZ		(64 * 1024)		/* 64KB */
+#define ICACHE_HASH_SIZE		256
+
+#define ICACHE_LWLOCK_TRANCHE	"PG-Strom inner cache"
+
+typedef struct
+{
+	LWLock	   *lock;
+	pg_atomic_uint32 clock;		/* logical clock for LRU eviction */
+	dlist_head	addr_list;		/* all the blocks in address order */
+	dlist_head	free_list;		/* free blocks */
+	dlist_head	active_list[ICACHE_HASH_SIZE];
+	char		data[FLEXIBLE_ARRAY_MEMBER];
+} innercache_head;
+
+/* ---- GUC variables ---- */
+static Size		inner_cache_size;
+static bool		pgstrom_enable_inner_cache;
+
+/* ---- static variables ---- */
+static shmem_startup_hook_type shmem_startup_next;
+static innercache_head *icache_head = NULL;
+static innercache_entry *icache_pinned = NULL;	/* entry pinned by myself */
+static bool		icache_callback_registered = false;
+
+/*
+ * innercache_relation_signature
+ *
+ * It returns the current signature of the relation, or false if relation
+ * is not cacheable right now.
+ */
+static bool
+innercache_relation_signature(Relation rel, pgstrom_inner_cache_sign *sign)
+{
+	BlockNumber		nblocks;
+	BlockNumber		nvisible;
+	BlockNumber		vm_nblocks = 0;
+	BlockNumber		blkno;
+	XLogRecPtr		vm_lsn = InvalidXLogRecPtr;
+
+	memset(sign, 0, sizeof(pgstrom_inner_cache_sign));
+	nblocks = RelationGetNumberOfBlocks(rel);
+#if PG_VERSION_NUM < 90600
+	nvisible = visibilitymap_count(rel);
+#else
+	visibilitymap_count(rel, &nvisible, NULL);
+#endif
+	if (nvisible < nblocks)
+		return false;
+
+	RelationOpenSmgr(rel);
+	if (smgrexists(rel->rd_smgr, VISIBILITYMAP_FORKNUM))
+		vm_nblocks = smgrnblocks(rel->rd_smgr, VISIBILITYMAP_FORKNUM);
+	for (blkno=0; blkno < vm_nblocks; blkno++)
+	{
+		Buffer		buffer;
+		XLogRecPtr	lsn;
+
+		buffer = ReadBufferExtended(rel, VISIBILITYMAP_FORKNUM, blkno,
+									RBM_NORMAL, NULL);
+		LockBuffer(buffer, BUFFER_LOCK_SHARE);
+		lsn = PageGetLSN(BufferGetPage(buffer));
+		UnlockReleaseBuffer(buffer);
+
+		if (vm_lsn < lsn)
+			vm_lsn = lsn;
+	}
+	sign->valid = true;
+	sign->nblocks = nblocks;
+	sign->vm_lsn = vm_lsn;
+
+	return true;
+}
+
+/*
+ * pgstrom_inner_cache_key
+ *
+ * It constructs a cache key of the inner relation if it is cacheable.
+ * Right now, only a plain SeqScan without any qualifiers and parameters,
+ * and with simple Var projection, is supported. Hash-keys also have to
+ * be simple Var references.
+ */
+char *
+pgstrom_inner_cache_key(PlanState *ps, List *hash_inner_keys,
+						JoinType join_type, int hash_function)
+{
+	Plan		   *plan = ps->plan;
+	Relation		rel;
+	StringInfoData	str;
+	ListCell	   *lc;
+
+	if (!icache_head || !pgstrom_enable_inner_cache)
+		return NULL;
+	if (!IsA(ps, SeqScanState) ||
+		plan->qual != NIL ||
+		!bms_is_empty(plan->allParam))
+		return NULL;
+
+	rel = ((ScanState *) ps)->ss_currentRelation;
+	if (RelationGetForm(rel)->relkind != RELKIND_RELATION ||
+		!RelationNeedsWAL(rel) ||
+		IsCatalogRelation(rel))
+		return NULL;
+
+	initStringInfo(&str);
+	appendStringInfo(&str, "%u/%u/%u jtype=%d hfunc=%d tlist=",
+					 MyDatabaseId,
+					 RelationGetRelid(rel),
+					 rel->rd_node.relNode,
+					 (int) join_type,
+					 hash_function);
+	foreach (lc, plan->targetlist)
+	{
+		TargetEntry *tle = lfirst(lc);
+		Var		   *var = (Var *) tle->expr;
+
+		if (!IsA(var, Var) || var->varattno <= 0)
+			goto not_cacheable;
+		appendStringInfo(&str, "%s%d:%u:%d",
+						 lc == list_head(plan->targetlist) ? "" : ",",
+						 var->varattno, var->vartype, var->vartypmod);
+	}
+	appendStringInfoString(&str, " keys=");
+	foreach (lc, hash_inner_keys)
+	{
+		Node	   *expr = lfirst(lc);
+		Oid			type_oid = exprType(expr);
+
+		if (IsA(expr, RelabelType))
+			expr = (Node *)((RelabelType *) expr)->arg;
+		if (!IsA(expr, Var))
+			goto not_cacheable;
+		appendStringInfo(&str, "%s%d:%u",
+						 lc == list_head(hash_inner_keys) ? "" : ",",
+						 ((Var *) expr)->varattno, type_oid);
+	}
+	return str.data;
+
+not_cacheable:
+	pfree(str.data);
+	return NULL;
+}
+
+/*
+ * innercache_free - release the block, and merge with neighbors if free
+ *
+ * caller must hold icache_head->lock in exclusive mode
+ */
+static void
+innercache_free(innercache_entry *entry)
+{
+	innercache_entry *buddy;
+	dlist_node	   *dnode;
+
+	Assert(!entry->is_free && pg_atomic_read_u32(&entry->refcnt) == 0);
+	if (entry->is_valid)
+		dlist_delete(&entry->hash_chain);
+	entry->is_free = true;
+	entry->is_valid = false;
+
+	/* merge with the next block */
+	if (dlist_has_next(&icache_head->addr_list, &entry->addr_chain))
+	{
+		dnode = dlist_next_node(&icache_head->addr_list, &entry->addr_chain);
+		buddy = dlist_container(innercache_entry, addr_chain, dnode);
+		if (buddy->is_free)
+		{
+			dlist_delete(&buddy->hash_chain);
+			dlist_delete(&buddy->addr_chain);
+			entry->length += buddy->length;
+		}
+	}
+	/* merge with the previous block */
+	if (dlist_has_prev(&icache_head->addr_list, &entry->addr_chain))
+	{
+		dnode = dlist_prev_node(&icache_head->addr_list, &entry->addr_chain);
+		buddy = dlist_container(innercache_entry, addr_chain, dnode);
+		if (buddy->is_free)
+		{
+			dlist_delete(&entry->addr_chain);
+			buddy->length += entry->length;
+			return;
+		}
+	}
+	dlist_push_head(&icache_head->free_list, &entry->hash_chain);
+}
+
+/*
+ * innercache_drop - remove the entry from the lookup path
+ *
+ * caller must hold icache_head->lock in exclusive mode
+ */
+static void
+innercache_drop(innercache_entry *entry)
+{
+	Assert(entry->is_valid);
+	dlist_delete(&entry->hash_chain);
+	memset(&entry->hash_chain, 0, sizeof(dlist_node));
+	entry->is_valid = false;
+	/* entries being copied are released by the last one */
+	if (pg_atomic_read_u32(&entry->refcnt) == 0)
+		innercache_free(entry);
+}
+
+/*
+ * innercache_alloc - first-fit allocation with LRU eviction
+ *
+ * caller must hold icache_head->lock in exclusive mode
+ */
+static innercache_entry *
+innercache_alloc(Size required)
+{
+	innercache_entry *entry;
+	dlist_iter		iter;
+
+	required = Max(MAXALIGN(required), ICACHE_MIN_BLOCKSZ);
+	for (;;)
+	{
+		dlist_foreach(iter, &icache_head->free_list)
+		{
+			entry = dlist_container(innercache_entry, hash_chain, iter.cur);
+			Assert(entry->is_free);
+			if (entry->length < required)
+				continue;
+
+			dlist_delete(&entry->hash_chain);
+			/* split the remaining portion, if large enough */
+			if (entry->length - required >= ICACHE_MIN_BLOCKSZ)
+			{
+				innercache_entry *rest = (innercache_entry *)
+					((char *)entry + required);
+
+				memset(rest, 0, offsetof(innercache_entry, data));
+				rest->length = entry->length - required;
+				rest->is_free = true;
+				dlist_insert_after(&entry->addr_chain, &rest->addr_chain);
+				dlist_push_head(&icache_head->free_list, &rest->hash_chain);
+				entry->length = required;
+			}
+			entry->is_free = false;
+			entry->is_valid = false;
+			pg_atomic_init_u32(&entry->refcnt, 0);
+			pg_atomic_init_u32(&entry->last_used, 0);
+			pg_atomic_init_u32(&entry->nhits, 0);
+			memset(&entry->hash_chain, 0, sizeof(dlist_node));
+			return entry;
+		}
+
+		/* evict the least recently used entry, not in use */
+		entry = NULL;
+		dlist_foreach(iter, &icache_head->addr_list)
+		{
+			innercache_entry *temp = dlist_container(innercache_entry,
+													 addr_chain, iter.cur);
+			if (!temp->is_valid ||
+				pg_atomic_read_u32(&temp->refcnt) > 0)
+				continue;
+			/* logical clock may wrap around */
+			if (!entry ||
+				(int32)(pg_atomic_read_u32(&temp->last_used) -
+						pg_atomic_read_u32(&entry->last_used)) < 0)
+				entry = temp;
+		}
+		if (!entry)
+			return NULL;
+		innercache_drop(entry);
+	}
+}
+
+/*
+ * innercache_lookup_entry
+ *
+ * caller must hold icache_head->lock in either mode
+ */
+static innercache_entry *
+innercache_lookup_entry(const char *key, Size key_len, pg_crc32 hash)
+{
+	int			hindex = hash % ICACHE_HASH_SIZE;
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &icache_head->active_list[hindex])
+	{
+		innercache_entry *entry = dlist_container(innercache_entry,
+												  hash_chain, iter.cur);
+		Assert(entry->is_valid);
+		if (entry->hash == hash &&
+			entry->database_oid == MyDatabaseId &&
+			entry->key_len == key_len &&
+			memcmp(entry->data, key, key_len) == 0)
+			return entry;
+	}
+	return NULL;
+}
+
+static pg_crc32
+innercache_key_hash(const char *key, Size key_len)
+{
+	pg_crc32	hash;
+
+	INIT_LEGACY_CRC32(hash);
+	COMP_LEGACY_CRC32(hash, key, key_len);
+	FIN_LEGACY_CRC32(hash);
+
+	return hash;
+}
+
+/*
+ * innercache_pin / innercache_unpin
+ *
+ * A pinned entry is never released nor reused by others. Backend pins at
+ * most one entry at a time, and tracks it to unpin on the error path.
+ */
+static void
+innercache_pin(innercache_entry *entry)
+{
+	Assert(icache_pinned == NULL);
+	pg_atomic_fetch_add_u32(&entry->refcnt, 1);
+	icache_pinned = entry;
+}
+
+static void
+innercache_unpin(innercache_entry *entry)
+{
+	bool		needs_free;
+
+	Assert(icache_pinned == entry);
+	icache_pinned = NULL;
+
+	LWLockAcquire(icache_head->lock, LW_SHARED);
+	needs_free = (pg_atomic_sub_fetch_u32(&entry->refcnt, 1) == 0 &&
+				  !entry->is_valid);
+	LWLockRelease(icache_head->lock);
+
+	/* the last one releases the entry already dropped */
+	if (needs_free)
+	{
+		LWLockAcquire(icache_head->lock, LW_EXCLUSIVE);
+		if (!entry->is_free &&
+			!entry->is_valid &&
+			pg_atomic_read_u32(&entry->refcnt) == 0)
+			innercache_free(entry);
+		LWLockRelease(icache_head->lock);
+	}
+}
+
+/*
+ * innercache_cleanup_callback / innercache_exit_callback
+ *
+ * It unpins the entry on transaction abort or process exit.
+ */
+static void
+innercache_cleanup_callback(ResourceReleasePhase phase,
+							bool isCommit,
+							bool isTopLevel,
+							void *arg)
+{
+	if (phase == RESOURCE_RELEASE_AFTER_LOCKS &&
+		icache_pinned != NULL)
+	{
+		if (isCommit)
+			elog(WARNING, "inner cache entry is still pinned at commit");
+		innercache_unpin(icache_pinned);
+	}
+}
+
+static void
+innercache_exit_callback(int code, Datum arg)
+{
+	if (icache_pinned != NULL)
+		innercache_unpin(icache_pinned);
+}
+
+static void
+innercache_register_callbacks(void)
+{
+	if (!icache_callback_registered)
+	{
+		RegisterResourceReleaseCallback(innercache_cleanup_callback, NULL);
+		on_shmem_exit(innercache_exit_callback, 0);
+		icache_callback_registered = true;
+	}
+}
+
+/*
+ * pgstrom_inner_cache_lookup
+ *
+ * It returns a PDS copied from the cache entry, or NULL if not found.
+ * The current signature of the relation is saved on *sign, to be checked
+ * again when the caller stores its own image.
+ */
+pgstrom_data_store *
+pgstrom_inner_cache_lookup(GpuContext *gcontext,
+						   PlanState *ps,
+						   const char *key,
+						   pgstrom_inner_cache_sign *sign)
+{
+	Relation		rel = ((ScanState *) ps)->ss_currentRelation;
+	TupleDesc		tupdesc = ps->ps_ResultTupleSlot->tts_tupleDescriptor;
+	Size			key_len = strlen(key);
+	pg_crc32		hash = innercache_key_hash(key, key_len);
+	innercache_entry *entry;
+	pgstrom_data_store *pds = NULL;
+
+	Assert(icache_head != NULL);
+	if (!innercache_relation_signature(rel, sign))
+		return NULL;
+	innercache_register_callbacks();
+
+	LWLockAcquire(icache_head->lock, LW_SHARED);
+	entry = innercache_lookup_entry(key, key_len, hash);
+	if (!entry)
+	{
+		LWLockRelease(icache_head->lock);
+		return NULL;
+	}
+	if (entry->nblocks != sign->nblocks ||
+		entry->vm_lsn != sign->vm_lsn)
+	{
+		/* relation was modified since the cache build */
+		LWLockRelease(icache_head->lock);
+
+		LWLockAcquire(icache_head->lock, LW_EXCLUSIVE);
+		entry = innercache_lookup_entry(key, key_len, hash);
+		if (entry && (entry->nblocks != sign->nblocks ||
+					  entry->vm_lsn != sign->vm_lsn))
+			innercache_drop(entry);
+		LWLockRelease(icache_head->lock);
+		return NULL;
+	}
+	innercache_pin(entry);
+	pg_atomic_fetch_add_u32(&entry->nhits, 1);
+	pg_atomic_write_u32(&entry->last_used,
+						pg_atomic_fetch_add_u32(&icache_head->clock, 1));
+	LWLockRelease(icache_head->lock);
+
+	/* entry is unpinned by the callback on error */
+	pds = PDS_create_hash(gcontext, tupdesc, entry->kds_length);
+	memcpy(pds->kds, (char *)entry + entry->kds_offset,
+		   entry->kds_length);
+	Assert(pds->kds->length == entry->kds_length);
+
+	innercache_unpin(entry);
+
+	return pds;
+}
+
+/*
+ * pgstrom_inner_cache_store
+ *
+ * It saves the built hash-table on the cache, if the relation was not
+ * modified during the build.
+ */
+void
+pgstrom_inner_cache_store(PlanState *ps,
+						  const char *key,
+						  pgstrom_inner_cache_sign *sign,
+						  pgstrom_data_store *pds)
+{
+	Relation		rel = ((ScanState *) ps)->ss_currentRelation;
+	kern_data_store *kds = pds->kds;
+	Size			key_len = strlen(key);
+	pg_crc32		hash = innercache_key_hash(key, key_len);
+	pgstrom_inner_cache_sign curr;
+	innercache_entry *entry;
+	Size			kds_offset;
+
+	Assert(icache_head != NULL);
+	if (!sign->valid ||
+		!innercache_relation_signature(rel, &curr) ||
+		curr.nblocks != sign->nblocks ||
+		curr.vm_lsn != sign->vm_lsn)
+		return;
+	Assert(kds->format == KDS_FORMAT_HASH && kds->nslots > 0);
+	innercache_register_callbacks();
+
+	kds_offset = MAXALIGN(offsetof(innercache_entry, data) + key_len);
+	LWLockAcquire(icache_head->lock, LW_EXCLUSIVE);
+	if (innercache_lookup_entry(key, key_len, hash) != NULL ||
+		!(entry = innercache_alloc(kds_offset + kds->length)))
+	{
+		/* someone already stored, or too large to cache */
+		LWLockRelease(icache_head->lock);
+		return;
+	}
+	/* under construction; released by the callback on error */
+	innercache_pin(entry);
+	LWLockRelease(icache_head->lock);
+
+	entry->hash = hash;
+	entry->database_oid = MyDatabaseId;
+	entry->relid = RelationGetRelid(rel);
+	entry->nblocks = sign->nblocks;
+	entry->vm_lsn = sign->vm_lsn;
+	entry->key_len = key_len;
+	entry->kds_offset = kds_offset;
+	entry->kds_length = kds->length;
+	memcpy(entry->data, key, key_len);
+	memcpy((char *)entry + kds_offset, kds, kds->length);
+
+	LWLockAcquire(icache_head->lock, LW_EXCLUSIVE);
+	if (innercache_lookup_entry(key, key_len, hash) == NULL)
+	{
+		entry->is_valid = true;
+		pg_atomic_write_u32(&entry->last_used,
+							pg_atomic_fetch_add_u32(&icache_head->clock, 1));
+		dlist_push_head(&icache_head->active_list[hash % ICACHE_HASH_SIZE],
+						&entry->hash_chain);
+	}
+	LWLockRelease(icache_head->lock);
+
+	/* entry is released here, if concurrent store won */
+	innercache_unpin(entry);
+}
+
+/*
+ * pgstrom_startup_inner_cache
+ */
+static void
+pgstrom_startup_inner_cache(void)
+{
+	innercache_entry *entry;
+	bool		found;
+	int			i;
+
+	if (shmem_startup_next)
+		(*shmem_startup_next)();
+
+	icache_head = ShmemInitStruct("PG-Strom inner hash-table cache",
+								  inner_cache_size, &found);
+	if (found)
+		elog(ERROR, "Bug? shared memory for inner cache already exists");
+
+	memset(icache_head, 0, offsetof(innercache_head, data));
+#if PG_VERSION_NUM < 90600
+	icache_head->lock = LWLockAssign();
+#else
+	icache_head->lock = &(GetNamedLWLockTranche(ICACHE_LWLOCK_TRANCHE))->lock;
+#endif
+	pg_atomic_init_u32(&icache_head->clock, 0);
+	dlist_init(&icache_head->addr_list);
+	dlist_init(&icache_head->free_list);
+	for (i=0; i < ICACHE_HASH_SIZE; i++)
+		dlist_init(&icache_head->active_list[i]);
+
+	/* a large free block that covers the whole segment */
+	entry = (innercache_entry *) BUFFERALIGN(icache_head->data);
+	memset(entry, 0, offsetof(innercache_entry, data));
+	entry->length = ((char *) icache_head + inner_cache_size -
+					 (char *) entry);
+	entry->is_free = true;
+	dlist_push_tail(&icache_head->addr_list, &entry->addr_chain);
+	dlist_push_tail(&icache_head->free_list, &entry->hash_chain);
+}
+
+/*
+ * pgstrom_init_inner_cache
+ */
+void
+pgstrom_init_inner_cache(void)
+{
+	static int	__inner_cache_size;
+
+	/*
+	 * size of the shared inner hash-table cache; 0 disables the cache
+	 */
+	DefineCustomIntVariable("pg_strom.inner_cache_size",
+							"size of shared inner hash-table cache",
+							NULL,
+							&__inner_cache_size,
+							0,
+							0,
+							INT_MAX,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+	inner_cache_size = (Size)__inner_cache_size * 1024L;
+
+	/* turn on/off the inner cache per session */
+	DefineCustomBoolVariable("pg_strom.enable_inner_cache",
+							 "Enables the shared inner hash-table cache",
+							 NULL,
+							 &pgstrom_enable_inner_cache,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+
+	if (inner_cache_size > 0)
+	{
+		if (inner_cache_size < 4 * ICACHE_MIN_BLOCKSZ)
+			elog(ERROR, "pg_strom.inner_cache_size is too small");
+		/* allocation of static shared memory */
+		RequestAddinShmemSpace(inner_cache_size);
+#if PG_VERSION_NUM < 90600
+		RequestAddinLWLocks(1);
+#else
+		RequestNamedLWLockTranche(ICACHE_LWLOCK_TRANCHE, 1);
+#endif
+		shmem_startup_next = shmem_startup_hook;
+		shmem_startup_hook = pgstrom_startup_inner_cache;
+	}
+}
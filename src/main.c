@@ -17,20 +17,25 @@
  */
 #include "postgres.h"
 #include "access/hash.h"
+#include "catalog/pg_type.h"
 #include "fmgr.h"
+#include "funcapi.h"
 #include "miscadmin.h"
 #include "optimizer/clauses.h"
 #include "optimizer/cost.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/planner.h"
 #include "parser/parsetree.h"
+#include "portability/instr_time.h"
 #include "storage/ipc.h"
 #include "storage/pg_shmem.h"
 #include "storage/shmem.h"
 #include "utils/builtins.h"
 #include "utils/guc.h"
 #include "utils/lsyscache.h"
+#include "utils/pg_crc.h"
 #include "utils/ruleutils.h"
+#include "utils/tuplestore.h"
 #include <float.h>
 #include <limits.h>
 #include "pg_strom.h"
@@ -53,6 +58,7 @@ bool		pgstrom_cpu_fallback_enabled;
 int			pgstrom_max_async_tasks;
 double		pgstrom_num_threads_margin;
 double		pgstrom_chunk_size_margin;
+int			pgstrom_hash_function;
 
 /* cost factors */
 double		pgstrom_gpu_setup_cost;
@@ -60,6 +66,12 @@ double		pgstrom_gpu_dma_cost;
 double		pgstrom_gpu_operator_cost;
 double		pgstrom_gpu_tuple_cost;
 
+static const struct config_enum_entry pgstrom_hash_function_options[] = {
+	{"legacy_crc32",	HASHFUNC_LEGACY_CRC32,	false},
+	{"fasthash",		HASHFUNC_FASTHASH,		false},
+	{NULL, 0, false}
+};
+
 static void
 pgstrom_init_misc_guc(void)
 {
@@ -141,6 +153,16 @@ pgstrom_init_misc_guc(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* hash function for join/group keys */
+	DefineCustomEnumVariable("pg_strom.hash_function",
+							 "Hash function to be used for join/group keys",
+							 NULL,
+							 &pgstrom_hash_function,
+							 HASHFUNC_FASTHASH,
+							 pgstrom_hash_function_options,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/* cost factor for Gpu setup */
 	DefineCustomRealVariable("pg_strom.gpu_setup_cost",
 							 "Cost to setup GPU device to run",
@@ -207,8 +229,10 @@ pgstrom_recursive_grafter(PlannedStmt *pstmt, Plan *parent, Plan **p_curr_plan)
 			/*
 			 * Try to inject GpuPreAgg plan if cost of the aggregate plan
 			 * is enough expensive to justify preprocess by GPU.
+			 * Agg node may be replaced, if GpuPreAgg runs final aggregation.
 			 */
-			pgstrom_try_insert_gpupreagg(pstmt, (Agg *) plan);
+			plan = pgstrom_try_insert_gpupreagg(pstmt, (Agg *) plan);
+			*p_curr_plan = plan;
 			break;
 
 		case T_SubqueryScan:
@@ -363,6 +387,113 @@ pgstrom_planner_entrypoint(Query *parse,
 	return result;
 }
 
+/*
+ * pgstrom_hash_benchmark
+ *
+ * A micro benchmark of the hash functions for join/group keys; it
+ * computes hash values of 'nkeys' pseudo-random keys with 'keylen' bytes,
+ * for each hash function. The checksum is XOR of the hash values, to
+ * compare with the device side implementation.
+ */
+Datum
+pgstrom_hash_benchmark(PG_FUNCTION_ARGS)
+{
+	int32			keylen = PG_GETARG_INT32(0);
+	int32			nkeys = PG_GETARG_INT32(1);
+	ReturnSetInfo  *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc		tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext	oldcxt;
+	char		   *keys;
+	cl_uint			seed = 0x12345678U;
+	int				method;
+	Size			i, total;
+
+	if (!rsinfo || !IsA(rsinfo, ReturnSetInfo) ||
+		(rsinfo->allowedModes & SFRM_Materialize) == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (keylen < 1 || nkeys < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("keylen and nkeys must be positive")));
+	total = (Size) keylen * (Size) nkeys;
+	if (!AllocSizeIsValid(total))
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("too large benchmark data: %zu bytes", total)));
+
+	oldcxt = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+	tupdesc = CreateTemplateTupleDesc(5, false);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "hash_function",
+					   TEXTOID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "keylen",
+					   INT4OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "nkeys",
+					   INT4OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 4, "elapsed_ms",
+					   FLOAT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 5, "checksum",
+					   INT4OID, -1, 0);
+	tupdesc = BlessTupleDesc(tupdesc);
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+	MemoryContextSwitchTo(oldcxt);
+
+	/* pseudo-random keys; deterministic for comparison */
+	keys = palloc(total);
+	for (i=0; i < total; i++)
+	{
+		seed = seed * 1103515245U + 12345U;
+		keys[i] = (char)(seed >> 16);
+	}
+
+	for (method = HASHFUNC_LEGACY_CRC32; method <= HASHFUNC_FASTHASH; method++)
+	{
+		instr_time	tv1, tv2;
+		cl_uint		hash;
+		cl_uint		checksum = 0;
+		Datum		values[5];
+		bool		isnull[5];
+
+		INSTR_TIME_SET_CURRENT(tv1);
+		for (i=0; i < total; i += keylen)
+		{
+			if (method == HASHFUNC_LEGACY_CRC32)
+			{
+				INIT_LEGACY_CRC32(hash);
+				COMP_LEGACY_CRC32(hash, keys + i, keylen);
+				FIN_LEGACY_CRC32(hash);
+			}
+			else
+			{
+				INIT_FAST_HASH(hash);
+				hash = pg_common_comp_fasthash(hash, keys + i, keylen);
+				FIN_FAST_HASH(hash);
+			}
+			checksum ^= hash;
+		}
+		INSTR_TIME_SET_CURRENT(tv2);
+		INSTR_TIME_SUBTRACT(tv2, tv1);
+
+		memset(isnull, 0, sizeof(isnull));
+		values[0] = CStringGetTextDatum(method == HASHFUNC_LEGACY_CRC32
+										? "legacy_crc32" : "fasthash");
+		values[1] = Int32GetDatum(keylen);
+		values[2] = Int32GetDatum(nkeys);
+		values[3] = Float8GetDatum(INSTR_TIME_GET_MILLISEC(tv2));
+		values[4] = Int32GetDatum((int32) checksum);
+		tuplestore_putvalues(tupstore, tupdesc, values, isnull);
+	}
+	pfree(keys);
+
+	return (Datum) 0;
+}
+PG_FUNCTION_INFO_V1(pgstrom_hash_benchmark);
+
 /*
  * _PG_init
  *
@@ -390,6 +521,7 @@ _PG_init(void)
 	pgstrom_init_cuda_program();
 	/* initialization of data store support */
 	pgstrom_init_datastore();
+	pgstrom_init_inner_cache();
 
 	/* registration of custom-scan providers */
 	pgstrom_init_gpuscan();
@@ -400,6 +532,8 @@ _PG_init(void)
 	/* miscellaneous initializations */
 	pgstrom_init_misc_guc();
 	pgstrom_init_codegen();
+	pgstrom_init_hostjit();
+	pgstrom_init_cpuvec();
 	pgstrom_init_plcuda();
 
 	/* overall planner hook registration */
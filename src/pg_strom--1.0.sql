@@ -43,6 +43,18 @@ CREATE FUNCTION pgstrom_program_info()
   AS 'MODULE_PATHNAME'
   LANGUAGE C STRICT;
 
+CREATE TYPE __pgstrom_hash_benchmark AS (
+  hash_function	text,
+  keylen		int4,
+  nkeys			int4,
+  elapsed_ms	float8,
+  checksum		int4
+);
+CREATE FUNCTION pgstrom_hash_benchmark(int4, int4)
+  RETURNS SETOF __pgstrom_hash_benchmark
+  AS 'MODULE_PATHNAME'
+  LANGUAGE C STRICT;
+
 --
 -- functions for GpuPreAgg
 --
@@ -175,6 +187,42 @@ CREATE FUNCTION pgstrom.pmin(timestamptz)
   AS 'MODULE_PATHNAME', 'gpupreagg_pseudo_expr'
   LANGUAGE C STRICT;
 
+-- Definition of Partial AND (bool_and, every and bit_and)
+CREATE FUNCTION pgstrom.pand(bool)
+  RETURNS bool
+  AS 'MODULE_PATHNAME', 'gpupreagg_pseudo_expr'
+  LANGUAGE C STRICT;
+CREATE FUNCTION pgstrom.pand(int2)
+  RETURNS int2
+  AS 'MODULE_PATHNAME', 'gpupreagg_pseudo_expr'
+  LANGUAGE C STRICT;
+CREATE FUNCTION pgstrom.pand(int4)
+  RETURNS int4
+  AS 'MODULE_PATHNAME', 'gpupreagg_pseudo_expr'
+  LANGUAGE C STRICT;
+CREATE FUNCTION pgstrom.pand(int8)
+  RETURNS int8
+  AS 'MODULE_PATHNAME', 'gpupreagg_pseudo_expr'
+  LANGUAGE C STRICT;
+
+-- Definition of Partial OR (bool_or and bit_or)
+CREATE FUNCTION pgstrom.por(bool)
+  RETURNS bool
+  AS 'MODULE_PATHNAME', 'gpupreagg_pseudo_expr'
+  LANGUAGE C STRICT;
+CREATE FUNCTION pgstrom.por(int2)
+  RETURNS int2
+  AS 'MODULE_PATHNAME', 'gpupreagg_pseudo_expr'
+  LANGUAGE C STRICT;
+CREATE FUNCTION pgstrom.por(int4)
+  RETURNS int4
+  AS 'MODULE_PATHNAME', 'gpupreagg_pseudo_expr'
+  LANGUAGE C STRICT;
+CREATE FUNCTION pgstrom.por(int8)
+  RETURNS int8
+  AS 'MODULE_PATHNAME', 'gpupreagg_pseudo_expr'
+  LANGUAGE C STRICT;
+
 -- Definition of Partial SUM
 CREATE FUNCTION pgstrom.psum(int8)
   RETURNS int8
@@ -232,6 +280,61 @@ CREATE FUNCTION pgstrom.pcov_xy(bool, float8, float8)
   AS 'MODULE_PATHNAME', 'gpupreagg_corr_psum_xy'
   LANGUAGE C CALLED ON NULL INPUT;
 
+CREATE FUNCTION pgstrom.phll(int4, int2)
+  RETURNS int8
+  AS 'MODULE_PATHNAME', 'gpupreagg_phll'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.phll(int4, int4)
+  RETURNS int8
+  AS 'MODULE_PATHNAME', 'gpupreagg_phll'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.phll(int4, int8)
+  RETURNS int8
+  AS 'MODULE_PATHNAME', 'gpupreagg_phll'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.phll(int4, float4)
+  RETURNS int8
+  AS 'MODULE_PATHNAME', 'gpupreagg_phll'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.phll(int4, float8)
+  RETURNS int8
+  AS 'MODULE_PATHNAME', 'gpupreagg_phll'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.phll(int4, date)
+  RETURNS int8
+  AS 'MODULE_PATHNAME', 'gpupreagg_phll'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.phll(int4, time)
+  RETURNS int8
+  AS 'MODULE_PATHNAME', 'gpupreagg_phll'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.phll(int4, timestamp)
+  RETURNS int8
+  AS 'MODULE_PATHNAME', 'gpupreagg_phll'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.phll(int4, timestamptz)
+  RETURNS int8
+  AS 'MODULE_PATHNAME', 'gpupreagg_phll'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.phll(int4, text)
+  RETURNS int8
+  AS 'MODULE_PATHNAME', 'gpupreagg_phll'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.pqhist(int4, float8)
+  RETURNS int8
+  AS 'MODULE_PATHNAME', 'gpupreagg_pqhist'
+  LANGUAGE C CALLED ON NULL INPUT;
+
 
 --
 -- Partial aggregate function for int2/int4 data types
@@ -546,6 +649,213 @@ CREATE AGGREGATE pgstrom.regr_syy(int4, float8, float8,
   initcond = '{0,0,0,0,0,0}'
 );
 
+--
+-- HyperLogLog based approximate count distinct
+--
+CREATE FUNCTION pgstrom.hll_count_accum(int8[],
+                                        int8, int8, int8, int8,
+                                        int8, int8, int8, int8,
+                                        int8, int8, int8, int8,
+                                        int8, int8, int8, int8)
+  RETURNS int8[]
+  AS 'MODULE_PATHNAME', 'pgstrom_hll_count_accum'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.hll_sfunc(int8[], anyelement)
+  RETURNS int8[]
+  AS 'MODULE_PATHNAME', 'pgstrom_hll_sfunc'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION pgstrom.hll_combine(int8[], int8[])
+  RETURNS int8[]
+  AS 'MODULE_PATHNAME', 'pgstrom_hll_combine'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION pgstrom.hll_count_final(int8[])
+  RETURNS int8
+  AS 'MODULE_PATHNAME', 'pgstrom_hll_count_final'
+  LANGUAGE C STRICT;
+
+CREATE AGGREGATE pgstrom.hll_count(int8, int8, int8, int8,
+                                   int8, int8, int8, int8,
+                                   int8, int8, int8, int8,
+                                   int8, int8, int8, int8)
+(
+  sfunc = pgstrom.hll_count_accum,
+  stype = int8[],
+  finalfunc = pgstrom.hll_count_final,
+  initcond = '{0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}'
+);
+
+CREATE AGGREGATE pgstrom.approx_count_distinct(anyelement)
+(
+  sfunc = pgstrom.hll_sfunc,
+  stype = int8[],
+  finalfunc = pgstrom.hll_count_final,
+  initcond = '{0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}'
+);
+
+--
+-- Log-scale histogram based approximate percentile
+--
+-- The histogram has half octave buckets on [2^-6, 2^25), so the estimation
+-- is within a factor of sqrt(2) only for positive values in this range.
+-- Zero, negative values and values less than 2^-6 share the first bucket;
+-- values not less than 2^25, +Inf and NaN share the last bucket.
+--
+CREATE FUNCTION pgstrom.percentile_hist_accum(float8[], float8, float8, float8,
+                                              int8, int8, int8, int8,
+                                              int8, int8, int8, int8,
+                                              int8, int8, int8, int8,
+                                              int8, int8, int8, int8,
+                                              int8, int8, int8, int8,
+                                              int8, int8, int8, int8,
+                                              int8, int8, int8, int8,
+                                              int8, int8, int8, int8)
+  RETURNS float8[]
+  AS 'MODULE_PATHNAME', 'pgstrom_percentile_hist_accum'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.percentile_sfunc(float8[], float8, float8)
+  RETURNS float8[]
+  AS 'MODULE_PATHNAME', 'pgstrom_percentile_sfunc'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.percentile_combine(float8[], float8[])
+  RETURNS float8[]
+  AS 'MODULE_PATHNAME', 'pgstrom_percentile_combine'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.percentile_final(float8[])
+  RETURNS float8
+  AS 'MODULE_PATHNAME', 'pgstrom_percentile_final'
+  LANGUAGE C STRICT;
+
+CREATE AGGREGATE pgstrom.percentile_hist(float8, float8, float8,
+                                         int8, int8, int8, int8,
+                                         int8, int8, int8, int8,
+                                         int8, int8, int8, int8,
+                                         int8, int8, int8, int8,
+                                         int8, int8, int8, int8,
+                                         int8, int8, int8, int8,
+                                         int8, int8, int8, int8,
+                                         int8, int8, int8, int8)
+(
+  sfunc = pgstrom.percentile_hist_accum,
+  stype = float8[],
+  finalfunc = pgstrom.percentile_final
+);
+
+CREATE AGGREGATE pgstrom.approx_percentile(float8, float8)
+(
+  sfunc = pgstrom.percentile_sfunc,
+  stype = float8[],
+  finalfunc = pgstrom.percentile_final
+);
+
+--
+-- Parallel aggregation support (PostgreSQL 9.6 or later)
+--
+CREATE FUNCTION pgstrom.numeric_agg_combine(internal, internal)
+  RETURNS internal
+  AS 'MODULE_PATHNAME', 'pgstrom_numeric_agg_combine'
+  LANGUAGE C CALLED ON NULL INPUT;
+
+CREATE FUNCTION pgstrom.numeric_agg_serial(internal)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME', 'pgstrom_numeric_agg_serial'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION pgstrom.numeric_agg_deserial(bytea, internal)
+  RETURNS internal
+  AS 'MODULE_PATHNAME', 'pgstrom_numeric_agg_deserial'
+  LANGUAGE C STRICT;
+
+-- CREATE AGGREGATE and CREATE FUNCTION of PostgreSQL 9.5 do not accept
+-- the combinefunc, serialfunc, deserialfunc and parallel options, so
+-- they are attached to the aggregates above by catalog updates, only
+-- when the server supports them. The script has to be loadable on 9.5.
+DO $$
+BEGIN
+  IF current_setting('server_version_num')::int >= 90600 THEN
+    UPDATE pg_catalog.pg_aggregate
+       SET aggcombinefn = 'pg_catalog.int8pl'::regproc
+     WHERE aggfnoid IN ('pgstrom.count(int4)'::regprocedure,
+                        'pgstrom.sum(int8)'::regprocedure,
+                        'pgstrom.regr_count(int4)'::regprocedure);
+    UPDATE pg_catalog.pg_aggregate
+       SET aggcombinefn = 'pg_catalog.int4_avg_combine'::regproc
+     WHERE aggfnoid = 'pgstrom.avg(int4,int8)'::regprocedure;
+    UPDATE pg_catalog.pg_aggregate
+       SET aggcombinefn = 'pg_catalog.float8_combine'::regproc
+     WHERE aggtransfn IN ('pgstrom.sum_float8_accum'::regproc,
+                          'pgstrom.variance_float8_accum'::regproc);
+    UPDATE pg_catalog.pg_aggregate
+       SET aggcombinefn = 'pg_catalog.float8_regr_combine'::regproc
+     WHERE aggtransfn = 'pgstrom.covariance_float8_accum'::regproc;
+    UPDATE pg_catalog.pg_aggregate
+       SET aggcombinefn = 'pgstrom.numeric_agg_combine'::regproc,
+           aggserialfn = 'pgstrom.numeric_agg_serial'::regproc,
+           aggdeserialfn = 'pgstrom.numeric_agg_deserial'::regproc
+     WHERE aggtransfn IN ('pgstrom.int8_avg_accum'::regproc,
+                          'pgstrom.numeric_avg_accum'::regproc,
+                          'pgstrom.numeric_var_accum'::regproc);
+    UPDATE pg_catalog.pg_aggregate
+       SET aggcombinefn = 'pgstrom.hll_combine'::regproc
+     WHERE aggtransfn IN ('pgstrom.hll_count_accum'::regproc,
+                          'pgstrom.hll_sfunc'::regproc);
+    UPDATE pg_catalog.pg_aggregate
+       SET aggcombinefn = 'pgstrom.percentile_combine'::regproc
+     WHERE aggtransfn IN ('pgstrom.percentile_hist_accum'::regproc,
+                          'pgstrom.percentile_sfunc'::regproc);
+    -- the aggregates above and their support functions are parallel safe
+    UPDATE pg_catalog.pg_proc
+       SET proparallel = 's'
+     WHERE oid IN ('pgstrom.avg_int8_accum'::regproc,
+                   'pgstrom.sum_int8_accum'::regproc,
+                   'pgstrom.int8_avg_accum'::regproc,
+                   'pgstrom.numeric_avg_accum'::regproc,
+                   'pgstrom.numeric_avg_final'::regproc,
+                   'pgstrom.sum_float8_accum'::regproc,
+                   'pgstrom.variance_float8_accum'::regproc,
+                   'pgstrom.numeric_var_accum'::regproc,
+                   'pgstrom.numeric_var_samp'::regproc,
+                   'pgstrom.numeric_stddev_samp'::regproc,
+                   'pgstrom.numeric_var_pop'::regproc,
+                   'pgstrom.numeric_stddev_pop'::regproc,
+                   'pgstrom.covariance_float8_accum'::regproc,
+                   'pgstrom.hll_count_accum'::regproc,
+                   'pgstrom.hll_sfunc'::regproc,
+                   'pgstrom.hll_combine'::regproc,
+                   'pgstrom.hll_count_final'::regproc,
+                   'pgstrom.percentile_hist_accum'::regproc,
+                   'pgstrom.percentile_sfunc'::regproc,
+                   'pgstrom.percentile_combine'::regproc,
+                   'pgstrom.percentile_final'::regproc,
+                   'pgstrom.numeric_agg_combine'::regproc,
+                   'pgstrom.numeric_agg_serial'::regproc,
+                   'pgstrom.numeric_agg_deserial'::regproc,
+                   'pgstrom.count(int4)'::regprocedure,
+                   'pgstrom.regr_count(int4)'::regprocedure)
+        OR oid IN (SELECT aggfnoid
+                     FROM pg_catalog.pg_aggregate
+                    WHERE aggtransfn IN
+                          ('pgstrom.avg_int8_accum'::regproc,
+                           'pgstrom.sum_int8_accum'::regproc,
+                           'pgstrom.int8_avg_accum'::regproc,
+                           'pgstrom.numeric_avg_accum'::regproc,
+                           'pgstrom.sum_float8_accum'::regproc,
+                           'pgstrom.variance_float8_accum'::regproc,
+                           'pgstrom.numeric_var_accum'::regproc,
+                           'pgstrom.covariance_float8_accum'::regproc,
+                           'pgstrom.hll_count_accum'::regproc,
+                           'pgstrom.hll_sfunc'::regproc,
+                           'pgstrom.percentile_hist_accum'::regproc,
+                           'pgstrom.percentile_sfunc'::regproc));
+  END IF;
+END
+$$;
+
 --
 -- Functions/Languages to support PL/CUDA
 --
@@ -496,6 +496,11 @@ typedef struct {
 	const char *kds_index_label; /* label to reference kds_index, if exist */
 	List	   *pseudo_tlist;/* pseudo tlist expression, if any */
 	int			extra_flags;/* external libraries to be included */
+	List	   *cse_exprs;	/* common sub-expressions in the function */
+	List	   *cse_codes;	/* code to compute the cse_exprs */
+	int			cse_limit;	/* number of valid entries in cse_exprs */
+	int			bool_ntemps;/* number of BOOL_%u temporary variables */
+	int			bool_depth;	/* current depth of AND/OR clauses */
 } codegen_context;
 
 extern void pgstrom_codegen_typeoid_declarations(StringInfo buf);
@@ -508,6 +513,9 @@ extern devfunc_info *pgstrom_devfunc_lookup_and_track(Oid func_oid,
 											  codegen_context *context);
 
 extern char *pgstrom_codegen_expression(Node *expr, codegen_context *context);
+extern char *pgstrom_codegen_cse_begin(List *exprs, codegen_context *context);
+extern void pgstrom_codegen_cse_end(codegen_context *context);
+extern List *pgstrom_reorder_device_quals(PlannerInfo *root, List *quals);
 extern void pgstrom_codegen_func_declarations(StringInfo buf,
 											  codegen_context *context);
 extern void pgstrom_codegen_expr_declarations(StringInfo buf,
@@ -521,6 +529,37 @@ extern bool pgstrom_device_expression(Expr *expr);
 extern void pgstrom_init_codegen_context(codegen_context *context);
 extern void pgstrom_init_codegen(void);
 
+/*
+ * hostjit.c
+ */
+typedef struct pgstrom_hostjit
+{
+	char	   *source;			/* source of the host JIT code */
+	AttrNumber	max_attno;		/* largest attribute number referenced */
+	bool		load_tried;		/* true, if already tried to load */
+	int		  (*qual_func)(Datum *values, bool *isnull);
+} pgstrom_hostjit;
+
+extern pgstrom_hostjit *pgstrom_hostjit_create_quals(Node *quals);
+extern bool pgstrom_hostjit_exec_quals(pgstrom_hostjit *hjit,
+									   List *qual_state,
+									   ExprContext *econtext);
+extern void pgstrom_init_hostjit(void);
+
+/*
+ * cpuvec.c
+ */
+typedef struct pgstrom_cpuvec pgstrom_cpuvec;
+
+extern pgstrom_cpuvec *pgstrom_cpuvec_create_quals(List *quals,
+												   PlanState *ps);
+extern cl_uint pgstrom_cpuvec_exec_quals(pgstrom_cpuvec *cvec,
+										 pgstrom_data_store *pds,
+										 TupleTableSlot *slot,
+										 ExprContext *econtext,
+										 cl_uint *row_sel);
+extern void pgstrom_init_cpuvec(void);
+
 /*
  * datastore.c
  */
@@ -575,6 +614,30 @@ extern bool PDS_insert_hashitem(pgstrom_data_store *pds,
 extern void PDS_build_hashtable(pgstrom_data_store *pds);
 extern void pgstrom_init_datastore(void);
 
+/*
+ * innercache.c
+ */
+typedef struct
+{
+	bool		valid;		/* true, if relation is cacheable */
+	BlockNumber	nblocks;	/* number of blocks */
+	XLogRecPtr	vm_lsn;		/* latest LSN of the visibility-map pages */
+} pgstrom_inner_cache_sign;
+
+extern char *pgstrom_inner_cache_key(PlanState *ps,
+									 List *hash_inner_keys,
+									 JoinType join_type,
+									 int hash_function);
+extern pgstrom_data_store *pgstrom_inner_cache_lookup(GpuContext *gcontext,
+											PlanState *ps,
+											const char *key,
+											pgstrom_inner_cache_sign *sign);
+extern void pgstrom_inner_cache_store(PlanState *ps,
+									  const char *key,
+									  pgstrom_inner_cache_sign *sign,
+									  pgstrom_data_store *pds);
+extern void pgstrom_init_inner_cache(void);
+
 /*
  * gpuscan.c
  */
@@ -605,7 +668,7 @@ extern void	pgstrom_init_gpujoin(void);
 /*
  * gpupreagg.c
  */
-extern void pgstrom_try_insert_gpupreagg(PlannedStmt *pstmt, Agg *agg);
+extern Plan *pgstrom_try_insert_gpupreagg(PlannedStmt *pstmt, Agg *agg);
 extern bool pgstrom_plan_is_gpupreagg(const Plan *plan);
 extern void pgstrom_init_gpupreagg(void);
 
@@ -641,9 +704,11 @@ extern double	pgstrom_nrows_growth_ratio_limit;
 extern double	pgstrom_nrows_growth_margin;
 extern double	pgstrom_num_threads_margin;
 extern double	pgstrom_chunk_size_margin;
+extern int		pgstrom_hash_function;
 
 extern void _PG_init(void);
 extern const char *pgstrom_strerror(cl_int errcode);
+extern Datum pgstrom_hash_benchmark(PG_FUNCTION_ARGS);
 
 extern void pgstrom_explain_expression(List *expr_list, const char *qlabel,
 									   PlanState *planstate,
@@ -0,0 +1,48 @@
+--#
+--#       Gpu PreAggregate TestCases with approximate aggregate functions.
+--#
+--#   Results of GpuPreAgg are compared with the ones computed by CPU,
+--#   because approximate values are not worth to be written down.
+--#
+
+set pg_strom.debug_force_gpupreagg to on;
+set pg_strom.enable_gpusort to off;
+set client_min_messages to warning;
+set extra_float_digits to -3;
+
+-- approx_count_distinct
+set pg_strom.enabled to on;
+create temp table acd_gpu as select key, pgstrom.approx_count_distinct(smlint_x) a, pgstrom.approx_count_distinct(integer_x) b, pgstrom.approx_count_distinct(bigint_x) c, pgstrom.approx_count_distinct(float_x) d, pgstrom.approx_count_distinct(id::text) e from strom_test group by key;
+set pg_strom.enable_gpupreagg_final to on;
+create temp table acd_final as select key, pgstrom.approx_count_distinct(smlint_x) a, pgstrom.approx_count_distinct(integer_x) b, pgstrom.approx_count_distinct(bigint_x) c, pgstrom.approx_count_distinct(float_x) d, pgstrom.approx_count_distinct(id::text) e from strom_test group by key;
+reset pg_strom.enable_gpupreagg_final;
+set pg_strom.enabled to off;
+create temp table acd_cpu as select key, pgstrom.approx_count_distinct(smlint_x) a, pgstrom.approx_count_distinct(integer_x) b, pgstrom.approx_count_distinct(bigint_x) c, pgstrom.approx_count_distinct(float_x) d, pgstrom.approx_count_distinct(id::text) e from strom_test group by key;
+create temp table acd_exact as select key, count(distinct integer_x) b, count(distinct id::text) e from strom_test group by key;
+set pg_strom.enabled to on;
+(table acd_gpu except all table acd_cpu) union all (table acd_cpu except all table acd_gpu);
+(table acd_final except all table acd_cpu) union all (table acd_cpu except all table acd_final);
+-- estimation error shall be within 30%
+select key from acd_gpu join acd_exact x using (key) where abs(acd_gpu.b - x.b) > 0.3 * x.b or abs(acd_gpu.e - x.e) > 0.3 * x.e;
+select key, pgstrom.approx_count_distinct(integer_x) from strom_test where key is null group by key;
+
+-- approx_percentile (supported domain is positive values in [2^-6, 2^25))
+set pg_strom.enabled to on;
+create temp table apc_gpu as select key, pgstrom.approx_percentile(integer_x, 0.5) a, pgstrom.approx_percentile(integer_x, 0.95) b, pgstrom.approx_percentile(float_x, 0.5) c, pgstrom.approx_percentile(float_x, 0.99) d, pgstrom.approx_percentile(float_x, 0.0) e, pgstrom.approx_percentile(float_x, 1.0) f from strom_test where key between 1 and 10 group by key;
+set pg_strom.enabled to off;
+create temp table apc_cpu as select key, pgstrom.approx_percentile(integer_x, 0.5) a, pgstrom.approx_percentile(integer_x, 0.95) b, pgstrom.approx_percentile(float_x, 0.5) c, pgstrom.approx_percentile(float_x, 0.99) d, pgstrom.approx_percentile(float_x, 0.0) e, pgstrom.approx_percentile(float_x, 1.0) f from strom_test where key between 1 and 10 group by key;
+create temp table apc_exact as select key, percentile_cont(0.5) within group (order by integer_x) a, percentile_cont(0.95) within group (order by integer_x) b, percentile_cont(0.5) within group (order by float_x) c, percentile_cont(0.99) within group (order by float_x) d, min(float_x) e, max(float_x) f from strom_test where key between 1 and 10 group by key;
+set pg_strom.enabled to on;
+(table apc_gpu except all table apc_cpu) union all (table apc_cpu except all table apc_gpu);
+-- estimation shall be within a factor of sqrt(2), and min/max at 0.0 and 1.0
+select key from apc_gpu g join apc_exact x using (key) where greatest(g.a / x.a, x.a / g.a) > 1.415 or greatest(g.b / x.b, x.b / g.b) > 1.415 or greatest(g.c / x.c, x.c / g.c) > 1.415 or greatest(g.d / x.d, x.d / g.d) > 1.415 or g.e <> x.e or abs(g.f - x.f) > 1.0e-9 * x.f;
+
+-- values below the domain, including zero and negative ones, are clamped into the range between the exact min value and the domain boundary
+set pg_strom.enabled to on;
+create temp table apcneg_gpu as select key, pgstrom.approx_percentile(integer_x, 0.5) a, pgstrom.approx_percentile(float_x, 0.5) c, pgstrom.approx_percentile(float_x, 0.0) e, pgstrom.approx_percentile(float_x, 1.0) f from strom_test where key between 11 and 20 group by key;
+set pg_strom.enabled to off;
+create temp table apcneg_cpu as select key, pgstrom.approx_percentile(integer_x, 0.5) a, pgstrom.approx_percentile(float_x, 0.5) c, pgstrom.approx_percentile(float_x, 0.0) e, pgstrom.approx_percentile(float_x, 1.0) f from strom_test where key between 11 and 20 group by key;
+create temp table apcneg_exact as select key, min(integer_x) amin, max(integer_x) amax, min(float_x) e, max(float_x) f from strom_test where key between 11 and 20 group by key;
+set pg_strom.enabled to on;
+(table apcneg_gpu except all table apcneg_cpu) union all (table apcneg_cpu except all table apcneg_gpu);
+select key from apcneg_gpu g join apcneg_exact x using (key) where g.a < x.amin or g.a > x.amax or g.c < x.e or g.c > x.f or g.e <> x.e or abs(g.f - x.f) > 1.0e-9;
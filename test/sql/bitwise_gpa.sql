@@ -0,0 +1,42 @@
+--#
+--#       Gpu PreAggregate TestCases with boolean and bitwise aggregates.
+--#
+--#   Results of GpuPreAgg are compared with the ones computed by CPU,
+--#   on the configurations of GpuPreAgg by the GUC parameters.
+--#
+
+set pg_strom.debug_force_gpupreagg to on;
+set pg_strom.enable_gpusort to off;
+set client_min_messages to warning;
+set extra_float_digits to -3;
+
+set pg_strom.enabled to off;
+create temp table bit_cpu as select key, bool_and(integer_x > 0) a, bool_or(smlint_x % 2 = 0) b, every(bigint_x > 0) c, bit_and(smlint_x) d, bit_or(smlint_x) e, bit_and(integer_x) f, bit_or(integer_x) g, bit_and(bigint_x) h, bit_or(bigint_x) i, count(*) j from strom_test group by key;
+
+-- default configuration
+set pg_strom.enabled to on;
+create temp table bit_gpu as select key, bool_and(integer_x > 0) a, bool_or(smlint_x % 2 = 0) b, every(bigint_x > 0) c, bit_and(smlint_x) d, bit_or(smlint_x) e, bit_and(integer_x) f, bit_or(integer_x) g, bit_and(bigint_x) h, bit_or(bigint_x) i, count(*) j from strom_test group by key;
+(table bit_gpu except all table bit_cpu) union all (table bit_cpu except all table bit_gpu);
+
+-- final aggregation by GpuPreAgg
+set pg_strom.enable_gpupreagg_final to on;
+create temp table bit_final as select key, bool_and(integer_x > 0) a, bool_or(smlint_x % 2 = 0) b, every(bigint_x > 0) c, bit_and(smlint_x) d, bit_or(smlint_x) e, bit_and(integer_x) f, bit_or(integer_x) g, bit_and(bigint_x) h, bit_or(bigint_x) i, count(*) j from strom_test group by key;
+(table bit_final except all table bit_cpu) union all (table bit_cpu except all table bit_final);
+reset pg_strom.enable_gpupreagg_final;
+
+-- no expansion of the final buffer, and no sketch of the number of groups
+set pg_strom.enable_gpupreagg_final_expand to off;
+set pg_strom.gpupreagg_sketch_nrows to 0;
+create temp table bit_noexp as select key, bool_and(integer_x > 0) a, bool_or(smlint_x % 2 = 0) b, every(bigint_x > 0) c, bit_and(smlint_x) d, bit_or(smlint_x) e, bit_and(integer_x) f, bit_or(integer_x) g, bit_and(bigint_x) h, bit_or(bigint_x) i, count(*) j from strom_test group by key;
+(table bit_noexp except all table bit_cpu) union all (table bit_cpu except all table bit_noexp);
+reset pg_strom.enable_gpupreagg_final_expand;
+reset pg_strom.gpupreagg_sketch_nrows;
+
+-- CPU fallback without host hash-aggregation
+set pg_strom.enable_gpupreagg_fallback_hashagg to off;
+create temp table bit_nohash as select key, bool_and(integer_x > 0) a, bool_or(smlint_x % 2 = 0) b, every(bigint_x > 0) c, bit_and(smlint_x) d, bit_or(smlint_x) e, bit_and(integer_x) f, bit_or(integer_x) g, bit_and(bigint_x) h, bit_or(bigint_x) i, count(*) j from strom_test group by key;
+(table bit_nohash except all table bit_cpu) union all (table bit_cpu except all table bit_nohash);
+reset pg_strom.enable_gpupreagg_fallback_hashagg;
+
+-- no group
+select bool_and(integer_x > -2147483648), bool_or(integer_x is null), every(id > 0), bit_and(id), bit_or(id) from strom_test;
@@ -0,0 +1,49 @@
+--#
+--#       Gpu PreAggregate TestCases with expansion of the final buffer.
+--#
+--#   Number of groups is underestimated and the sketch is disabled, so
+--#   the final buffer of a segment gets filled up. Results of GpuPreAgg
+--#   are compared with the ones of plain Agg.
+--#
+
+set pg_strom.debug_force_gpupreagg to on;
+set pg_strom.enable_gpusort to off;
+set client_min_messages to warning;
+set pg_strom.chunk_size to '4MB';
+set pg_strom.gpupreagg_sketch_nrows to 0;
+
+create function pg_temp.explain_has(query text, pattern text) returns bool as $$
+declare
+	line	text;
+begin
+	for line in execute 'explain (analyze, costs off, timing off) ' || query loop
+		if line like pattern then
+			return true;
+		end if;
+	end loop;
+	return false;
+end;
+$$ language plpgsql;
+
+create table expand_gpa_test as select x id, (x * 7919) % 1000003 v, (x % 1000)::numeric / 7 n from generate_series(1, 400000) x;
+analyze expand_gpa_test;
+
+-- final buffer expansion
+set pg_strom.enable_gpupreagg_final_expand to on;
+select pg_temp.explain_has('select id % 200000 k, count(*) c, sum(v) s, max(n) m from expand_gpa_test group by id % 200000', '%final buffer expanded%');
+set pg_strom.enabled to on;
+create temp table expand_gpu as select id % 200000 k, count(*) c, sum(v) s, max(n) m, sum(n) t from expand_gpa_test group by id % 200000;
+create temp table expand_small_gpu as select id % 5000 k, count(*) c, sum(v) s, max(n) m, sum(n) t from expand_gpa_test group by id % 5000;
+-- urgent termination of the segment instead
+set pg_strom.enable_gpupreagg_final_expand to off;
+create temp table noexpand_gpu as select id % 200000 k, count(*) c, sum(v) s, max(n) m, sum(n) t from expand_gpa_test group by id % 200000;
+reset pg_strom.enable_gpupreagg_final_expand;
+set pg_strom.enabled to off;
+create temp table expand_cpu as select id % 200000 k, count(*) c, sum(v) s, max(n) m, sum(n) t from expand_gpa_test group by id % 200000;
+create temp table expand_small_cpu as select id % 5000 k, count(*) c, sum(v) s, max(n) m, sum(n) t from expand_gpa_test group by id % 5000;
+set pg_strom.enabled to on;
+(table expand_gpu except all table expand_cpu) union all (table expand_cpu except all table expand_gpu);
+(table expand_small_gpu except all table expand_small_cpu) union all (table expand_small_cpu except all table expand_small_gpu);
+(table noexpand_gpu except all table expand_cpu) union all (table expand_cpu except all table noexpand_gpu);
+select count(*) from expand_gpu;
+drop table expand_gpa_test;
@@ -0,0 +1,58 @@
+--#
+--#       Gpu Scan TestCases with device expressions.
+--#
+--#   Results of GpuScan are compared with the ones computed by CPU.
+--#
+
+set pg_strom.gpu_setup_cost=0;
+set pg_strom.enable_gpusort to off;
+set client_min_messages to warning;
+
+create function pg_temp.explain_has(query text, pattern text) returns bool as $$
+declare
+	line	text;
+begin
+	for line in execute 'explain (analyze, costs off, timing off) ' || query loop
+		if line like pattern then
+			return true;
+		end if;
+	end loop;
+	return false;
+end;
+$$ language plpgsql;
+
+-- binary search on large constant arrays
+select pg_temp.explain_has('select id from strom_test where id = any(''{251,502,753,1004,1255,1506,1757,2008,2259,2510,2761,3012,3263,3514,3765,4016,4267,4518,4769,5020,5271,5522,5773,6024,6275,6526,6777,7028,7279,7530,7781,8032,8283,8534,8785,9036,9287,9538,9789,10040}''::int4[])', '%GpuScan%');
+set pg_strom.enabled to on;
+create temp table bsearch_gpu as select id from strom_test where id = any('{251,502,753,1004,1255,1506,1757,2008,2259,2510,2761,3012,3263,3514,3765,4016,4267,4518,4769,5020,5271,5522,5773,6024,6275,6526,6777,7028,7279,7530,7781,8032,8283,8534,8785,9036,9287,9538,9789,10040}'::int4[]) or smlint_x = any('{-60,-57,-54,-51,-48,-45,-42,-39,-36,-33,-30,-27,-24,-21,-18,-15,-12,-9,-6,-3,0,3,6,9,12,15,18,21,24,27,30,33,36,39,42,45,48,51,54,57}'::int2[]) or (id % 10000)::int8 = any('{7919,5838,3757,1676,9595,7514,5433,3352,1271,9190,7109,5028,2947,866,8785,6704,4623,2542,461,8380,6299,4218,2137,56,7975,5894,3813,1732,9651,7570,5489,3408,1327,9246,7165,5084,3003,922,8841,6760}'::int8[]);
+create temp table bsearch_all_gpu as select id from strom_test where id % 100 <> all('{-60,-57,-54,-51,-48,-45,-42,-39,-36,-33,-30,-27,-24,-21,-18,-15,-12,-9,-6,-3,0,3,6,9,12,15,18,21,24,27,30,33,36,39,42,45,48,51,54,57}'::int4[]) and id % 1000 = 0;
+set pg_strom.array_bsearch_threshold to 2;
+create temp table bsearch_small_gpu as select id from strom_test where id = any('{10,5,5,20000,30000,40000}'::int4[]) or integer_x = any('{0}'::int4[]);
+reset pg_strom.array_bsearch_threshold;
+set pg_strom.enabled to off;
+create temp table bsearch_cpu as select id from strom_test where id = any('{251,502,753,1004,1255,1506,1757,2008,2259,2510,2761,3012,3263,3514,3765,4016,4267,4518,4769,5020,5271,5522,5773,6024,6275,6526,6777,7028,7279,7530,7781,8032,8283,8534,8785,9036,9287,9538,9789,10040}'::int4[]) or smlint_x = any('{-60,-57,-54,-51,-48,-45,-42,-39,-36,-33,-30,-27,-24,-21,-18,-15,-12,-9,-6,-3,0,3,6,9,12,15,18,21,24,27,30,33,36,39,42,45,48,51,54,57}'::int2[]) or (id % 10000)::int8 = any('{7919,5838,3757,1676,9595,7514,5433,3352,1271,9190,7109,5028,2947,866,8785,6704,4623,2542,461,8380,6299,4218,2137,56,7975,5894,3813,1732,9651,7570,5489,3408,1327,9246,7165,5084,3003,922,8841,6760}'::int8[]);
+create temp table bsearch_all_cpu as select id from strom_test where id % 100 <> all('{-60,-57,-54,-51,-48,-45,-42,-39,-36,-33,-30,-27,-24,-21,-18,-15,-12,-9,-6,-3,0,3,6,9,12,15,18,21,24,27,30,33,36,39,42,45,48,51,54,57}'::int4[]) and id % 1000 = 0;
+create temp table bsearch_small_cpu as select id from strom_test where id = any('{10,5,5,20000,30000,40000}'::int4[]) or integer_x = any('{0}'::int4[]);
+set pg_strom.enabled to on;
+(table bsearch_gpu except all table bsearch_cpu) union all (table bsearch_cpu except all table bsearch_gpu);
+(table bsearch_all_gpu except all table bsearch_all_cpu) union all (table bsearch_all_cpu except all table bsearch_all_gpu);
+(table bsearch_small_gpu except all table bsearch_small_cpu) union all (table bsearch_small_cpu except all table bsearch_small_gpu);
+
+-- common sub-expression that contains AND/OR, referenced in AND/OR
+set pg_strom.enabled to on;
+create temp table cse_bool_gpu as select id, key from strom_test where case when smlint_x > 0 and integer_x > 0 then id % 30 else key end between 10 and 20 and (bigint_x > 0 or case when smlint_x > 0 and integer_x > 0 then id % 30 else key end > 15);
+set pg_strom.enabled to off;
+create temp table cse_bool_cpu as select id, key from strom_test where case when smlint_x > 0 and integer_x > 0 then id % 30 else key end between 10 and 20 and (bigint_x > 0 or case when smlint_x > 0 and integer_x > 0 then id % 30 else key end > 15);
+set pg_strom.enabled to on;
+(table cse_bool_gpu except all table cse_bool_cpu) union all (table cse_bool_cpu except all table cse_bool_gpu);
+
+-- short-circuit evaluation of AND/OR clauses, with NULLs
+set pg_strom.enabled to on;
+create temp table bool_qual_gpu as select id from strom_test where (id % 1000 = 0 or 1000 / (id % 1000) > 10) and (smlint_x is null or not (integer_x > 0 and bigint_x < 0) or (float_x > 0 and (real_x < 0 or id % 7 = 0)));
+create temp table bool_proj_gpu as select id, (smlint_x > 0 and integer_x > 0) a, (smlint_x > 0 or integer_x > 0) b, (smlint_x > 0 and (integer_x > 0 or bigint_x > 0)) c, not (smlint_x > 0 or (integer_x > 0 and bigint_x > 0)) d from strom_test where id % 10 = 0;
+set pg_strom.enabled to off;
+create temp table bool_qual_cpu as select id from strom_test where (id % 1000 = 0 or 1000 / (id % 1000) > 10) and (smlint_x is null or not (integer_x > 0 and bigint_x < 0) or (float_x > 0 and (real_x < 0 or id % 7 = 0)));
+create temp table bool_proj_cpu as select id, (smlint_x > 0 and integer_x > 0) a, (smlint_x > 0 or integer_x > 0) b, (smlint_x > 0 and (integer_x > 0 or bigint_x > 0)) c, not (smlint_x > 0 or (integer_x > 0 and bigint_x > 0)) d from strom_test where id % 10 = 0;
+set pg_strom.enabled to on;
+(table bool_qual_gpu except all table bool_qual_cpu) union all (table bool_qual_cpu except all table bool_qual_gpu);
+(table bool_proj_gpu except all table bool_proj_cpu) union all (table bool_proj_cpu except all table bool_proj_gpu);
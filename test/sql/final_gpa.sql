@@ -0,0 +1,32 @@
+--#
+--#       Gpu PreAggregate TestCases with final aggregation.
+--#
+--#   Results of GpuPreAgg are compared with the ones of plain Agg.
+--#
+
+set pg_strom.debug_force_gpupreagg to on;
+set pg_strom.enable_gpusort to off;
+set client_min_messages to warning;
+set pg_strom.enable_gpupreagg_final to on;
+
+create function pg_temp.explain_has(query text, pattern text) returns bool as $$
+declare
+	line	text;
+begin
+	for line in execute 'explain (analyze, costs off, timing off) ' || query loop
+		if line like pattern then
+			return true;
+		end if;
+	end loop;
+	return false;
+end;
+$$ language plpgsql;
+
+-- final aggregation with init-plans of the Agg node
+select pg_temp.explain_has('select key, count(*) + (select count(*) from strom_mix) c from strom_test group by key', '%Final Aggregation: on%');
+set pg_strom.enabled to on;
+create temp table initplan_gpu as select key, count(*) + (select count(*) from strom_mix) c, sum(integer_x) * (select max(id) from strom_test where id < 100) s from strom_test group by key;
+set pg_strom.enabled to off;
+create temp table initplan_cpu as select key, count(*) + (select count(*) from strom_mix) c, sum(integer_x) * (select max(id) from strom_test where id < 100) s from strom_test group by key;
+set pg_strom.enabled to on;
+(table initplan_gpu except all table initplan_cpu) union all (table initplan_cpu except all table initplan_gpu);
@@ -0,0 +1,51 @@
+--#
+--#       Gpu Hash Join TestCases with partitioned (grace) hash join.
+--#
+--#   Inner buffer is restricted to make multiple inner chunks, then
+--#   results of GpuHashJoin are compared with the ones computed by CPU.
+--#
+
+set pg_strom.gpu_setup_cost=0;
+set pg_strom.enable_gpupreagg to off;
+set pg_strom.enable_gpusort to off;
+set random_page_cost=1000000;   --# force off index_scan.
+set client_min_messages to warning;
+set pg_strom.debug_gpujoin_inner_limit to '512kB';
+set work_mem to '64kB';
+
+create function pg_temp.explain_has(query text, pattern text) returns bool as $$
+declare
+	line	text;
+begin
+	for line in execute 'explain (analyze, costs off, timing off) ' || query loop
+		if line like pattern then
+			return true;
+		end if;
+	end loop;
+	return false;
+end;
+$$ language plpgsql;
+
+-- partitioned by a single outer scan
+set pg_strom.enable_gpujoin_grace_hash to on;
+select pg_temp.explain_has('select a.id, b.id from strom_test a join strom_test b on a.id = b.id where b.id % 2 = 0', '%, partitioned%Spilled:%');
+create temp table grace_gpu as select a.id aid, b.id bid, a.integer_x, b.float_x from strom_test a join strom_test b on a.id = b.id where b.id % 2 = 0;
+create temp table grace_key_gpu as select a.id aid, b.id bid from strom_test a join strom_test b on a.key = b.key and a.smlint_x = b.smlint_x where b.id % 2 = 0;
+create temp table grace_left_gpu as select a.id aid, b.id bid from strom_test a left join strom_test b on a.id = b.id + 1 and b.id % 2 = 0 where a.id % 3 <> 0;
+-- multiple inner chunks without partitioning
+set pg_strom.enable_gpujoin_grace_hash to off;
+create temp table nograce_gpu as select a.id aid, b.id bid, a.integer_x, b.float_x from strom_test a join strom_test b on a.id = b.id where b.id % 2 = 0;
+create temp table nograce_key_gpu as select a.id aid, b.id bid from strom_test a join strom_test b on a.key = b.key and a.smlint_x = b.smlint_x where b.id % 2 = 0;
+create temp table nograce_left_gpu as select a.id aid, b.id bid from strom_test a left join strom_test b on a.id = b.id + 1 and b.id % 2 = 0 where a.id % 3 <> 0;
+reset pg_strom.enable_gpujoin_grace_hash;
+set pg_strom.enabled to off;
+create temp table grace_cpu as select a.id aid, b.id bid, a.integer_x, b.float_x from strom_test a join strom_test b on a.id = b.id where b.id % 2 = 0;
+create temp table grace_key_cpu as select a.id aid, b.id bid from strom_test a join strom_test b on a.key = b.key and a.smlint_x = b.smlint_x where b.id % 2 = 0;
+create temp table grace_left_cpu as select a.id aid, b.id bid from strom_test a left join strom_test b on a.id = b.id + 1 and b.id % 2 = 0 where a.id % 3 <> 0;
+set pg_strom.enabled to on;
+(table grace_gpu except all table grace_cpu) union all (table grace_cpu except all table grace_gpu);
+(table grace_key_gpu except all table grace_key_cpu) union all (table grace_key_cpu except all table grace_key_gpu);
+(table grace_left_gpu except all table grace_left_cpu) union all (table grace_left_cpu except all table grace_left_gpu);
+(table nograce_gpu except all table grace_cpu) union all (table grace_cpu except all table nograce_gpu);
+(table nograce_key_gpu except all table grace_key_cpu) union all (table grace_key_cpu except all table nograce_key_gpu);
+(table nograce_left_gpu except all table grace_left_cpu) union all (table grace_left_cpu except all table nograce_left_gpu);
@@ -0,0 +1,33 @@
+--#
+--#       Gpu PreAggregate TestCases with GROUPING SETS, ROLLUP and CUBE.
+--#
+--#   Results of GpuPreAgg are compared with the ones of plain Agg.
+--#
+
+set pg_strom.debug_force_gpupreagg to on;
+set pg_strom.enable_gpusort to off;
+set client_min_messages to warning;
+set extra_float_digits to -3;
+
+-- ROLLUP
+set pg_strom.enabled to on;
+create temp table rollup_gpu as select key, id % 4 k, grouping(key, id % 4) g, count(*) c, sum(integer_x) s, max(float_x) m from strom_test group by rollup(key, id % 4);
+set pg_strom.enabled to off;
+create temp table rollup_cpu as select key, id % 4 k, grouping(key, id % 4) g, count(*) c, sum(integer_x) s, max(float_x) m from strom_test group by rollup(key, id % 4);
+(table rollup_gpu except all table rollup_cpu) union all (table rollup_cpu except all table rollup_gpu);
+
+-- CUBE
+set pg_strom.enabled to on;
+create temp table cube_gpu as select key, id % 4 k, grouping(key, id % 4) g, count(*) c, sum(integer_x) s, max(float_x) m from strom_test group by cube(key, id % 4);
+set pg_strom.enabled to off;
+create temp table cube_cpu as select key, id % 4 k, grouping(key, id % 4) g, count(*) c, sum(integer_x) s, max(float_x) m from strom_test group by cube(key, id % 4);
+(table cube_gpu except all table cube_cpu) union all (table cube_cpu except all table cube_gpu);
+
+-- GROUPING SETS of disjoint keys
+set pg_strom.enabled to on;
+create temp table gsets_gpu as select key, id % 4 k, grouping(key, id % 4) g, count(*) c, sum(integer_x) s, max(float_x) m from strom_test group by grouping sets ((key), (id % 4));
+set pg_strom.enabled to off;
+create temp table gsets_cpu as select key, id % 4 k, grouping(key, id % 4) g, count(*) c, sum(integer_x) s, max(float_x) m from strom_test group by grouping sets ((key), (id % 4));
+(table gsets_gpu except all table gsets_cpu) union all (table gsets_cpu except all table gsets_gpu);
+set pg_strom.enabled to on;
+select count(*) from gsets_gpu;
@@ -0,0 +1,62 @@
+--#
+--#       Gpu Hash Join TestCases with each hash function of join keys.
+--#
+--#   Results of GpuHashJoin and GpuPreAgg are compared with the ones
+--#   computed by CPU.
+--#
+
+set pg_strom.gpu_setup_cost=0;
+set pg_strom.enable_gpupreagg to off;
+set pg_strom.enable_gpusort to off;
+set random_page_cost=1000000;   --# force off index_scan.
+set client_min_messages to warning;
+
+create function pg_temp.explain_has(query text, pattern text) returns bool as $$
+declare
+	line	text;
+begin
+	for line in execute 'explain (analyze, costs off, timing off) ' || query loop
+		if line like pattern then
+			return true;
+		end if;
+	end loop;
+	return false;
+end;
+$$ language plpgsql;
+
+-- legacy_crc32
+set pg_strom.hash_function to legacy_crc32;
+select pg_temp.explain_has('select a.id, b.id from strom_test a join strom_test b on a.key = b.key and a.nume_x = b.nume_x where a.id % 10 = 0', '%GpuHashJoin%');
+set pg_strom.enabled to on;
+create temp table crc32_join_gpu as select a.id aid, b.id bid, a.key from strom_test a join strom_test b on a.key = b.key and a.nume_x = b.nume_x and a.bigint_x = b.bigint_x where a.id % 10 = 0;
+create temp table crc32_mkey_gpu as select a.id aid, b.id bid from strom_test a join strom_test b on a.smlint_x = b.smlint_x and a.float_x = b.float_x and a.key = b.key where a.id % 20 = 0;
+set pg_strom.enable_gpupreagg to on;
+set pg_strom.debug_force_gpupreagg to on;
+create temp table crc32_group_gpu as select key, nume_x, count(*) c, sum(integer_x) s from strom_test group by key, nume_x;
+reset pg_strom.debug_force_gpupreagg;
+set pg_strom.enable_gpupreagg to off;
+
+-- fasthash
+set pg_strom.hash_function to fasthash;
+select pg_temp.explain_has('select a.id, b.id from strom_test a join strom_test b on a.key = b.key and a.nume_x = b.nume_x where a.id % 10 = 0', '%GpuHashJoin%');
+create temp table fast_join_gpu as select a.id aid, b.id bid, a.key from strom_test a join strom_test b on a.key = b.key and a.nume_x = b.nume_x and a.bigint_x = b.bigint_x where a.id % 10 = 0;
+create temp table fast_mkey_gpu as select a.id aid, b.id bid from strom_test a join strom_test b on a.smlint_x = b.smlint_x and a.float_x = b.float_x and a.key = b.key where a.id % 20 = 0;
+set pg_strom.enable_gpupreagg to on;
+set pg_strom.debug_force_gpupreagg to on;
+create temp table fast_group_gpu as select key, nume_x, count(*) c, sum(integer_x) s from strom_test group by key, nume_x;
+reset pg_strom.debug_force_gpupreagg;
+set pg_strom.enable_gpupreagg to off;
+reset pg_strom.hash_function;
+
+-- CPU
+set pg_strom.enabled to off;
+create temp table join_cpu as select a.id aid, b.id bid, a.key from strom_test a join strom_test b on a.key = b.key and a.nume_x = b.nume_x and a.bigint_x = b.bigint_x where a.id % 10 = 0;
+create temp table mkey_cpu as select a.id aid, b.id bid from strom_test a join strom_test b on a.smlint_x = b.smlint_x and a.float_x = b.float_x and a.key = b.key where a.id % 20 = 0;
+create temp table group_cpu as select key, nume_x, count(*) c, sum(integer_x) s from strom_test group by key, nume_x;
+set pg_strom.enabled to on;
+(table crc32_join_gpu except all table join_cpu) union all (table join_cpu except all table crc32_join_gpu);
+(table crc32_mkey_gpu except all table mkey_cpu) union all (table mkey_cpu except all table crc32_mkey_gpu);
+(table crc32_group_gpu except all table group_cpu) union all (table group_cpu except all table crc32_group_gpu);
+(table fast_join_gpu except all table join_cpu) union all (table join_cpu except all table fast_join_gpu);
+(table fast_mkey_gpu except all table mkey_cpu) union all (table mkey_cpu except all table fast_mkey_gpu);
+(table fast_group_gpu except all table group_cpu) union all (table group_cpu except all table fast_group_gpu);
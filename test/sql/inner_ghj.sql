@@ -0,0 +1,142 @@
+--#
+--#       Gpu Hash Join TestCases on the inner hash table.
+--#
+--#   Results of GpuHashJoin are compared with the ones computed by CPU.
+--#
+
+set pg_strom.gpu_setup_cost=0;
+set pg_strom.enable_gpupreagg to off;
+set pg_strom.enable_gpusort to off;
+set random_page_cost=1000000;   --# force off index_scan.
+set client_min_messages to warning;
+
+create function pg_temp.explain_has(query text, pattern text) returns bool as $$
+declare
+	line	text;
+begin
+	for line in execute 'explain (analyze, costs off, timing off) ' || query loop
+		if line like pattern then
+			return true;
+		end if;
+	end loop;
+	return false;
+end;
+$$ language plpgsql;
+
+-- rescan with non-parameterized inner relation
+select pg_temp.explain_has('select o.k, (select count(*) from strom_test a join strom_test b on a.id = b.id where a.key = o.k and b.id % 100 = 0) from generate_series(1,3) o(k)', '%GpuJoin%loops=3)%');
+set pg_strom.enabled to on;
+create temp table rescan_gpu as select o.k, (select count(*) from strom_test a join strom_test b on a.id = b.id where a.key = o.k and b.id % 100 = 0) c, (select sum(b.integer_x) from strom_test a join strom_test b on a.id = b.id where a.key = o.k and b.id % 100 = 0) s from generate_series(1,40) o(k);
+set pg_strom.enabled to off;
+create temp table rescan_cpu as select o.k, (select count(*) from strom_test a join strom_test b on a.id = b.id where a.key = o.k and b.id % 100 = 0) c, (select sum(b.integer_x) from strom_test a join strom_test b on a.id = b.id where a.key = o.k and b.id % 100 = 0) s from generate_series(1,40) o(k);
+set pg_strom.enabled to on;
+(table rescan_gpu except all table rescan_cpu) union all (table rescan_cpu except all table rescan_gpu);
+
+-- bloom filter of the inner join keys
+set pg_strom.enable_gpujoin_bloom_filter to on;
+select pg_temp.explain_has('select a.id, b.id from strom_test a join strom_test b on a.id = b.id where b.id % 100 = 0', '%Bloom (size:%');
+set pg_strom.gpujoin_bloom_prefilter to off;
+create temp table bloom_gpu as select a.id aid, b.id bid, a.integer_x from strom_test a join strom_test b on a.id = b.id where b.id % 100 = 0;
+create temp table bloom_null_gpu as select a.id aid, b.id bid from strom_test a join strom_test b on a.integer_x = b.integer_x and a.key = b.key where b.id % 500 = 0;
+set pg_strom.gpujoin_bloom_prefilter to on;
+select pg_temp.explain_has('select a.id, b.id from strom_test a join strom_test b on a.id = b.id where b.id % 100 = 0', '%Bloom (size:%');
+create temp table bloom_pre_gpu as select a.id aid, b.id bid, a.integer_x from strom_test a join strom_test b on a.id = b.id where b.id % 100 = 0;
+create temp table bloom_pre_null_gpu as select a.id aid, b.id bid from strom_test a join strom_test b on a.integer_x = b.integer_x and a.key = b.key where b.id % 500 = 0;
+reset pg_strom.gpujoin_bloom_prefilter;
+set pg_strom.enabled to off;
+create temp table bloom_cpu as select a.id aid, b.id bid, a.integer_x from strom_test a join strom_test b on a.id = b.id where b.id % 100 = 0;
+create temp table bloom_null_cpu as select a.id aid, b.id bid from strom_test a join strom_test b on a.integer_x = b.integer_x and a.key = b.key where b.id % 500 = 0;
+set pg_strom.enabled to on;
+reset pg_strom.enable_gpujoin_bloom_filter;
+(table bloom_gpu except all table bloom_cpu) union all (table bloom_cpu except all table bloom_gpu);
+(table bloom_null_gpu except all table bloom_null_cpu) union all (table bloom_null_cpu except all table bloom_null_gpu);
+(table bloom_pre_gpu except all table bloom_cpu) union all (table bloom_cpu except all table bloom_pre_gpu);
+(table bloom_pre_null_gpu except all table bloom_null_cpu) union all (table bloom_null_cpu except all table bloom_pre_null_gpu);
+
+-- heavy-hitter keys of the inner relation
+set pg_strom.enable_gpujoin_skew_handling to on;
+select pg_temp.explain_has('select a.key, count(*) from strom_test a join strom_test b on a.key = b.key where a.id between 1 and 1000 and b.id % 2 = 0 group by a.key', '%Skew (keys:%');
+create temp table skew_gpu as select a.key, count(*) c, sum(b.integer_x) s, min(a.id) i from strom_test a join strom_test b on a.key = b.key where a.id between 1 and 1000 and b.id % 2 = 0 group by a.key;
+create temp table skew_left_gpu as select a.key, count(*) c, count(b.id) n, sum(b.bigint_x) s from strom_test a left join strom_test b on a.key = b.key and b.id % 2 = 0 where a.id between 29501 and 30500 group by a.key;
+set pg_strom.enable_gpujoin_skew_handling to off;
+create temp table noskew_gpu as select a.key, count(*) c, sum(b.integer_x) s, min(a.id) i from strom_test a join strom_test b on a.key = b.key where a.id between 1 and 1000 and b.id % 2 = 0 group by a.key;
+reset pg_strom.enable_gpujoin_skew_handling;
+set pg_strom.enabled to off;
+create temp table skew_cpu as select a.key, count(*) c, sum(b.integer_x) s, min(a.id) i from strom_test a join strom_test b on a.key = b.key where a.id between 1 and 1000 and b.id % 2 = 0 group by a.key;
+create temp table skew_left_cpu as select a.key, count(*) c, count(b.id) n, sum(b.bigint_x) s from strom_test a left join strom_test b on a.key = b.key and b.id % 2 = 0 where a.id between 29501 and 30500 group by a.key;
+set pg_strom.enabled to on;
+(table skew_gpu except all table skew_cpu) union all (table skew_cpu except all table skew_gpu);
+(table skew_left_gpu except all table skew_left_cpu) union all (table skew_left_cpu except all table skew_left_gpu);
+(table noskew_gpu except all table skew_cpu) union all (table skew_cpu except all table noskew_gpu);
+
+-- join growth much larger than the estimation
+set pg_strom.enable_gpujoin_feedback to on;
+set pg_strom.gpujoin_count_then_materialize to off;
+create temp table growth_gpu as select a.id aid, b.id bid, a.integer_x + b.integer_x v from strom_test a join strom_test b on a.key = b.id % 30 + 1 where a.id % 29 = 0 and b.id % 5 = 0;
+select pg_temp.explain_has('select a.id aid, b.id bid, a.integer_x + b.integer_x v from strom_test a join strom_test b on a.key = b.id % 30 + 1 where a.id % 29 = 0 and b.id % 5 = 0', '%Nrows (in:%planned%feedback%');
+create temp table growth_fb_gpu as select a.id aid, b.id bid, a.integer_x + b.integer_x v from strom_test a join strom_test b on a.key = b.id % 30 + 1 where a.id % 29 = 0 and b.id % 5 = 0;
+set pg_strom.enable_gpujoin_feedback to off;
+set pg_strom.gpujoin_count_then_materialize to on;
+create temp table growth_count_gpu as select a.id aid, b.id bid, a.integer_x + b.integer_x v from strom_test a join strom_test b on a.key = b.id % 30 + 1 where a.id % 29 = 0 and b.id % 5 = 0;
+create temp table growth_count2_gpu as select a.id aid, b.id bid, c.id cid from strom_test a join strom_test b on a.key = b.id % 30 + 1 join strom_test c on b.key = c.id % 20 + 1 where a.id % 211 = 0 and b.id % 5 = 0 and c.id % 131 = 0;
+reset pg_strom.gpujoin_count_then_materialize;
+reset pg_strom.enable_gpujoin_feedback;
+set pg_strom.enabled to off;
+create temp table growth_cpu as select a.id aid, b.id bid, a.integer_x + b.integer_x v from strom_test a join strom_test b on a.key = b.id % 30 + 1 where a.id % 29 = 0 and b.id % 5 = 0;
+create temp table growth_count2_cpu as select a.id aid, b.id bid, c.id cid from strom_test a join strom_test b on a.key = b.id % 30 + 1 join strom_test c on b.key = c.id % 20 + 1 where a.id % 211 = 0 and b.id % 5 = 0 and c.id % 131 = 0;
+set pg_strom.enabled to on;
+(table growth_gpu except all table growth_cpu) union all (table growth_cpu except all table growth_gpu);
+(table growth_fb_gpu except all table growth_cpu) union all (table growth_cpu except all table growth_fb_gpu);
+(table growth_count_gpu except all table growth_cpu) union all (table growth_cpu except all table growth_count_gpu);
+(table growth_count2_gpu except all table growth_count2_cpu) union all (table growth_count2_cpu except all table growth_count2_gpu);
+
+-- dense hash index with duplicated keys, and on the shrunk inner chunks
+select pg_temp.explain_has('select a.id, b.id from strom_test a join strom_test b on a.key = b.key and a.smlint_x = b.smlint_x where a.id % 13 = 0', '%GpuHashJoin, HashKeys:%');
+set pg_strom.enabled to on;
+create temp table dense_gpu as select a.id aid, b.id bid from strom_test a join strom_test b on a.key = b.key and a.smlint_x = b.smlint_x where a.id % 13 = 0;
+create temp table dense_mkey_gpu as select a.id aid, b.id bid, b.nume_x from strom_test a join strom_test b on a.key = b.key and a.id % 3 = b.id % 3 and a.real_x::numeric = round(b.real_x::numeric, 1) where b.id % 17 = 0;
+set pg_strom.enable_gpujoin_grace_hash to off;
+set pg_strom.debug_gpujoin_inner_limit to '256kB';
+create temp table dense_shrink_gpu as select a.id aid, b.id bid from strom_test a join strom_test b on a.key = b.key and a.smlint_x = b.smlint_x where a.id % 13 = 0;
+reset pg_strom.debug_gpujoin_inner_limit;
+reset pg_strom.enable_gpujoin_grace_hash;
+set pg_strom.enabled to off;
+create temp table dense_cpu as select a.id aid, b.id bid from strom_test a join strom_test b on a.key = b.key and a.smlint_x = b.smlint_x where a.id % 13 = 0;
+create temp table dense_mkey_cpu as select a.id aid, b.id bid, b.nume_x from strom_test a join strom_test b on a.key = b.key and a.id % 3 = b.id % 3 and a.real_x::numeric = round(b.real_x::numeric, 1) where b.id % 17 = 0;
+set pg_strom.enabled to on;
+(table dense_gpu except all table dense_cpu) union all (table dense_cpu except all table dense_gpu);
+(table dense_mkey_gpu except all table dense_mkey_cpu) union all (table dense_mkey_cpu except all table dense_mkey_gpu);
+(table dense_shrink_gpu except all table dense_cpu) union all (table dense_cpu except all table dense_shrink_gpu);
+
+-- inner hash table built by multiple threads
+select pg_temp.explain_has('select a.key, count(*) c, sum(b.integer_x) s, max(b.nume_x) m from strom_test a join (select id, integer_x, nume_x from strom_test where id % 1 = 0 union all select id, integer_x, nume_x from strom_test where id % 1 = 0 union all select id, integer_x, nume_x from strom_test where id % 1 = 0 union all select id, integer_x, nume_x from strom_test where id % 1 = 0) b on a.id = b.id group by a.key', '%GpuHashJoin, HashKeys:%');
+set pg_strom.hashbuild_workers to 8;
+create temp table hbuild_gpu as select a.key, count(*) c, sum(b.integer_x) s, max(b.nume_x) m from strom_test a join (select id, integer_x, nume_x from strom_test where id % 1 = 0 union all select id, integer_x, nume_x from strom_test where id % 1 = 0 union all select id, integer_x, nume_x from strom_test where id % 1 = 0 union all select id, integer_x, nume_x from strom_test where id % 1 = 0) b on a.id = b.id group by a.key;
+set pg_strom.hashbuild_workers to 1;
+create temp table hbuild_single_gpu as select a.key, count(*) c, sum(b.integer_x) s, max(b.nume_x) m from strom_test a join (select id, integer_x, nume_x from strom_test where id % 1 = 0 union all select id, integer_x, nume_x from strom_test where id % 1 = 0 union all select id, integer_x, nume_x from strom_test where id % 1 = 0 union all select id, integer_x, nume_x from strom_test where id % 1 = 0) b on a.id = b.id group by a.key;
+reset pg_strom.hashbuild_workers;
+set pg_strom.enabled to off;
+create temp table hbuild_cpu as select a.key, count(*) c, sum(b.integer_x) s, max(b.nume_x) m from strom_test a join (select id, integer_x, nume_x from strom_test where id % 1 = 0 union all select id, integer_x, nume_x from strom_test where id % 1 = 0 union all select id, integer_x, nume_x from strom_test where id % 1 = 0 union all select id, integer_x, nume_x from strom_test where id % 1 = 0) b on a.id = b.id group by a.key;
+set pg_strom.enabled to on;
+(table hbuild_gpu except all table hbuild_cpu) union all (table hbuild_cpu except all table hbuild_gpu);
+(table hbuild_single_gpu except all table hbuild_cpu) union all (table hbuild_cpu except all table hbuild_single_gpu);
+
+-- shared inner cache across queries
+create table icache_inner as select id, key, integer_x from strom_test where id % 10 = 0;
+vacuum analyze icache_inner;
+set pg_strom.enable_inner_cache to on;
+create temp table icache_build_gpu as select a.key, count(*) c, sum(b.integer_x) s from strom_test a join icache_inner b on a.id = b.id group by a.key;
+select pg_temp.explain_has('select a.key, count(*) c, sum(b.integer_x) s from strom_test a join icache_inner b on a.id = b.id group by a.key', '%KDS-Hash%, cached%');
+create temp table icache_hit_gpu as select a.key, count(*) c, sum(b.integer_x) s from strom_test a join icache_inner b on a.id = b.id group by a.key;
+update icache_inner set integer_x = integer_x + 1 where id % 1000 = 0;
+create temp table icache_mod_gpu as select a.key, count(*) c, sum(b.integer_x) s from strom_test a join icache_inner b on a.id = b.id group by a.key;
+set pg_strom.enabled to off;
+create temp table icache_mod_cpu as select a.key, count(*) c, sum(b.integer_x) s from strom_test a join icache_inner b on a.id = b.id group by a.key;
+update icache_inner set integer_x = integer_x - 1 where id % 1000 = 0;
+create temp table icache_cpu as select a.key, count(*) c, sum(b.integer_x) s from strom_test a join icache_inner b on a.id = b.id group by a.key;
+set pg_strom.enabled to on;
+reset pg_strom.enable_inner_cache;
+(table icache_build_gpu except all table icache_cpu) union all (table icache_cpu except all table icache_build_gpu);
+(table icache_hit_gpu except all table icache_cpu) union all (table icache_cpu except all table icache_hit_gpu);
+(table icache_mod_gpu except all table icache_mod_cpu) union all (table icache_mod_cpu except all table icache_mod_gpu);
+drop table icache_inner;
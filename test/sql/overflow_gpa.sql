@@ -158,3 +158,14 @@ select key, var_samp(bigsrl_x)::bigint       from strom_overflow_test  group by
 select key,corr(bigsrl_x,bigsrl_x)::bigint from strom_overflow_test  group by key order by key;
 select key,covar_pop(bigsrl_x,bigsrl_x)::bigint from strom_overflow_test  group by key order by key;
 select key,covar_samp(bigsrl_x,bigsrl_x)::bigint from strom_overflow_test  group by key order by key;
+
+-- int128 accumulators; sums across the int64 and the int128 boundaries
+create table int128_gpa_test as select x id, x % 10 key, case when x % 2 = 0 then 9223372036854775807 - x else -9223372036854775807 + x end b, case when x % 3 = 0 then 1e37 * (x % 17) + x / 1000.0 when x % 3 = 1 then 99999999999999999999999999999999999999 - x else 0.1234567890123456789012345678901234567 * x end n from generate_series(1, 3000) x;
+insert into int128_gpa_test values (3001, 10, 9223372036854775807, 'NaN'), (3002, 10, -9223372036854775808, 1), (3003, 11, 9223372036854775807, 1e38), (3004, 11, 9223372036854775807, 1e38), (3005, 11, 0, -1.7e38), (3006, 12, null, 123456789012345678901234567890123456789.5);
+set pg_strom.enabled to on;
+create temp table int128_gpu as select key, count(*) c, sum(b) sb, avg(b) ab, variance(b) vb, sum(n) sn, avg(n) an, var_samp(n) vn, stddev_pop(n) dn from int128_gpa_test group by key;
+set pg_strom.enabled to off;
+create temp table int128_cpu as select key, count(*) c, sum(b) sb, avg(b) ab, variance(b) vb, sum(n) sn, avg(n) an, var_samp(n) vn, stddev_pop(n) dn from int128_gpa_test group by key;
+set pg_strom.enabled to on;
+(table int128_gpu except all table int128_cpu) union all (table int128_cpu except all table int128_gpu);
+drop table int128_gpa_test;
@@ -0,0 +1,54 @@
+--#
+--#       Gpu PreAggregate TestCases with parallel aggregation.
+--#
+--#   Results of the partial/final aggregation under Gather are compared
+--#   with the ones of serial aggregation. Parallel query is available
+--#   on PostgreSQL 9.6 or later; the results are compared as well on 9.5.
+--#
+
+set pg_strom.debug_force_gpupreagg to on;
+set pg_strom.enable_gpusort to off;
+set client_min_messages to warning;
+
+create function pg_temp.explain_has(query text, pattern text) returns bool as $$
+declare
+	line	text;
+begin
+	for line in execute 'explain (analyze, costs off, timing off) ' || query loop
+		if line like pattern then
+			return true;
+		end if;
+	end loop;
+	return false;
+end;
+$$ language plpgsql;
+
+create function pg_temp.set_parallel(nworkers int) returns void as $$
+begin
+	if current_setting('server_version_num')::int >= 90600 then
+		perform set_config('parallel_setup_cost', '0', false);
+		perform set_config('parallel_tuple_cost', '0', false);
+		perform set_config('min_parallel_relation_size', '0', false);
+		perform set_config('max_parallel_workers_per_gather', nworkers::text, false);
+	end if;
+end;
+$$ language plpgsql;
+
+-- numeric state of pgstrom aggregates across combine/serial/deserial
+set pg_strom.enabled to off;
+select pg_temp.set_parallel(4);
+select current_setting('server_version_num')::int < 90600 or pg_temp.explain_has('select key, pgstrom.avg_numeric(1, nume_x) from strom_test group by key', '%Partial %Aggregate%') as explain_has;
+create temp table numeric_par as select key, pgstrom.avg_int8(1, bigint_x) ai, pgstrom.avg_numeric(1, nume_x) an, pgstrom.var_samp(1, nume_x, nume_x * nume_x) vs, pgstrom.var_pop(1, nume_x, nume_x * nume_x) vp, pgstrom.stddev_samp(1, nume_x, nume_x * nume_x) ss, pgstrom.stddev_pop(1, nume_x, nume_x * nume_x) sp from strom_test where nume_x is not null group by key;
+select pg_temp.set_parallel(0);
+create temp table numeric_ser as select key, pgstrom.avg_int8(1, bigint_x) ai, pgstrom.avg_numeric(1, nume_x) an, pgstrom.var_samp(1, nume_x, nume_x * nume_x) vs, pgstrom.var_pop(1, nume_x, nume_x * nume_x) vp, pgstrom.stddev_samp(1, nume_x, nume_x * nume_x) ss, pgstrom.stddev_pop(1, nume_x, nume_x * nume_x) sp from strom_test where nume_x is not null group by key;
+(table numeric_par except all table numeric_ser) union all (table numeric_ser except all table numeric_par);
+
+-- GpuPreAgg under parallel query
+set pg_strom.enabled to on;
+select pg_temp.set_parallel(4);
+create temp table avg_gpu_par as select key, avg(bigint_x) ai, avg(nume_x) an, variance(nume_x) vn, stddev(nume_x) sn from strom_test group by key;
+select pg_temp.set_parallel(0);
+set pg_strom.enabled to off;
+create temp table avg_cpu_ser as select key, avg(bigint_x) ai, avg(nume_x) an, variance(nume_x) vn, stddev(nume_x) sn from strom_test group by key;
+set pg_strom.enabled to on;
+(table avg_gpu_par except all table avg_cpu_ser) union all (table avg_cpu_ser except all table avg_gpu_par);
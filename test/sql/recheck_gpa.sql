@@ -38,3 +38,20 @@ deallocate p1;
 prepare p1 as select sum(float_x/(id%1000)) from strom_test;
 execute p1;
 deallocate p1;
+
+-- CPU fallback that groups the partial rows by hash table
+set pg_strom.enabled to on;
+set pg_strom.enable_gpupreagg_fallback_hashagg to on;
+create temp table fbhash_gpu as select key, id % 100 k, count(*) c, sum(integer_x) s, max(float_x) m, sum(nume_x * 1e+49) n from strom_test group by key, id % 100;
+set work_mem to '64kB';
+create temp table fbhash_small_gpu as select key, id % 100 k, count(*) c, sum(integer_x) s, max(float_x) m, sum(nume_x * 1e+49) n from strom_test group by key, id % 100;
+reset work_mem;
+set pg_strom.enable_gpupreagg_fallback_hashagg to off;
+create temp table nofbhash_gpu as select key, id % 100 k, count(*) c, sum(integer_x) s, max(float_x) m, sum(nume_x * 1e+49) n from strom_test group by key, id % 100;
+reset pg_strom.enable_gpupreagg_fallback_hashagg;
+set pg_strom.enabled to off;
+create temp table fbhash_cpu as select key, id % 100 k, count(*) c, sum(integer_x) s, max(float_x) m, sum(nume_x * 1e+49) n from strom_test group by key, id % 100;
+set pg_strom.enabled to on;
+(table fbhash_gpu except all table fbhash_cpu) union all (table fbhash_cpu except all table fbhash_gpu);
+(table fbhash_small_gpu except all table fbhash_cpu) union all (table fbhash_cpu except all table fbhash_small_gpu);
+(table nofbhash_gpu except all table fbhash_cpu) union all (table fbhash_cpu except all table nofbhash_gpu);
@@ -89,3 +89,39 @@ deallocate p1;
 prepare p1 as select * from strom_test where float_x/(id%1000) = 1;
 execute p1;
 deallocate p1;
+
+-- CPU recheck with host JIT code
+set pg_strom.enable_hostjit to on;
+prepare p1 as select * from strom_test where integer_x/(id-id/1000*1000) = 1;
+execute p1;
+deallocate p1;
+
+prepare p1 as select * from strom_test where bigint_x/(id-id/1000*1000) = 1;
+execute p1;
+deallocate p1;
+
+set pg_strom.enabled to on;
+create temp table hostjit_gpu as select id, nume_x*1e+49 as v from strom_test where id/1000*1000 = id and smlint_x > 0;
+set pg_strom.enabled to off;
+create temp table hostjit_cpu as select id, nume_x*1e+49 as v from strom_test where id/1000*1000 = id and smlint_x > 0;
+(table hostjit_gpu except all table hostjit_cpu) union all (table hostjit_cpu except all table hostjit_gpu);
+set pg_strom.enabled to on;
+reset pg_strom.enable_hostjit;
+
+-- CPU recheck with chunk-at-a-time evaluation of device quals
+set pg_strom.enabled to on;
+set pg_strom.enable_cpuvec to on;
+create temp table cpuvec_gpu as select id, nume_x*1e+49 as v from strom_test where (smlint_x > 0 or float_x < -10 or bigint_x is null) and integer_x <> 0 and real_x >= -1000 and id % 100 = 0;
+create temp table cpuvec_qual_gpu as select id from strom_test where (smlint_x > 0 or bigint_x is null) and 10 > id % 50 and nume_x*1e+49 > 0;
+set pg_strom.enable_cpuvec to off;
+create temp table nocpuvec_gpu as select id, nume_x*1e+49 as v from strom_test where (smlint_x > 0 or float_x < -10 or bigint_x is null) and integer_x <> 0 and real_x >= -1000 and id % 100 = 0;
+create temp table nocpuvec_qual_gpu as select id from strom_test where (smlint_x > 0 or bigint_x is null) and 10 > id % 50 and nume_x*1e+49 > 0;
+set pg_strom.enabled to off;
+create temp table cpuvec_cpu as select id, nume_x*1e+49 as v from strom_test where (smlint_x > 0 or float_x < -10 or bigint_x is null) and integer_x <> 0 and real_x >= -1000 and id % 100 = 0;
+create temp table cpuvec_qual_cpu as select id from strom_test where (smlint_x > 0 or bigint_x is null) and 10 > id % 50 and nume_x*1e+49 > 0;
+(table cpuvec_gpu except all table cpuvec_cpu) union all (table cpuvec_cpu except all table cpuvec_gpu);
+(table nocpuvec_gpu except all table cpuvec_cpu) union all (table cpuvec_cpu except all table nocpuvec_gpu);
+(table cpuvec_qual_gpu except all table cpuvec_qual_cpu) union all (table cpuvec_qual_cpu except all table cpuvec_qual_gpu);
+(table nocpuvec_qual_gpu except all table cpuvec_qual_cpu) union all (table cpuvec_qual_cpu except all table nocpuvec_qual_gpu);
+set pg_strom.enabled to on;
+reset pg_strom.enable_cpuvec;
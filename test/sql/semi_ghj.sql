@@ -0,0 +1,55 @@
+--#
+--#       Gpu Hash Join TestCases of SEMI and ANTI JOIN.
+--#
+--#   Results of GpuHashJoin are compared with the ones computed by CPU.
+--#
+
+set pg_strom.gpu_setup_cost=0;
+set pg_strom.enable_gpupreagg to off;
+set pg_strom.enable_gpusort to off;
+set random_page_cost=1000000;   --# force off index_scan.
+set client_min_messages to warning;
+
+create function pg_temp.explain_has(query text, pattern text) returns bool as $$
+declare
+	line	text;
+begin
+	for line in execute 'explain (analyze, costs off, timing off) ' || query loop
+		if line like pattern then
+			return true;
+		end if;
+	end loop;
+	return false;
+end;
+$$ language plpgsql;
+
+-- EXISTS
+select pg_temp.explain_has('select a.id from strom_test a where exists (select 1 from strom_test b where b.smlint_x = a.smlint_x and b.key = a.key and b.id % 7 = 0)', '%GpuHashSemiJoin%');
+set pg_strom.enabled to on;
+create temp table semi_gpu as select a.id, a.key from strom_test a where exists (select 1 from strom_test b where b.smlint_x = a.smlint_x and b.key = a.key and b.id % 7 = 0);
+create temp table semi_nume_gpu as select a.id from strom_test a where a.id % 3 = 0 and exists (select 1 from strom_test b where b.nume_x = a.nume_x and b.id < 25000);
+create temp table semi_filter_gpu as select a.id from strom_test a where exists (select 1 from strom_test b where b.key = a.key and b.id % 11 = 0 and b.integer_x > a.integer_x);
+set pg_strom.enabled to off;
+create temp table semi_cpu as select a.id, a.key from strom_test a where exists (select 1 from strom_test b where b.smlint_x = a.smlint_x and b.key = a.key and b.id % 7 = 0);
+create temp table semi_nume_cpu as select a.id from strom_test a where a.id % 3 = 0 and exists (select 1 from strom_test b where b.nume_x = a.nume_x and b.id < 25000);
+create temp table semi_filter_cpu as select a.id from strom_test a where exists (select 1 from strom_test b where b.key = a.key and b.id % 11 = 0 and b.integer_x > a.integer_x);
+set pg_strom.enabled to on;
+(table semi_gpu except all table semi_cpu) union all (table semi_cpu except all table semi_gpu);
+(table semi_nume_gpu except all table semi_nume_cpu) union all (table semi_nume_cpu except all table semi_nume_gpu);
+(table semi_filter_gpu except all table semi_filter_cpu) union all (table semi_filter_cpu except all table semi_filter_gpu);
+
+-- NOT EXISTS; outer rows with NULL join keys never match
+select pg_temp.explain_has('select a.id from strom_test a where not exists (select 1 from strom_test b where b.smlint_x = a.smlint_x and b.key = a.key and b.id % 7 = 0)', '%GpuHashAntiJoin%');
+set pg_strom.enabled to on;
+create temp table anti_gpu as select a.id, a.key from strom_test a where not exists (select 1 from strom_test b where b.smlint_x = a.smlint_x and b.key = a.key and b.id % 7 = 0);
+create temp table anti_nume_gpu as select a.id from strom_test a where a.id % 3 = 0 and not exists (select 1 from strom_test b where b.nume_x = a.nume_x and b.id < 25000);
+create temp table anti_filter_gpu as select a.id from strom_test a where not exists (select 1 from strom_test b where b.key = a.key and b.id % 11 = 0 and b.integer_x > a.integer_x);
+set pg_strom.enabled to off;
+create temp table anti_cpu as select a.id, a.key from strom_test a where not exists (select 1 from strom_test b where b.smlint_x = a.smlint_x and b.key = a.key and b.id % 7 = 0);
+create temp table anti_nume_cpu as select a.id from strom_test a where a.id % 3 = 0 and not exists (select 1 from strom_test b where b.nume_x = a.nume_x and b.id < 25000);
+create temp table anti_filter_cpu as select a.id from strom_test a where not exists (select 1 from strom_test b where b.key = a.key and b.id % 11 = 0 and b.integer_x > a.integer_x);
+set pg_strom.enabled to on;
+(table anti_gpu except all table anti_cpu) union all (table anti_cpu except all table anti_gpu);
+(table anti_nume_gpu except all table anti_nume_cpu) union all (table anti_nume_cpu except all table anti_nume_gpu);
+(table anti_filter_gpu except all table anti_filter_cpu) union all (table anti_filter_cpu except all table anti_filter_gpu);
+select count(*) from anti_gpu where key is null;